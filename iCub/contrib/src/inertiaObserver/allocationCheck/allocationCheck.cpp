@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+//
+// Check of the steady state of the estimation step of inertiaObserver: the
+// workspace and the learners of the right arm are set up as in
+// inertiaObserver_thread::threadInit() (with random identifiable subspaces),
+// then for each sample the kinematics is solved in a random state and the
+// regressors and the update of the learners are computed as in run(),
+// alternating still and moving phases. After a warm up (until the learners
+// are full rank) the calls to operator new of the estimation step are counted
+// over n_steps samples (the kinematics, that allocates in iDyn, is outside the count).
+// Exits with 1 if any allocation is counted.
+//
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynBody.h>
+#include <iCub/iDyn/iDynRegressor.h>
+#include <iCub/learningMachine/MultiTaskLinearGPRLearner.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include "estimationWorkspace.h"
+
+using namespace yarp::sig;
+using namespace iCub::iDyn;
+using namespace iCub::iDyn::Regressor;
+using namespace iCub::learningmachine;
+
+const int n_warmup = 1000;
+const int n_steps = 500;
+const int phase_length = 50;
+
+double randomDouble(double range)
+{
+    return range*(2.0*rand()/RAND_MAX-1.0);
+}
+
+Vector randomVector(int n, double range)
+{
+    Vector v(n);
+    for(int i=0; i < n; i++ ) {
+        v[i] = randomDouble(range);
+    }
+    return v;
+}
+
+Matrix randomMatrix(int rows, int cols, double range)
+{
+    Matrix M(rows,cols);
+    for(int i=0; i < rows; i++ ) {
+        for(int j=0; j < cols; j++ ) {
+            M(i,j) = randomDouble(range);
+        }
+    }
+    return M;
+}
+
+//random state of the right arm and of the head, with the kinematics solved
+void setRandomState(iCubWholeBody & icub)
+{
+    const std::string limbs[2] = {"right_arm","head"};
+    for(int l=0; l < 2; l++ ) {
+        int n = icub.upperTorso->getAng(limbs[l]).size();
+        icub.upperTorso->setAng(limbs[l],randomVector(n,1.0));
+        icub.upperTorso->setDAng(limbs[l],randomVector(n,2.0));
+        icub.upperTorso->setD2Ang(limbs[l],randomVector(n,5.0));
+    }
+    Vector ddp0 = randomVector(3,1.0);
+    ddp0[2] += 9.81;
+    icub.upperTorso->setInertialMeasure(randomVector(3,1.0),randomVector(3,1.0),ddp0);
+    icub.upperTorso->solveKinematics();
+}
+
+int main()
+{
+    srand(0);
+
+    version_tag icub_type;
+    iCubWholeBody icub(icub_type,DYNAMIC,iCub::skinDynLib::NO_VERBOSE);
+    const std::string limb("right_arm");
+
+    //random subspaces, with the sizes of the ones of the observer
+    Matrix Phi;
+    iCubLimbRegressorSensorWrench(&icub,limb,Phi);
+    const int n_param = Phi.cols();
+    const int n_ident = n_param/2;
+    const int n_static = n_ident/3;
+    const int n_dynamic = n_ident-n_static;
+    Matrix identifiable_parameters = randomMatrix(n_param,n_ident,1.0);
+    Matrix static_identifiable_parameters = randomMatrix(n_param,n_static,1.0);
+    Matrix dynamic_identifiable_parameters = randomMatrix(n_param,n_dynamic,1.0);
+
+    estimationWorkspace ws;
+    ws.resize(n_param,n_ident,n_static,n_dynamic,3,0);
+    if( !ws.setBases(identifiable_parameters,static_identifiable_parameters,dynamic_identifiable_parameters) ) {
+        std::cout << "setBases failed" << std::endl;
+        return 1;
+    }
+
+    //learners as in threadInit, with the noise of the right arm sensor
+    Vector ft_std(6);
+    ft_std[0] = 0.0759966;
+    ft_std[1] = 0.0893956;
+    ft_std[2] = 0.1793871;
+    ft_std[3] = 0.0019388;
+    ft_std[4] = 0.0028635;
+    ft_std[5] = 0.0014280;
+    std::vector<IParameterLearner *> estimators;
+    MultiTaskLinearGPRLearner rls(n_ident+6,6);
+    rls.setNoiseStandardDeviation(ft_std);
+    estimators.push_back(&rls);
+    MultiTaskLinearGPRLearner static_estimator(n_static+6,6);
+    MultiTaskLinearGPRLearner dynamic_estimator(n_dynamic,6);
+
+    //synthetic wrench: Phi_w_offset*theta + noise
+    Vector theta = randomVector(n_ident+6,1.0);
+    Vector w(6);
+
+    unsigned long allocations = 0;
+    int dynamic_updates = 0;
+    for(int i=0; i < n_warmup+n_steps; i++ ) {
+        setRandomState(icub);
+        const bool still = (i/phase_length)%2 == 0;
+
+        unsigned long count = estimationWorkspace::getAllocationCount();
+        if( !ws.computeRegressors(&icub,limb) ) {
+            std::cout << "computeRegressors failed" << std::endl;
+            return 1;
+        }
+        for(int r=0; r < 6; r++ ) {
+            w[r] = ft_std[r]*randomDouble(1.0);
+            for(int c=0; c < n_ident+6; c++ ) {
+                w[r] += ws.Phi_w_offset(r,c)*theta[c];
+            }
+        }
+        bool dynamic_update = ws.feedLearners(estimators,&static_estimator,&dynamic_estimator,w,still);
+        count = estimationWorkspace::getAllocationCount()-count;
+
+        if( i >= n_warmup ) {
+            allocations += count;
+            if( dynamic_update ) dynamic_updates++;
+        }
+    }
+
+    int failures = 0;
+    std::cout << "allocations in " << n_steps << " estimation steps: " << allocations
+              << (allocations == 0 ? " ok" : " FAILED") << std::endl;
+    if( allocations != 0 ) failures++;
+    //the update of the dynamic estimator must be part of the checked steps
+    std::cout << "updates of the dynamic estimator: " << dynamic_updates
+              << (dynamic_updates > 0 ? " ok" : " FAILED") << std::endl;
+    if( dynamic_updates == 0 ) failures++;
+
+    return failures ? 1 : 0;
+}
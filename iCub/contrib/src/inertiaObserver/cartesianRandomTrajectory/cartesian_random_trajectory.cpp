@@ -20,18 +20,25 @@
 #include <yarp/dev/ControlBoardInterfaces.h>
 
 #include <iCub/ctrl/math.h>
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynBody.h>
+#include <iCub/iDyn/iDynRegressor.h>
 
+#include "fourierTrajectory.h"
 
 #include <gsl/gsl_math.h>
 
 #include <stdio.h>
 
 #include <string>
+#include <algorithm>
 
 using namespace iCub::ctrl;
+using namespace iCub::iDyn;
 
 #define PRINT_STATUS_PER    1.0     // [s]
 #define MAX_TORSO_PITCH     30.0    // [deg]
+#define EXCITATION_GAIN     2.0     // [1/s] gain of the position error in the velocity streaming of the excitation trajectory
 
 std::string robotName;
 bool gaze_enabled;
@@ -39,6 +46,16 @@ bool gaze_enabled;
 double ctrl_thread_period = 10.0;
 double trajectory_time = 5.0;
 
+//periodic joint trajectory (designed by excitation_trajectory for the right arm) played back instead of the random cartesian targets
+bool excitation_enabled = false;
+fourierTrajectory excitation;
+
+//targets selected by the information of the static estimation published by the inertiaObserver
+bool information_enabled = false;
+std::string information_port_name;
+int information_candidates = 10;
+int information_path_samples = 3;
+
 
 YARP_DECLARE_DEVICES(icubmod)
 
@@ -56,6 +73,7 @@ protected:
     PolyDriver         client;
     PolyDriver         client_gaze;
     IPositionControl *ipos;
+    IVelocityControl *ivel;
     ICartesianControl *icart;
     IImpedanceControl *iimp;
     IPidControl * ipid;
@@ -86,6 +104,21 @@ protected:
     double t0;
     double t1;
     
+    Vector q_exc, dq_exc, ddq_exc;
+    Vector enc_exc;
+    int excitation_cycle;
+    
+    int n_axes;
+    BufferedPort<Bottle> information_port;
+    iCubWholeBody * icub_model;
+    iDynChain * arm_chain;
+    //least informed directions (columns) and their information
+    Matrix info_directions;
+    Vector info_eigenvalues;
+    Matrix Phi;
+    //null velocities and accelerations of the static configurations of the arm
+    Vector zero_arm;
+    
     // the event callback attached to the "motion-ongoing"
     virtual void cartesianEventCallback()
     {
@@ -100,6 +133,11 @@ public:
         cartesianEventParameters.type="motion-ongoing";
         cartesianEventParameters.motionOngoingCheckPoint=0.2;
         
+        icart = 0;
+        ivel = 0;
+        igaze = 0;
+        icub_model = 0;
+        arm_chain = 0;
     }
     
     void closeRightHand(IPositionControl * ipos) {
@@ -162,6 +200,7 @@ public:
 		ok = ok && robotDevice.view(iimp);
 		ok = ok && robotDevice.view(ipid);
 		ok = ok && robotDevice.view(ipos);
+		ok = ok && robotDevice.view(ivel);
 		ok = ok && robotDevice.view(iencs);
 		ok = ok && robotDevice.view(ipid_trq);
 
@@ -173,6 +212,7 @@ public:
 		int nj = 0;
 		
 		iimp->getAxes(&nj);
+		n_axes = nj;
 	
 		starting_enc.resize(nj);
 		starting_enc.zero();
@@ -199,6 +239,10 @@ public:
 			iimp->setImpedance(i, 0.111, 0.014);
 		}
 		
+        if( excitation_enabled ) {
+            return startExcitation(nj);
+        }
+		
 		
         // open a client interface to connect to the cartesian server of the simulator
         // we suppose that:
@@ -305,6 +349,29 @@ public:
 
         xd.resize(3);
         od.resize(4);
+        
+        if( information_enabled ) {
+            std::string local_port = "/cartesian_random_trajectory/information:i";
+            if( !information_port.open(local_port.c_str()) ||
+                !Network::connect(information_port_name.c_str(),local_port.c_str()) ) {
+                fprintf(stdout,"Could not connect to %s, using random targets\n",information_port_name.c_str());
+                information_enabled = false;
+            } else {
+                //model used for the static regressor of the FT sensor of the arm
+                icub_model = new iCubWholeBody(version_tag(),DYNAMIC,iCub::skinDynLib::NO_VERBOSE);
+                iDynSensor * p_sensor;
+                int virtual_link;
+                iCub::iDyn::Regressor::iCubLimbGetData(icub_model,"right_arm",/*consider_virtual_link=*/false,arm_chain,p_sensor,virtual_link);
+                Vector w0(3),dw0(3),ddp0(3);
+                w0.zero();
+                dw0.zero();
+                ddp0.zero();
+                ddp0[2] = 9.78;
+                icub_model->upperTorso->setInertialMeasure(w0,dw0,ddp0);
+                zero_arm.resize(arm_chain->getN());
+                zero_arm.zero();
+            }
+        }
 
 		yarp::os::Random::seed(Time::now());
 		
@@ -322,6 +389,187 @@ public:
         return true;
     }
     
+    /**
+     * Move the arm to the start of the excitation trajectory, and switch its joints
+     * to velocity control
+     */
+    bool startExcitation(int nj)
+    {
+        if( excitation.getNrOfJoints() > nj ) {
+            printf("The excitation trajectory has %d joints, the arm %d\n",excitation.getNrOfJoints(),nj);
+            return false;
+        }
+        
+        got_starting_enc = iencs->getEncoders(starting_enc.data());
+        
+        closeRightHand(ipos);
+        
+        excitation.evaluate(0.0,q_exc,dq_exc,ddq_exc);
+        for(int j=0; j < excitation.getNrOfJoints(); j++ ) {
+            ipos->setRefSpeed(j,10.0);
+            ipos->positionMove(j,CTRL_RAD2DEG*q_exc[j]);
+        }
+        
+        bool motionDone = false;
+        double t_start = Time::now();
+        while( !motionDone && Time::now()-t_start < 30.0 ) {
+            yarp::os::Time::delay(0.5);
+            ipos->checkMotionDone(&motionDone);
+        }
+        
+        //the reference acceleration of the velocity control should not limit the
+        //acceleration of the trajectory: twice its maximum on a period
+        const int n_exc = excitation.getNrOfJoints();
+        Vector ddq_exc_max(n_exc,0.0);
+        for(int s=0; s < 200; s++ ) {
+            excitation.evaluate(s*excitation.getPeriod()/200,q_exc,dq_exc,ddq_exc);
+            for(int j=0; j < n_exc; j++ ) {
+                ddq_exc_max[j] = std::max(ddq_exc_max[j],fabs(ddq_exc[j]));
+            }
+        }
+        for(int j=0; j < n_exc; j++ ) {
+            ivel->setRefAcceleration(j,std::max(2.0*CTRL_RAD2DEG*ddq_exc_max[j],10.0));
+            ictrl->setVelocityMode(j);
+        }
+        enc_exc.resize(nj);
+        excitation_cycle = -1;
+        printf("Starting the excitation trajectory, period %lf s\n",excitation.getPeriod());
+        return true;
+    }
+    
+    /**
+     * Stream the velocity of the excitation trajectory, corrected by the error of the
+     * measured position (the position control, with a new positionMove and reference
+     * speed each period, would not track the velocity of the trajectory)
+     */
+    void streamExcitation()
+    {
+        const double t_traj = t-t0;
+        
+        int cycle = (int)(t_traj/excitation.getPeriod());
+        if( cycle != excitation_cycle ) {
+            printf("Excitation trajectory, cycle %d\n",cycle);
+            excitation_cycle = cycle;
+        }
+        
+        excitation.evaluate(t_traj,q_exc,dq_exc,ddq_exc);
+        bool got_enc = iencs->getEncoders(enc_exc.data());
+        for(int j=0; j < excitation.getNrOfJoints(); j++ ) {
+            double speed = CTRL_RAD2DEG*dq_exc[j];
+            if( got_enc ) {
+                speed += EXCITATION_GAIN*(CTRL_RAD2DEG*q_exc[j]-enc_exc[j]);
+            }
+            ivel->velocityMove(j,speed);
+        }
+    }
+    
+    /**
+     * Read the last information published by the observer, if any
+     * @return true if the least informed directions are available
+     */
+    bool updateInformation()
+    {
+        Bottle * info_bot = information_port.read(false);
+        if( info_bot != 0 ) {
+            Bottle * eigenvalues = info_bot->find("eigenvalues").asList();
+            Bottle * directions = info_bot->find("directions").asList();
+            if( eigenvalues != 0 && directions != 0 && eigenvalues->size() == directions->size() && directions->size() > 0 &&
+                directions->get(0).asList() != 0 ) {
+                const int m = eigenvalues->size();
+                const int n = directions->get(0).asList()->size();
+                info_directions.resize(n,m);
+                info_eigenvalues.resize(m);
+                for(int k=0; k < m; k++ ) {
+                    Bottle * direction = directions->get(k).asList();
+                    if( direction == 0 || direction->size() != n ) {
+                        info_directions.resize(0,0);
+                        break;
+                    }
+                    info_eigenvalues[k] = eigenvalues->get(k).asDouble();
+                    for(int i=0; i < n; i++ ) {
+                        info_directions(i,k) = direction->get(i).asDouble();
+                    }
+                }
+            }
+        }
+        return info_directions.cols() > 0;
+    }
+    
+    /**
+     * Information added by a static sample in the arm configuration q (radians) to the
+     * least informed directions, relative to their current information.
+     * Only the kinematics of the right arm is solved (the rest of the model does not change),
+     * and the specialized regressor of its FT sensor is used.
+     */
+    double informationGain(const Vector & q)
+    {
+        icub_model->upperTorso->setState(TORSO_NODE_RIGHT,q,zero_arm,zero_arm);
+        icub_model->upperTorso->solveLimbKinematics(TORSO_NODE_RIGHT);
+        iCub::iDyn::Regressor::iCubLimbRegressorSensorWrench(icub_model,"right_arm",Phi,/*consider_virtual_link=*/false,/*use_specialized=*/true);
+        const int n = Phi.cols();
+        if( info_directions.rows() != n+6 ) return 0.0;
+        
+        double gain = 0.0;
+        for(int k=0; k < info_directions.cols(); k++ ) {
+            double g = 0.0;
+            for(int i=0; i < 6; i++ ) {
+                //component i of the wrench along the direction: Phi_i*d + offset_i
+                const double * Phi_row = Phi[i];
+                double y = info_directions(n+i,k);
+                for(int c=0; c < n; c++ ) {
+                    if( Phi_row[c] != 0.0 ) y += Phi_row[c]*info_directions(c,k);
+                }
+                g += y*y;
+            }
+            gain += g/(info_eigenvalues[k]+1e-6);
+        }
+        return gain;
+    }
+    
+    /**
+     * Choose among random targets in the box the one whose path (approximated by the linear
+     * interpolation in joint space of the current and the final configuration of the arm, as
+     * solved by the cartesian controller) gives the largest information gain.
+     * The evaluation of the candidates is stopped at half of the thread period.
+     */
+    void selectInformativeTarget(double min_x, double max_x, double min_y, double max_y, double min_z, double max_z)
+    {
+        const double t_start = Time::now();
+        const double budget = 0.5*getRate()/1000.0;
+        Vector enc(n_axes), candidate(3), xdhat, odhat, qdhat, q(arm_chain->getN());
+        const int arm_dofs = arm_chain->getN();
+        bool got_enc = iencs->getEncoders(enc.data());
+        double best_gain = -1.0;
+        int evaluated = 0;
+        
+        for(int c=0; c < information_candidates; c++ ) {
+            candidate[0]=(max_x - min_x)*yarp::os::Random::uniform() + min_x;
+            candidate[1]=(max_y - min_y)*yarp::os::Random::uniform() + min_y;
+            candidate[2]=(max_z - min_z)*yarp::os::Random::uniform() + min_z;
+            if( !got_enc || !icart->askForPosition(candidate,xdhat,odhat,qdhat) || (int)qdhat.size() < arm_dofs ) {
+                if( best_gain < 0.0 ) xd = candidate;
+                continue;
+            }
+            //the arm joints are the last ones of the cartesian chain
+            const int first = qdhat.size()-arm_dofs;
+            double gain = 0.0;
+            for(int s=1; s <= information_path_samples; s++ ) {
+                const double alpha = ((double)s)/information_path_samples;
+                for(int j=0; j < arm_dofs; j++ ) {
+                    q[j] = CTRL_DEG2RAD*((1.0-alpha)*enc[j] + alpha*qdhat[first+j]);
+                }
+                gain += informationGain(q);
+            }
+            evaluated++;
+            if( gain > best_gain ) {
+                best_gain = gain;
+                xd = candidate;
+            }
+            if( Time::now()-t_start > budget ) break;
+        }
+        printf("Information gain of the target %g (%d candidates evaluated in %g s)\n",best_gain,evaluated,Time::now()-t_start);
+    }
+    
     /**
      * If a fixation point brings the head near to the limits, returns 
      * a more "relaxed" fixation point
@@ -346,6 +594,11 @@ public:
     virtual void run()
     {
         t=Time::now();
+        
+        if( excitation_enabled ) {
+            streamExcitation();
+            return;
+        }
 
         generateTarget();
 
@@ -367,9 +620,11 @@ public:
     {    
         //Return to initial pose
         printf("Returning to initial position");
-        icart->goToPose(starting_pose,starting_orient);
+        if( icart ) {
+            icart->goToPose(starting_pose,starting_orient);
+        }
         
-        if( gaze_enabled ) {
+        if( gaze_enabled && igaze ) {
             igaze->lookAtFixationPoint(starting_fixation_point);
         }
         
@@ -385,18 +640,28 @@ public:
 		for(int j = 0; j < 5; j++ ) {
 			ipid_trq->setTorquePid(j,old_pids[j]);
 		}
-        // we require an immediate stop
-        // before closing the client for safety reason
-        icart->stopControl();
+        if( icart ) {
+            // we require an immediate stop
+            // before closing the client for safety reason
+            icart->stopControl();
 
-        // it's a good rule to restore the controller
-        // context as it was before opening the module
-        icart->restoreContext(startup_context_id);
+            // it's a good rule to restore the controller
+            // context as it was before opening the module
+            icart->restoreContext(startup_context_id);
+        }
         
         
+        if( excitation_enabled ) {
+            ivel->stop();
+        }
+        
         if( got_starting_enc ) {
             for (int i = 0; i < nj; i++) {
                 ictrl->setPositionMode(i);
+                if( excitation_enabled ) {
+                    //slow return from the point where the trajectory was stopped
+                    ipos->setRefSpeed(i,10.0);
+                }
                 ipos->positionMove(i,starting_enc[i]);
                 printf("Restoring position for encoder %d to  %lf\n",i,starting_enc[i]);
             }
@@ -411,8 +676,15 @@ public:
 
         client.close();
         
+        if( information_enabled ) {
+            information_port.interrupt();
+            information_port.close();
+            delete icub_model;
+            icub_model = 0;
+        }
+        
         //Closing gaze interface
-        if( gaze_enabled ) {
+        if( gaze_enabled && igaze ) {
             igaze->stopControl();
  
             // it's a good rule to restore the controller
@@ -437,7 +709,9 @@ public:
         max_z = 0.40;
         min_z = 0.20;
         
-        if( called >= 8 ) { 
+        if( called >= 8 && information_enabled && updateInformation() ) {
+            selectInformativeTarget(min_x,max_x,min_y,max_y,min_z,max_z);
+        } else if( called >= 8 ) { 
     
 			xd[0]=(max_x - min_x)*(yarp::os::Random::uniform()) + min_x;
 
@@ -590,6 +864,12 @@ int main(int argc, char ** argv)
         fprintf(stdout,"\t--trajectory_time time: the time used for doing a cartesian trajectory (default: 2.0)\n");
         fprintf(stdout,"\t--ctrl_thread_period period: the period used for the control thread (default: 5.0)\n");
         fprintf(stdout,"\t--gaze_enabled : enables the gaze following the hand movements (default: off)\n");
+        fprintf(stdout,"\t--information port: chooses the targets that add more information to the static estimation, published by inertiaObserver on port\n");
+        fprintf(stdout,"\t\t(e.g. /inertiaObserver/right_arm/static_information:o), among --candidates random targets (default: 10)\n");
+        fprintf(stdout,"\t\tevaluated on --path_samples configurations of the path (default: 3)\n");
+        fprintf(stdout,"\t\tonly the static information of the right_arm is supported (the trajectories are always of the right arm)\n");
+        fprintf(stdout,"\t--excitation file: plays back the joint trajectory designed by excitation_trajectory for the right_arm, instead of the random targets\n");
+        fprintf(stdout,"\t\t(the joints of the trajectory are in velocity control, without the impedance of the position mode)\n");
         return 0;
     }
 
@@ -605,6 +885,33 @@ int main(int argc, char ** argv)
 
     gaze_enabled = params.check("gaze_enabled");
     
+    if( params.check("information") ) {
+        information_enabled = true;
+        information_port_name = params.find("information").asString().c_str();
+        if( params.check("candidates") ) {
+            information_candidates = params.find("candidates").asInt();
+        }
+        if( params.check("path_samples") ) {
+            information_path_samples = params.find("path_samples").asInt();
+        }
+        if( information_candidates < 1 || information_path_samples < 1 ) {
+            fprintf(stderr,"candidates and path_samples should be positive\n");
+            return -1;
+        }
+    }
+    
+    if( params.check("excitation") ) {
+        iCubArmNoTorsoDyn right_arm("right");
+        if( !excitation.load(params.find("excitation").asString().c_str(),"right_arm",right_arm.getN()) ) {
+            fprintf(stderr,"Error in loading the excitation trajectory\n");
+            return -1;
+        }
+        excitation_enabled = true;
+        gaze_enabled = false;
+        //the velocity is streamed, the control period should be short
+        ctrl_thread_period = 0.05;
+    }
+    
     if( params.check("trajectory_time") ) {
         fprintf(stdout,"Using trajectory_time from configuration: ");
         trajectory_time = params.find("trajectory_time").asDouble();
@@ -0,0 +1,427 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+//
+// Offline design of a periodic excitation trajectory for the identification of the
+// inertial parameters of a limb, with the model used by the inertiaObserver.
+//
+// The trajectory of the joints of the limb is a Fourier series (see fourierTrajectory.h),
+// whose coefficients are chosen to minimize the condition number of the regressor of the
+// FT sensor of the limb, projected on the identifiable parameters (with the offset),
+// stacked on the samples of a period. The position, velocity and acceleration limits are
+// enforced on each candidate. The candidates are generated by a random search around the
+// best trajectory, and evaluated concurrently by a pool of threads.
+//
+// Usage:
+//   excitation_trajectory --output excitation.ini [--limb right_arm] [--period 10] [--harmonics 5]
+//                         [--samples 100] [--candidates 64] [--iterations 50] [--threads 4]
+//                         [--dq_max 30] [--ddq_max 60] [--seed 0]
+//   cartesian_random_trajectory --robot icub --excitation excitation.ini
+//                         plays back the trajectory on the robot
+//
+
+#include <yarp/os/Property.h>
+#include <yarp/os/Random.h>
+#include <yarp/os/Thread.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <yarp/math/SVD.h>
+
+#include <iCub/ctrl/math.h>
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynBody.h>
+#include <iCub/iDyn/iDynRegressor.h>
+
+#include "fourierTrajectory.h"
+
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::ctrl;
+using namespace iCub::iDyn;
+using namespace iCub::iDyn::Regressor;
+
+/**
+ * Evaluation of the condition number of the identification problem of a trajectory.
+ * Each thread uses its own object, as the iCubWholeBody is not shared.
+ */
+class excitationEvaluator
+{
+    iCubWholeBody icub;
+    std::string limb;
+    const Matrix & basis;
+    int n_samples;
+    iDynChain * p_chain;
+    Matrix Phi;
+    Matrix G;
+    Vector row;
+    Vector q, dq, ddq;
+
+public:
+    excitationEvaluator(version_tag icub_type, const std::string & _limb, const Matrix & _basis, int _n_samples) :
+        icub(icub_type,DYNAMIC,iCub::skinDynLib::NO_VERBOSE), limb(_limb), basis(_basis), n_samples(_n_samples), p_chain(0)
+    {
+        iDynSensor * p_sensor;
+        int virtual_link;
+        iCubLimbGetData(&icub,limb,/*consider_virtual_link=*/false,p_chain,p_sensor,virtual_link);
+
+        Vector w0(3),dw0(3),ddp0(3);
+        w0.zero();
+        dw0.zero();
+        ddp0.zero();
+        ddp0[2] = 9.78;
+        icub.upperTorso->setInertialMeasure(w0,dw0,ddp0);
+
+        const int r = basis.cols()+6;
+        G.resize(r,r);
+        row.resize(r);
+    }
+
+    /**
+     * Condition number of the regressor [Phi*basis I] stacked on n_samples samples of a period
+     */
+    double conditionNumber(const fourierTrajectory & traj)
+    {
+        const int n = basis.rows();
+        const int r = basis.cols();
+        G.zero();
+        for(int s=0; s < n_samples; s++ ) {
+            traj.evaluate(s*traj.getPeriod()/n_samples,q,dq,ddq);
+            for(int j=0; j < traj.getNrOfJoints(); j++ ) {
+                p_chain->setAng(j,q[j]);
+                p_chain->setDAng(j,dq[j]);
+                p_chain->setD2Ang(j,ddq[j]);
+            }
+            icub.upperTorso->solveKinematics();
+            iCubLimbRegressorSensorWrench(&icub,limb,Phi);
+
+            for(int i=0; i < 6; i++ ) {
+                //row i of [Phi*basis I]
+                row.zero();
+                const double * Phi_row = Phi[i];
+                for(int k=0; k < n; k++ ) {
+                    const double phi = Phi_row[k];
+                    if( phi == 0.0 ) continue;
+                    const double * basis_row = basis[k];
+                    for(int c=0; c < r; c++ ) {
+                        row[c] += phi*basis_row[c];
+                    }
+                }
+                row[r+i] = 1.0;
+                for(int c1=0; c1 < r+6; c1++ ) {
+                    if( row[c1] == 0.0 ) continue;
+                    for(int c2=c1; c2 < r+6; c2++ ) {
+                        G(c1,c2) += row[c1]*row[c2];
+                    }
+                }
+            }
+        }
+        for(int c1=0; c1 < r+6; c1++ ) {
+            for(int c2=0; c2 < c1; c2++ ) {
+                G(c1,c2) = G(c2,c1);
+            }
+        }
+
+        //the singular values of the stacked regressor are the square roots of the ones of G
+        Matrix U,V;
+        Vector S;
+        SVD(G,U,S,V);
+        if( S[S.size()-1] <= 0.0 ) return std::numeric_limits<double>::infinity();
+        return sqrt(S[0]/S[S.size()-1]);
+    }
+};
+
+/**
+ * Concurrent evaluation of a set of candidate trajectories
+ */
+class excitationPool
+{
+    std::vector<excitationEvaluator *> evaluators;
+    const std::vector<fourierTrajectory> * candidates;
+    std::vector<double> * costs;
+    int next_task;
+    Semaphore task_mutex;
+
+    friend class excitationWorker;
+
+    int getNextTask()
+    {
+        int task = -1;
+        task_mutex.wait();
+        if( next_task < (int)candidates->size() ) {
+            task = next_task;
+            next_task++;
+        }
+        task_mutex.post();
+        return task;
+    }
+
+public:
+    excitationPool(int n_threads, version_tag icub_type, const std::string & limb, const Matrix & basis, int n_samples) :
+        candidates(0), costs(0), next_task(0), task_mutex(1)
+    {
+        for(int t=0; t < std::max(n_threads,1); t++ ) {
+            evaluators.push_back(new excitationEvaluator(icub_type,limb,basis,n_samples));
+        }
+    }
+
+    ~excitationPool()
+    {
+        for(size_t t=0; t < evaluators.size(); t++ ) {
+            delete evaluators[t];
+        }
+    }
+
+    void evaluate(const std::vector<fourierTrajectory> & _candidates, std::vector<double> & _costs);
+};
+
+/**
+ * Thread of the pool: evaluates candidates until there are no more
+ */
+class excitationWorker : public Thread
+{
+    excitationPool & pool;
+    excitationEvaluator & evaluator;
+
+public:
+    excitationWorker(excitationPool & _pool, excitationEvaluator & _evaluator) : pool(_pool), evaluator(_evaluator) {}
+
+    void run()
+    {
+        int task;
+        while( (task = pool.getNextTask()) != -1 ) {
+            (*pool.costs)[task] = evaluator.conditionNumber((*pool.candidates)[task]);
+        }
+    }
+};
+
+void excitationPool::evaluate(const std::vector<fourierTrajectory> & _candidates, std::vector<double> & _costs)
+{
+    candidates = &_candidates;
+    costs = &_costs;
+    costs->assign(candidates->size(),std::numeric_limits<double>::infinity());
+    next_task = 0;
+
+    if( evaluators.size() == 1 ) {
+        excitationWorker worker(*this,*evaluators[0]);
+        worker.run();
+    } else {
+        std::vector<excitationWorker *> workers(evaluators.size());
+        for(size_t t=0; t < evaluators.size(); t++ ) {
+            workers[t] = new excitationWorker(*this,*evaluators[t]);
+            workers[t]->start();
+        }
+        //stop() waits for the end of run(), that returns when the candidates are finished
+        for(size_t t=0; t < evaluators.size(); t++ ) {
+            workers[t]->stop();
+            delete workers[t];
+        }
+    }
+    candidates = 0;
+    costs = 0;
+}
+
+/**
+ * Identifiable subspace of the parameters of the limb, from the regressors of random motions
+ * (as in inertiaObserver_thread::getiCubLimbIdentifiableSubspace)
+ */
+Matrix getIdentifiableSubspace(version_tag icub_type, const std::string & limb, int num_samples = 1000)
+{
+    iCubWholeBody icub(icub_type,DYNAMIC,iCub::skinDynLib::NO_VERBOSE);
+    iDynChain * p_chain;
+    iDynSensor * p_sensor;
+    int virtual_link;
+    iCubLimbGetData(&icub,limb,/*consider_virtual_link=*/false,p_chain,p_sensor,virtual_link);
+
+    Vector w0(3),dw0(3),ddp0(3);
+    w0.zero();
+    dw0.zero();
+    ddp0.zero();
+    ddp0[2] = 9.78;
+    icub.upperTorso->setInertialMeasure(w0,dw0,ddp0);
+
+    Vector q_min = p_chain->getJointBoundMin();
+    Vector q_max = p_chain->getJointBoundMax();
+    Matrix A, allA;
+    for(int s=0; s < num_samples; s++ ) {
+        for(unsigned int i=0; i < q_min.size(); i++ ) {
+            p_chain->setAng(i,((q_max[i]-q_min[i])*Random::uniform() + q_min[i]));
+            p_chain->setDAng(i,Random::uniform());
+            p_chain->setD2Ang(i,0.5*Random::uniform());
+        }
+        icub.upperTorso->solveKinematics();
+        iCubLimbRegressorSensorWrench(&icub,limb,A);
+        if( s == 0 ) {
+            allA.resize(A.rows()*num_samples,A.cols());
+        }
+        allA.setSubmatrix(A,A.rows()*s,0);
+    }
+
+    Matrix U,V;
+    Vector S;
+    SVD(allA,U,S,V);
+    double tol = std::max(allA.rows(),allA.cols())*std::numeric_limits<double>::epsilon()*S[0];
+    int rank;
+    for(rank = 0; rank < (int)S.size(); rank++ ) {
+        if( S[rank] < tol ) break;
+    }
+    return V.submatrix(0,V.rows()-1,0,rank-1);
+}
+
+//random trajectory, or perturbation of a trajectory with relative amplitude sigma
+void randomTrajectory(fourierTrajectory & traj, const Vector & q_min, const Vector & q_max, const Vector & dq_max, double sigma,
+                      const fourierTrajectory * center = 0)
+{
+    const int n = traj.getNrOfJoints();
+    const int L = traj.getNrOfHarmonics();
+    for(int j=0; j < n; j++ ) {
+        const double range = q_max[j]-q_min[j];
+        if( center == 0 ) {
+            traj.offset()[j] = q_min[j]+range*Random::uniform();
+            for(int l=0; l < L; l++ ) {
+                traj.sinCoefficients()(j,l) = dq_max[j]*(2*Random::uniform()-1)/L;
+                traj.cosCoefficients()(j,l) = dq_max[j]*(2*Random::uniform()-1)/L;
+            }
+        } else {
+            traj.offset()[j] = center->offset()[j]+sigma*range*Random::normal();
+            for(int l=0; l < L; l++ ) {
+                traj.sinCoefficients()(j,l) = center->sinCoefficients()(j,l)+sigma*dq_max[j]*Random::normal()/L;
+                traj.cosCoefficients()(j,l) = center->cosCoefficients()(j,l)+sigma*dq_max[j]*Random::normal()/L;
+            }
+        }
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    Property params;
+    params.fromCommand(argc, argv);
+
+    if( params.check("help") || !params.check("output") ) {
+        fprintf(stdout,"Options:\n");
+        fprintf(stdout,"\t--output file: the file of the optimized trajectory\n");
+        fprintf(stdout,"\t--limb limb: the limb of the FT sensor (default: right_arm)\n");
+        fprintf(stdout,"\t--period T: the period of the trajectory [s] (default: 10.0)\n");
+        fprintf(stdout,"\t--harmonics L: the number of harmonics of the Fourier series (default: 5)\n");
+        fprintf(stdout,"\t--samples n: the samples of a period used for the condition number (default: 100)\n");
+        fprintf(stdout,"\t--candidates n: the trajectories evaluated at each iteration (default: 64)\n");
+        fprintf(stdout,"\t--iterations n: the iterations of the random search (default: 50)\n");
+        fprintf(stdout,"\t--threads n: the threads used for the evaluation (default: 1)\n");
+        fprintf(stdout,"\t--dq_max v: the velocity limit of the joints [deg/s] (default: 30.0)\n");
+        fprintf(stdout,"\t--ddq_max a: the acceleration limit of the joints [deg/s^2] (default: 60.0)\n");
+        fprintf(stdout,"\t--joint_margin m: margin from the joint limits [deg] (default: 5.0)\n");
+        fprintf(stdout,"\t--seed s: the seed of the random search (default: 0)\n");
+        fprintf(stdout,"\t--headV2 : use the version 2 of the head\n");
+        return 0;
+    }
+
+    std::string output_file = params.find("output").asString().c_str();
+    std::string limb = params.check("limb") ? params.find("limb").asString().c_str() : "right_arm";
+    double period = params.check("period") ? params.find("period").asDouble() : 10.0;
+    int harmonics = params.check("harmonics") ? params.find("harmonics").asInt() : 5;
+    int n_samples = params.check("samples") ? params.find("samples").asInt() : 100;
+    int n_candidates = params.check("candidates") ? params.find("candidates").asInt() : 64;
+    int iterations = params.check("iterations") ? params.find("iterations").asInt() : 50;
+    int n_threads = params.check("threads") ? params.find("threads").asInt() : 1;
+    double dq_max_deg = params.check("dq_max") ? params.find("dq_max").asDouble() : 30.0;
+    double ddq_max_deg = params.check("ddq_max") ? params.find("ddq_max").asDouble() : 60.0;
+    double margin_deg = params.check("joint_margin") ? params.find("joint_margin").asDouble() : 5.0;
+    int seed = params.check("seed") ? params.find("seed").asInt() : 0;
+
+    if( period <= 0.0 || harmonics < 1 || n_samples < 1 || n_candidates < 1 || iterations < 0 || dq_max_deg <= 0.0 || ddq_max_deg <= 0.0 ) {
+        fprintf(stderr,"excitation_trajectory: wrong options, check --help\n");
+        return -1;
+    }
+
+    version_tag icub_type;
+    icub_type.head_version = params.check("headV2") ? 2 : 1;
+    icub_type.legs_version = 1;
+
+    Random::seed(seed);
+
+    fprintf(stdout,"Calculating the identifiable parameters of %s\n",limb.c_str());
+    Matrix basis = getIdentifiableSubspace(icub_type,limb);
+    fprintf(stdout,"Identifiable parameters subspace size: %d of %d\n",basis.cols(),basis.rows());
+
+    excitationPool pool(n_threads,icub_type,limb,basis,n_samples);
+
+    //limits of the joints of the limb, in radians
+    Vector q_min, q_max;
+    {
+        iCubWholeBody icub(icub_type,DYNAMIC,iCub::skinDynLib::NO_VERBOSE);
+        iDynChain * p_chain;
+        iDynSensor * p_sensor;
+        int virtual_link;
+        iCubLimbGetData(&icub,limb,/*consider_virtual_link=*/false,p_chain,p_sensor,virtual_link);
+        q_min = p_chain->getJointBoundMin();
+        q_max = p_chain->getJointBoundMax();
+    }
+    const int n_joints = q_min.size();
+    Vector dq_max(n_joints,CTRL_DEG2RAD*dq_max_deg);
+    Vector ddq_max(n_joints,CTRL_DEG2RAD*ddq_max_deg);
+    for(int j=0; j < n_joints; j++ ) {
+        q_min[j] += CTRL_DEG2RAD*margin_deg;
+        q_max[j] -= CTRL_DEG2RAD*margin_deg;
+        if( q_max[j] <= q_min[j] ) {
+            q_min[j] = q_max[j] = 0.5*(q_min[j]+q_max[j]);
+            q_max[j] += 1e-6;
+        }
+    }
+
+    //random search: the first iteration samples the whole space, the next ones perturb the best trajectory
+    std::vector<fourierTrajectory> candidates(n_candidates,fourierTrajectory(n_joints,harmonics,period));
+    std::vector<double> costs;
+    fourierTrajectory best(n_joints,harmonics,period);
+    double best_cost = std::numeric_limits<double>::infinity();
+    double sigma = 0.3;
+    double t0 = Time::now();
+
+    for(int it=0; it <= iterations; it++ ) {
+        for(int c=0; c < n_candidates; c++ ) {
+            randomTrajectory(candidates[c],q_min,q_max,dq_max,sigma,it == 0 ? 0 : &best);
+            candidates[c].enforceLimits(q_min,q_max,dq_max,ddq_max);
+        }
+        pool.evaluate(candidates,costs);
+
+        bool improved = false;
+        for(int c=0; c < n_candidates; c++ ) {
+            if( costs[c] < best_cost ) {
+                best_cost = costs[c];
+                best = candidates[c];
+                improved = true;
+            }
+        }
+        if( it == 0 ) {
+            double mean_cost = 0.0;
+            int finite = 0;
+            for(int c=0; c < n_candidates; c++ ) {
+                if( costs[c] < std::numeric_limits<double>::infinity() ) {
+                    mean_cost += costs[c];
+                    finite++;
+                }
+            }
+            fprintf(stdout,"Random trajectories: mean condition number %g, best %g\n",finite > 0 ? mean_cost/finite : -1.0,best_cost);
+        } else {
+            //shrink the search around the best trajectory if no candidate improved it
+            if( !improved ) sigma *= 0.8;
+            fprintf(stdout,"Iteration %d: condition number %g (sigma %g)\n",it,best_cost,sigma);
+        }
+    }
+
+    fprintf(stdout,"Optimized condition number %g, in %g s\n",best_cost,Time::now()-t0);
+    best.setLimb(limb);
+    if( !best.save(output_file) ) {
+        fprintf(stderr,"excitation_trajectory: error in saving %s\n",output_file.c_str());
+        return -1;
+    }
+    fprintf(stdout,"Trajectory saved in %s\n",output_file.c_str());
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include "fourierTrajectory.h"
+
+#include <yarp/os/Property.h>
+#include <yarp/os/Bottle.h>
+
+#include <gsl/gsl_math.h>
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+
+using namespace yarp::os;
+using namespace yarp::sig;
+
+fourierTrajectory::fourierTrajectory(int joints, int harmonics, double _period) : period(_period)
+{
+    resize(joints,harmonics);
+}
+
+void fourierTrajectory::resize(int joints, int harmonics)
+{
+    q0.resize(joints);
+    q0.zero();
+    a.resize(joints,harmonics);
+    a.zero();
+    b.resize(joints,harmonics);
+    b.zero();
+}
+
+void fourierTrajectory::evaluate(double t, Vector & q, Vector & dq, Vector & ddq) const
+{
+    const int n = getNrOfJoints();
+    const int L = getNrOfHarmonics();
+    const double w = 2*M_PI/period;
+    if( (int)q.size() != n ) q.resize(n);
+    if( (int)dq.size() != n ) dq.resize(n);
+    if( (int)ddq.size() != n ) ddq.resize(n);
+    for(int j=0; j < n; j++ ) {
+        q[j] = q0[j];
+        dq[j] = 0.0;
+        ddq[j] = 0.0;
+    }
+    for(int l=1; l <= L; l++ ) {
+        const double wl = w*l;
+        const double s = sin(wl*t);
+        const double c = cos(wl*t);
+        for(int j=0; j < n; j++ ) {
+            const double a_jl = a(j,l-1);
+            const double b_jl = b(j,l-1);
+            q[j] += (a_jl*s - b_jl*c)/wl;
+            dq[j] += a_jl*c + b_jl*s;
+            ddq[j] += wl*(b_jl*c - a_jl*s);
+        }
+    }
+}
+
+bool fourierTrajectory::enforceLimits(const Vector & q_min, const Vector & q_max, const Vector & dq_max, const Vector & ddq_max)
+{
+    const int n = getNrOfJoints();
+    const int L = getNrOfHarmonics();
+    const double w = 2*M_PI/period;
+    if( (int)q_min.size() != n || (int)q_max.size() != n || (int)dq_max.size() != n || (int)ddq_max.size() != n ) {
+        return false;
+    }
+    for(int j=0; j < n; j++ ) {
+        const double half_range = 0.5*(q_max[j]-q_min[j]);
+        if( half_range <= 0.0 ) return false;
+
+        //bounds on the amplitude of the position, velocity and acceleration
+        double pos_amp = 0.0, vel_amp = 0.0, acc_amp = 0.0;
+        for(int l=1; l <= L; l++ ) {
+            const double c = sqrt(a(j,l-1)*a(j,l-1)+b(j,l-1)*b(j,l-1));
+            pos_amp += c/(w*l);
+            vel_amp += c;
+            acc_amp += c*w*l;
+        }
+
+        double scale = 1.0;
+        if( pos_amp > half_range ) scale = std::min(scale,half_range/pos_amp);
+        if( vel_amp > dq_max[j] ) scale = std::min(scale,dq_max[j]/vel_amp);
+        if( acc_amp > ddq_max[j] ) scale = std::min(scale,ddq_max[j]/acc_amp);
+        if( scale < 1.0 ) {
+            for(int l=0; l < L; l++ ) {
+                a(j,l) *= scale;
+                b(j,l) *= scale;
+            }
+            pos_amp *= scale;
+        }
+        q0[j] = std::max(q_min[j]+pos_amp,std::min(q_max[j]-pos_amp,q0[j]));
+    }
+    return true;
+}
+
+bool fourierTrajectory::save(const std::string & file_name) const
+{
+    FILE * fp = fopen(file_name.c_str(),"w");
+    if( fp == NULL ) {
+        std::cerr << "Error opening " << file_name << std::endl;
+        return false;
+    }
+    const int n = getNrOfJoints();
+    const int L = getNrOfHarmonics();
+    fprintf(fp,"// Fourier series excitation trajectory, angles in radians\n");
+    fprintf(fp,"// q_j(t) = q0_j + sum_l a_jl/(w l) sin(w l t) - b_jl/(w l) cos(w l t), w = 2 pi/period\n");
+    fprintf(fp,"limb %s\n",limb.c_str());
+    fprintf(fp,"period %.17g\n",period);
+    fprintf(fp,"joints %d\n",n);
+    fprintf(fp,"harmonics %d\n",L);
+    fprintf(fp,"q0 (");
+    for(int j=0; j < n; j++ ) {
+        fprintf(fp,"%s%.17g",j == 0 ? "" : " ",q0[j]);
+    }
+    fprintf(fp,")\n");
+    const Matrix * coeffs[2] = {&a,&b};
+    const char * names[2] = {"a","b"};
+    for(int k=0; k < 2; k++ ) {
+        fprintf(fp,"%s (",names[k]);
+        for(int j=0; j < n; j++ ) {
+            fprintf(fp,"%s(",j == 0 ? "" : " ");
+            for(int l=0; l < L; l++ ) {
+                fprintf(fp,"%s%.17g",l == 0 ? "" : " ",(*coeffs[k])(j,l));
+            }
+            fprintf(fp,")");
+        }
+        fprintf(fp,")\n");
+    }
+    return fclose(fp) == 0;
+}
+
+bool fourierTrajectory::load(const std::string & file_name, const std::string & _limb, int joints)
+{
+    Property prop;
+    if( !prop.fromConfigFile(file_name.c_str()) ) {
+        std::cerr << "Error opening " << file_name << std::endl;
+        return false;
+    }
+    if( !prop.check("limb") || !prop.check("period") || !prop.check("joints") || !prop.check("harmonics") ||
+        !prop.find("q0").isList() || !prop.find("a").isList() || !prop.find("b").isList() ) {
+        std::cerr << "Error reading " << file_name << ": missing fields" << std::endl;
+        return false;
+    }
+    const std::string file_limb = prop.find("limb").asString().c_str();
+    const int n = prop.find("joints").asInt();
+    const int L = prop.find("harmonics").asInt();
+    if( file_limb != _limb || n != joints ) {
+        std::cerr << "Error reading " << file_name << ": trajectory of the " << n << " joints of " << file_limb
+                  << ", expected the " << joints << " joints of " << _limb << std::endl;
+        return false;
+    }
+    limb = file_limb;
+    period = prop.find("period").asDouble();
+    if( n <= 0 || L <= 0 || period <= 0.0 ) {
+        std::cerr << "Error reading " << file_name << ": wrong sizes" << std::endl;
+        return false;
+    }
+    resize(n,L);
+
+    Bottle * q0_list = prop.find("q0").asList();
+    Bottle * a_list = prop.find("a").asList();
+    Bottle * b_list = prop.find("b").asList();
+    if( q0_list->size() != n || a_list->size() != n || b_list->size() != n ) {
+        std::cerr << "Error reading " << file_name << ": wrong number of joints" << std::endl;
+        return false;
+    }
+    for(int j=0; j < n; j++ ) {
+        q0[j] = q0_list->get(j).asDouble();
+        Bottle * a_row = a_list->get(j).asList();
+        Bottle * b_row = b_list->get(j).asList();
+        if( a_row == 0 || b_row == 0 || a_row->size() != L || b_row->size() != L ) {
+            std::cerr << "Error reading " << file_name << ": wrong number of harmonics" << std::endl;
+            return false;
+        }
+        for(int l=0; l < L; l++ ) {
+            a(j,l) = a_row->get(l).asDouble();
+            b(j,l) = b_row->get(l).asDouble();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef FOURIER_TRAJECTORY
+#define FOURIER_TRAJECTORY
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#include <string>
+
+/**
+ * Periodic joint trajectory, defined for each joint j by a finite Fourier series
+ * (Swevers et al., Optimal robot excitation and identification, 1997):
+ *
+ *  q_j(t) = q0_j + sum_{l=1}^{L} a_jl/(w l) sin(w l t) - b_jl/(w l) cos(w l t)
+ *
+ * with w = 2*pi/period. The velocity a_jl cos(w l t) + b_jl sin(w l t) has zero mean,
+ * so the trajectory can be repeated for any number of periods.
+ * Angles are in radians. The trajectory is designed for the joints of a limb,
+ * whose name is saved with it.
+ */
+class fourierTrajectory
+{
+    std::string limb;
+    double period;
+    yarp::sig::Vector q0;
+    yarp::sig::Matrix a;
+    yarp::sig::Matrix b;
+
+public:
+    fourierTrajectory(int joints = 0, int harmonics = 0, double period = 10.0);
+
+    void resize(int joints, int harmonics);
+
+    int getNrOfJoints() const { return a.rows(); }
+    int getNrOfHarmonics() const { return a.cols(); }
+    double getPeriod() const { return period; }
+    void setPeriod(double _period) { period = _period; }
+    const std::string & getLimb() const { return limb; }
+    void setLimb(const std::string & _limb) { limb = _limb; }
+
+    yarp::sig::Vector & offset() { return q0; }
+    const yarp::sig::Vector & offset() const { return q0; }
+    yarp::sig::Matrix & sinCoefficients() { return a; }
+    const yarp::sig::Matrix & sinCoefficients() const { return a; }
+    yarp::sig::Matrix & cosCoefficients() { return b; }
+    const yarp::sig::Matrix & cosCoefficients() const { return b; }
+
+    /**
+     * Position, velocity and acceleration at time t (the vectors are resized only if needed)
+     */
+    void evaluate(double t, yarp::sig::Vector & q, yarp::sig::Vector & dq, yarp::sig::Vector & ddq) const;
+
+    /**
+     * Scale the coefficients and move the offset so that, for any t:
+     * q_min <= q(t) <= q_max, |dq(t)| <= dq_max, |ddq(t)| <= ddq_max
+     * The bounds on the amplitude of the harmonics are used, so the limits are
+     * satisfied also between the samples used for evaluating the trajectory.
+     * @return false if the position range of some joint is empty
+     */
+    bool enforceLimits(const yarp::sig::Vector & q_min, const yarp::sig::Vector & q_max,
+                       const yarp::sig::Vector & dq_max, const yarp::sig::Vector & ddq_max);
+
+    /**
+     * Save the trajectory in a text file, readable with yarp::os::Property::fromConfigFile
+     */
+    bool save(const std::string & file_name) const;
+
+    /**
+     * Load a trajectory saved with save(), designed for the given limb
+     * @param limb the limb that will play back the trajectory
+     * @param joints the number of joints of the limb
+     * @return false if the file can not be read, or if it was designed for another limb or number of joints
+     */
+    bool load(const std::string & file_name, const std::string & limb, int joints);
+};
+
+#endif
@@ -0,0 +1,153 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+//
+// Replay of inertial sensor data through iCubStateEstimator, to check the
+// base kinematics (w0, dw0, d2p0) used by the inertiaObserver.
+//
+// Usage:
+//   inertial_replay                  replays a synthetic trajectory (with
+//                                    timestamp jitter and out of order samples)
+//                                    and checks the estimates against the
+//                                    analytic values
+//   inertial_replay --file data.log  replays a log of the /icub/inertial port
+//                                    saved by yarpdatadumper, and prints
+//                                    time w0 dw0 d2p0 for each sample
+//
+
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+
+#include "iCubStateEstimator.h"
+
+#include <cstdlib>
+#include <deque>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace yarp::os;
+using namespace yarp::sig;
+
+//samples whose estimate is requested: old enough to have the samples needed by the non causal estimation
+const int delay_samples = 20;
+
+int replayFile(const char * file_name)
+{
+    std::ifstream log(file_name);
+    if( !log.is_open() ) {
+        fprintf(stderr,"inertial_replay: could not open %s\n",file_name);
+        return 1;
+    }
+
+    iCubStateEstimator state_estimator;
+    std::deque<double> times;
+    std::string line;
+    Vector w0, dw0, d2p0;
+
+    while( std::getline(log,line) ) {
+        //yarpdatadumper format: counter timestamp data
+        std::istringstream line_stream(line);
+        int counter;
+        double time, value;
+        Vector inertial;
+        if( !(line_stream >> counter >> time) ) continue;
+        while( line_stream >> value ) {
+            inertial.push_back(value);
+        }
+        if( !state_estimator.submitInertial(inertial,time) ) {
+            fprintf(stderr,"inertial_replay: discarded sample %d of size %d\n",counter,(int)inertial.size());
+            continue;
+        }
+        times.push_back(time);
+        if( (int)times.size() > delay_samples ) {
+            double requested_time = times.front();
+            times.pop_front();
+            if( state_estimator.getInertialKinematics(w0,dw0,d2p0,requested_time) == -1.0 ) continue;
+            printf("%f %s %s %s\n",requested_time,w0.toString().c_str(),dw0.toString().c_str(),d2p0.toString().c_str());
+        }
+    }
+    return 0;
+}
+
+int replaySynthetic()
+{
+    //sinusoidal angular velocity (deg/s) and linear acceleration (m/s^2), the sensor sampled at 100 Hz
+    const double period = 0.01;
+    const double jitter = 0.001;
+    const double w_amplitude = 20.0;
+    const double acc_amplitude = 0.5;
+    const double frequency = 0.5;
+    const int n_samples = 1000;
+
+    const double w_tol = 0.5;
+    const double dw_tol = 5.0;
+    const double acc_tol = 0.05;
+
+    iCubStateEstimator state_estimator;
+    std::deque<double> times;
+    Vector w0, dw0, d2p0;
+    double max_w_err = 0.0, max_dw_err = 0.0, max_acc_err = 0.0;
+    int n_checked = 0;
+    Vector delayed_inertial;
+    double delayed_time = -1.0;
+
+    srand(0);
+
+    for(int k = 0; k < n_samples; k++ ) {
+        double time = 1000.0 + k*period + jitter*(2.0*rand()/RAND_MAX-1.0);
+        double phase = 2*M_PI*frequency*(time-1000.0);
+        Vector inertial(12,0.0);
+        for(int i = 0; i < 3; i++ ) {
+            inertial[3+i] = acc_amplitude*sin(phase+i);
+            inertial[6+i] = w_amplitude*sin(phase+i);
+        }
+        inertial[5] += 9.78;
+
+        //every 50 samples a sample is delivered after the following one
+        if( k % 50 == 10 ) {
+            delayed_inertial = inertial;
+            delayed_time = time;
+            continue;
+        }
+        state_estimator.submitInertial(inertial,time);
+        times.push_back(time);
+        if( delayed_time != -1.0 ) {
+            state_estimator.submitInertial(delayed_inertial,delayed_time);
+            times.push_back(delayed_time);
+            delayed_time = -1.0;
+        }
+
+        while( (int)times.size() > delay_samples ) {
+            double requested_time = times.front();
+            times.pop_front();
+            if( state_estimator.getInertialKinematics(w0,dw0,d2p0,requested_time) == -1.0 ) continue;
+            double req_phase = 2*M_PI*frequency*(requested_time-1000.0);
+            for(int i = 0; i < 3; i++ ) {
+                max_w_err = std::max(max_w_err,fabs(w0[i]-w_amplitude*sin(req_phase+i)));
+                max_dw_err = std::max(max_dw_err,fabs(dw0[i]-2*M_PI*frequency*w_amplitude*cos(req_phase+i)));
+                max_acc_err = std::max(max_acc_err,fabs(d2p0[i]-acc_amplitude*sin(req_phase+i)-(i == 2 ? 9.78 : 0.0)));
+            }
+            n_checked++;
+        }
+    }
+
+    printf("inertial_replay: checked %d samples\n",n_checked);
+    printf("inertial_replay: max error w0 %f deg/s, dw0 %f deg/s^2, d2p0 %f m/s^2\n",max_w_err,max_dw_err,max_acc_err);
+
+    if( n_checked < n_samples/2 || max_w_err > w_tol || max_dw_err > dw_tol || max_acc_err > acc_tol ) {
+        printf("inertial_replay: FAILED\n");
+        return 1;
+    }
+    printf("inertial_replay: OK\n");
+    return 0;
+}
+
+int main(int argc, char * argv[])
+{
+    if( argc == 3 && strcmp(argv[1],"--file") == 0 ) {
+        return replayFile(argv[2]);
+    }
+    return replaySynthetic();
+}
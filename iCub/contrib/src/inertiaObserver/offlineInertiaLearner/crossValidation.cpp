@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include "crossValidation.h"
+
+#include <yarp/os/Thread.h>
+#include <yarp/math/Math.h>
+#include <yarp/math/SVD.h>
+
+#include <iCub/learningMachine/Math.h>
+
+#include <cmath>
+#include <algorithm>
+
+using namespace yarp::math;
+
+void foldStatistics::reset(int cols)
+{
+    n_samples = 0;
+    gram.resize(6);
+    rhs.resize(6);
+    for(int r=0; r < 6; r++ ) {
+        gram[r].resize(cols,cols);
+        gram[r].zero();
+        rhs[r].resize(cols);
+        rhs[r].zero();
+    }
+    yy.resize(6);
+    yy.zero();
+}
+
+void foldStatistics::addSample(const double * regr, const double * ft)
+{
+    const int p = cols();
+    for(int r=0; r < 6; r++ ) {
+        const double * phi = regr+r*p;
+        Matrix & G = gram[r];
+        //the static regressor has many structural zeros, only the upper triangle is accumulated
+        for(int i=0; i < p; i++ ) {
+            if( phi[i] == 0.0 ) continue;
+            double * G_row = G[i];
+            for(int j=i; j < p; j++ ) {
+                G_row[j] += phi[i]*phi[j];
+            }
+            rhs[r][i] += phi[i]*ft[r];
+        }
+        yy[r] += ft[r]*ft[r];
+    }
+    n_samples++;
+}
+
+void foldStatistics::sum(const foldStatistics & a, const foldStatistics & b)
+{
+    const int p = a.cols();
+    reset(p);
+    for(int r=0; r < 6; r++ ) {
+        for(int i=0; i < p; i++ ) {
+            for(int j=i; j < p; j++ ) {
+                gram[r](i,j) = a.gram[r](i,j) + b.gram[r](i,j);
+            }
+            rhs[r][i] = a.rhs[r][i] + b.rhs[r][i];
+        }
+        yy[r] = a.yy[r] + b.yy[r];
+    }
+    n_samples = a.n_samples + b.n_samples;
+}
+
+void foldStatistics::difference(const foldStatistics & a, const foldStatistics & b)
+{
+    const int p = a.cols();
+    reset(p);
+    for(int r=0; r < 6; r++ ) {
+        for(int i=0; i < p; i++ ) {
+            for(int j=i; j < p; j++ ) {
+                gram[r](i,j) = a.gram[r](i,j) - b.gram[r](i,j);
+            }
+            rhs[r][i] = a.rhs[r][i] - b.rhs[r][i];
+        }
+        yy[r] = a.yy[r] - b.yy[r];
+    }
+    n_samples = a.n_samples - b.n_samples;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+/**
+ * Thread of the pool: evaluates (configuration, fold) pairs until there are no more
+ */
+class crossValidationWorker : public yarp::os::Thread
+{
+    crossValidation & cv;
+    Matrix A;
+    Vector b, theta;
+
+public:
+    crossValidationWorker(crossValidation & _cv) : cv(_cv) {}
+
+    void run()
+    {
+        int task;
+        while( (task = cv.getNextTask()) != -1 ) {
+            cv.runTask(task,A,b,theta);
+        }
+    }
+};
+
+crossValidation::crossValidation(int _folds, int cols, const Vector & _nominal_noise_std, uint64_t _seed) :
+    n_folds(_folds), n_cols(cols), seed(_seed), folds(_folds,foldStatistics(cols)), total(cols),
+    nominal_noise_std(_nominal_noise_std), configs(0), next_task(0), task_mutex(1)
+{
+}
+
+int crossValidation::getFold(uint64_t index) const
+{
+    return (int)(sampleHash(index,seed) % (uint64_t)n_folds);
+}
+
+void crossValidation::addSample(uint64_t index, const double * regr, const double * ft)
+{
+    folds[getFold(index)].addSample(regr,ft);
+}
+
+int crossValidation::getNextTask()
+{
+    int task = -1;
+    task_mutex.wait();
+    if( next_task < (int)task_sse.size() ) {
+        task = next_task;
+        next_task++;
+    }
+    task_mutex.post();
+    return task;
+}
+
+void crossValidation::runTask(int task, Matrix & A, Vector & b, Vector & theta)
+{
+    const hyperParameters & config = (*configs)[task/n_folds];
+    const foldStatistics & validation = folds[task%n_folds];
+    const int p = n_cols;
+
+    //training statistics: all the samples except the ones of the fold
+    //A = sum_r gram_r/sigma_r^2 + I/sigma_w^2, b = sum_r rhs_r/sigma_r^2
+    A.resize(p,p);
+    A.zero();
+    b.resize(p);
+    b.zero();
+    for(int r=0; r < 6; r++ ) {
+        const double w = 1.0/(config.noise_std[r]*config.noise_std[r]);
+        for(int i=0; i < p; i++ ) {
+            for(int j=i; j < p; j++ ) {
+                A(i,j) += w*(total.gram[r](i,j)-validation.gram[r](i,j));
+            }
+            b[i] += w*(total.rhs[r][i]-validation.rhs[r][i]);
+        }
+    }
+    for(int i=0; i < p; i++ ) {
+        for(int j=0; j < i; j++ ) {
+            A(i,j) = A(j,i);
+        }
+        if( config.weight_std > 0.0 ) {
+            A(i,i) += 1.0/(config.weight_std*config.weight_std);
+        }
+    }
+
+    if( config.weight_std > 0.0 ) {
+        iCub::learningmachine::math::cholsolve(iCub::learningmachine::math::choldecomp(A),b,theta);
+    } else {
+        //same tolerance used by MultiTaskLinearGPRLearner until the covariance is full rank
+        theta = pinv(A,1e-5)*b;
+    }
+
+    //squared error on the fold: yy_r - 2*theta^T*rhs_r + theta^T*gram_r*theta
+    Vector & sse = task_sse[task];
+    sse.resize(6);
+    for(int r=0; r < 6; r++ ) {
+        const Matrix & G = validation.gram[r];
+        double quad = 0.0, lin = 0.0;
+        for(int i=0; i < p; i++ ) {
+            lin += theta[i]*validation.rhs[r][i];
+            quad += G(i,i)*theta[i]*theta[i];
+            for(int j=i+1; j < p; j++ ) {
+                quad += 2.0*G(i,j)*theta[i]*theta[j];
+            }
+        }
+        sse[r] = std::max(0.0,validation.yy[r]-2.0*lin+quad);
+    }
+}
+
+static bool lessScore(const crossValidationScore & a, const crossValidationScore & b)
+{
+    return a.score < b.score;
+}
+
+bool crossValidation::evaluate(const std::vector<hyperParameters> & _configs, int n_threads, std::vector<crossValidationScore> & scores)
+{
+    for(int f=0; f < n_folds; f++ ) {
+        if( folds[f].n_samples == 0 ) return false;
+    }
+
+    //statistics of the complete dataset, shared by all the tasks
+    total.reset(n_cols);
+    for(int f=0; f < n_folds; f++ ) {
+        foldStatistics partial = total;
+        total.sum(partial,folds[f]);
+    }
+
+    configs = &_configs;
+    task_sse.assign(_configs.size()*n_folds,Vector(6,0.0));
+    next_task = 0;
+
+    if( n_threads <= 1 ) {
+        crossValidationWorker worker(*this);
+        worker.run();
+    } else {
+        std::vector<crossValidationWorker *> workers(n_threads);
+        for(int t=0; t < n_threads; t++ ) {
+            workers[t] = new crossValidationWorker(*this);
+            workers[t]->start();
+        }
+        //stop() waits for the end of run(), that returns when the tasks are finished
+        for(int t=0; t < n_threads; t++ ) {
+            workers[t]->stop();
+            delete workers[t];
+        }
+    }
+
+    scores.resize(_configs.size());
+    for(size_t c=0; c < _configs.size(); c++ ) {
+        crossValidationScore & score = scores[c];
+        score.config = c;
+        double sum_force = 0.0, sum_torque = 0.0, sum_sq_force = 0.0, sum_sq_torque = 0.0;
+        double normalized_sse = 0.0;
+        for(int f=0; f < n_folds; f++ ) {
+            const Vector & sse = task_sse[c*n_folds+f];
+            double n = folds[f].n_samples;
+            double rms_force = sqrt((sse[0]+sse[1]+sse[2])/n);
+            double rms_torque = sqrt((sse[3]+sse[4]+sse[5])/n);
+            sum_force += rms_force;
+            sum_torque += rms_torque;
+            sum_sq_force += rms_force*rms_force;
+            sum_sq_torque += rms_torque*rms_torque;
+            for(int r=0; r < 6; r++ ) {
+                normalized_sse += sse[r]/(nominal_noise_std[r]*nominal_noise_std[r]);
+            }
+        }
+        score.rms_force = sum_force/n_folds;
+        score.rms_torque = sum_torque/n_folds;
+        score.sd_rms_force = sqrt(std::max(0.0,sum_sq_force/n_folds-score.rms_force*score.rms_force));
+        score.sd_rms_torque = sqrt(std::max(0.0,sum_sq_torque/n_folds-score.rms_torque*score.rms_torque));
+        score.score = normalized_sse/(6.0*total.n_samples);
+    }
+    std::sort(scores.begin(),scores.end(),lessScore);
+    configs = 0;
+    return true;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef CROSS_VALIDATION
+#define CROSS_VALIDATION
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/os/Semaphore.h>
+
+#include <vector>
+#include <stdint.h>
+
+using namespace yarp::sig;
+
+/**
+ * Hash of the index of a sample (splitmix64 finalizer), used to split the samples
+ * between training and testing, or between the folds, without keeping a shuffled index in memory
+ */
+inline uint64_t sampleHash(uint64_t index, uint64_t seed)
+{
+    uint64_t z = index + seed*0x9E3779B97F4A7C15ULL + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Sufficient statistics of a set of static samples (6 rows of the regressor, 6 FT values),
+ * kept separately for each component of the measure, so that the weighted least squares
+ * solution and its residuals can be computed for any diagonal noise covariance:
+ *  - gram[r] = sum of phi_r*phi_r^T
+ *  - rhs[r]  = sum of phi_r*y_r
+ *  - yy[r]   = sum of y_r^2
+ * where phi_r is the row r of the regressor of a sample and y_r the component r of its FT.
+ */
+class foldStatistics
+{
+public:
+    int n_samples;
+    std::vector<Matrix> gram;
+    std::vector<Vector> rhs;
+    Vector yy;
+
+    foldStatistics(int cols = 0) { reset(cols); }
+
+    void reset(int cols);
+    int cols() const { return gram.size() > 0 ? gram[0].cols() : 0; }
+
+    /**
+     * Add a sample
+     * @param regr the 6 rows of the regressor, in row major order
+     * @param ft the 6 FT values
+     */
+    void addSample(const double * regr, const double * ft);
+
+    /** this = a + b */
+    void sum(const foldStatistics & a, const foldStatistics & b);
+    /** this = a - b */
+    void difference(const foldStatistics & a, const foldStatistics & b);
+};
+
+/**
+ * Hyperparameters of MultiTaskLinearGPRLearner evaluated by the cross-validation
+ */
+struct hyperParameters
+{
+    Vector noise_std;   ///< standard deviation of the noise of each FT component
+    double weight_std;  ///< standard deviation of the prior of the parameters, <= 0 for no prior
+    double force_scale; ///< scale of the nominal force noise (only for the report)
+    double torque_scale;///< scale of the nominal torque noise (only for the report)
+};
+
+/**
+ * Result of the cross-validation of a hyperparameter configuration
+ */
+struct crossValidationScore
+{
+    int config;
+    double rms_force;       ///< mean on the folds of the RMS of the force error norm
+    double rms_torque;      ///< mean on the folds of the RMS of the torque error norm
+    double sd_rms_force;    ///< standard deviation on the folds of rms_force
+    double sd_rms_torque;   ///< standard deviation on the folds of rms_torque
+    double score;           ///< mean squared error normalized by the nominal FT noise
+};
+
+/**
+ * k-fold cross-validation of the static model FT = regr*parameters, estimated with the
+ * MultiTaskLinearGPRLearner model (Gaussian noise with diagonal covariance, Gaussian prior
+ * on the parameters), for a set of hyperparameter configurations.
+ *
+ * The samples are assigned to the folds by a hash of their index and only the statistics of
+ * each fold are stored: the training statistics of a fold are the total ones minus the ones of
+ * the fold, and the validation error is computed from the statistics of the fold, so each
+ * (configuration, fold) pair costs a solve of a cols x cols system, independently of the
+ * number of samples. The pairs are evaluated concurrently by a pool of threads.
+ */
+class crossValidation
+{
+    int n_folds;
+    int n_cols;
+    uint64_t seed;
+    std::vector<foldStatistics> folds;
+    foldStatistics total;
+    Vector nominal_noise_std;
+
+    //state shared by the threads
+    const std::vector<hyperParameters> * configs;
+    std::vector<Vector> task_sse;       //squared errors of each component, for each (config,fold)
+    int next_task;
+    yarp::os::Semaphore task_mutex;
+
+    int getNextTask();
+    void runTask(int task, Matrix & A, Vector & b, Vector & theta);
+
+    friend class crossValidationWorker;
+
+public:
+    /**
+     * @param folds number of folds
+     * @param cols number of columns of the regressor
+     * @param nominal_noise_std the nominal standard deviation of the FT noise, used for the score
+     * @param seed seed of the hash that assigns the samples to the folds
+     */
+    crossValidation(int folds, int cols, const Vector & nominal_noise_std, uint64_t seed = 0);
+
+    int getNrOfFolds() const { return n_folds; }
+    int getFold(uint64_t index) const;
+
+    /**
+     * Add the sample of given index to its fold
+     * @param regr the 6 rows of the regressor, in row major order
+     * @param ft the 6 FT values
+     */
+    void addSample(uint64_t index, const double * regr, const double * ft);
+
+    /** number of samples in a fold */
+    int getNrOfSamples(int fold) const { return folds[fold].n_samples; }
+
+    /**
+     * Evaluate the configurations
+     * @param configs the hyperparameter configurations
+     * @param n_threads number of threads
+     * @param scores the scores of the configurations, sorted by increasing score
+     * @return false if some fold is empty
+     */
+    bool evaluate(const std::vector<hyperParameters> & configs, int n_threads, std::vector<crossValidationScore> & scores);
+};
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+//
+// Check of crossValidation on synthetic data: the scores computed by
+// crossValidation::evaluate from the statistics of the folds, with 1 and 4
+// threads, are compared with the ones obtained training a
+// MultiTaskLinearGPRLearner on the samples of each training set and
+// predicting the samples of the corresponding validation fold.
+// Exits with 1 if they differ by more than a relative tolerance.
+//
+
+#include <yarp/os/Network.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#include <iCub/learningMachine/MultiTaskLinearGPRLearner.h>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+#include "crossValidation.h"
+
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace iCub::learningmachine;
+
+const int n_samples = 600;
+const int n_cols = 8;
+const int n_folds = 4;
+const double tolerance = 1e-6;
+
+double randomDouble(double range)
+{
+    return range*(2.0*rand()/RAND_MAX-1.0);
+}
+
+//scores of the configurations obtained training a learner for each (configuration, fold)
+void bruteForceScores(const std::vector<Matrix> & regr, const std::vector<Vector> & ft, const crossValidation & cv,
+                      const std::vector<hyperParameters> & configs, const Vector & nominal_noise_std,
+                      std::vector<crossValidationScore> & scores)
+{
+    scores.resize(configs.size());
+    for(size_t c=0; c < configs.size(); c++ ) {
+        double sum_force = 0.0, sum_torque = 0.0, sum_sq_force = 0.0, sum_sq_torque = 0.0;
+        double normalized_sse = 0.0;
+        for(int f=0; f < n_folds; f++ ) {
+            MultiTaskLinearGPRLearner learner(n_cols,6);
+            learner.setNoiseStandardDeviation(configs[c].noise_std);
+            if( configs[c].weight_std > 0.0 ) {
+                learner.setWeightsStandardDeviation(Vector(n_cols,configs[c].weight_std));
+            }
+            for(int i=0; i < n_samples; i++ ) {
+                if( cv.getFold(i) != f ) {
+                    learner.feedSample(regr[i],ft[i]);
+                }
+            }
+            Vector theta = learner.getParameters();
+
+            Vector sse(6,0.0);
+            int n = 0;
+            for(int i=0; i < n_samples; i++ ) {
+                if( cv.getFold(i) != f ) continue;
+                for(int r=0; r < 6; r++ ) {
+                    double prediction = 0.0;
+                    for(int j=0; j < n_cols; j++ ) {
+                        prediction += regr[i](r,j)*theta[j];
+                    }
+                    sse[r] += (ft[i][r]-prediction)*(ft[i][r]-prediction);
+                }
+                n++;
+            }
+            double rms_force = sqrt((sse[0]+sse[1]+sse[2])/n);
+            double rms_torque = sqrt((sse[3]+sse[4]+sse[5])/n);
+            sum_force += rms_force;
+            sum_torque += rms_torque;
+            sum_sq_force += rms_force*rms_force;
+            sum_sq_torque += rms_torque*rms_torque;
+            for(int r=0; r < 6; r++ ) {
+                normalized_sse += sse[r]/(nominal_noise_std[r]*nominal_noise_std[r]);
+            }
+        }
+        crossValidationScore & score = scores[c];
+        score.config = c;
+        score.rms_force = sum_force/n_folds;
+        score.rms_torque = sum_torque/n_folds;
+        score.sd_rms_force = sqrt(std::max(0.0,sum_sq_force/n_folds-score.rms_force*score.rms_force));
+        score.sd_rms_torque = sqrt(std::max(0.0,sum_sq_torque/n_folds-score.rms_torque*score.rms_torque));
+        score.score = normalized_sse/(6.0*n_samples);
+    }
+}
+
+double relativeError(double a, double b)
+{
+    return fabs(a-b)/std::max(1.0,fabs(b));
+}
+
+//maximum relative error between the scores of evaluate (sorted) and the brute force ones (by configuration)
+double maxScoreError(const std::vector<crossValidationScore> & scores, const std::vector<crossValidationScore> & reference)
+{
+    if( scores.size() != reference.size() ) return HUGE_VAL;
+    double max_error = 0.0;
+    for(size_t i=0; i < scores.size(); i++ ) {
+        const crossValidationScore & s = scores[i];
+        const crossValidationScore & r = reference[s.config];
+        max_error = std::max(max_error,relativeError(s.rms_force,r.rms_force));
+        max_error = std::max(max_error,relativeError(s.rms_torque,r.rms_torque));
+        max_error = std::max(max_error,relativeError(s.sd_rms_force,r.sd_rms_force));
+        max_error = std::max(max_error,relativeError(s.sd_rms_torque,r.sd_rms_torque));
+        max_error = std::max(max_error,relativeError(s.score,r.score));
+    }
+    return max_error;
+}
+
+int main()
+{
+    Network yarp;
+    srand(0);
+
+    //synthetic static dataset: ft = regr*theta + noise
+    Vector nominal_noise_std(6);
+    for(int r=0; r < 6; r++ ) {
+        nominal_noise_std[r] = r < 3 ? 0.5 : 0.05;
+    }
+    Vector theta(n_cols);
+    for(int j=0; j < n_cols; j++ ) {
+        theta[j] = randomDouble(1.0);
+    }
+    std::vector<Matrix> regr(n_samples,Matrix(6,n_cols));
+    std::vector<Vector> ft(n_samples,Vector(6));
+    crossValidation cv(n_folds,n_cols,nominal_noise_std);
+    for(int i=0; i < n_samples; i++ ) {
+        for(int r=0; r < 6; r++ ) {
+            ft[i][r] = nominal_noise_std[r]*randomDouble(1.7);
+            for(int j=0; j < n_cols; j++ ) {
+                //some structural zeros, as in the static regressor
+                regr[i](r,j) = (j+r)%3 == 0 ? 0.0 : randomDouble(2.0);
+                ft[i][r] += regr[i](r,j)*theta[j];
+            }
+        }
+        cv.addSample(i,regr[i].data(),ft[i].data());
+    }
+
+    std::vector<hyperParameters> configs;
+    const double scales[2] = {0.5, 2.0};
+    const double weight_stds[3] = {0.0, 0.1, 10.0};
+    for(int s=0; s < 2; s++ ) {
+        for(int w=0; w < 3; w++ ) {
+            hyperParameters config;
+            config.noise_std = nominal_noise_std;
+            for(int r=0; r < 3; r++ ) {
+                config.noise_std[r] *= scales[s];
+            }
+            config.weight_std = weight_stds[w];
+            config.force_scale = scales[s];
+            config.torque_scale = 1.0;
+            configs.push_back(config);
+        }
+    }
+
+    std::vector<crossValidationScore> reference;
+    bruteForceScores(regr,ft,cv,configs,nominal_noise_std,reference);
+
+    int failures = 0;
+    const int threads[2] = {1, 4};
+    for(int t=0; t < 2; t++ ) {
+        std::vector<crossValidationScore> scores;
+        if( !cv.evaluate(configs,threads[t],scores) ) {
+            std::cout << threads[t] << " threads: evaluate failed" << std::endl;
+            failures++;
+            continue;
+        }
+        double error = maxScoreError(scores,reference);
+        bool ok = error <= tolerance;
+        std::cout << threads[t] << " threads: max relative error with respect to the per fold training " << error
+                  << (ok ? " ok" : " FAILED") << std::endl;
+        if( !ok ) failures++;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -16,6 +16,7 @@
 #include <iCub/learningMachine/IParameterLearner.h>
 #include <iCub/learningMachine/MultiTaskLinearGPRLearner.h>
 #include <iCub/learningMachine/MultiTaskLinearFixedParameters.h>
+#include <iCub/learningMachine/SufficientStatistics.h>
 
 #include <gsl/gsl_math.h>
 
@@ -24,9 +25,22 @@
 #include <cassert>
 #include <algorithm>
 #include <string>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+#include <cstdio>
+#include <cmath>
+
+#ifndef WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 
 #include "MatVetIO.h"
 #include "onlineMean.h"
+#include "crossValidation.h"
+#include "recordedDataset.h"
 
 using namespace iCub::ctrl;
 using namespace yarp::sig;
@@ -37,30 +51,367 @@ using namespace yarp::sig;
 using namespace yarp::math;
 using namespace iCub::learningmachine;
 
-// random generator function:
-ptrdiff_t myrandom (ptrdiff_t i) { return  (ptrdiff_t) yarp::os::Random::uniform(0,(int)i); }
+//true if the sample is used for training, with probability training_percentage
+inline bool isTrainingSample(uint64_t index, uint64_t seed, double training_percentage)
+{
+    return (sampleHash(index,seed) >> 11)*(1.0/9007199254740992.0) < training_percentage;
+}
+
+//number of samples (blocks of 6 rows) read from the files at once
+const int default_batch_samples = 1024;
+
+//dot product of the first n elements of a row with a vector
+inline double rowDot(const double * row, const Vector & vec, int n)
+{
+    double ret = 0.0;
+    for(int c=0; c < n; c++ ) {
+        ret += row[c]*vec[c];
+    }
+    return ret;
+}
+
+//feed the first n_samples samples of the batch buffers to the learners
+void feedTrainingBatch(IParameterLearner * param_learner, IParameterLearner * offset_cad_learner,
+                       const Matrix & regr_batch, const Vector & ft_batch, const Matrix & offset_batch, const Vector & res_batch,
+                       int n_samples)
+{
+    if( n_samples == 0 ) return;
+    if( 6*n_samples == regr_batch.rows() ) {
+        param_learner->feedBatch(regr_batch,ft_batch);
+        offset_cad_learner->feedBatch(offset_batch,res_batch);
+    } else {
+        //last (partial) batch
+        param_learner->feedBatch(regr_batch.submatrix(0,6*n_samples-1,0,regr_batch.cols()-1),ft_batch.subVector(0,6*n_samples-1));
+        offset_cad_learner->feedBatch(offset_batch.submatrix(0,6*n_samples-1,0,5),res_batch.subVector(0,6*n_samples-1));
+    }
+}
+
+//Training: the samples begin_sample ... end_sample-1 of the files are read sequentially, in blocks of
+//batch_samples samples, and the training samples (all if use_all is true) are fed to the learners in batches
+int trainSamples(const MatVetReader & regrReader, const MatVetReader & ftReader, int begin_sample, int end_sample,
+                 bool use_all, uint64_t split_seed, double training_percentage, int batch_samples,
+                 const Vector & cad_static, IParameterLearner * param_learner, IParameterLearner * offset_cad_learner)
+{
+    const int regr_cols = regrReader.cols();
+    const int n_static = regr_cols-6;
+    Matrix regr_batch(6*batch_samples,regr_cols);
+    Vector ft_batch(6*batch_samples);
+    Matrix offset_batch(6*batch_samples,6);
+    Vector res_batch(6*batch_samples);
+    offset_batch.zero();
+    for(int r=0; r < offset_batch.rows(); r++ ) {
+        offset_batch(r,r%6) = 1.0;
+    }
+    
+    int batch_fill = 0;
+    int training_samples = 0;
+    
+    for(int first = begin_sample; first < end_sample; first += batch_samples ) {
+        int n = std::min(batch_samples,end_sample-first);
+        MatVetRowBlock regr_block = regrReader.getRows(6*(int64_t)first,6*n);
+        MatVetRowBlock ft_block = ftReader.getRows(6*(int64_t)first,6*n);
+        for(int k=0; k < n; k++ ) {
+            if( !use_all && !isTrainingSample(first+k,split_seed,training_percentage) ) continue;
+            for(int r=0; r < 6; r++ ) {
+                const double * regr_row = regr_block.row(6*k+r);
+                memcpy(regr_batch[6*batch_fill+r],regr_row,regr_cols*sizeof(double));
+                double FT = ft_block(6*k+r,0);
+                ft_batch[6*batch_fill+r] = FT;
+                res_batch[6*batch_fill+r] = FT-rowDot(regr_row,cad_static,n_static);
+            }
+            batch_fill++;
+            training_samples++;
+            if( batch_fill == batch_samples ) {
+                feedTrainingBatch(param_learner,offset_cad_learner,regr_batch,ft_batch,offset_batch,res_batch,batch_fill);
+                batch_fill = 0;
+            }
+        }
+    }
+    feedTrainingBatch(param_learner,offset_cad_learner,regr_batch,ft_batch,offset_batch,res_batch,batch_fill);
+    return training_samples;
+}
+
+//first sample of a shard, when num_samples samples are split in n_shards contiguous shards
+int shardBegin(int num_samples, int shard, int n_shards)
+{
+    return (int)(((int64_t)num_samples*shard)/n_shards);
+}
+
+//The sufficient statistics of a learner are saved in a matrix with p columns:
+//the p rows of the gram matrix, the rows of the rhs and a last row with the number of samples
+bool writeStatistics(const std::string file_name, const SufficientStatistics & stats)
+{
+    const int p = stats.gram.cols();
+    Matrix packed(p+stats.rhs.rows()+1,p);
+    packed.zero();
+    packed.setSubmatrix(stats.gram,0,0);
+    packed.setSubmatrix(stats.rhs,p,0);
+    packed(packed.rows()-1,0) = stats.sampleCount;
+    return Matrix_write(file_name,packed);
+}
+
+bool readStatistics(const std::string file_name, int p, int m, SufficientStatistics & stats)
+{
+    Matrix packed;
+    if( !Matrix_read(file_name,packed) ) return false;
+    if( packed.cols() != p || packed.rows() != p+m+1 ) {
+        std::cout << "The statistics in " << file_name << " do not match the size of the learner" << std::endl;
+        return false;
+    }
+    stats.reset(p,m);
+    stats.gram = packed.submatrix(0,p-1,0,p-1);
+    stats.rhs = packed.submatrix(p,p+m-1,0,p-1);
+    stats.sampleCount = (int)packed(p+m,0);
+    return true;
+}
+
+bool exportStatistics(const std::string prefix, MultiTaskLinearGPRLearner * param_learner, MultiTaskLinearGPRLearner * offset_cad_learner)
+{
+    SufficientStatistics param_stats, offset_stats;
+    param_learner->getSufficientStatistics(param_stats);
+    offset_cad_learner->getSufficientStatistics(offset_stats);
+    return writeStatistics(prefix+"_param.ymt",param_stats) && writeStatistics(prefix+"_offset.ymt",offset_stats);
+}
+
+bool mergeStatistics(const std::string prefix, MultiTaskLinearGPRLearner * param_learner, MultiTaskLinearGPRLearner * offset_cad_learner)
+{
+    SufficientStatistics param_stats, offset_stats;
+    if( !readStatistics(prefix+"_param.ymt",param_learner->getDomainCols(),1,param_stats) ||
+        !readStatistics(prefix+"_offset.ymt",offset_cad_learner->getDomainCols(),1,offset_stats) ) {
+        return false;
+    }
+    param_learner->mergeSufficientStatistics(param_stats);
+    offset_cad_learner->mergeSufficientStatistics(offset_stats);
+    return true;
+}
 
-// pointer object to it:
-ptrdiff_t (*p_myrandom)(ptrdiff_t) = myrandom;
+//Training in n_processes processes, each on a shard of the samples: the statistics of the shards
+//are exported to temporary files and merged in the learners of this process.
+//Returns the number of training samples, -1 on error
+int trainParallel(int n_processes, const MatVetReader & regrReader, const MatVetReader & ftReader,
+                  bool use_all, uint64_t split_seed, double training_percentage, int batch_samples,
+                  const Vector & cad_static, MultiTaskLinearGPRLearner * param_learner, MultiTaskLinearGPRLearner * offset_cad_learner)
+{
+    const int num_samples = (int)(regrReader.rows()/6);
+#ifdef WIN32
+    std::cout << "The parallel training is not available on this platform, training sequentially" << std::endl;
+    n_processes = 1;
+#endif
+    if( n_processes <= 1 ) {
+        return trainSamples(regrReader,ftReader,0,num_samples,use_all,split_seed,training_percentage,batch_samples,
+                            cad_static,param_learner,offset_cad_learner);
+    }
+#ifndef WIN32
+    char prefix_base[256];
+    sprintf(prefix_base,"offlineInertiaLearner_%d_shard",(int)getpid());
+    std::vector<std::string> prefixes(n_processes);
+    std::vector<pid_t> children(n_processes,-1);
+    bool ok = true;
+
+    //the children inherit the learners (empty, with the prior) and the mapped files
+    std::cout.flush();
+    for(int shard=0; shard < n_processes; shard++ ) {
+        char suffix[16];
+        sprintf(suffix,"%d",shard);
+        prefixes[shard] = std::string(prefix_base)+suffix;
+        children[shard] = fork();
+        if( children[shard] == 0 ) {
+            trainSamples(regrReader,ftReader,shardBegin(num_samples,shard,n_processes),shardBegin(num_samples,shard+1,n_processes),
+                         use_all,split_seed,training_percentage,batch_samples,cad_static,param_learner,offset_cad_learner);
+            bool exported = exportStatistics(prefixes[shard],param_learner,offset_cad_learner);
+            std::cout.flush();
+            _exit(exported ? 0 : 1);
+        } else if( children[shard] < 0 ) {
+            std::cout << "Error in creating the process of shard " << shard << std::endl;
+            ok = false;
+        }
+    }
 
-Vector abs(Vector vec) {
-    for(size_t i = 0; i < vec.size(); i++ ) {
-        vec[i] = fabs(vec[i]);
+    for(int shard=0; shard < n_processes; shard++ ) {
+        if( children[shard] < 0 ) continue;
+        int status = 0;
+        if( waitpid(children[shard],&status,0) != children[shard] || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ) {
+            std::cout << "Error in the training of shard " << shard << std::endl;
+            ok = false;
+        }
+    }
+
+    //the statistics of the shards are merged in the order of the shards
+    for(int shard=0; shard < n_processes && ok; shard++ ) {
+        ok = mergeStatistics(prefixes[shard],param_learner,offset_cad_learner);
+    }
+    for(int shard=0; shard < n_processes; shard++ ) {
+        std::remove((prefixes[shard]+"_param.ymt").c_str());
+        std::remove((prefixes[shard]+"_offset.ymt").c_str());
+    }
+    if( !ok ) return -1;
+
+    SufficientStatistics stats;
+    param_learner->getSufficientStatistics(stats);
+    return stats.sampleCount;
+#else
+    return -1;
+#endif
+}
+
+//check that the regressor and the measure files contain the same number of 6 rows samples
+bool checkDataset(const MatVetReader & regrReader, const MatVetReader & ftReader, int cols)
+{
+    if( regrReader.isVector() || !ftReader.isVector() ) {
+        std::cout << "The regressor file should contain a matrix, and the measure file a vector" << std::endl;
+        return false;
+    }
+    if( regrReader.rows() != ftReader.rows() || regrReader.rows() % 6 != 0 ) {
+        std::cout << "Inconsistent number of rows: " << regrReader.rows() << " in the regressor file, "
+                  << ftReader.rows() << " in the measure file" << std::endl;
+        return false;
+    }
+    if( regrReader.cols() != cols ) {
+        std::cout << "The regressor file has " << regrReader.cols() << " columns instead of " << cols << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//read a list of values (or a single value) from the parameters
+std::vector<double> readValues(Property & params, const char * name, const std::vector<double> & default_values)
+{
+    if( !params.check(name) ) return default_values;
+    std::vector<double> values;
+    Value & value = params.find(name);
+    if( value.isList() ) {
+        for(int i=0; i < value.asList()->size(); i++ ) {
+            values.push_back(value.asList()->get(i).asDouble());
+        }
+    } else {
+        values.push_back(value.asDouble());
+    }
+    return values.size() > 0 ? values : default_values;
+}
+
+//log-uniform random value in the range of the positive values of a list (0 if there are none)
+double randomLogUniform(const std::vector<double> & values)
+{
+    double min_value = 0.0, max_value = 0.0;
+    for(size_t i=0; i < values.size(); i++ ) {
+        if( values[i] <= 0.0 ) continue;
+        if( min_value == 0.0 || values[i] < min_value ) min_value = values[i];
+        if( values[i] > max_value ) max_value = values[i];
+    }
+    if( min_value == 0.0 ) return 0.0;
+    return exp(log(min_value)+Random::uniform()*(log(max_value)-log(min_value)));
+}
+
+//k-fold cross-validation of the hyperparameters of the learner, on a grid or on random configurations
+int crossValidationSweep(Property & params, const MatVetReader & regrReader, const MatVetReader & ftReader,
+                         const Vector & ftStdDev, uint64_t split_seed, int batch_samples)
+{
+    int n_folds = params.find("cv_folds").asInt();
+    if( n_folds < 2 ) {
+        std::cout << "cv_folds should be at least 2, not " << n_folds << std::endl;
+        return 0;
+    }
+    
+    int n_threads = 1;
+    #ifndef WIN32
+    n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    #endif
+    if( params.check("threads") ) {
+        n_threads = params.find("threads").asInt();
+    }
+    if( n_threads < 1 ) n_threads = 1;
+    
+    //the noise standard deviations are the nominal ones scaled, a weight_std <= 0 means no prior on the parameters
+    std::vector<double> default_scales, default_weight_std;
+    default_scales.push_back(0.5);
+    default_scales.push_back(1.0);
+    default_scales.push_back(2.0);
+    default_weight_std.push_back(0.0);
+    default_weight_std.push_back(0.1);
+    default_weight_std.push_back(1.0);
+    default_weight_std.push_back(10.0);
+    std::vector<double> force_scales = readValues(params,"noise_force_scale",default_scales);
+    std::vector<double> torque_scales = readValues(params,"noise_torque_scale",default_scales);
+    std::vector<double> weight_stds = readValues(params,"weight_std",default_weight_std);
+    
+    std::vector<hyperParameters> configs;
+    hyperParameters config;
+    config.noise_std.resize(6);
+    if( params.check("sweep_random") ) {
+        int n_random = params.find("sweep_random").asInt();
+        Random::seed((int)split_seed);
+        for(int i=0; i < n_random; i++ ) {
+            config.force_scale = randomLogUniform(force_scales);
+            config.torque_scale = randomLogUniform(torque_scales);
+            config.weight_std = randomLogUniform(weight_stds);
+            configs.push_back(config);
+        }
+    } else {
+        for(size_t f=0; f < force_scales.size(); f++ ) {
+            for(size_t t=0; t < torque_scales.size(); t++ ) {
+                for(size_t w=0; w < weight_stds.size(); w++ ) {
+                    config.force_scale = force_scales[f];
+                    config.torque_scale = torque_scales[t];
+                    config.weight_std = weight_stds[w];
+                    configs.push_back(config);
+                }
+            }
+        }
+    }
+    for(size_t c=0; c < configs.size(); c++ ) {
+        if( configs[c].force_scale <= 0.0 || configs[c].torque_scale <= 0.0 ) {
+            std::cout << "The noise scales should be positive" << std::endl;
+            return 0;
+        }
+        for(int r=0; r < 6; r++ ) {
+            configs[c].noise_std[r] = ftStdDev[r]*(r < 3 ? configs[c].force_scale : configs[c].torque_scale);
+        }
     }
-    return vec;
+    
+    //a single sequential pass on the dataset, to compute the statistics of the folds
+    const int num_samples = (int)(regrReader.rows()/6);
+    crossValidation cv(n_folds,regrReader.cols(),ftStdDev,split_seed);
+    for(int first = 0; first < num_samples; first += batch_samples ) {
+        int n = std::min(batch_samples,num_samples-first);
+        MatVetRowBlock regr_block = regrReader.getRows(6*(int64_t)first,6*n);
+        MatVetRowBlock ft_block = ftReader.getRows(6*(int64_t)first,6*n);
+        for(int k=0; k < n; k++ ) {
+            cv.addSample(first+k,regr_block.row(6*k),ft_block.row(6*k));
+        }
+    }
+    
+    std::cout << "Cross-validation of " << configs.size() << " configurations on " << n_folds << " folds of "
+              << num_samples << " samples, with " << n_threads << " threads" << std::endl;
+    
+    double start_time = Time::now();
+    std::vector<crossValidationScore> scores;
+    if( !cv.evaluate(configs,n_threads,scores) ) {
+        std::cout << "Some folds are empty, use less folds" << std::endl;
+        return 0;
+    }
+    std::cout << "Evaluated in " << Time::now()-start_time << " s" << std::endl;
+    
+    //table of the configurations, sorted by score (mean squared error normalized by the nominal noise)
+    printf("%4s %12s %12s %12s %12s %12s %12s %12s %12s\n","rank","force_scale","torque_scale","weight_std",
+           "rms_force","sd_force","rms_torque","sd_torque","score");
+    for(size_t i=0; i < scores.size(); i++ ) {
+        const hyperParameters & c = configs[scores[i].config];
+        printf("%4d %12g %12g %12g %12g %12g %12g %12g %12g\n",(int)i+1,c.force_scale,c.torque_scale,c.weight_std,
+               scores[i].rms_force,scores[i].sd_rms_force,scores[i].rms_torque,scores[i].sd_rms_torque,scores[i].score);
+    }
+    return 0;
 }
 
 int main(int argc, char ** argv)
 {   
-    Matrix allRegr;
-    Vector allFT;
+    MatVetReader regrReader, ftReader;
     
     Matrix static_identifiable_parameters;
     Vector cad_parameters;
     
     Vector ftStdDev;
     
-    int num_samples, training_samples;
+    int num_samples, training_samples, testing_samples;
     
     onlineMean<Vector> cad_errors;
     onlineMean<Vector> errors;
@@ -71,6 +422,9 @@ int main(int argc, char ** argv)
     std::string regr_file, cad_param_file, measure_file, identifiable_param_file;
     double training_percentage = 0.5;
     
+    //the split between training and testing samples depends only on the index of the sample and on this seed
+    uint64_t split_seed = 0;
+    int batch_samples = default_batch_samples;
     
     bool set_weight_prior = false;
     bool set_noise_scaling = true;
@@ -97,6 +451,15 @@ int main(int argc, char ** argv)
     
     if( params.check("help") ) {
         std::cout << "Run in directory with data produced by inertiaObserver --dump_static" << std::endl;
+        std::cout << "--lmds file (and --validation_lmds file) uses a dataset recorded by inertiaObserver --record_dataset," << std::endl;
+        std::cout << "  converted to file_regr.ymt and file_measure.yvc, instead of --regr and --measure" << std::endl;
+        std::cout << "--cv_folds k runs the k-fold cross-validation of the learner hyperparameters, on the grid (or with --sweep_random n" << std::endl;
+        std::cout << "  on n random configurations in the range) of --noise_force_scale, --noise_torque_scale and --weight_std (lists)," << std::endl;
+        std::cout << "  using --threads threads" << std::endl;
+        std::cout << "--parallel n fits n shards of the dataset in n processes, and merges their statistics" << std::endl;
+        std::cout << "--export_stats prefix fits only the shard --shard i of --shards n, and saves the statistics in prefix_param.ymt and prefix_offset.ymt" << std::endl;
+        std::cout << "--merge_stats (prefix1 prefix2 ...) merges the saved statistics instead of training, then tests" << std::endl;
+        std::cout << "  (use the same --split_seed, --training and learner options when exporting and merging)" << std::endl;
         std::cout << "for other options, check the source code :-) " << std::endl;
         return 0;
     }
@@ -121,7 +484,7 @@ int main(int argc, char ** argv)
     
     if( params.check("cad_param" ) ) {
         std::cout << "Found cad_param parameter" << std::endl;
-        regr_file = params.find("cad_param").asString();
+        cad_param_file = params.find("cad_param").asString();
     }
     
     if( params.check("identifiable_param" ) ) {
@@ -140,28 +503,63 @@ int main(int argc, char ** argv)
         }
     }
     
+    if( params.check("split_seed") ) {
+        std::cout << "Found split_seed parameter" << std::endl; 
+        split_seed = (uint64_t)params.find("split_seed").asInt();
+    }
+    
+    if( params.check("batch") ) {
+        std::cout << "Found batch parameter" << std::endl; 
+        int batch = params.find("batch").asInt();
+        if( batch > 0 ) {
+            batch_samples = batch;
+        } else {
+            std::cout << "batch should be a positive number of samples, not " << batch << std::endl;
+        }
+    }
+    
     std::string validation_regr_file, validation_measure_file;
     
-    Matrix allRegr_validation;
-    Vector allFT_validation;
+    MatVetReader regrReader_validation, ftReader_validation;
     
     if( params.check("validation_regr") || params.check("validation_measure") ) {
         using_different_set_for_validation = true;
         validation_regr_file  = params.find("validation_regr").asString();
         validation_measure_file = params.find("validation_measure").asString();
     }
+    
+    //the datasets recorded by inertiaObserver --record_dataset are converted to a regressor and a measure file
+    const char * lmds_options[2] = {"lmds", "validation_lmds"};
+    for(int i=0; i < 2; i++ ) {
+        if( !params.check(lmds_options[i]) ) continue;
+        std::string lmds_file = params.find(lmds_options[i]).asString().c_str();
+        std::string & converted_regr_file = i == 0 ? regr_file : validation_regr_file;
+        std::string & converted_measure_file = i == 0 ? measure_file : validation_measure_file;
+        converted_regr_file = convertedDatasetName(lmds_file,false);
+        converted_measure_file = convertedDatasetName(lmds_file,true);
+        int converted = convertRecordedDataset(lmds_file,converted_regr_file,converted_measure_file);
+        if( converted < 0 ) {
+            std::cout << "Input error " << std::endl;
+            return 0;
+        }
+        std::cout << "Converted " << converted << " samples of " << lmds_file << " in " << converted_regr_file
+                  << " and " << converted_measure_file << std::endl;
+        if( i == 1 ) {
+            using_different_set_for_validation = true;
+        }
+    }
 
     
 
     bool res = true;
-    res &= Matrix_read(regr_file,allRegr);
-    res &= Vector_read(measure_file,allFT);
+    res &= regrReader.open(regr_file);
+    res &= ftReader.open(measure_file);
     res &= Matrix_read(identifiable_param_file,static_identifiable_parameters);
     res &= Vector_read(cad_param_file,cad_parameters);
     
     if( using_different_set_for_validation ) { 
-        res &= Matrix_read(validation_regr_file,allRegr_validation);
-        res &= Vector_read(validation_measure_file,allFT_validation);
+        res &= regrReader_validation.open(validation_regr_file);
+        res &= ftReader_validation.open(validation_measure_file);
     }
 
     if( !res ) {
@@ -169,24 +567,28 @@ int main(int argc, char ** argv)
         return 0;
     }
 
-    assert(allRegr.rows() == (int)allFT.size());
-    
-    num_samples = allRegr.rows()/6;
+    const int regr_cols = static_identifiable_parameters.cols()+6;
     
-    if( !using_different_set_for_validation ) { 
-        training_samples = (int)(training_percentage*(double)num_samples);
-    } else {
-        training_samples = num_samples;
+    if( !checkDataset(regrReader,ftReader,regr_cols) || 
+        (using_different_set_for_validation && !checkDataset(regrReader_validation,ftReader_validation,regr_cols)) ) {
+        std::cout << "Input error " << std::endl;
+        return 0;
     }
     
-    std::cout << "Read " << allRegr.rows()/6 << " data samples " << std::endl;
+    num_samples = (int)(regrReader.rows()/6);
+    
+    std::cout << "Read " << num_samples << " data samples " << std::endl;
+    
+    if( params.check("cv_folds") ) {
+        return crossValidationSweep(params,regrReader,ftReader,ftStdDev,split_seed,batch_samples);
+    }
     
     
 
-    IParameterLearner * param_learner, * offset_cad_learner ;
+    MultiTaskLinearGPRLearner * param_learner, * offset_cad_learner ;
             
     //~~~~~~~~~~~
-    param_learner = new MultiTaskLinearGPRLearner(allRegr.cols(),6);
+    param_learner = new MultiTaskLinearGPRLearner(regr_cols,6);
     param_learner->setName("RLS");
     if( set_weight_prior ) {
         param_learner->setNoiseStandardDeviation(ftStdDev);
@@ -201,38 +603,63 @@ int main(int argc, char ** argv)
     if( set_noise_scaling ) {
         offset_cad_learner->setNoiseStandardDeviation(ftStdDev);
     }
-
-    size_t i;
-    
-    yarp::os::Random::seed(yarp::os::Time::now());
-    
-    std::vector<int> validation_samples;
-    
-    std::vector<int> scrambled_indexes;
-    
-    int l;
-    for(l = 0; l < num_samples; l++ ) { scrambled_indexes.push_back(l); }
     
-    std::random_shuffle ( scrambled_indexes.begin(), scrambled_indexes.end(), p_myrandom);
+    //the FT predicted with the CAD parameters, without offset, is regr_no_offset*cad_static
+    const int n_static = static_identifiable_parameters.cols();
+    Vector cad_static = static_identifiable_parameters.transposed()*cad_parameters;
     
-    for(l = 0; l < training_samples; l++ ) {
-        i = scrambled_indexes[l];
-        //std::cout << "~~~~~~~~~~~~~~~~ I " << i << std::endl;
-        Matrix regr, regr_no_offset;
-        Vector FT;
-        regr = allRegr.submatrix(6*i,6*i+6-1,0,allRegr.cols()-1);
-        FT = allFT.subVector(6*i,6*i+6-1);
-        regr_no_offset = regr.submatrix(0,regr.rows()-1,0,regr.cols()-1-6);
-        
-        //std::cout << "FT " << FT.toString() << std::endl;
-        //std::cout << "regr " << regr.toString() << std::endl;
-        
-        //training
-        param_learner->feedSample(regr,FT);
-        Vector FTcad = regr_no_offset*static_identifiable_parameters.transposed()*cad_parameters;
-        Vector res = FT-FTcad;
-        offset_cad_learner->feedSample(eye(6,6),res);
-
+    //~~~~~~~~~~~
+    //Training: sequentially in this process, in parallel processes on shards of the dataset,
+    //or merging the statistics of shards fitted elsewhere
+    if( params.check("export_stats") ) {
+        //fit a shard and save the statistics of the learners, to be merged with merge_stats
+        int n_shards = params.check("shards") ? params.find("shards").asInt() : 1;
+        int shard = params.check("shard") ? params.find("shard").asInt() : 0;
+        if( n_shards < 1 || shard < 0 || shard >= n_shards ) {
+            std::cout << "shard should be between 0 and shards-1" << std::endl;
+            return 0;
+        }
+        std::string prefix = params.find("export_stats").asString().c_str();
+        training_samples = trainSamples(regrReader,ftReader,shardBegin(num_samples,shard,n_shards),shardBegin(num_samples,shard+1,n_shards),
+                                        using_different_set_for_validation,split_seed,training_percentage,batch_samples,
+                                        cad_static,param_learner,offset_cad_learner);
+        if( !exportStatistics(prefix,param_learner,offset_cad_learner) ) {
+            std::cout << "Error in saving the statistics with prefix " << prefix << std::endl;
+            return 0;
+        }
+        std::cout << "Saved the statistics of " << training_samples << " training samples of shard " << shard << " of " << n_shards << std::endl;
+        return 0;
+    } else if( params.check("merge_stats") ) {
+        Value & prefixes = params.find("merge_stats");
+        std::vector<std::string> prefix_list;
+        if( prefixes.isList() ) {
+            for(int k=0; k < prefixes.asList()->size(); k++ ) {
+                prefix_list.push_back(prefixes.asList()->get(k).asString().c_str());
+            }
+        } else {
+            prefix_list.push_back(prefixes.asString().c_str());
+        }
+        for(size_t k=0; k < prefix_list.size(); k++ ) {
+            if( !mergeStatistics(prefix_list[k],param_learner,offset_cad_learner) ) {
+                std::cout << "Error in merging the statistics with prefix " << prefix_list[k] << std::endl;
+                return 0;
+            }
+        }
+        SufficientStatistics stats;
+        param_learner->getSufficientStatistics(stats);
+        training_samples = stats.sampleCount;
+    } else if( params.check("parallel") ) {
+        training_samples = trainParallel(params.find("parallel").asInt(),regrReader,ftReader,
+                                         using_different_set_for_validation,split_seed,training_percentage,batch_samples,
+                                         cad_static,param_learner,offset_cad_learner);
+        if( training_samples < 0 ) {
+            std::cout << "Error in the parallel training" << std::endl;
+            return 0;
+        }
+    } else {
+        training_samples = trainSamples(regrReader,ftReader,0,num_samples,
+                                        using_different_set_for_validation,split_seed,training_percentage,batch_samples,
+                                        cad_static,param_learner,offset_cad_learner);
     }
     
     std::cout << "Using " << training_samples  << " for training " << std::endl;
@@ -240,69 +667,61 @@ int main(int argc, char ** argv)
     if( !using_different_set_for_validation ) {
         std::cout << "Using " << num_samples - training_samples << " for testing  " << std::endl;
     } else {
-        std::cout << "Using " << allFT_validation.size()/6 << " for validation " << std::endl;
+        std::cout << "Using " << regrReader_validation.rows()/6 << " for validation " << std::endl;
     }
 
     Vector offset_cad = offset_cad_learner->getParameters();
     Vector learned_param = param_learner->getParameters();
     
+    //~~~~~~~~~~~
+    //Testing: a second sequential pass, on the testing samples or on the validation files
+    const MatVetReader & testRegrReader = using_different_set_for_validation ? regrReader_validation : regrReader;
+    const MatVetReader & testFtReader = using_different_set_for_validation ? ftReader_validation : ftReader;
+    const int test_samples = (int)(testRegrReader.rows()/6);
     
     if( !using_different_set_for_validation ) { 
         std::cout << "Using right branch" << std::endl;
-        for( ; l < num_samples ; l++ ) {
-            i = scrambled_indexes[l];
-            
-            Prediction pred;
-            Matrix regr, regr_no_offset;
-            Vector FT, predFT, predFTCAD;
-            Vector F,T, predF,predT,predFCAD,predTCAD;
-            regr = allRegr.submatrix(6*i,6*i+6-1,0,allRegr.cols()-1);
-            regr_no_offset = regr.submatrix(0,regr.rows()-1,0,regr.cols()-1-6);
-            FT = allFT.subVector(6*i,6*i+6-1);
-            
-            F = FT.subVector(0,2);
-            T = FT.subVector(3,5);
-            
-            pred = param_learner->predict(regr);
-            predFT = pred.getPrediction();
-            predF = predFT.subVector(0,2);
-            predT = predFT.subVector(3,5);
-            
-            predFTCAD = regr_no_offset*static_identifiable_parameters.transposed()*cad_parameters + offset_cad;
-            predFCAD = predFTCAD.subVector(0,2);
-            predTCAD = predFTCAD.subVector(3,5);
-            
+    }
+    
+    Vector FT(6), predFT(6), predFTCAD(6);
+    Vector err(6), cad_err(6);
+    Vector err_norms(2), cad_err_norms(2);
+    testing_samples = 0;
+    
+    for(int first = 0; first < test_samples; first += batch_samples ) {
+        int n = std::min(batch_samples,test_samples-first);
+        MatVetRowBlock regr_block = testRegrReader.getRows(6*(int64_t)first,6*n);
+        MatVetRowBlock ft_block = testFtReader.getRows(6*(int64_t)first,6*n);
+        for(int k=0; k < n; k++ ) {
+            if( !using_different_set_for_validation && isTrainingSample(first+k,split_seed,training_percentage) ) continue;
+            for(int r=0; r < 6; r++ ) {
+                const double * regr_row = regr_block.row(6*k+r);
+                FT[r] = ft_block(6*k+r,0);
+                predFT[r] = rowDot(regr_row,learned_param,regr_cols);
+                predFTCAD[r] = rowDot(regr_row,cad_static,n_static) + offset_cad[r];
+                err[r] = fabs(predFT[r]-FT[r]);
+                cad_err[r] = fabs(predFTCAD[r]-FT[r]);
+            }
             
-            errors.feedSample(abs(predFT-FT));
-            cad_errors.feedSample(abs(predFTCAD-FT));
+            errors.feedSample(err);
+            cad_errors.feedSample(cad_err);
             
-            Vector err_norms(2), cad_err_norms(2);
-            err_norms[0] = norm(predF-F);
-            err_norms[1] = norm(predT-T);
+            //norms of the force and torque errors
+            err_norms[0] = sqrt(err[0]*err[0]+err[1]*err[1]+err[2]*err[2]);
+            err_norms[1] = sqrt(err[3]*err[3]+err[4]*err[4]+err[5]*err[5]);
             
-            cad_err_norms[0] = norm(predFCAD-F);   
-            cad_err_norms[1] = norm(predTCAD-T);
+            cad_err_norms[0] = sqrt(cad_err[0]*cad_err[0]+cad_err[1]*cad_err[1]+cad_err[2]*cad_err[2]);
+            cad_err_norms[1] = sqrt(cad_err[3]*cad_err[3]+cad_err[4]*cad_err[4]+cad_err[5]*cad_err[5]);
 
             errors_norms.feedSample(err_norms);
             cad_errors_norms.feedSample(cad_err_norms);
+            testing_samples++;
         }
-    } else {
-        for(i = 0; i < allFT_validation.size()/6; i++ ) {
-            Prediction pred;
-            Matrix regr, regr_no_offset;
-            Vector FT, predFT, predFTCAD;
-            regr = allRegr_validation.submatrix(6*i,6*i+6-1,0,allRegr.cols()-1);
-            regr_no_offset = regr.submatrix(0,regr.rows()-1,0,regr.cols()-1-6);
-            FT = allFT_validation.subVector(6*i,6*i+6-1);
-            
-            pred = param_learner->predict(regr);
-            predFT = pred.getPrediction();
-            
-            predFTCAD = regr_no_offset*static_identifiable_parameters.transposed()*cad_parameters + offset_cad;
-            
-            errors.feedSample(abs(predFT-FT));
-            cad_errors.feedSample(abs(predFTCAD-FT));
-        }
+    }
+    
+    if( testing_samples == 0 ) {
+        std::cout << "No samples for testing " << std::endl;
+        return 0;
     }
     
     Vector errors_force = errors.getMean().subVector(0,2);
@@ -341,6 +760,3 @@ int main(int argc, char ** argv)
     } 
     return 0;
 }
-
-
-
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include "recordedDataset.h"
+
+#include <iCub/learningMachine/DatasetReader.h>
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+
+#include "MatVetIO.h"
+
+using namespace iCub::learningmachine;
+
+std::string convertedDatasetName(const std::string & lmds_file, bool measure)
+{
+    std::string base = lmds_file;
+    const std::string extension = ".lmds";
+    if( base.size() > extension.size() && base.compare(base.size()-extension.size(),extension.size(),extension) == 0 ) {
+        base.erase(base.size()-extension.size());
+    }
+    return base + (measure ? "_measure.yvc" : "_regr.ymt");
+}
+
+int convertRecordedDataset(const std::string & lmds_file, const std::string & regr_file, const std::string & measure_file)
+{
+    DatasetReader reader;
+    try {
+        reader.open(lmds_file);
+    } catch(const std::runtime_error & e) {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+    const std::vector<int> & groups = reader.getGroups();
+    if( groups.size() != 4 || groups[0] != 1 || groups[1] != 1 || groups[3] != 6 || groups[2] == 0 || groups[2] % 6 != 0 ) {
+        std::cout << lmds_file << " does not contain the samples of an F/T sensor (6 x n regressor and 6 measures)" << std::endl;
+        return -1;
+    }
+    const int cols = groups[2]/6;
+
+    MatVetWriter regrWriter, ftWriter;
+    if( !regrWriter.open(regr_file,cols) || !ftWriter.open(measure_file,1,true) ) {
+        std::cout << "Could not create " << regr_file << " and " << measure_file << std::endl;
+        return -1;
+    }
+    std::vector<double> record(reader.getColumns());
+    const double * regr = &record[2];
+    const double * ft = &record[2+6*cols];
+    int n_samples = 0;
+    bool ok = true;
+    while( ok && reader.read(&record[0]) ) {
+        for(int r=0; r < 6; r++ ) {
+            ok = ok && regrWriter.appendRow(regr+r*cols) && ftWriter.appendRow(ft+r);
+        }
+        n_samples++;
+    }
+    ok = regrWriter.close() && ok;
+    ok = ftWriter.close() && ok;
+    if( !ok ) {
+        std::cout << "Error in writing " << regr_file << " and " << measure_file << std::endl;
+        return -1;
+    }
+    return n_samples;
+}
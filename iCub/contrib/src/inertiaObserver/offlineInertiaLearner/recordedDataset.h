@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef RECORDED_DATASET
+#define RECORDED_DATASET
+
+#include <string>
+
+/**
+ * Name of the regressor (.ymt) or measure (.yvc) file converted from a dataset recorded by
+ * inertiaObserver --record_dataset: the name of the recorded file without the .lmds extension,
+ * followed by _regr.ymt or _measure.yvc
+ */
+std::string convertedDatasetName(const std::string & lmds_file, bool measure);
+
+/**
+ * Convert a dataset recorded by inertiaObserver --record_dataset (binary records of a
+ * MatrixDatasetRecorder: time, source, the 6 x n regressor in row major order and the 6 FT measures)
+ * to a regressor file with n columns and a measure file, 6 rows for each sample, as the ones
+ * of inertiaObserver --dump_static. The records are converted one at a time.
+ * @return the number of converted samples, -1 on error
+ */
+int convertRecordedDataset(const std::string & lmds_file, const std::string & regr_file, const std::string & measure_file);
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+//
+// Round trip check of the binary datasets recorded by inertiaObserver --record_dataset:
+// records with the layout of the MatrixDatasetRecorder (time, source, 6 x n regressor
+// and 6 measures) are written by a DatasetWriter, synchronously and with the background
+// thread (with many handoffs), then appended to after reopening the file. The records
+// dropped by the background thread when its buffers are full are not expected back.
+// The header (groups and names) and the records read back by the DatasetReader must be
+// the written ones, appending with a different layout must be refused, and the regressor
+// and measure files obtained by convertRecordedDataset must contain the same samples.
+// Exits with 1 if a check fails.
+//
+
+#include <yarp/os/Network.h>
+
+#include <iCub/learningMachine/DatasetWriter.h>
+#include <iCub/learningMachine/DatasetReader.h>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdio>
+
+#include "MatVetIO.h"
+#include "recordedDataset.h"
+
+using namespace yarp::os;
+using namespace iCub::learningmachine;
+
+const int n_cols = 9;
+const int n_first = 100;
+const int n_appended = 37;
+const int flush_size = 7;
+
+double randomDouble(double range)
+{
+    return range*(2.0*rand()/RAND_MAX-1.0);
+}
+
+bool check(const std::string & what, bool ok)
+{
+    std::cout << what << (ok ? " ok" : " FAILED") << std::endl;
+    return ok;
+}
+
+//write n_records records of the layout of groups, returning the values of the records
+//that have not been dropped and counting the dropped ones
+bool writeRecords(const std::string & file_name, bool async, const std::vector<int> & groups, const std::vector<std::string> & names,
+                  int n_records, std::vector<double> & written, int & dropped)
+{
+    int columns = 0;
+    for(size_t g=0; g < groups.size(); g++ ) {
+        columns += groups[g];
+    }
+    DatasetWriter writer(true,8,async,flush_size,0.0);
+    try {
+        writer.open(file_name,groups,names);
+    } catch(const std::runtime_error & e) {
+        std::cout << e.what() << std::endl;
+        return false;
+    }
+    std::vector<double> record(columns);
+    for(int i=0; i < n_records; i++ ) {
+        record[0] = 0.01*i;
+        record[1] = 1.0;
+        for(int c=2; c < columns; c++ ) {
+            record[c] = randomDouble(10.0);
+        }
+        const int dropped_before = writer.getDroppedCount();
+        writer.write(&record[0]);
+        written.insert(written.end(),record.begin(),record.end());
+        //the dropped records are the last ones of the buffer handed over by this write
+        const int n_dropped = writer.getDroppedCount()-dropped_before;
+        written.resize(written.size()-n_dropped*columns);
+        dropped += n_dropped;
+    }
+    writer.close();
+    return true;
+}
+
+int main()
+{
+    Network yarp;
+    srand(0);
+    int failures = 0;
+
+    std::vector<int> groups(4);
+    groups[0] = 1;
+    groups[1] = 1;
+    groups[2] = 6*n_cols;
+    groups[3] = 6;
+    //the last names are missing, and are stored empty
+    std::vector<std::string> names;
+    names.push_back("time");
+    names.push_back("source");
+    for(int i=0; i < 6*n_cols; i++ ) {
+        std::ostringstream name;
+        name << "phi_" << i/n_cols << "_" << i%n_cols;
+        names.push_back(name.str());
+    }
+
+    for(int a=0; a < 2; a++ ) {
+        const bool async = a == 1;
+        const std::string mode = async ? "async: " : "sync: ";
+        const std::string file_name = async ? "recordedDatasetCheck_async.lmds" : "recordedDatasetCheck_sync.lmds";
+        std::remove(file_name.c_str());
+
+        std::vector<double> written;
+        int dropped = 0;
+        bool ok = writeRecords(file_name,async,groups,names,n_first,written,dropped) &&
+                  writeRecords(file_name,async,groups,names,n_appended,written,dropped);
+        if( !check(mode+"writing and appending",ok) ) {
+            failures++;
+            continue;
+        }
+        const int n_written = n_first+n_appended-dropped;
+        std::cout << mode << dropped << " records dropped by the writer" << std::endl;
+        if( !async && !check(mode+"no records dropped",dropped == 0) ) failures++;
+
+        //appending with a different layout is refused
+        std::vector<int> other_groups(groups);
+        other_groups[2] = 6*(n_cols+1);
+        std::vector<double> not_written;
+        int not_dropped = 0;
+        if( !check(mode+"different layout refused",!writeRecords(file_name,async,other_groups,names,1,not_written,not_dropped)) ) failures++;
+
+        DatasetReader reader;
+        try {
+            reader.open(file_name);
+        } catch(const std::runtime_error & e) {
+            std::cout << e.what() << std::endl;
+        }
+        bool header_ok = reader.isOpen() && reader.getGroups() == groups && reader.getColumns() == 6*n_cols+8 &&
+                         (int)reader.getNames().size() == reader.getColumns();
+        for(int i=0; header_ok && i < reader.getColumns(); i++ ) {
+            header_ok = reader.getNames()[i] == (i < (int)names.size() ? names[i] : std::string(""));
+        }
+        if( !check(mode+"header",header_ok) ) {
+            failures++;
+            continue;
+        }
+
+        std::vector<double> record(reader.getColumns());
+        int n_read = 0;
+        bool records_ok = true;
+        while( reader.read(&record[0]) ) {
+            for(int c=0; c < reader.getColumns(); c++ ) {
+                records_ok = records_ok && (size_t)(n_read*reader.getColumns()+c) < written.size() &&
+                             record[c] == written[n_read*reader.getColumns()+c];
+            }
+            n_read++;
+        }
+        std::cout << mode << n_read << " records read back" << std::endl;
+        if( !check(mode+"records",records_ok && n_read == n_written) ) failures++;
+        reader.close();
+
+        //conversion for offlineInertiaLearner
+        const std::string regr_file = convertedDatasetName(file_name,false);
+        const std::string measure_file = convertedDatasetName(file_name,true);
+        bool converted_ok = convertRecordedDataset(file_name,regr_file,measure_file) == n_written;
+        MatVetReader regrReader, ftReader;
+        converted_ok = converted_ok && regrReader.open(regr_file) && ftReader.open(measure_file) &&
+                       regrReader.cols() == n_cols && regrReader.rows() == 6*n_read && ftReader.isVector() && ftReader.rows() == 6*n_read;
+        if( converted_ok ) {
+            MatVetRowBlock regr_block = regrReader.getRows(0,6*n_read);
+            MatVetRowBlock ft_block = ftReader.getRows(0,6*n_read);
+            const int columns = 6*n_cols+8;
+            for(int k=0; k < n_read; k++ ) {
+                for(int r=0; r < 6; r++ ) {
+                    for(int c=0; c < n_cols; c++ ) {
+                        converted_ok = converted_ok && regr_block(6*k+r,c) == written[k*columns+2+r*n_cols+c];
+                    }
+                    converted_ok = converted_ok && ft_block(6*k+r,0) == written[k*columns+2+6*n_cols+r];
+                }
+            }
+        }
+        if( !check(mode+"conversion to regressor and measure files",converted_ok) ) failures++;
+        regrReader.close();
+        ftReader.close();
+
+        std::remove(file_name.c_str());
+        std::remove(regr_file.c_str());
+        std::remove(measure_file.c_str());
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+//
+// Check of onlineMean::merge: a stream of random samples (double, Vector with
+// the full covariance and Matrix) is split in parts of different sizes (empty,
+// of a single sample, large), each part is fed to its own onlineMean and the
+// parts are merged, in order and as a tree. Mean, variance, covariance, minimum,
+// maximum and number of samples must be the ones of a single pass on the stream.
+// Merging a part without the covariance must drop it.
+// Exits with 1 if a check fails.
+//
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+#include "onlineMean.h"
+
+using namespace yarp::sig;
+
+const int n_samples = 1000;
+const double tolerance = 1e-10;
+//the stream is split before these samples
+const int n_splits = 5;
+const int splits[n_splits] = {0, 0, 1, 300, 999};
+
+double randomDouble(double range)
+{
+    return range*(2.0*rand()/RAND_MAX-1.0);
+}
+
+//random samples with an offset, so that the mean is far from zero
+void randomSample(double & x) { x = 100.0+randomDouble(1.0); }
+void randomSample(Vector & x) { for(size_t i=0; i < x.size(); i++ ) x[i] = 10.0*i+randomDouble(1.0+i); }
+void randomSample(Matrix & x) { for(int r=0; r < x.rows(); r++ ) for(int c=0; c < x.cols(); c++ ) x(r,c) = r-c+randomDouble(2.0); }
+
+//maximum relative difference of the elements
+double relativeDifference(const double * a, const double * b, size_t n)
+{
+    double max_diff = 0.0;
+    for(size_t i=0; i < n; i++ ) {
+        max_diff = std::max(max_diff,fabs(a[i]-b[i])/std::max(1.0,fabs(b[i])));
+    }
+    return max_diff;
+}
+
+template <class T>
+double statisticsDifference(const onlineMean<T> & a, const onlineMean<T> & b)
+{
+    typedef onlineMeanTraits<T> traits;
+    if( a.getSampleNum() != b.getSampleNum() || a.hasCovariance() != b.hasCovariance() ) return HUGE_VAL;
+    const size_t n = traits::size(b.getMean());
+    if( traits::size(a.getMean()) != n ) return HUGE_VAL;
+    T var_a = a.getVariance(), var_b = b.getVariance();
+    double diff = relativeDifference(traits::data(a.getMean()),traits::data(b.getMean()),n);
+    diff = std::max(diff,relativeDifference(traits::data(var_a),traits::data(var_b),n));
+    //minimum and maximum are samples, they must be exactly the same
+    for(size_t i=0; i < n; i++ ) {
+        if( traits::data(a.getMin())[i] != traits::data(b.getMin())[i] ) return HUGE_VAL;
+        if( traits::data(a.getMax())[i] != traits::data(b.getMax())[i] ) return HUGE_VAL;
+    }
+    if( b.hasCovariance() ) {
+        Matrix cov_a = a.getCovariance(), cov_b = b.getCovariance();
+        diff = std::max(diff,relativeDifference(cov_a.data(),cov_b.data(),n*n));
+    }
+    return diff;
+}
+
+bool check(const std::string & what, double error)
+{
+    bool ok = error <= tolerance;
+    std::cout << what << ": max relative error " << error << (ok ? " ok" : " FAILED") << std::endl;
+    return ok;
+}
+
+//single pass and merge of the parts, in order and as a tree
+template <class T>
+int checkMerge(const std::string & name, const T & like, bool full_covariance)
+{
+    std::vector<T> samples(n_samples,like);
+    for(int i=0; i < n_samples; i++ ) {
+        randomSample(samples[i]);
+    }
+
+    onlineMean<T> single_pass(full_covariance);
+    for(int i=0; i < n_samples; i++ ) {
+        single_pass.feedSample(samples[i]);
+    }
+
+    std::vector<onlineMean<T> > parts(n_splits+1,onlineMean<T>(full_covariance));
+    for(int p=0; p <= n_splits; p++ ) {
+        const int first = p == 0 ? 0 : splits[p-1];
+        const int last = p == n_splits ? n_samples : splits[p];
+        for(int i=first; i < last; i++ ) {
+            parts[p].feedSample(samples[i]);
+        }
+    }
+
+    onlineMean<T> in_order(full_covariance);
+    for(int p=0; p <= n_splits; p++ ) {
+        in_order.merge(parts[p]);
+    }
+
+    std::vector<onlineMean<T> > tree(parts);
+    for(size_t step=1; step < tree.size(); step *= 2 ) {
+        for(size_t p=0; p+step < tree.size(); p += 2*step ) {
+            tree[p].merge(tree[p+step]);
+        }
+    }
+
+    int failures = 0;
+    if( !check(name+" merge in order",statisticsDifference(in_order,single_pass)) ) failures++;
+    if( !check(name+" merge as a tree",statisticsDifference(tree[0],single_pass)) ) failures++;
+
+    if( full_covariance ) {
+        onlineMean<T> without_covariance(false);
+        without_covariance.feedSample(samples[0]);
+        onlineMean<T> merged = in_order;
+        merged.merge(without_covariance);
+        bool ok = !merged.hasCovariance() && merged.getSampleNum() == (unsigned int)n_samples+1;
+        std::cout << name << " covariance dropped by a merge without it" << (ok ? " ok" : " FAILED") << std::endl;
+        if( !ok ) failures++;
+    }
+    return failures;
+}
+
+int main()
+{
+    srand(0);
+    int failures = 0;
+
+    failures += checkMerge("double",0.0,false);
+    failures += checkMerge("Vector",Vector(4),true);
+    failures += checkMerge("Matrix",Matrix(2,3),true);
+    failures += checkMerge("Vector without covariance",Vector(4),false);
+
+    return failures ? 1 : 0;
+}
@@ -1,124 +1,365 @@
 #include "MatVetIO.h"
 #include <cstdio>
-#include <gsl/gsl_vector.h>
-#include <gsl/gsl_matrix.h>
-#include <stdint.h>
+#include <cstring>
+#include <cassert>
+#include <iostream>
+#include <algorithm>
 
-bool Vector_write(const std::string file_name, const yarp::sig::Vector & vec)
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//the header must have the size written in the documentation of the format
+typedef char MatVetHeaderSizeCheck[sizeof(MatVetHeader) == 64 ? 1 : -1];
+
+static const char MATVETIO_MAGIC[4] = {'M','V','I','O'};
+
+static void initHeader(MatVetHeader & header, uint32_t type, uint32_t cols, uint32_t chunk_rows)
+{
+    memset(&header,0,sizeof(MatVetHeader));
+    memcpy(header.magic,MATVETIO_MAGIC,4);
+    header.version = MATVETIO_VERSION;
+    header.type = type;
+    header.cols = cols;
+    header.rows = 0;
+    header.chunk_rows = chunk_rows;
+    header.data_offset = sizeof(MatVetHeader);
+}
+
+static bool isMatVetHeader(const MatVetHeader & header)
+{
+    return memcmp(header.magic,MATVETIO_MAGIC,4) == 0;
+}
+
+void MatVetRowBlock::toMatrix(yarp::sig::Matrix & mat) const
+{
+    if( mat.rows() != rows || mat.cols() != cols ) {
+        mat.resize(rows,cols);
+    }
+    for(int i=0; i < rows; i++ ) {
+        memcpy(mat[i],row(i),cols*sizeof(double));
+    }
+}
+
+void MatVetRowBlock::toVector(yarp::sig::Vector & vec) const
 {
-    FILE * fp;
-    uint32_t len;
-    double elem;
-    
-    len = vec.size();
-    
-    fp = fopen(file_name.c_str(),"wb");
-    if( fp == NULL ) return false;
-    
-    fwrite(&len,sizeof(uint32_t),1,fp);
-    
-    for(size_t i=0;i<len;i++) { 
-        elem = vec[i];
-        fwrite(&elem,sizeof(double),1,fp);
-    }
-    
-    /*
-    if( gsl_vector_fwrite(fp,(gsl_vector *)vec.getGslVector()) == GSL_EFAILED ) {
-        fclose(fp);
+    const size_t n = (size_t)rows*cols;
+    if( vec.size() != n ) {
+        vec.resize(n);
+    }
+    if( n > 0 ) {
+        memcpy(vec.data(),data,n*sizeof(double));
+    }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+MatVetReader::MatVetReader() : opened(false), data(0), n_rows(0), n_cols(0), type(MATVETIO_MATRIX), version(0), map_address(0), map_length(0)
+{
+}
+
+MatVetReader::~MatVetReader()
+{
+    close();
+}
+
+void MatVetReader::close()
+{
+#ifndef WIN32
+    if( map_address != 0 ) {
+        munmap(map_address,map_length);
+    }
+#endif
+    map_address = 0;
+    map_length = 0;
+    buffer.clear();
+    data = 0;
+    n_rows = 0;
+    n_cols = 0;
+    version = 0;
+    opened = false;
+}
+
+bool MatVetReader::open(const std::string file_name)
+{
+    close();
+
+    FILE * fp = fopen(file_name.c_str(),"rb");
+    if( fp == NULL ) {
+        std::cerr << "Error opening " << file_name << std::endl;
         return false;
-    }*/
-    
+    }
+    fseek(fp,0,SEEK_END);
+    const long file_size = ftell(fp);
+    fseek(fp,0,SEEK_SET);
+
+    MatVetHeader header;
+    memset(&header,0,sizeof(MatVetHeader));
+    size_t header_read = fread(&header,1,sizeof(MatVetHeader),fp);
+
+    uint64_t rows;
+    uint32_t cols;
+    long data_offset;
+    if( header_read == sizeof(MatVetHeader) && isMatVetHeader(header) ) {
+        if( header.version != MATVETIO_VERSION || (header.type != MATVETIO_MATRIX && header.type != MATVETIO_VECTOR) ) {
+            std::cerr << "Error opening " << file_name << ": unknown format version " << header.version << std::endl;
+            fclose(fp);
+            return false;
+        }
+        version = header.version;
+        type = header.type;
+        rows = header.rows;
+        cols = header.cols;
+        data_offset = (long)header.data_offset;
+    } else {
+        //first version: the size of the data is used for telling a matrix from a vector
+        uint32_t dims[2] = {0,0};
+        memcpy(dims,&header,std::min(header_read,sizeof(dims)));
+        version = 1;
+        if( header_read >= 8 && (uint64_t)file_size == 8+(uint64_t)dims[0]*dims[1]*sizeof(double) ) {
+            type = MATVETIO_MATRIX;
+            rows = dims[0];
+            cols = dims[1];
+            data_offset = 8;
+        } else if( header_read >= 4 && (uint64_t)file_size == 4+(uint64_t)dims[0]*sizeof(double) ) {
+            type = MATVETIO_VECTOR;
+            rows = dims[0];
+            cols = 1;
+            data_offset = 4;
+        } else {
+            std::cerr << "Error opening " << file_name << ": the file size does not match the header" << std::endl;
+            fclose(fp);
+            return false;
+        }
+    }
+
+    //a writer could have been interrupted after the header update: only the complete rows are used
+    if( cols == 0 ) {
+        rows = 0;
+    } else if( data_offset+rows*cols*sizeof(double) > (uint64_t)file_size ) {
+        std::cerr << "Warning: " << file_name << " is truncated" << std::endl;
+        rows = (file_size-data_offset)/(cols*sizeof(double));
+    }
+    n_rows = (int64_t)rows;
+    n_cols = cols;
+    const size_t data_size = (size_t)(rows*cols*sizeof(double));
+
+    if( data_size > 0 ) {
+#ifndef WIN32
+        //the data of the current version are aligned, and can be mapped
+        if( version == MATVETIO_VERSION ) {
+            map_length = data_offset+data_size;
+            map_address = mmap(0,map_length,PROT_READ,MAP_SHARED,fileno(fp),0);
+            if( map_address == MAP_FAILED ) {
+                map_address = 0;
+                map_length = 0;
+            } else {
+                madvise(map_address,map_length,MADV_SEQUENTIAL);
+                data = (const double *)((const char *)map_address+data_offset);
+            }
+        }
+#endif
+        if( data == 0 ) {
+            buffer.resize(rows*cols);
+            fseek(fp,data_offset,SEEK_SET);
+            if( fread(&(buffer[0]),sizeof(double),buffer.size(),fp) != buffer.size() ) {
+                std::cerr << "Error reading " << file_name << std::endl;
+                fclose(fp);
+                close();
+                return false;
+            }
+            data = &(buffer[0]);
+        }
+    }
+
     fclose(fp);
+    opened = true;
     return true;
 }
 
-bool Vector_read(const std::string file_name, yarp::sig::Vector & vec)
+MatVetRowBlock MatVetReader::getRows(int64_t first_row, int num_rows) const
 {
-    FILE * fp;
-    uint32_t len;
-    double elem;
-    
-    fp = fopen(file_name.c_str(),"rb");
-    if( fp == NULL ) return false;
-    
-    fread(&len,sizeof(uint32_t),1,fp);
-    vec.resize(len);
-    
-    for(size_t i=0;i<len;i++) { 
-        fread(&elem,sizeof(double),1,fp);
-        vec[i]=elem;
-    }
-    
-    /*
-    if( gsl_vector_fread(fp,(gsl_vector*)vec.getGslVector()) == GSL_EFAILED ) {
-        fclose(fp);
-        return false;
-    }*/
+    assert(first_row >= 0 && num_rows >= 0 && first_row+num_rows <= n_rows);
+    MatVetRowBlock block;
+    block.data = data+(size_t)first_row*n_cols;
+    block.rows = num_rows;
+    block.cols = n_cols;
+    return block;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+MatVetWriter::MatVetWriter() : fp(0), chunk_fill(0)
+{
+    initHeader(header,MATVETIO_MATRIX,0,MATVETIO_DEFAULT_CHUNK_ROWS);
+}
+
+MatVetWriter::~MatVetWriter()
+{
+    close();
+}
+
+bool MatVetWriter::open(const std::string file_name, int cols, bool is_vector, bool append, int chunk_rows)
+{
+    close();
+    if( cols <= 0 || chunk_rows <= 0 || (is_vector && cols != 1) ) return false;
+
+    initHeader(header,is_vector ? MATVETIO_VECTOR : MATVETIO_MATRIX,cols,chunk_rows);
+
+    if( append ) {
+        fp = fopen(file_name.c_str(),"r+b");
+        if( fp != NULL ) {
+            MatVetHeader old_header;
+            if( fread(&old_header,sizeof(MatVetHeader),1,fp) != 1 || !isMatVetHeader(old_header) ||
+                old_header.version != MATVETIO_VERSION || old_header.type != header.type || (int)old_header.cols != cols ) {
+                std::cerr << "Error appending to " << file_name << ": incompatible file" << std::endl;
+                fclose(fp);
+                fp = 0;
+                return false;
+            }
+            //the rows after the ones in the header (of an incomplete chunk) are overwritten
+            header.rows = old_header.rows;
+            fseek(fp,header.data_offset+header.rows*cols*sizeof(double),SEEK_SET);
+        }
+    }
+    if( fp == 0 ) {
+        fp = fopen(file_name.c_str(),"w+b");
+        if( fp == NULL ) {
+            fp = 0;
+            std::cerr << "Error opening " << file_name << std::endl;
+            return false;
+        }
+        if( fwrite(&header,sizeof(MatVetHeader),1,fp) != 1 ) {
+            fclose(fp);
+            fp = 0;
+            return false;
+        }
+    }
+    chunk.resize(chunk_rows*cols);
+    chunk_fill = 0;
+    return true;
+}
+
+bool MatVetWriter::writeChunk()
+{
+    if( chunk_fill == 0 ) return true;
+    bool ret = ( fwrite(&(chunk[0]),sizeof(double)*header.cols,chunk_fill,fp) == (size_t)chunk_fill );
+    if( ret ) {
+        //update the number of rows in the header, then return to the end of the data
+        header.rows += chunk_fill;
+        fseek(fp,0,SEEK_SET);
+        ret = ( fwrite(&header,sizeof(MatVetHeader),1,fp) == 1 );
+        fseek(fp,header.data_offset+header.rows*header.cols*sizeof(double),SEEK_SET);
+    }
+    chunk_fill = 0;
+    return ret;
+}
+
+bool MatVetWriter::flush()
+{
+    if( fp == 0 ) return false;
+    bool ret = writeChunk();
+    fflush(fp);
+    return ret;
+}
+
+bool MatVetWriter::close()
+{
+    if( fp == 0 ) return false;
+    bool ret = writeChunk();
     fclose(fp);
+    fp = 0;
+    return ret;
+}
+
+bool MatVetWriter::appendRow(const double * row)
+{
+    if( fp == 0 ) return false;
+    memcpy(&(chunk[chunk_fill*header.cols]),row,header.cols*sizeof(double));
+    chunk_fill++;
+    if( chunk_fill == (int)header.chunk_rows ) {
+        return writeChunk();
+    }
     return true;
 }
 
-bool Matrix_write(const std::string file_name, const yarp::sig::Matrix & mat)
+bool MatVetWriter::append(const yarp::sig::Matrix & mat)
+{
+    if( fp == 0 || mat.cols() != (int)header.cols ) return false;
+    bool ret = true;
+    for(int i=0; i < mat.rows(); i++ ) {
+        ret = ret && appendRow(mat[i]);
+    }
+    return ret;
+}
+
+bool MatVetWriter::append(const yarp::sig::Vector & vec)
 {
-    FILE * fp;
-    uint32_t rows,cols;
-    double elem;
-    
-    rows = mat.rows();
-    cols = mat.cols();
-    
-    fp = fopen(file_name.c_str(),"wb");
-    if( fp == NULL ) return false;
-    
-    //writing dimensions informations
-    fwrite(&rows,sizeof(uint32_t),1,fp);
-    fwrite(&cols,sizeof(uint32_t),1,fp);
-
-    for(size_t i=0;i<rows;i++) {
-        for(size_t j=0;j<cols;j++ ) {
-            elem = mat(i,j);
-            fwrite(&elem,sizeof(double),1,fp);
-         }
-     }
-    /*
-    if( gsl_matrix_fwrite(fp,(gsl_matrix*)mat.getGslMatrix()) == GSL_EFAILED ) {
-        fclose(fp);
+    if( fp == 0 ) return false;
+    if( header.type == MATVETIO_VECTOR ) {
+        bool ret = true;
+        for(size_t i=0; i < vec.size(); i++ ) {
+            ret = ret && appendRow(vec.data()+i);
+        }
+        return ret;
+    }
+    if( (int)vec.size() != (int)header.cols ) return false;
+    return appendRow(vec.data());
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+bool Vector_write(const std::string file_name, const yarp::sig::Vector & vec)
+{
+    MatVetWriter writer;
+    if( !writer.open(file_name,1,true) ) return false;
+    bool ret = writer.append(vec);
+    return writer.close() && ret;
+}
+
+bool Vector_read(const std::string file_name, yarp::sig::Vector & vec)
+{
+    MatVetReader reader;
+
+    std::cerr << "Opening vector " << file_name << std::endl;
+
+    if( !reader.open(file_name) ) {
+        std::cerr << "Error opening vector " << file_name << std::endl;
         return false;
-    }*/
-    fclose(fp);
+    }
+    if( !reader.isVector() ) {
+        std::cerr << "Error opening vector " << file_name << ": the file contains a matrix" << std::endl;
+        return false;
+    }
+    reader.getRows(0,(int)reader.rows()).toVector(vec);
     return true;
 }
 
+bool Matrix_write(const std::string file_name, const yarp::sig::Matrix & mat)
+{
+    MatVetWriter writer;
+    if( !writer.open(file_name,mat.cols() > 0 ? mat.cols() : 1) ) return false;
+    bool ret = mat.cols() > 0 ? writer.append(mat) : true;
+    return writer.close() && ret;
+}
+
 bool Matrix_read(const std::string file_name, yarp::sig::Matrix & mat)
 {
-    FILE * fp;
-    uint32_t rows,cols;
-    double elem;
-    
-    fp = fopen(file_name.c_str(),"rb");
-    if( fp == NULL ) return false;
-    
-    //reading dimensions information
-    fread(&rows,sizeof(uint32_t),1,fp);
-    fread(&cols,sizeof(uint32_t),1,fp);
-    
-    mat.resize(rows,cols);
-    
-    for(size_t i=0;i<rows;i++) {
-        for(size_t j=0;j<cols;j++ ) {
-             fread(&elem,sizeof(double),1,fp);
-             mat(i,j) = elem;
-         }
-     }
-    
-    /*
-    if( gsl_matrix_fread(fp,(gsl_matrix*)mat.getGslMatrix()) == GSL_EFAILED ) {
-        fclose(fp);
+    MatVetReader reader;
+
+    std::cerr << "Opening matrix " << file_name << std::endl;
+
+    if( !reader.open(file_name) ) {
+        std::cerr << "Error opening matrix " << file_name << std::endl;
         return false;
     }
-    */
-    
-    
-    fclose(fp);
+    if( reader.isVector() ) {
+        std::cerr << "Error opening matrix " << file_name << ": the file contains a vector" << std::endl;
+        return false;
+    }
+    reader.getRows(0,(int)reader.rows()).toMatrix(mat);
     return true;
 }
@@ -5,10 +5,161 @@
 #include <yarp/sig/Matrix.h>
 
 #include <string>
+#include <vector>
+#include <cstdio>
+#include <stdint.h>
+
+/**
+ * File format (version 2) of the .ymt (matrix) and .yvc (vector) files, in the native binary format
+ * (it may not be portable between different architectures):
+ *  - a 64 bytes header: the magic "MVIO", the format version, the type (matrix or vector), the number of
+ *    columns (1 for a vector), the number of rows (the length for a vector), the number of rows of a chunk
+ *    and the offset of the data
+ *  - the elements as doubles, in row major order. The rows are written by chunks, and the number of rows in the
+ *    header is updated after each chunk, so a file that is being written always contains the complete chunks.
+ *
+ * The files of the first version (without header, the unsigned 32 bits number of rows and of columns of a matrix,
+ * or the length of a vector, followed by the elements) can still be read.
+ */
+const uint32_t MATVETIO_VERSION = 2;
+const uint32_t MATVETIO_MATRIX = 0;
+const uint32_t MATVETIO_VECTOR = 1;
+const uint32_t MATVETIO_DEFAULT_CHUNK_ROWS = 1024;
+
+struct MatVetHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t type;
+    uint32_t cols;
+    uint64_t rows;
+    uint32_t chunk_rows;
+    uint32_t reserved;
+    uint64_t data_offset;
+    char padding[24];
+};
+
+/**
+ * View of a block of contiguous rows of a file opened by MatVetReader, valid until the reader is closed
+ */
+struct MatVetRowBlock
+{
+    const double * data;
+    int rows;
+    int cols;
+
+    double operator()(int r, int c) const { return data[(size_t)r*cols+c]; }
+    const double * row(int r) const { return data+(size_t)r*cols; }
+
+    /**
+     * Copy the block in a Matrix (resized only if it has the wrong size)
+     */
+    void toMatrix(yarp::sig::Matrix & mat) const;
+
+    /**
+     * Copy the block in a Vector, row after row (resized only if it has the wrong size)
+     */
+    void toVector(yarp::sig::Vector & vec) const;
+};
+
+/**
+ * Reader of a .ymt/.yvc file: the file is memory mapped (the files of the first version are instead read
+ * in memory), so the blocks of rows are returned without copying the data
+ */
+class MatVetReader
+{
+    bool opened;
+    const double * data;
+    int64_t n_rows;
+    int n_cols;
+    uint32_t type;
+    uint32_t version;
+    //mapping of the file
+    void * map_address;
+    size_t map_length;
+    //buffer for the files that are not mapped
+    std::vector<double> buffer;
+
+    MatVetReader(const MatVetReader &);
+    MatVetReader & operator=(const MatVetReader &);
+
+    public:
+    MatVetReader();
+    ~MatVetReader();
+
+    /**
+     * Open a file
+     * @return true if the file is opened, false otherwise
+     */
+    bool open(const std::string file_name);
+    void close();
+    bool isOpen() const { return opened; }
+
+    int64_t rows() const { return n_rows; }
+    int cols() const { return n_cols; }
+    bool isVector() const { return type == MATVETIO_VECTOR; }
+    /** format version of the file */
+    uint32_t getVersion() const { return version; }
+
+    /**
+     * Get a view of the rows first_row ... first_row+num_rows-1
+     * (if the file contains a vector, each element is a row); the offsets are computed in 64 bits,
+     * so first_row can be beyond the 2^31 elements of a large file
+     */
+    MatVetRowBlock getRows(int64_t first_row, int num_rows) const;
+};
+
+/**
+ * Append only writer of a .ymt/.yvc file: the rows are buffered and written by chunks
+ */
+class MatVetWriter
+{
+    FILE * fp;
+    MatVetHeader header;
+    std::vector<double> chunk;
+    int chunk_fill;
+
+    MatVetWriter(const MatVetWriter &);
+    MatVetWriter & operator=(const MatVetWriter &);
+
+    bool writeChunk();
+
+    public:
+    MatVetWriter();
+    ~MatVetWriter();
+
+    /**
+     * Open a file for writing
+     * @param cols number of columns of the matrix, 1 for a vector
+     * @param is_vector true if the file contains a vector
+     * @param append if true and the file exists (in the current format, with the same type and columns), the rows are appended to it
+     * @param chunk_rows number of rows written together
+     * @return true if the file is opened, false otherwise
+     */
+    bool open(const std::string file_name, int cols, bool is_vector = false, bool append = false, int chunk_rows = MATVETIO_DEFAULT_CHUNK_ROWS);
+
+    /**
+     * Write the buffered rows and close the file
+     * @return true if all the rows are written, false otherwise
+     */
+    bool close();
+    bool isOpen() const { return fp != 0; }
+
+    /** number of rows in the file, including the buffered ones */
+    uint64_t rows() const { return header.rows + chunk_fill; }
+    int cols() const { return header.cols; }
+
+    bool appendRow(const double * row);
+    /** append the rows of a matrix */
+    bool append(const yarp::sig::Matrix & mat);
+    /** append the elements of a vector: for a vector file each element is a row, for a matrix file the vector is a row */
+    bool append(const yarp::sig::Vector & vec);
+    /** write the buffered rows to the file */
+    bool flush();
+};
 
 /**
  * This function writes the content of a Vector to a given file
- * Uses internally gsl_vector_fwrite function
  * Since the data is written in the native binary format it may not be portable between different architectures.
  * @return true if the file is written, false otherwise
  */
@@ -17,27 +168,21 @@ bool Vector_write(const std::string file_name, const yarp::sig::Vector & vec);
 
 /**
  * This function reads the content of a Vector to a given file
- * Uses internally gsl_vector_fread function
  * Since the data is written in the native binary format it may not be portable between different architectures.
- * File format: first 4 bytes: unsigned length of the vector, the rest of the file in gsl format, handled by gsl_vector_fread
  * @return true if the Vector is read, false otherwise
  */
 bool Vector_read(const std::string file_name, yarp::sig::Vector & vec);
 
 /**
  * This function writes the content of a Matrix to a given file
- * Uses internally gsl_matrix_fwrite function
  * Since the data is written in the native binary format it may not be portable between different architectures.
- * File format: first 4 bytes: unsigned number of rows of the matrix, successive 4 bytes: unsigned number of columns of the matrix, the rest of the file in gsl format, handled by gsl_matrix_fwrite
  * @return true if the file is written, false otherwise
  */
 bool Matrix_write(const std::string file_name, const yarp::sig::Matrix & mat);
 
 /**
  * This function reads the content of a Matrix to a given file
- * Uses internally gsl_matrix_fread function
  * Since the data is written in the native binary format it may not be portable between different architectures.
- * File format: first 4 bytes: unsigned number of rows of the matrix, successive 4 bytes: unsigned number of columns of the matrix, the rest of the file in gsl format, handled by gsl_matrix_fread
  * @return true if the Matrix is read, false otherwise
  */
 bool Matrix_read(const std::string file_name, yarp::sig::Matrix & mat);
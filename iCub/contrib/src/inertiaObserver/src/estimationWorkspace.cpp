@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include "estimationWorkspace.h"
+
+#include <yarp/os/Log.h>
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace iCub::iDyn;
+using namespace iCub::iDyn::Regressor;
+using namespace iCub::learningmachine;
+
+#ifdef INERTIAOBSERVER_COUNT_ALLOCATIONS
+//Debug hook: count all the calls to global operator new
+//(dynamic exception specifications are deprecated in C++11, and removed in C++17)
+#if __cplusplus >= 201103L
+#define INERTIAOBSERVER_THROW_BAD_ALLOC
+#define INERTIAOBSERVER_NO_THROW noexcept
+#else
+#define INERTIAOBSERVER_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define INERTIAOBSERVER_NO_THROW throw()
+#endif
+
+static unsigned long allocation_count = 0;
+
+void * operator new(size_t size) INERTIAOBSERVER_THROW_BAD_ALLOC
+{
+    allocation_count++;
+    void * p = malloc(size == 0 ? 1 : size);
+    if( !p ) throw std::bad_alloc();
+    return p;
+}
+
+void * operator new[](size_t size) INERTIAOBSERVER_THROW_BAD_ALLOC
+{
+    allocation_count++;
+    void * p = malloc(size == 0 ? 1 : size);
+    if( !p ) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void * p) INERTIAOBSERVER_NO_THROW
+{
+    free(p);
+}
+
+void operator delete[](void * p) INERTIAOBSERVER_NO_THROW
+{
+    free(p);
+}
+#endif
+
+estimationWorkspace::estimationWorkspace() :
+    n_param(0), n_ident(0), n_static(0), n_dynamic(0), first_torque(0), n_torques(0)
+{
+}
+
+void estimationWorkspace::resize(int _n_param, int _n_ident, int _n_static, int _n_dynamic, int _first_torque, int _n_torques)
+{
+    n_param = _n_param;
+    n_ident = _n_ident;
+    n_static = _n_static;
+    n_dynamic = _n_dynamic;
+    first_torque = _first_torque;
+    n_torques = _n_torques;
+
+    Phi.resize(6,n_param);
+    Phi.zero();
+
+    Phi_w_offset.resize(6,n_ident+6);
+    Phi_w_offset.zero();
+    Phi_static_w_offset.resize(6,n_static+6);
+    Phi_static_w_offset.zero();
+    for(int i=0; i < 6; i++ ) {
+        Phi_w_offset(i,n_ident+i) = 1.0;
+        Phi_static_w_offset(i,n_static+i) = 1.0;
+    }
+
+    Phi_dynamic.resize(6,n_dynamic);
+    Phi_dynamic.zero();
+
+    torques_regressor.resize(n_torques,n_param);
+    torques_regressor.zero();
+    torques_regressor_w_offset.resize(n_torques,n_ident+6);
+    torques_regressor_w_offset.zero();
+
+    JY_1.resize(n_torques,n_ident);
+    JY_1.zero();
+    JacTor.resize(n_torques,6);
+    JacTor.zero();
+    YTB.resize(n_torques,n_ident);
+    YTB.zero();
+
+    F_up.resize(6,0.0);
+    static_prediction.resize(6,0.0);
+    static_prediction_sd.resize(6,0.0);
+    dynamic_prediction.resize(6,0.0);
+    dynamic_prediction_sd.resize(6,0.0);
+    dynamic_residual.resize(6,0.0);
+    adInv.resize(6,6);
+    adInv.zero();
+}
+
+bool estimationWorkspace::setBases(const Matrix & identifiable_parameters, const Matrix & static_identifiable_parameters, const Matrix & dynamic_identifiable_parameters)
+{
+    if( identifiable_parameters.cols() != n_ident || 
+        static_identifiable_parameters.cols() != n_static ||
+        dynamic_identifiable_parameters.cols() != n_dynamic ) {
+        return false;
+    }
+    std::vector<Matrix> bases(3);
+    bases[0] = identifiable_parameters;
+    bases[1] = static_identifiable_parameters;
+    bases[2] = dynamic_identifiable_parameters;
+    if( !projection.setBases(bases) ) {
+        return false;
+    }
+    Phi_projected.resize(6,projection.getTotalSize());
+    Phi_projected.zero();
+    return true;
+}
+
+void estimationWorkspace::splitProjectedRegressor()
+{
+    YARP_ASSERT(Phi_projected.cols() == n_ident+n_static+n_dynamic);
+    for(int i=0; i < 6; i++ ) {
+        const double * proj_row = Phi_projected[i];
+        double * ident_row = Phi_w_offset[i];
+        double * static_row = Phi_static_w_offset[i];
+        double * dynamic_row = Phi_dynamic[i];
+        for(int j=0; j < n_ident; j++ ) {
+            ident_row[j] = proj_row[j];
+        }
+        for(int j=0; j < n_static; j++ ) {
+            static_row[j] = proj_row[n_ident+j];
+        }
+        for(int j=0; j < n_dynamic; j++ ) {
+            dynamic_row[j] = proj_row[n_ident+n_static+j];
+        }
+    }
+}
+
+bool estimationWorkspace::computeRegressors(iCubWholeBody * icub, const std::string & limbName)
+{
+    if( !iCubLimbRegressorSensorWrenchProjected(icub,limbName,projection,Phi_projected) ) {
+        return false;
+    }
+    splitProjectedRegressor();
+    return true;
+}
+
+bool estimationWorkspace::feedLearners(const std::vector<IParameterLearner *> & estimators,
+                                       MultiTaskLinearGPRLearner * staticEstimator,
+                                       MultiTaskLinearGPRLearner * dynamicEstimator,
+                                       const Vector & w, bool still, double max_static_sd)
+{
+    for(size_t j=0; j < estimators.size(); j++ ) {
+        estimators[j]->feedSample(Phi_w_offset,w);
+    }
+
+    if( still ) {
+        staticEstimator->feedSample(Phi_static_w_offset,w);
+        return false;
+    }
+
+    staticEstimator->predict(Phi_static_w_offset,static_prediction,static_prediction_sd);
+    double max = -1.0;
+    for(int i=0; i < (int)static_prediction_sd.size(); i++ ) {
+        if( max < static_prediction_sd[i] ) {
+            max = static_prediction_sd[i];
+        }
+    }
+    if( max >= max_static_sd ) {
+        return false;
+    }
+    for(int i=0; i < 6; i++ ) {
+        dynamic_residual[i] = w[i]-static_prediction[i];
+    }
+    dynamicEstimator->feedSample(Phi_dynamic,dynamic_residual);
+    return true;
+}
+
+void estimationWorkspace::projectRegressor(const Matrix & regr, int first_row, const Matrix & basis, Matrix & out)
+{
+    YARP_ASSERT(regr.cols() == basis.rows());
+    YARP_ASSERT(out.cols() >= basis.cols());
+    YARP_ASSERT(first_row+out.rows() <= regr.rows());
+
+    const int n = basis.rows();
+    const int r = basis.cols();
+    for(int i=0; i < out.rows(); i++ ) {
+        double * out_row = out[i];
+        const double * regr_row = regr[first_row+i];
+        for(int j=0; j < r; j++ ) {
+            out_row[j] = 0.0;
+        }
+        for(int k=0; k < n; k++ ) {
+            const double a = regr_row[k];
+            if( a == 0.0 ) continue;
+            const double * basis_row = basis[k];
+            for(int j=0; j < r; j++ ) {
+                out_row[j] += a*basis_row[j];
+            }
+        }
+    }
+}
+
+void estimationWorkspace::multiplyBlock(const Matrix & A, int ncols, const Vector & x, Vector & out)
+{
+    YARP_ASSERT(ncols <= A.cols());
+    YARP_ASSERT((int)x.size() == ncols);
+    if( (int)out.size() != A.rows() ) {
+        out.resize(A.rows());
+    }
+    for(int i=0; i < A.rows(); i++ ) {
+        const double * A_row = A[i];
+        double sum = 0.0;
+        for(int k=0; k < ncols; k++ ) {
+            sum += A_row[k]*x[k];
+        }
+        out[i] = sum;
+    }
+}
+
+void estimationWorkspace::addGram(const Matrix & A, int first_row, int last_row, const Vector & w, Matrix & G)
+{
+    YARP_ASSERT((int)w.size() == last_row-first_row+1);
+    addGram(A,first_row,last_row,w.data(),G);
+}
+
+void estimationWorkspace::addGram(const Matrix & A, int first_row, int last_row, Matrix & G)
+{
+    addGram(A,first_row,last_row,(const double *)0,G);
+}
+
+void estimationWorkspace::addGram(const Matrix & A, int first_row, int last_row, const double * w, Matrix & G)
+{
+    YARP_ASSERT(G.rows() == A.cols() && G.cols() == A.cols());
+    YARP_ASSERT(first_row >= 0 && last_row < A.rows());
+
+    const int n = A.cols();
+    for(int l=first_row; l <= last_row; l++ ) {
+        const double * A_row = A[l];
+        const double weight = w ? w[l-first_row] : 1.0;
+        for(int i=0; i < n; i++ ) {
+            const double a = weight*A_row[i];
+            if( a == 0.0 ) continue;
+            double * G_row = G[i];
+            for(int j=0; j < n; j++ ) {
+                G_row[j] += a*A_row[j];
+            }
+        }
+    }
+}
+
+void estimationWorkspace::adjointInv(const Matrix & H, Matrix & adInv)
+{
+    YARP_ASSERT(H.rows() == 4 && H.cols() == 4);
+    if( adInv.rows() != 6 || adInv.cols() != 6 ) {
+        adInv.resize(6,6);
+    }
+    const double p[3] = {H(0,3), H(1,3), H(2,3)};
+    for(int i=0; i < 3; i++ ) {
+        for(int j=0; j < 3; j++ ) {
+            adInv(i,j) = H(j,i);
+            adInv(3+i,3+j) = H(j,i);
+            adInv(3+i,j) = 0.0;
+        }
+        //-R^T*S(p), the column j of S(p) is e_j x p
+        adInv(i,3) = H(2,i)*p[1]-H(1,i)*p[2];
+        adInv(i,4) = H(0,i)*p[2]-H(2,i)*p[0];
+        adInv(i,5) = H(1,i)*p[0]-H(0,i)*p[1];
+    }
+}
+
+unsigned long estimationWorkspace::getAllocationCount()
+{
+    #ifdef INERTIAOBSERVER_COUNT_ALLOCATIONS
+    return allocation_count;
+    #else
+    return 0;
+    #endif
+}
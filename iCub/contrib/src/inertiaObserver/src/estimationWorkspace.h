@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef ESTIMATION_WORKSPACE
+#define ESTIMATION_WORKSPACE
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#include <iCub/iDyn/iDynRegressor.h>
+#include <iCub/learningMachine/IParameterLearner.h>
+#include <iCub/learningMachine/MultiTaskLinearGPRLearner.h>
+
+#include <vector>
+
+using namespace yarp::sig;
+
+/**
+ * Buffers used by inertiaObserver_thread::run() for the estimation step of a FT sensor.
+ *
+ * All the matrices are sized once (in threadInit) by resize() and then
+ * overwritten in place for each sample, so once the learners are full rank
+ * the estimation step (computeRegressors() and feedLearners()) does not allocate
+ * memory. The offset columns (identity for the wrench regressors, zero for the
+ * torque regressor) are written only in resize().
+ *
+ * \note The state estimation (iCubStateEstimator) and the kinematics of iDyn
+ *       still allocate, their results are only copied in the state buffers.
+ *       The regressor computed by iDyn (Phi) for the debug outputs is assigned
+ *       with Matrix::operator=, that reuses the storage if the size is unchanged,
+ *       while the block sparse ones (Phi_complete, Y) are overwritten in place
+ */
+class estimationWorkspace
+{
+public:
+    int n_param;        ///< number of parameters of the limb (10*N)
+    int n_ident;        ///< size of the identifiable subspace
+    int n_static;       ///< size of the static identifiable subspace
+    int n_dynamic;      ///< size of the only dynamic identifiable subspace
+    int first_torque;   ///< index of the first joint torque used for the projected torques
+    int n_torques;      ///< number of joint torques used for the projected torques
+
+    Matrix Phi;                         ///< 6 x n_param sensor wrench regressor
+    Matrix Phi_w_offset;                ///< 6 x (n_ident+6), [Phi*identifiable_parameters I]
+    Matrix Phi_static_w_offset;         ///< 6 x (n_static+6), [Phi*static_identifiable_parameters I]
+    Matrix Phi_dynamic;                 ///< 6 x n_dynamic, Phi*dynamic_identifiable_parameters
+
+    iCub::iDyn::Regressor::BlockSparseRegressor Phi_complete;   ///< regressor of the sensor wrench and of all the joint torques
+    iCub::iDyn::Regressor::BlockSparseRegressor Y;              ///< complete regressor used for the backward torques
+
+    Matrix torques_regressor;           ///< joint torques regressor, one row for each joint after the sensor (n_torques x n_param if first_torque is the first one)
+    Matrix torques_regressor_w_offset;  ///< n_torques x (n_ident+6), [torques_regressor*identifiable_parameters 0]
+    Matrix JY_1;                        ///< n_torques x n_ident
+    Matrix JacTor;                      ///< n_torques x 6
+    Matrix YTB;                         ///< n_torques x n_ident
+
+    Vector ftWeights;                   ///< weights for the ATA accumulation
+
+    iCub::iDyn::Regressor::RegressorProjection projection;  ///< slices of [identifiable static dynamic] bases
+    Matrix Phi_projected;               ///< 6 x (n_ident+n_static+n_dynamic), Phi*[identifiable static dynamic]
+
+    Vector q_limb, dq_limb, ddq_limb;       ///< state of the limb of the sensor, at the time of the FT sample
+    Vector q_head, dq_head, ddq_head;       ///< state of the head
+    Vector q_torso, dq_torso, ddq_torso;    ///< state of the torso (only for the legs)
+    Vector w0, dw0, d2p0;                   ///< inertial measure of the head
+    Vector F_up;                            ///< null wrench, for the sensors not used
+
+    Vector static_prediction;           ///< prediction of the static estimator, Phi_static_w_offset*static parameters
+    Vector static_prediction_sd;        ///< standard deviation of static_prediction
+    Vector dynamic_prediction;          ///< prediction of the dynamic estimator (debug outputs only)
+    Vector dynamic_prediction_sd;       ///< standard deviation of dynamic_prediction
+    Vector dynamic_residual;            ///< measured wrench minus static_prediction, fed to the dynamic estimator
+    Matrix adInv;                       ///< 6 x 6, adjointInv of the transform of a joint (debug outputs only)
+
+    estimationWorkspace();
+
+    /**
+     * Allocate all the buffers, and write the constant offset blocks.
+     */
+    void resize(int _n_param, int _n_ident, int _n_static, int _n_dynamic, int _first_torque, int _n_torques);
+
+    /**
+     * Precompute the per link slices of the identifiable subspaces, used to calculate
+     * Phi_projected without building Phi
+     * @return false if the bases are not compatible with the sizes given to resize()
+     */
+    bool setBases(const Matrix & identifiable_parameters, const Matrix & static_identifiable_parameters, const Matrix & dynamic_identifiable_parameters);
+
+    /**
+     * Copy the blocks of Phi_projected in Phi_w_offset, Phi_static_w_offset and Phi_dynamic
+     */
+    void splitProjectedRegressor();
+
+    /**
+     * Compute Phi_projected for the current (solved) kinematics of the limb, and
+     * split it in Phi_w_offset, Phi_static_w_offset and Phi_dynamic
+     * @return false if the regressor of the limb is not available
+     */
+    bool computeRegressors(iCub::iDyn::iCubWholeBody * icub, const std::string & limbName);
+
+    /**
+     * Feed the sample (Phi_w_offset, Phi_static_w_offset, Phi_dynamic and the measured wrench w)
+     * to the learners: all the estimators get the identifiable regressor, then if the limb is
+     * still the static estimator is updated, otherwise the dynamic one is updated with the
+     * residual of the static prediction, if its standard deviation is less than max_static_sd.
+     * @return true if the dynamic estimator was updated
+     */
+    bool feedLearners(const std::vector<iCub::learningmachine::IParameterLearner *> & estimators,
+                      iCub::learningmachine::MultiTaskLinearGPRLearner * staticEstimator,
+                      iCub::learningmachine::MultiTaskLinearGPRLearner * dynamicEstimator,
+                      const Vector & w, bool still, double max_static_sd = 0.2);
+
+    /**
+     * Compute out(i,j) = \f$ \sum_k \f$ regr(first_row+i,k)*basis(k,j)
+     * for i < out.rows() and j < basis.cols(), writing in place.
+     * The columns of out after basis.cols() are not modified.
+     */
+    static void projectRegressor(const Matrix & regr, int first_row, const Matrix & basis, Matrix & out);
+
+    /**
+     * Compute out = A(:,0:ncols-1)*x, resizing out only if its size is wrong
+     */
+    static void multiplyBlock(const Matrix & A, int ncols, const Vector & x, Vector & out);
+
+    /**
+     * G = G + A(first_row:last_row,:)^T*diag(w)*A(first_row:last_row,:) , with
+     * w the vector of row weights
+     */
+    static void addGram(const Matrix & A, int first_row, int last_row, const Vector & w, Matrix & G);
+
+    /**
+     * G = G + A(first_row:last_row,:)^T*A(first_row:last_row,:)
+     */
+    static void addGram(const Matrix & A, int first_row, int last_row, Matrix & G);
+
+    /**
+     * Compute adInv = adjointInv(H) = [R^T -R^T*S(p); 0 R^T], with R and p the rotation
+     * and the origin of H, writing in place (adInv is resized only if it is not 6 x 6)
+     */
+    static void adjointInv(const Matrix & H, Matrix & adInv);
+
+    /**
+     * Return the number of calls to global operator new since the start of the program,
+     * if compiled with INERTIAOBSERVER_COUNT_ALLOCATIONS (0 otherwise).
+     * Used to count the memory allocations of the estimation step of a sample in run(),
+     * and checked by allocationCheck.
+     * \note the counter is not thread safe, use it only for debug
+     */
+    static unsigned long getAllocationCount();
+
+private:
+    static void addGram(const Matrix & A, int first_row, int last_row, const double * w, Matrix & G);
+};
+
+#endif
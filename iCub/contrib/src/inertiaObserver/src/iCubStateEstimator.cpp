@@ -131,7 +131,6 @@ void inertialCollector::onRead(Bottle &b)
         else
             pos_time=Time::now();
             
-        //Minus because of the definition of the FT measurment in the sensor and in iDyn !!!
         p_state_estimator->submitInertial(x,pos_time);
     
 }
@@ -198,6 +197,15 @@ iCubStateEstimator::iCubStateEstimator()
             FTListMutex[vectorFT[i]] = new Semaphore;
 		}
         
+        inertialList = new AWPolyList;
+        inertialListMutex = new Semaphore;
+        NInertial = 25;
+        DInertialAll = 1.0;
+        DInertial = Vector(0);
+        winLenInertial = Vector(0);
+        xInertial = Vector(0);
+        tInertial = Vector(0);
+        firstTimeInertial = true;
 
 }
 
@@ -228,24 +236,40 @@ iCubStateEstimator::~iCubStateEstimator()
             delete FTListMutex[vectorFT[i]];
         }
     }
+    
+    if( inertialList ) {
+        delete inertialList;
+    }
+    if( inertialListMutex ) {
+        delete inertialListMutex;
+    }
 
 }
         
 double iCubStateEstimator::getPos(iCubLimb limb, Vector & pos, const double time)
 {
-    AWPolyList * p_list;
-    double return_time = -1.0;
-    p_list = (posList[limb]);
+    double return_time;
     
     posListMutex[limb]->wait();
     
+    return_time = interpolate(*(posList[limb]),pos,time);
+    
+    posListMutex[limb]->post();
+    
+    return return_time;
+}
+
+double iCubStateEstimator::interpolate(AWPolyList & elemList, Vector & result, const double time)
+{
+    AWPolyList * p_list = &elemList;
+    double return_time = -1.0;
 
     if( p_list->size() <= 2 ) {
-		pos = Vector(0);
+		result = Vector(0);
 		return_time = -1.0;
 	} else if( time < (p_list->back()).time  ) {
 		//Requested instant out of available samples
-		pos = Vector(0);
+		result = Vector(0);
 		return_time = -1.0;
 	} else if( time > (p_list->front()).time ) {
 		/**
@@ -253,7 +277,7 @@ double iCubStateEstimator::getPos(iCubLimb limb, Vector & pos, const double time
          * \todo Return last available sample? it time is too distant? TODO 
          * 
          */
-		pos = Vector(0);
+		result = Vector(0);
 		return_time = -1.0;
 	} else {
         //scan list to found the two sample with respect to which the request time sample is in the middle 
@@ -264,11 +288,7 @@ double iCubStateEstimator::getPos(iCubLimb limb, Vector & pos, const double time
             if( curr != p_list->begin() ) {
                 if( time <= next_time && time >= curr_time ) {
                     next = curr-1;
-                    Vector deltaData,nextData,currData;
-                    nextData = next->data;
-                    currData = curr->data;
-                    deltaData = nextData - currData;
-                    pos = ((*(next)).data-curr->data)*((time-curr_time)/(next_time-curr_time)) + curr->data;
+                    result = ((*(next)).data-curr->data)*((time-curr_time)/(next_time-curr_time)) + curr->data;
                     return_time = time;
                     break;
                 }
@@ -276,14 +296,11 @@ double iCubStateEstimator::getPos(iCubLimb limb, Vector & pos, const double time
             next_time = curr_time;
         }
         if( curr == p_list->end() ) {
-            pos = Vector(0);
+            result = Vector(0);
             return_time = -1.0;
         } 
     }
     
-    
-    posListMutex[limb]->post();
-    
     return return_time;
 }
 
@@ -499,10 +516,55 @@ double iCubStateEstimator::getFT(iCubFT ft, Vector & result, const double time)
     return result_time;
 }
 
-double getInertial(Vector & inertial, double time)
+double iCubStateEstimator::getInertial(Vector & inertial, const double time)
 {
-    inertial = Vector(0);
-    return -1.0;
+    double return_time;
+    
+    inertialListMutex->wait();
+    
+    if( inertialList->size() >= 1 && time == -1.0 ) {
+        inertial = inertialList->front().data;
+        return_time = inertialList->front().time;
+    } else {
+        return_time = interpolate(*inertialList,inertial,time);
+    }
+    
+    inertialListMutex->post();
+    
+    return return_time;
+}
+
+double iCubStateEstimator::getInertialKinematics(Vector & w0, Vector & dw0, Vector & d2p0, const double time)
+{
+    Vector inertial, d_inertial;
+    double return_time = -1.0;
+    double estimate_time = -1.0;
+    
+    inertialListMutex->wait();
+    
+    //the angular acceleration needs NInertial/2 samples on both sides of time
+    if( inertialList->size() > (unsigned) NInertial ) {
+        return_time = interpolate(*inertialList,inertial,time);
+        if( return_time != -1.0 ) {
+            d_inertial = estimate(*inertialList,time,winLenInertial,NInertial,DInertial,xInertial,tInertial,1,estimate_time);
+            if( estimate_time == -1.0 ) {
+                return_time = -1.0;
+            }
+        }
+    }
+    
+    inertialListMutex->post();
+    
+    if( return_time == -1.0 ) {
+        w0 = dw0 = d2p0 = Vector(0);
+        return -1.0;
+    }
+    
+    w0 = inertial.subVector(0,2);
+    dw0 = d_inertial.subVector(0,2);
+    d2p0 = inertial.subVector(3,5);
+    
+    return return_time;
 }
 
 
@@ -594,7 +656,48 @@ bool iCubStateEstimator::submitFT(iCubFT ft, const Vector & FT, double time)
 
 bool iCubStateEstimator::submitInertial(const Vector & inertial, double time)
 {
-    return false;
+    AWPolyElement el;
+    
+    if( inertial.size() < 9 ) {
+        return false;
+    }
+    
+    //only angular velocity and linear acceleration are used by iDyn
+    el.data.resize(6);
+    for(int i = 0; i < 3; i++ ) {
+        el.data[i] = inertial[6+i];
+        el.data[3+i] = inertial[3+i];
+    }
+    el.time = time;
+    
+    inertialListMutex->wait();
+    
+    if( firstTimeInertial ) {
+        DInertial = Vector(el.data.size(),DInertialAll);
+        winLenInertial.resize(el.data.size(),NInertial);
+        xInertial.resize(NInertial);
+        tInertial.resize(NInertial);
+        firstTimeInertial = false;
+    }
+    
+    //check to keep the list in descending ordered 
+    if( inertialList->size() == 0 || el.time >= inertialList->front().time ) {
+        //standard case
+        inertialList->push_front(el);
+    } else {
+        //an ordered insert would be more efficient, but is a very rare possibility
+        //so it is easier to do in this way
+        inertialList->push_front(el);
+        sort(inertialList->begin(),inertialList->end(),greater_elem);
+    }
+    
+    if( inertialList->size() > window_length ) {
+        inertialList->pop_back();
+    }
+    
+    inertialListMutex->post();
+    
+    return true;
 }
 
 
@@ -640,6 +743,15 @@ bool iCubStateEstimator::reset()
         FTListMutex[vectorFT[i]]->post();
 
     }
+    
+    inertialListMutex->wait();
+    inertialList->clear();
+    DInertial = Vector(0);
+    winLenInertial = Vector(0);
+    xInertial = Vector(0);
+    tInertial = Vector(0);
+    firstTimeInertial = true;
+    inertialListMutex->post();
 
     return true;
 }
@@ -725,7 +837,7 @@ bool iCubStateEstimator::areEqual(const Vector& a,const Vector& b,const double t
 }
 
 bool iCubStateEstimator::greater_elem(AWPolyElement el1, AWPolyElement el2) {
-    return (el1.time < el2.time);
+    return (el1.time > el2.time);
 }
 
 void iCubStateEstimator::waitOnFTMutex(iCubFT ft) {
@@ -796,7 +908,7 @@ Vector iCubStateEstimator::estimate(AWPolyList & elemList, const double time, Ve
     unsigned int lateral_samples;
     lateral_samples = N/2;
     
-    if( central_sample_index < lateral_samples || (elemList.size()-central_sample_index) < lateral_samples ) {
+    if( central_sample_index < lateral_samples || (elemList.size()-central_sample_index) <= lateral_samples ) {
         //Not sufficient samples arount the central samples
         return_time = -1.0;
         return Vector(0);
@@ -48,6 +48,10 @@ class iCubStateEstimator
 		
 		map<iCubFT,AWPolyList *> FTList;
         map<iCubFT,Semaphore*> FTListMutex;
+        
+        //Inertial samples, stored as [angular velocity (deg/s) ; linear acceleration (m/s^2)]
+        AWPolyList * inertialList;
+        Semaphore * inertialListMutex;
 		
         map<iCubLimb,double> last_ts_linEst;
         map<iCubLimb,double> last_ts_quadEst;
@@ -79,11 +83,21 @@ class iCubStateEstimator
         
         map<iCubLimb,bool> isStillFlag;
         
+        //Non causal estimation of the derivative of the inertial samples
+        int NInertial;
+        double DInertialAll;
+        Vector DInertial;
+        Vector winLenInertial;
+        Vector xInertial;
+        Vector tInertial;
+        bool firstTimeInertial;
+        
         vector<iCubLimb> vectorLimbs;
         vector<iCubFT> vectorFT;
         
         bool useNonCausalEst;
         
+        double interpolate(AWPolyList & elemList, Vector & result, const double time);
         Vector estimate(AWPolyList & elemList, const double time, Vector & winLen, const unsigned N, const Vector & D, Vector & x, Vector & t, const unsigned int order, double & return_time);
         Vector fitCoeff(const Vector & x, Vector & y, const unsigned int i1, const unsigned int i2, const unsigned int order);
         double eval(const Vector & coeff, double x);
@@ -139,11 +153,25 @@ class iCubStateEstimator
         
         /**
          * Get a inertial for timestamp time
-         * @param inertial the reference to the vector contining the output sample
-         * @param time the timestamp of the requested sample
+         * @param inertial the reference to the vector contining the output sample,
+         *        in the form [angular velocity (deg/s) ; linear acceleration (m/s^2)]
+         * @param time the timestamp of the requested sample, or -1.0 to
+         *        get the last available sample 
          * @return time the timestamp of the returned sample it all went well, -1.0 otherwise
          */
-        double getInertial(Vector & inertial,const double time);
+        double getInertial(Vector & inertial,const double time = -1.0);
+        
+        /**
+         * Get the kinematics of the inertial sensor for timestamp time, 
+         * in the form expected by iDynSensorNode::setInertialMeasure
+         * (the angular acceleration is estimated from the angular velocity)
+         * @param w0 angular velocity (deg/s)
+         * @param dw0 angular acceleration (deg/s^2)
+         * @param d2p0 linear acceleration (m/s^2)
+         * @param time the timestamp of the requested sample
+         * @return the timestamp of the returned sample it all went well, -1.0 otherwise
+         */
+        double getInertialKinematics(Vector & w0, Vector & dw0, Vector & d2p0, const double time);
         
         /**
          * Submit a position sample
@@ -160,7 +188,9 @@ class iCubStateEstimator
         bool submitFT(iCubFT ft, const Vector & FT, double time);
         
         /**
-         * Submit a inertial sensor sample
+         * Submit a inertial sensor sample, as streamed by the iCub inertial 
+         * sensor: euler angles (0-2), linear acceleration (3-5), 
+         * angular velocity (6-8), magnetometer (9-11)
          * 
          * @return true if the sample was submitted, false otherwise
          */
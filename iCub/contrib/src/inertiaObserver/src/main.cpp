@@ -60,6 +60,9 @@ inertia matrix) for each link of a limb of the iCub.
 --no_left_arm 
 - this option disables the parameter estimation computation for the left arm
 
+--no_inertial 
+- this option disables the use of the inertial sensor: the head is assumed still and upright
+
 
 --enable_debug_output
 - this option enables the output ports, used for debug
@@ -73,6 +76,18 @@ The port the service is listening to.
   receives the input data vector.
 
 - \e <name>/<part>/
+
+- \e <name>/rpc:i accepts the commands: susp, run, test (stop learning),
+  ntes (start learning), get par <part> (offset, parameters and standard
+  deviations of the learners), get stat (statistics of the estimation),
+  rst <part> [learner] (reset the learners), cal (calibrate the offsets
+  in background, from the samples read while the limb is still),
+  dec <n> (feed one every n FT samples to the learners), help.
+  The queries are answered from a snapshot published by the estimation
+  thread, so they never suspend it. The standard deviations of get par
+  are computed by the thread only when requested, and are empty if it
+  does not publish them within a second (e.g. when suspended). cal is
+  refused if no limb has an offset calibrator.
  
 \section in_files_sec Input Data Files
 None.
@@ -121,6 +136,14 @@ using namespace iCub::ctrl;
 using namespace iCub::iDyn;
 using namespace std;
 
+//append the elements of a vector to a bottle, used by the rpc replies
+void addVector(Bottle & bot, const Vector & v)
+{
+    for(int i=0; i < (int)v.size(); i++ ) {
+        bot.addDouble(v[i]);
+    }
+}
+
 // The main module
 class inertiaObserver_module: public RFModule
 {
@@ -189,48 +212,175 @@ public:
                     }
                 case VOCAB4('t','e','s','t'):
                     {
-                        fprintf(stderr,"Stopping learning parameters, fixing them to current value");
+                        fprintf(stderr,"Stopping learning parameters, fixing them to current value\n");
                         if( ine_obs_thr ) 
                         {
-							ine_obs_thr->suspend();
-							ine_obs_thr->disableLearning(); 
-							ine_obs_thr->resume();
+                            ine_obs_thr->disableLearning(); 
                         }
+                        reply.addVocab(Vocab::encode("ack"));
                         cmdSize--;
                         index++;
                         break;
                     }
                 case VOCAB4('n','t','e','s'):
                     {
-                        fprintf(stderr,"Starting learning parameters, movimeng them from current value");
+                        fprintf(stderr,"Starting learning parameters, movimeng them from current value\n");
                         if( ine_obs_thr ) 
                         {
-							ine_obs_thr->suspend();
-							ine_obs_thr->enableLearning(); 
-							ine_obs_thr->resume();
+                            ine_obs_thr->enableLearning(); 
+                        }
+                        reply.addVocab(Vocab::encode("ack"));
+                        cmdSize--;
+                        index++;
+                        break;
+                    }
+                //the queries are answered from the state published by the thread,
+                //and the other commands are applied by the thread at its next run:
+                //none of them suspends the estimation
+                case VOCAB3('g','e','t'):
+                    {
+                        //the standard deviations of the parameters are computed by the thread only for "get par"
+                        observerSnapshot snapshot;
+                        bool get_par = command.get(index+1).asVocab() == VOCAB3('p','a','r');
+                        if( !ine_obs_thr || !(get_par ? ine_obs_thr->getSnapshotWithStandardDeviations(snapshot) : ine_obs_thr->getSnapshot(snapshot)) ) 
+                        {
+                            reply.addVocab(Vocab::encode("nack"));
+                        }
+                        else if( command.get(index+1).asVocab() == VOCAB3('p','a','r') ) 
+                        {
+                            iCubFT ft;
+                            if( !ine_obs_thr->getFT(command.get(index+2).asString().c_str(),ft) || snapshot.ft.count(ft) == 0 ) 
+                            {
+                                reply.addVocab(Vocab::encode("nack"));
+                            }
+                            else 
+                            {
+                                //(offset (o_1 ... o_6)) (name (parameters (...)) (sd (...))) ...
+                                //(sd ()) if the thread did not publish them in time (e.g. it is suspended)
+                                const ftSnapshot & ft_snapshot = snapshot.ft[ft];
+                                Bottle & offset_bot = reply.addList();
+                                offset_bot.addString("offset");
+                                addVector(offset_bot.addList(),ft_snapshot.offset);
+                                for(unsigned int j=0; j < ft_snapshot.names.size(); j++ ) 
+                                {
+                                    Bottle & learner_bot = reply.addList();
+                                    learner_bot.addString(ft_snapshot.names[j].c_str());
+                                    Bottle & par_bot = learner_bot.addList();
+                                    par_bot.addString("parameters");
+                                    addVector(par_bot.addList(),ft_snapshot.parameters[j]);
+                                    Bottle & sd_bot = learner_bot.addList();
+                                    sd_bot.addString("sd");
+                                    if( snapshot.has_parameters_sd && j < ft_snapshot.parameters_sd.size() ) 
+                                    {
+                                        addVector(sd_bot.addList(),ft_snapshot.parameters_sd[j]);
+                                    }
+                                    else 
+                                    {
+                                        sd_bot.addList();
+                                    }
+                                }
+                            }
+                        }
+                        else if( command.get(index+1).asVocab() == VOCAB4('s','t','a','t') ) 
+                        {
+                            //(time t) (calls n) (learning 0|1) (decimation n) (period mean sd max) (<ft> read fed calibrating) ...
+                            Bottle & b_time = reply.addList();
+                            b_time.addString("time");
+                            b_time.addDouble(snapshot.time);
+                            Bottle & b_calls = reply.addList();
+                            b_calls.addString("calls");
+                            b_calls.addInt(snapshot.call_count);
+                            Bottle & b_learning = reply.addList();
+                            b_learning.addString("learning");
+                            b_learning.addInt(snapshot.learning_enabled ? 1 : 0);
+                            Bottle & b_decimation = reply.addList();
+                            b_decimation.addString("decimation");
+                            b_decimation.addInt(snapshot.decimation);
+                            Bottle & b_period = reply.addList();
+                            b_period.addString("period");
+                            b_period.addDouble(snapshot.run_period_mean);
+                            b_period.addDouble(snapshot.run_period_sd);
+                            b_period.addDouble(snapshot.run_period_max);
+                            map<iCubFT,ftSnapshot>::const_iterator it;
+                            for(it = snapshot.ft.begin(); it != snapshot.ft.end(); it++ ) 
+                            {
+                                Bottle & b_ft = reply.addList();
+                                b_ft.addString(ine_obs_thr->getFTName(it->first).c_str());
+                                b_ft.addInt(it->second.read_count);
+                                b_ft.addInt(it->second.fed_count);
+                                b_ft.addInt(it->second.calibrating ? 1 : 0);
+                            }
+                        }
+                        else 
+                        {
+                            reply.addVocab(Vocab::encode("nack"));
+                        }
+                        cmdSize--;
+                        index++;
+                        break;
+                    }
+                case VOCAB3('r','s','t'):
+                    {
+                        iCubFT ft;
+                        string learner_name = command.size() > index+2 ? command.get(index+2).asString().c_str() : "";
+                        if( ine_obs_thr && ine_obs_thr->getFT(command.get(index+1).asString().c_str(),ft) && ine_obs_thr->requestReset(ft,learner_name) ) 
+                        {
+                            reply.addVocab(Vocab::encode("ack"));
+                        }
+                        else 
+                        {
+                            reply.addVocab(Vocab::encode("nack"));
                         }
                         cmdSize--;
                         index++;
                         break;
                     }
-                
-                /*
                 case VOCAB3('c','a','l'):    
-					{
-						fprintf(stderr,"Asking recalibration...\n");
-						if (inertiaObserver_thread)
-						{
-							inertiaObserver_thread->suspend();
-							//inertiaObserver_thread->calibrateOffset(); 
-							inertiaObserver_thread->resume();
-						}
-						fprintf(stderr,"Recalibration complete.\n");
-						reply.addVocab(Vocab::encode("rec");
-						cmdSize--;
+                    {
+                        //the offsets are computed in background by the calibrator threads,
+                        //the blocking calibration of threadInit is never run from here
+                        fprintf(stderr,"Asking recalibration...\n");
+                        if( ine_obs_thr && ine_obs_thr->requestCalibration() ) 
+                        {
+                            reply.addVocab(Vocab::encode("ack"));
+                        }
+                        else 
+                        {
+                            reply.addVocab(Vocab::encode("nack"));
+                        }
+                        cmdSize--;
+                        index++;
+                        break;
+                    }
+                case VOCAB3('d','e','c'):
+                    {
+                        if( ine_obs_thr && command.get(index+1).isInt() && ine_obs_thr->requestDecimation(command.get(index+1).asInt()) ) 
+                        {
+                            reply.addVocab(Vocab::encode("ack"));
+                        }
+                        else 
+                        {
+                            reply.addVocab(Vocab::encode("nack"));
+                        }
+                        cmdSize--;
+                        index++;
+                        break;
+                    }
+                case VOCAB4('h','e','l','p'):
+                    {
+                        reply.addString("susp: suspend the estimation");
+                        reply.addString("run: resume the estimation");
+                        reply.addString("test: stop learning, the parameters are kept fixed");
+                        reply.addString("ntes: start learning again");
+                        reply.addString("get par <ft>: offset, parameters and their standard deviations of the learners of <ft> (e.g. right_arm)");
+                        reply.addString("get stat: statistics of the estimation");
+                        reply.addString("rst <ft> [learner]: reset a learner of <ft> (all of them if not specified)");
+                        reply.addString("cal: calibrate the offsets again, from the next samples read while the limbs are still");
+                        reply.addString("dec <n>: feed one every <n> FT samples to the learners");
+                        cmdSize--;
                         index++;
                         break;
-					}
-				*/
+                    }
                 default:
                     {
                         cmdSize--;
@@ -321,6 +471,13 @@ public:
             fprintf(stderr,"'no_right_arm' option found. Right arm will be disabled.\n");
         }
         
+        bool inertial_enabled = true;
+        if (rf.check("no_inertial"))
+        {
+            inertial_enabled = false;
+            fprintf(stderr,"'no_inertial' option found. The head will be assumed still and upright.\n");
+        }
+        
         if (rf.check("enable_debug_output"))
         {
              debug_out_enabled= true;
@@ -369,6 +526,13 @@ public:
             fprintf(stderr,"'dump_static' option found.\n");
         }
         
+        string record_dataset = "";
+        if (rf.check("record_dataset") )
+        {
+            record_dataset = rf.find("record_dataset").asString().c_str();
+            fprintf(stderr,"'record_dataset' option found, recording the samples in %s_<limb>.lmds\n",record_dataset.c_str());
+        }
+        
         //--------------------CHECK FT SENSOR------------------------
         if (( (Network::exists(string("/"+robot_name+"/left_arm/analog:o").c_str())  == false) && left_arm_enabled ) || 
                 ( (Network::exists(string("/"+robot_name+"/right_arm/analog:o").c_str()) == false) && right_arm_enabled ) ||
@@ -379,7 +543,7 @@ public:
                     return false;
                 }
         //--------------------------THREAD--------------------------
-        ine_obs_thr = new inertiaObserver_thread(rate, rateEstimation, robot_name, local_name, icub_type, data_path, autoconnect, right_leg_enabled, left_leg_enabled, right_arm_enabled, left_arm_enabled, debug_out_enabled, dump_static, xml_yarpscope_file);
+        ine_obs_thr = new inertiaObserver_thread(rate, rateEstimation, robot_name, local_name, icub_type, data_path, autoconnect, right_leg_enabled, left_leg_enabled, right_arm_enabled, left_arm_enabled, debug_out_enabled, dump_static, xml_yarpscope_file, inertial_enabled, record_dataset);
 
         fprintf(stderr,"ft thread istantiated...\n");
         Time::delay(5.0);
@@ -488,8 +652,10 @@ int main(int argc, char * argv[])
         cout << "\t--no_right_leg 		    disable the right leg"         << endl;
         cout << "\t--no_left_arm            disables the left arm"                                                                           << endl;
         cout << "\t--no_right_arm           disables the right arm"     << endl;
+        cout << "\t--no_inertial            disables the inertial sensor, assuming the head still and upright"     << endl;
         cout << "\t--enable_debug_output    enable the debug output"  << endl;
         cout << "\t--dump_static    for the considered limbs dump the static FT measurments" << endl; 
+        cout << "\t--record_dataset prefix  record the regressors and the FT measurements of all the samples in prefix_<limb>.lmds" << endl;
         cout << "\t--yarpscope_xml file_path print a yarpscope xml file for debug of the installed learners " << endl;
         return 0;
     }
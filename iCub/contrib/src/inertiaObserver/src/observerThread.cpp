@@ -35,6 +35,7 @@
 #include <iCub/learningMachine/MultiTaskLinearGPRLearner.h>
 #include <iCub/learningMachine/MultiTaskLinearGPRLearnerFixedParameters.h>
 #include <iCub/learningMachine/MultiTaskLinearFixedParameters.h>
+#include <iCub/learningMachine/SufficientStatistics.h>
 
 
 #include <iostream>
@@ -44,6 +45,10 @@
 #include <limits>
 #include <fstream>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 
 #include "observerThread.h"
 #include "MatVetIO.h"
@@ -83,7 +88,8 @@ inertiaObserver_thread::inertiaObserver_thread(int _rate,int _rateEstimation,
                                                 bool _autoconnect, bool _right_leg_enabled, 
                                                 bool _left_leg_enabled, bool _right_arm_enabled, 
                                                 bool _left_arm_enabled,bool _debug_out_enabled, 
-                                                bool _dump_static, string _xml_yarpscope_file) : RateThread(_rate), rateEstimation(_rateEstimation), robot_name(_robot_name), local_name(_local_name), icub_type(_icub_type), data_path(_data_path), autoconnect(_autoconnect), right_leg_enabled(_right_leg_enabled), left_leg_enabled(_left_leg_enabled), right_arm_enabled(_right_arm_enabled), left_arm_enabled(_left_arm_enabled), debug_out_enabled(_debug_out_enabled), dump_static(_dump_static), xml_yarpscope_file(_xml_yarpscope_file)
+                                                bool _dump_static, string _xml_yarpscope_file,
+                                                bool _inertial_enabled, string _record_dataset) : RateThread(_rate), rateEstimation(_rateEstimation), robot_name(_robot_name), local_name(_local_name), icub_type(_icub_type), data_path(_data_path), autoconnect(_autoconnect), right_leg_enabled(_right_leg_enabled), left_leg_enabled(_left_leg_enabled), right_arm_enabled(_right_arm_enabled), left_arm_enabled(_left_arm_enabled), debug_out_enabled(_debug_out_enabled), dump_static(_dump_static), record_dataset(_record_dataset), inertial_enabled(_inertial_enabled), use_specialized_regressors(true), xml_yarpscope_file(_xml_yarpscope_file)
 {
     //ugly, change ASAP todo
     //Information on iCub/FT sensor structure
@@ -165,14 +171,30 @@ inertiaObserver_thread::inertiaObserver_thread(int _rate,int _rateEstimation,
     
     
     ftStdDev[ICUB_FT_LEFT_ARM] = ftStdDev[ICUB_FT_RIGHT_ARM];
+    //no identification of the noise of the leg sensors, the ones of the arms are used
+    ftStdDev[ICUB_FT_RIGHT_LEG] = ftStdDev[ICUB_FT_RIGHT_ARM];
+    ftStdDev[ICUB_FT_LEFT_LEG] = ftStdDev[ICUB_FT_RIGHT_ARM];
     
     learning_enabled = true;
+    decimation = 1;
+    
+    requested_learning = -1;
+    requested_decimation = 0;
+    requested_calibration = false;
+    requested_parameters_sd = false;
+    parameters_sd_pending = false;
+    
+    snapshot_sequence = 0;
+    snapshot_work.time = -1.0;
+    snapshot_shared.time = -1.0;
+    snapshot_work.has_parameters_sd = false;
+    snapshot_shared.has_parameters_sd = false;
 
     
      
 
     //---------------------PORT--------------------------//
-    port_inertial_thread=new BufferedPort<Vector>;
+    port_inertial = new inertialCollector(&current_state_estimator);
     
     for(vector<iCubLimb>::size_type i = 0; i != vectorLimbs.size(); i++) {
         if( is_enabled[vectorLimbs[i]] ) {
@@ -185,14 +207,16 @@ inertiaObserver_thread::inertiaObserver_thread(int _rate,int _rateEstimation,
         if( is_enabled[FTlimb[vectorFT[i]]] ) {
             port_ft[vectorFT[i]] = new FTCollector(vectorFT[i],&current_state_estimator);
             if( dump_static ) {
-                //onlineMeanFT[vectorFT[i]].reset();
-                //onlineMeanRegr[vectorFT[i]].reset();
+                static_regr_writer[vectorFT[i]] = 0;
+                static_ft_writer[vectorFT[i]] = 0;
+                static_sample_count[vectorFT[i]] = 0;
                 static_dump_count[vectorFT[i]] = 0;
             }
         }
     }
 
-    port_inertial_thread->open(string("/"+local_name+"/inertial:i").c_str());
+    port_inertial->useCallback();
+    port_inertial->open(string("/"+local_name+"/inertial:i").c_str());
     
     
     for(vector<iCubLimb>::size_type i = 0; i != vectorLimbs.size(); i++) {
@@ -223,6 +247,9 @@ inertiaObserver_thread::inertiaObserver_thread(int _rate,int _rateEstimation,
         
         //Network::connect(string("/"+local_name+"/filtered/inertial:o").c_str(),string("/"+local_name+"/inertial:i").c_str(),"tcp",false);			
         //Network::connect(string("/"+robot_name+"/inertial").c_str(),           string("/"+local_name+"/unfiltered/inertial:i").c_str(),"tcp",false);
+        if( inertial_enabled ) {
+            Network::connect(string("/"+robot_name+"/inertial").c_str(),string("/"+local_name+"/inertial:i").c_str(),"tcp",false);
+        }
             
         for(vector<iCubLimb>::size_type i = 0; i != vectorLimbs.size(); i++) {
             if( is_enabled[vectorLimbs[i]] ) {
@@ -246,6 +273,11 @@ inertiaObserver_thread::inertiaObserver_thread(int _rate,int _rateEstimation,
     
     //----------INIT icub object--------------------//
     icub = new iCubWholeBody(icub_type, DYNAMIC);
+    
+    //limbs of the upper torso are addressed by handle, without comparing their names at each sample
+    upperTorsoHandles[ICUB_HEAD] = icub->upperTorso->getLimbHandle(limbNames[ICUB_HEAD]);
+    upperTorsoHandles[ICUB_RIGHT_ARM] = icub->upperTorso->getLimbHandle(limbNames[ICUB_RIGHT_ARM]);
+    upperTorsoHandles[ICUB_LEFT_ARM] = icub->upperTorso->getLimbHandle(limbNames[ICUB_LEFT_ARM]);
 
 }
 
@@ -258,6 +290,16 @@ bool inertiaObserver_thread::threadInit()
     
     N_samples = 0;
     
+    if( inertial_enabled ) {
+        Vector inertial;
+        if( current_state_estimator.getInertial(inertial) == -1.0 ) {
+            fprintf(stderr,"threadInit: no inertial measure received on %s, assuming the head still and upright \n\n",port_inertial->getName().c_str());
+            inertial_enabled = false;
+        } else {
+            fprintf(stderr,"threadInit: using the inertial measure for the base kinematics \n\n");
+        }
+    }
+    
     if( debug_out_enabled ) {
         calibrateOffset();
     }
@@ -276,11 +318,54 @@ bool inertiaObserver_thread::threadInit()
                     << ", static identifiable parameters subspace size : " <<  static_identifiable_parameters[vectorFT[i]].cols() 
                     << " of " <<  static_identifiable_parameters[vectorFT[i]].rows() << endl; 
             //}
+            if( dump_static ) {
+                //the static regressor has 6 rows for each still phase, with the offset in the last 6 columns
+                int n_static_cols = static_identifiable_parameters[vectorFT[i]].cols()+6;
+                static_regr_sum[vectorFT[i]].resize(6,n_static_cols);
+                static_regr_sum[vectorFT[i]].zero();
+                static_ft_sum[vectorFT[i]].resize(6,0.0);
+                static_regr_writer[vectorFT[i]] = new MatVetWriter;
+                static_ft_writer[vectorFT[i]] = new MatVetWriter;
+                //each still phase is a single row, so the header is updated after every phase
+                if( !static_regr_writer[vectorFT[i]]->open("staticRegr_"+limbNames[FTlimb[vectorFT[i]]]+".ymt",n_static_cols,false,false,6) ||
+                    !static_ft_writer[vectorFT[i]]->open("staticFT_"+limbNames[FTlimb[vectorFT[i]]]+".yvc",1,true,false,6) ) {
+                    fprintf(stderr,"threadInit: could not open the static dataset files for %s\n",limbNames[FTlimb[vectorFT[i]]].c_str());
+                    return false;
+                }
+            }
                dynamic_identifiable_parameters[vectorFT[i]] = getOnlyDynamicParam(identifiable_parameters[vectorFT[i]]);
                   cerr    << "threadInit: FT " << limbNames[FTlimb[vectorFT[i]]] 
                     << ", only dynamic identifiable parameters subspace size : " <<  dynamic_identifiable_parameters[vectorFT[i]].cols() 
-                    << " of " <<  dynamic_identifiable_parameters[vectorFT[i]].rows() << endl; 
- 
+                    << " of " <<  dynamic_identifiable_parameters[vectorFT[i]].rows() << endl;
+
+            //Allocating the buffers used in run()
+            iDynSensor * p_sensor;
+            iDynChain * p_chain;
+            int virtual_link;
+            const int first_torque = 3;
+            iCubLimbGetData(icub,limbNames[FTlimb[vectorFT[i]]],/*consider_virtual_link=*/false,p_chain,p_sensor,virtual_link);
+            workspace[vectorFT[i]].resize(identifiable_parameters[vectorFT[i]].rows(),
+                                          identifiable_parameters[vectorFT[i]].cols(),
+                                          static_identifiable_parameters[vectorFT[i]].cols(),
+                                          dynamic_identifiable_parameters[vectorFT[i]].cols(),
+                                          first_torque,
+                                          std::max(0,(int)p_chain->getN()-first_torque));
+            if( !workspace[vectorFT[i]].setBases(identifiable_parameters[vectorFT[i]],static_identifiable_parameters[vectorFT[i]],dynamic_identifiable_parameters[vectorFT[i]]) ) {
+                cerr << "threadInit: FT " << limbNames[FTlimb[vectorFT[i]]] << ", error in setting the identifiable subspaces slices" << endl;
+                return false;
+            }
+            if( debug_out_enabled ) {
+                double max_error;
+                if( iDynChainRegressorCheckSpecialized(p_chain,p_sensor,max_error,virtual_link) ) {
+                    cerr << "threadInit: FT " << limbNames[FTlimb[vectorFT[i]]] << ", specialized regressors error with respect to the generic ones : " << max_error << endl;
+                } else {
+                    cerr << "threadInit: FT " << limbNames[FTlimb[vectorFT[i]]] << ", no specialized regressors available, using the generic ones" << endl;
+                }
+            }
+            workspace[vectorFT[i]].ftWeights = ftStdDev[vectorFT[i]];
+            for(int j=0; j < (int)workspace[vectorFT[i]].ftWeights.size(); j++ ) {
+                workspace[vectorFT[i]].ftWeights[j] = ftStdDev[vectorFT[i]][j]*ftStdDev[vectorFT[i]][j];
+            }
         }
     }
     
@@ -324,6 +409,22 @@ bool inertiaObserver_thread::threadInit()
 
             }
             
+            offsetCalibrators[vectorFT[i]] = 0;
+            if( FTlimb[vectorFT[i]] == ICUB_RIGHT_ARM || FTlimb[vectorFT[i]] == ICUB_LEFT_ARM ) {
+                offsetCalibrators[vectorFT[i]] = new offsetCalibrator(icub_type,limbNames[FTlimb[vectorFT[i]]]);
+                offsetCalibrators[vectorFT[i]]->start();
+            }
+            
+            datasetRecorders[vectorFT[i]] = 0;
+            if( record_dataset != "" ) {
+                MatrixDatasetRecorder * recorder = new MatrixDatasetRecorder(6,identifiable_parameters[vectorFT[i]].cols()+6,6);
+                Property recorder_config;
+                recorder_config.put("filename",(record_dataset+"_"+limbNames[FTlimb[vectorFT[i]]]+".lmds").c_str());
+                recorder_config.put("format","binary");
+                recorder->configure(recorder_config);
+                recorder->setSource(FTlimb[vectorFT[i]]);
+                datasetRecorders[vectorFT[i]] = recorder;
+            }
         }
     }
     
@@ -339,6 +440,10 @@ bool inertiaObserver_thread::threadInit()
     
     static_estimated_out_port = new BufferedPort<Vector>;
     static_estimated_out_port->open(string("/"+local_name+"/"+FTNames[ICUB_FT_RIGHT_ARM]+"/FT_static_RLS_estimated:o").c_str());
+    
+    static_information_out_port = new BufferedPort<Bottle>;
+    static_information_out_port->open(string("/"+local_name+"/"+FTNames[ICUB_FT_RIGHT_ARM]+"/static_information:o").c_str());
+    last_information_time = -1.0;
   
     
     //If debug is enabled, open output debug ports
@@ -375,6 +480,10 @@ bool inertiaObserver_thread::threadInit()
         }
     }
 
+    //the readers do not access the snapshots until the first publication
+    initSnapshot(snapshot_work);
+    initSnapshot(snapshot_shared);
+
     debug_generate_yarpscope_xml(ICUB_FT_RIGHT_ARM);
     debug_generate_yarpscope_xml(ICUB_FT_RIGHT_ARM,true);
     debug_generate_yarpscope_xml_only_param(ICUB_FT_RIGHT_ARM);
@@ -392,10 +501,6 @@ void inertiaObserver_thread::run()
 {
 	static int call_count = 0;
     
-    Matrix Phi, Phi_w_offset;
-    Matrix Phi_static_w_offset;
-    Matrix Phi_dynamic;
-    
     map<iCubFT,double> W_timestamp;
     
     bool read_success;
@@ -413,6 +518,8 @@ void inertiaObserver_thread::run()
 
     call_count++;
     
+    applyRequests();
+    
     tic_run = yarp::os::Time::now();
 
 
@@ -434,6 +541,25 @@ void inertiaObserver_thread::run()
             limbIsStill = current_state_estimator.isStill(currLimb) && current_state_estimator.isStill(ICUB_HEAD);
             
             if( read_success ) {
+                #ifdef INERTIAOBSERVER_COUNT_ALLOCATIONS
+                //the estimation step of a sample is checked, from the regressors to the update of the 
+                //learners (other threads allocating at the same time are counted too)
+                unsigned long alloc_count = estimationWorkspace::getAllocationCount();
+                #endif
+                estimationWorkspace & ws = workspace[currFT];
+                read_sample_count[currFT]++;
+                
+                //Get current regressor projections on the identifiable
+                //subspaces (with offset regression), in the preallocated buffers
+                //(the complete regressor is computed only for the debug analysis)
+                if( debug_out_enabled ) {
+                    iCubLimbRegressorSensorWrench(icub,limbNames[currLimb],ws.Phi,false,use_specialized_regressors);
+                    estimationWorkspace::projectRegressor(ws.Phi,0,identifiable_parameters[currFT],ws.Phi_w_offset);
+                    estimationWorkspace::projectRegressor(ws.Phi,0,static_identifiable_parameters[currFT],ws.Phi_static_w_offset);
+                    estimationWorkspace::projectRegressor(ws.Phi,0,dynamic_identifiable_parameters[currFT],ws.Phi_dynamic);
+                } else {
+                    ws.computeRegressors(icub,limbNames[currLimb]);
+                }
                 
                 if( limbIsStill  ) {
                     //if(verbose) fprintf(stderr,"Estimate not updated because the arm was still for more than half a second\n");
@@ -444,23 +570,25 @@ void inertiaObserver_thread::run()
                     //It was not still, now it is
                     wasStill[currLimb] = true;
                     //}
+                    if( offsetCalibrators[currFT] ) {
+                        //only copied in the ring of the calibration thread, that computes the CAD wrench
+                        //(nothing is done if no calibration is in progress)
+                        offsetCalibrators[currFT]->addSample(ws.q_limb,ws.dq_limb,ws.ddq_limb,ws.q_head,ws.dq_head,ws.ddq_head,
+                                                             ws.w0,ws.dw0,ws.d2p0,measuredW[currFT]);
+                    }
                     if( dump_static ) {
-                        //calculate regressor only for static case
-                        //Get current static regressors
-                        Matrix Phi_reduced_static;	
-                        //fprintf(stderr,"Read FT success!\n");
-                        //Doing an online estimation step
-                        iCubLimbRegressorSensorWrench(icub,limbNames[currLimb],Phi);
-                        //Considering only identifable parameters
-                        Phi_reduced_static = Phi*static_identifiable_parameters[currFT];
-                    
-                        //Adding offset regression
-                        Phi_w_offset = Matrix(Phi_reduced_static.rows(),Phi_reduced_static.cols()+6);
-                        Phi_w_offset.setSubmatrix(Phi_reduced_static,0,0);
-                        Phi_w_offset.setSubmatrix(eye(6,6),0,Phi_reduced_static.cols());
-                        
-                        //onlineMeanFT[currFT].feedSample(measuredW[currFT]);
-                        //onlineMeanRegr[currFT].feedSample(Phi_w_offset);
+                        //static regressor already in ws.Phi_static_w_offset
+                        Matrix & regr_sum = static_regr_sum[currFT];
+                        Vector & ft_sum = static_ft_sum[currFT];
+                        for(int r=0; r < 6; r++ ) {
+                            const double * regr_row = ws.Phi_static_w_offset[r];
+                            double * sum_row = regr_sum[r];
+                            for(int c=0; c < regr_sum.cols(); c++ ) {
+                                sum_row[c] += regr_row[c];
+                            }
+                            ft_sum[r] += measuredW[currFT][r];
+                        }
+                        static_sample_count[currFT]++;
                     }
                     
                 } else {
@@ -469,74 +597,42 @@ void inertiaObserver_thread::run()
                         //It was still, now it is moving
                         wasStill[currLimb] = false;
                         if( dump_static ) {
-                            Matrix regrMean;
-                            Vector ftMean;
-                            //use mean... what to do?
-                            //Store for offline learning? use as sample for a static online method                             
-                            //ftMean = onlineMeanFT[currFT].getMean();
-                            //regrMean = onlineMeanRegr[currFT].getMean();
-                            /*
-                            if( onlineMeanFT[currFT].getSampleNum() > 100 ) { //If was stopped for more than a second
-                                //std::cerr << "Dumping static " << static_dump_count[currFT] << std::endl;
-                                if( static_dump_count[currFT] == 0 ) {
-                                    allStaticRegr[currFT] = regrMean;
-                                    allStaticFT[currFT] = ftMean;
-                                    //std::cerr << "fist static_dump: allStaticFT[currFT] " << allStaticFT[currFT].size() << std::endl;
+                            //the mean of the still phase is appended to the static dataset,
+                            //if the limb was still for more than a second
+                            int n = static_sample_count[currFT];
+                            if( n > 100 ) {
+                                Matrix & regr_sum = static_regr_sum[currFT];
+                                Vector & ft_sum = static_ft_sum[currFT];
+                                for(int r=0; r < 6; r++ ) {
+                                    double * sum_row = regr_sum[r];
+                                    for(int c=0; c < regr_sum.cols(); c++ ) {
+                                        sum_row[c] /= n;
+                                    }
+                                    ft_sum[r] /= n;
+                                }
+                                if( static_regr_writer[currFT]->append(regr_sum) && static_ft_writer[currFT]->append(ft_sum) ) {
                                     static_dump_count[currFT]++;
                                 } else {
-                                    YARP_ASSERT( 6*static_dump_count[currFT] == allStaticRegr[currFT].rows());
-                                    YARP_ASSERT( (unsigned)allStaticRegr[currFT].rows() == allStaticFT[currFT].size() );
-                                    YARP_ASSERT( 6 == regrMean.rows() );
-                                    allStaticRegr[currFT] = pile(allStaticRegr[currFT],regrMean);  
-                                    allStaticFT[currFT] = cat(allStaticFT[currFT],ftMean);
-                                    static_dump_count[currFT]++;
+                                    fprintf(stderr,"run: error in writing the static dataset of %s\n",limbNames[currLimb].c_str());
                                 }
-                            }*/
-                            //onlineMeanFT[currFT].reset();
-                            //onlineMeanRegr[currFT].reset();
-                            
+                            }
+                            static_regr_sum[currFT].zero();
+                            static_ft_sum[currFT].zero();
+                            static_sample_count[currFT] = 0;
                         }
                     }
                 }
                 
                 oneReadWasSuccess = true;
                 if( debug_out_enabled ) {
-                    //calculate regressor is limb is not still only if debug in enabled 
-                    //Get current regressors
-                    Matrix Phi_reduced, Phi_forces, Phi_torques;	
-                    //fprintf(stderr,"Read FT success!\n");
-                    //Doing an online estimation step
-                    iCubLimbRegressorSensorWrench(icub,limbNames[currLimb],Phi);
-                    //Considering only identifable parameters
-                    Phi_reduced = Phi*identifiable_parameters[currFT];
-                    
-                    Phi_forces = Phi.submatrix(0,2,0,Phi.cols()-1);
-                    Phi_torques = Phi.submatrix(3,5,0,Phi.cols()-1);
-                    
-                    //Mixed regressor
-                    Matrix Phi_static;
-                    Phi_static = Phi*static_identifiable_parameters[currFT];
-                    Phi_static_w_offset = Matrix(Phi_static.rows(),Phi_static.cols()+6);
-                    Phi_static_w_offset.setSubmatrix(Phi_static,0,0);
-                    Phi_static_w_offset.setSubmatrix(eye(6,6),0,Phi_static.cols());       
-                    
-                    Phi_dynamic = Phi*dynamic_identifiable_parameters[currFT];             
-                    
-                    
-                    ATA = ATA + Phi.transposed()*diagonalMatrix(ftStdDev[ICUB_FT_RIGHT_ARM])*diagonalMatrix(ftStdDev[ICUB_FT_RIGHT_ARM])*Phi;
-                    ATA_forces = ATA_forces + Phi_forces.transposed()*Phi_forces;
-                    ATA_torques = ATA_torques + Phi_torques.transposed()*Phi_torques;
+                    //ATA = ATA + Phi^T*diag(ftStdDev)*diag(ftStdDev)*Phi
+                    estimationWorkspace::addGram(ws.Phi,0,5,ws.ftWeights,ATA);
+                    estimationWorkspace::addGram(ws.Phi,0,2,ATA_forces);
+                    estimationWorkspace::addGram(ws.Phi,3,5,ATA_torques);
                     N_samples++;
                     
-                    //Adding offset regression
-                    Phi_w_offset = Matrix(Phi_reduced.rows(),Phi_reduced.cols()+6);
-                    Phi_w_offset.setSubmatrix(Phi_reduced,0,0);
-                    Phi_w_offset.setSubmatrix(eye(6,6),0,Phi_reduced.cols());
-                    
-                    Matrix Phi_complete, Phi_tau;
-                    iCubLimbRegressorComplete(icub,limbNames[currLimb],Phi_complete);
-                    Phi_tau = Phi_complete.submatrix(6,Phi_complete.rows()-1,0,Phi_complete.cols()-1);
-                    TauTTau = TauTTau + Phi_tau.transposed()*Phi_tau;
+                    iCubLimbRegressorCompleteBlockSparse(icub,limbNames[currLimb],ws.Phi_complete);
+                    ws.Phi_complete.addGram(6,ws.Phi_complete.rows()-1,TauTTau);
                     
                     //if debug is activated, output the estimation of the measure and the real one
                     if( debug_out_enabled ) {
@@ -549,21 +645,20 @@ void inertiaObserver_thread::run()
                         int virtual_link;
                         iCubLimbGetData(icub,limbNames[currLimb],/*consider_virtual_link=*/false,p_chain,p_sensor,virtual_link);
 
-                        Matrix torques_regressor(0,Phi.cols()); 
-                        int first_torque = 3;
-                        int Ntorques = p_chain->getN()-first_torque;
+                        int first_torque = ws.first_torque;
+                        int Ntorques = ws.n_torques;
+                        YARP_ASSERT(Ntorques == (int)p_chain->getN()-first_torque);
 
                         //Calculate torque estimation regressor, right arms arms only
+                        //(the rows of ws.torques_regressor start from the first joint after the sensor)
+                        iDynChainRegressorTorquesEstimation(p_chain,p_sensor,ws.torques_regressor,virtual_link,use_specialized_regressors);
+                        const int first_row = first_torque-p_sensor->getSensorLink()-1;
                         for( int joint_index = first_torque; joint_index < first_torque+Ntorques; joint_index++ ) {
-                            Vector T = iDynChainRegressorTorqueEstimation(p_chain,p_sensor,joint_index,virtual_link);
-                            TTT[joint_index] = TTT[joint_index] + outerProduct(T,T);
-                            torques_regressor = pile(torques_regressor,T);
+                            const int row = first_row+joint_index-first_torque;
+                            estimationWorkspace::addGram(ws.torques_regressor,row,row,TTT[joint_index]);
                         }
-                        torques_regressor = torques_regressor*identifiable_parameters[currFT];
-                        
-                        Matrix torques_regressor_w_offset = Matrix(torques_regressor.rows(),torques_regressor.cols()+6);
-                        torques_regressor_w_offset.setSubmatrix(torques_regressor,0,0);
-                        torques_regressor_w_offset.setSubmatrix(zeros(6,6),0,torques_regressor.cols());
+                        //the offset columns of torques_regressor_w_offset are always zero
+                        estimationWorkspace::projectRegressor(ws.torques_regressor,first_row,identifiable_parameters[currFT],ws.torques_regressor_w_offset);
                         
                         //torques_sensor[0] = (adjointInv(p_sensor->getH_i_s(2)).transposed()*measuredW[currFT])[5];
                         //torques_sensor[1] = (adjointInv(p_sensor->getH_i_s(3)).transposed()*measuredW[currFT])[5];
@@ -571,22 +666,24 @@ void inertiaObserver_thread::run()
                         //------------------------------------------------
                         // Code for checking accuracy of projected torques
                         //------------------------------------------------
-                        Matrix Y;
-                        Matrix JY_1(Ntorques,Phi_reduced.cols()), YTF, YTB; // YTF + JY_1 == YTB
-                        iDynChainRegressorComplete(icub->upperTorso->right->asChain(), icub->upperTorso->rightSensor,Y,5);
-                        YTB = Y.submatrix(6,6+Ntorques-1,0,Y.cols()-1)*identifiable_parameters[currFT];
-                        YTF = torques_regressor;
-                         int joint_index;
+                        // YTF + JY_1 == YTB, with YTF the first ws.n_ident columns of ws.torques_regressor_w_offset
+                        iDynChainRegressorCompleteBlockSparse(icub->upperTorso->right->asChain(), icub->upperTorso->rightSensor,ws.Y,5);
+                        ws.Y.project(identifiable_parameters[currFT],ws.YTB,6);
+                        int joint_index;
                         for(joint_index = first_torque; joint_index < first_torque+Ntorques; joint_index++ ) {
-                            Vector JY = (adjointInv(p_sensor->getH_i_s(joint_index-1)).transposed()*Phi_reduced).getRow(5);
-                            JY_1.setRow(joint_index-first_torque,JY);
-                        }
-                        
-                        
-                        Matrix JacTor(Ntorques,6);
-                        for( joint_index = first_torque; joint_index < first_torque+Ntorques; joint_index++ ) {
-                            Vector Jrow = (adjointInv(p_sensor->getH_i_s(joint_index-1)).transposed()).getRow(5);
-                            JacTor.setRow(joint_index-first_torque,Jrow);
+                            //JacTor row is the last row of adjointInv(H_i_s)^T, JY_1 = JacTor*Phi_reduced
+                            estimationWorkspace::adjointInv(p_sensor->getH_i_s(joint_index-1),ws.adInv);
+                            int row = joint_index-first_torque;
+                            for(int k=0; k < 6; k++ ) {
+                                ws.JacTor(row,k) = ws.adInv(k,5);
+                            }
+                            for(int c=0; c < ws.n_ident; c++ ) {
+                                double sum = 0.0;
+                                for(int k=0; k < 6; k++ ) {
+                                    sum += ws.adInv(k,5)*ws.Phi_w_offset(k,c);
+                                }
+                                ws.JY_1(row,c) = sum;
+                            }
                         }
                         /**
                         Vector JWmeasured(Ntorques);
@@ -626,25 +723,28 @@ void inertiaObserver_thread::run()
                         measured_out_port[currFT]->write();
                         
                         //Mixed prediction
-                        Prediction pred_static, pred_dynamic;
-                        pred_static = staticParamEstimator->predict(Phi_static_w_offset);
-                        pred_dynamic = dynamicParamEstimator->predict(Phi_dynamic);
-                        mixed_estimated_out_port->prepare() = pred_static.getPrediction() + pred_dynamic.getPrediction();
+                        staticParamEstimator->predict(ws.Phi_static_w_offset,ws.static_prediction,ws.static_prediction_sd);
+                        dynamicParamEstimator->predict(ws.Phi_dynamic,ws.dynamic_prediction,ws.dynamic_prediction_sd);
+                        Vector & mixed_prediction = mixed_estimated_out_port->prepare();
+                        mixed_prediction.resize(6);
+                        for(int r=0; r < 6; r++ ) {
+                            mixed_prediction[r] = ws.static_prediction[r]+ws.dynamic_prediction[r];
+                        }
                         mixed_estimated_out_port->setEnvelope(info);
                         mixed_estimated_out_port->write();
                         
-                        std::cerr << "Debug static " << pred_static.getPrediction().toString() << std::endl;
-                        std::cerr << "Debug dynamic " << pred_dynamic.getPrediction().toString() << std::endl;
+                        std::cerr << "Debug static " << ws.static_prediction.toString() << std::endl;
+                        std::cerr << "Debug dynamic " << ws.dynamic_prediction.toString() << std::endl;
 
                         
-                        static_estimated_out_port->prepare() = pred_static.getPrediction();
+                        static_estimated_out_port->prepare() = ws.static_prediction;
                         static_estimated_out_port->setEnvelope(info);
                         static_estimated_out_port->write();
                         
                         
                         for(unsigned int j=0; j < paramEstimators[currFT].size(); j++ ) {
                             Prediction pred;
-                            pred = paramEstimators[currFT][j]->predict(Phi_w_offset);
+                            pred = paramEstimators[currFT][j]->predict(ws.Phi_w_offset);
                             estimated_out_port[currFT][j]->prepare() = pred.getPrediction();
                             estimated_out_port[currFT][j]->setEnvelope(info);
                             estimated_out_port[currFT][j]->write();
@@ -661,7 +761,7 @@ void inertiaObserver_thread::run()
                             
 
 
-                            Prediction pred_torques = paramEstimators[currFT][j]->predict(torques_regressor_w_offset);
+                            Prediction pred_torques = paramEstimators[currFT][j]->predict(ws.torques_regressor_w_offset);
                             //Prediction pred_torques_cad = paramEstimators[currFT][2]->predict(torques_regressor_w_offset);
                             /* 
                             Vector est_torques_cad = torques_regressor*identifiable_parameters[currFT]*(params).subVector(0,params.size()-7);
@@ -725,10 +825,10 @@ void inertiaObserver_thread::run()
                             //cout << "Error in using different regressor  1:" << norm( YTF*par + JY_1*par - YTB*par) << endl;
                             //cout << "Error in using different regressors 2:" << norm(JY_1*par - JacTor*Phi_reduced*par) << endl;
                             
-                            estimated_forward_inertial_torques[currFT][j]->prepare() = YTF*par;
-                            estimated_backward_inertial_torques[currFT][j]->prepare() = YTB*par;
-                            estimated_FT_sens_torques[currFT][j]->prepare() = JY_1*par;
-                            measured_FT_sens_torques[currFT][j]->prepare() = JacTor*(measuredW[currFT]-offset_par);
+                            estimationWorkspace::multiplyBlock(ws.torques_regressor_w_offset,ws.n_ident,par,estimated_forward_inertial_torques[currFT][j]->prepare());
+                            estimationWorkspace::multiplyBlock(ws.YTB,ws.n_ident,par,estimated_backward_inertial_torques[currFT][j]->prepare());
+                            estimationWorkspace::multiplyBlock(ws.JY_1,ws.n_ident,par,estimated_FT_sens_torques[currFT][j]->prepare());
+                            measured_FT_sens_torques[currFT][j]->prepare() = ws.JacTor*(measuredW[currFT]-offset_par);
                             
                             estimated_forward_inertial_torques[currFT][j]->setEnvelope(info);
                             estimated_backward_inertial_torques[currFT][j]->setEnvelope(info);
@@ -762,32 +862,31 @@ void inertiaObserver_thread::run()
                 
                 //if( !limbIsStill ) {
                     //by default using the first one, if debug is enabled use more
-                if( learning_enabled ) {
-                    for(unsigned int j=0; j < paramEstimators[currFT].size(); j++ ) {
-                        paramEstimators[currFT][j]->feedSample(Phi_w_offset,measuredW[currFT]);
-                    }
-                    
-                    if( limbIsStill ) {
-                        staticParamEstimator->feedSample(Phi_static_w_offset,measuredW[currFT]);
-                    } else {
-                        Prediction pred_static;
-                        pred_static = staticParamEstimator->predict(Phi_static_w_offset);
-                        Vector pred_sd = pred_static.getVariance();
-                        double max = -1.0;
-                        for(int i = 0; i < pred_sd.size(); i++ ) {
-                            if( max < pred_sd[i]) {
-                                max = pred_sd[i];
-                            }
-                        }
-                        //std::cerr << "Static uncert max " << max << std::endl; 
-                        
-                        if( max < 0.2 ) {
-                            dynamicParamEstimator->feedSample(Phi_dynamic,measuredW[currFT]-pred_static.getPrediction());
-                        }
-                        
+                if( datasetRecorders[currFT] ) {
+                    try {
+                        datasetRecorders[currFT]->setTimestamp(W_timestamp[currFT]);
+                        datasetRecorders[currFT]->feedSample(ws.Phi_w_offset,measuredW[currFT]);
+                    } catch(const std::exception & e) {
+                        cerr << "run: recording of " << limbNames[currLimb] << " disabled: " << e.what() << endl;
+                        delete datasetRecorders[currFT];
+                        datasetRecorders[currFT] = 0;
                     }
                 }
+                
+                if( learning_enabled && (read_sample_count[currFT] % decimation) == 0 ) {
+                    fed_sample_count[currFT]++;
+                    //the dynamic estimator is fed with the residual of the static one, if its
+                    //prediction is accurate enough
+                    ws.feedLearners(paramEstimators[currFT],staticParamEstimator,dynamicParamEstimator,measuredW[currFT],limbIsStill);
+                }
                 //}
+                
+                #ifdef INERTIAOBSERVER_COUNT_ALLOCATIONS
+                //the debug outputs are not part of the steady state
+                if( !debug_out_enabled && estimationWorkspace::getAllocationCount() != alloc_count ) {
+                    fprintf(stderr,"run: %lu allocations in the estimation step of a sample\n",estimationWorkspace::getAllocationCount()-alloc_count);
+                }
+                #endif
             }
                 
         } while( read_success );
@@ -796,6 +895,12 @@ void inertiaObserver_thread::run()
         //~~~~~~~~~~~~~~
         toc_run = yarp::os::Time::now();
         run_period.feedSample(toc_run-tic_run);
+        
+        //the information of the static estimation changes slowly, it is published once per second
+        if( learning_enabled && static_information_out_port->getOutputCount() > 0 && toc_run-last_information_time > 1.0 ) {
+            publishStaticInformation();
+            last_information_time = toc_run;
+        }
         if( call_count % 100 == 0 ) {
             //fprintf(stderr,"Correct run method, duration: %lf, mean %lf\n",toc_run-tic_run,run_period.getMean());
             //fprintf(stderr,"W_timestamp icub_right_arm %lf\n",W_timestamp[ICUB_FT_RIGHT_ARM]);
@@ -812,6 +917,321 @@ void inertiaObserver_thread::run()
          
 
     }
+    
+    if( call_count % snapshot_period == 0 ) {
+        publishSnapshot(call_count);
+    }
+}
+
+void inertiaObserver_thread::applyRequests()
+{
+    int new_learning, new_decimation;
+    bool calibration;
+    vector< pair<iCubFT,string> > resets;
+    
+    //the requests are taken in a short critical section, and applied outside of it
+    request_mutex.wait();
+    new_learning = requested_learning;
+    new_decimation = requested_decimation;
+    calibration = requested_calibration;
+    parameters_sd_pending = parameters_sd_pending || requested_parameters_sd;
+    resets.swap(requested_resets);
+    requested_learning = -1;
+    requested_decimation = 0;
+    requested_calibration = false;
+    requested_parameters_sd = false;
+    request_mutex.post();
+    
+    if( new_learning != -1 ) {
+        learning_enabled = (new_learning == 1);
+        fprintf(stderr,"applyRequests: learning %s\n",learning_enabled ? "enabled" : "disabled");
+    }
+    if( new_decimation > 0 ) {
+        decimation = new_decimation;
+        fprintf(stderr,"applyRequests: feeding one every %d FT samples to the learners\n",decimation);
+    }
+    for(unsigned int i=0; i < resets.size(); i++ ) {
+        iCubFT ft = resets[i].first;
+        for(unsigned int j=0; j < paramEstimators[ft].size(); j++ ) {
+            if( resets[i].second == "" || resets[i].second == paramEstimators[ft][j]->getName() ) {
+                fprintf(stderr,"applyRequests: resetting %s of %s\n",paramEstimators[ft][j]->getName().c_str(),FTNames[ft].c_str());
+                paramEstimators[ft][j]->reset();
+            }
+        }
+        fed_sample_count[ft] = 0;
+    }
+    if( calibration ) {
+        fprintf(stderr,"applyRequests: collecting the still samples for the calibration of the offsets\n");
+    }
+    for(vector<iCubFT>::size_type i = 0; i != vectorFT.size(); i++) {
+        iCubFT ft = vectorFT[i];
+        if( !is_enabled[FTlimb[ft]] || !offsetCalibrators[ft] ) continue;
+        if( calibration ) {
+            offsetCalibrators[ft]->startCollection();
+        }
+        //a completed calibration is installed between two cycles, as a whole
+        Vector new_offset;
+        if( offsetCalibrators[ft]->getOffset(new_offset) ) {
+            offset[ft] = new_offset;
+            for(unsigned int j=0; j < paramEstimators[ft].size(); j++ ) {
+                //the offset is a parameter of the CAD model
+                MultiTaskLinearFixedParameters * cad_learner = dynamic_cast<MultiTaskLinearFixedParameters *>(paramEstimators[ft][j]);
+                if( cad_learner ) {
+                    Vector cad_parameters = cad_learner->getParameters();
+                    cad_parameters.setSubvector(cad_parameters.size()-6,new_offset);
+                    cad_learner->setParameters(cad_parameters);
+                }
+            }
+            fprintf(stderr,"applyRequests: new offset of %s: %s\n",FTNames[ft].c_str(),new_offset.toString().c_str());
+        }
+    }
+}
+
+void inertiaObserver_thread::initSnapshot(observerSnapshot & snapshot)
+{
+    snapshot.ft.clear();
+    for(vector<iCubFT>::size_type i = 0; i != vectorFT.size(); i++) {
+        iCubFT ft = vectorFT[i];
+        if( !is_enabled[FTlimb[ft]] ) continue;
+        ftSnapshot & ft_snapshot = snapshot.ft[ft];
+        ft_snapshot.read_count = 0;
+        ft_snapshot.fed_count = 0;
+        ft_snapshot.calibrating = false;
+        ft_snapshot.offset.resize(6,0.0);
+        //the names of the learners do not change after threadInit
+        unsigned int n = paramEstimators[ft].size();
+        ft_snapshot.names.resize(n);
+        ft_snapshot.parameters.resize(n);
+        ft_snapshot.parameters_sd.resize(n);
+        ft_snapshot.parameters_sd_available.resize(n,false);
+        for(unsigned int j=0; j < n; j++ ) {
+            ft_snapshot.names[j] = paramEstimators[ft][j]->getName();
+            paramEstimators[ft][j]->copyParameters(ft_snapshot.parameters[j]);
+            ft_snapshot.parameters_sd[j].resize(ft_snapshot.parameters[j].size(),0.0);
+        }
+    }
+}
+
+//copy of the values of a vector, with the size of the destination already right
+static void copyValues(const Vector & from, Vector & to)
+{
+    YARP_ASSERT(from.size() == to.size());
+    for(int i=0; i < (int)from.size(); i++ ) {
+        to[i] = from[i];
+    }
+}
+
+void inertiaObserver_thread::copySnapshot(const observerSnapshot & from, observerSnapshot & to)
+{
+    //both the snapshots have been set up by initSnapshot, so no memory is allocated
+    to.time = from.time;
+    to.call_count = from.call_count;
+    to.learning_enabled = from.learning_enabled;
+    to.decimation = from.decimation;
+    to.run_period_mean = from.run_period_mean;
+    to.run_period_sd = from.run_period_sd;
+    to.run_period_max = from.run_period_max;
+    to.has_parameters_sd = from.has_parameters_sd;
+    YARP_ASSERT(from.ft.size() == to.ft.size());
+    map<iCubFT,ftSnapshot>::const_iterator it_from = from.ft.begin();
+    map<iCubFT,ftSnapshot>::iterator it_to = to.ft.begin();
+    for( ; it_from != from.ft.end(); it_from++, it_to++ ) {
+        const ftSnapshot & ft_from = it_from->second;
+        ftSnapshot & ft_to = it_to->second;
+        ft_to.read_count = ft_from.read_count;
+        ft_to.fed_count = ft_from.fed_count;
+        ft_to.calibrating = ft_from.calibrating;
+        copyValues(ft_from.offset,ft_to.offset);
+        for(unsigned int j=0; j < ft_from.parameters.size(); j++ ) {
+            copyValues(ft_from.parameters[j],ft_to.parameters[j]);
+            copyValues(ft_from.parameters_sd[j],ft_to.parameters_sd[j]);
+            ft_to.parameters_sd_available[j] = ft_from.parameters_sd_available[j];
+        }
+    }
+}
+
+//memory barrier for the sequence lock of the snapshot
+static inline void snapshotBarrier()
+{
+#ifdef _MSC_VER
+    //x86 does not reorder stores with stores and loads with loads, only the compiler has to be stopped
+    _ReadWriteBarrier();
+#else
+    __sync_synchronize();
+#endif
+}
+
+void inertiaObserver_thread::publishSnapshot(int call_count)
+{
+    //only run() writes snapshot_work, whose buffers are allocated by initSnapshot
+    observerSnapshot & work = snapshot_work;
+    work.time = yarp::os::Time::now();
+    work.call_count = call_count;
+    work.learning_enabled = learning_enabled;
+    work.decimation = decimation;
+    if( run_period.getSampleNum() > 0 ) {
+        work.run_period_mean = run_period.getMean();
+        work.run_period_sd = sqrt(run_period.getVariance());
+        work.run_period_max = run_period.getMax();
+    } else {
+        work.run_period_mean = work.run_period_sd = work.run_period_max = 0.0;
+    }
+    work.has_parameters_sd = parameters_sd_pending;
+    parameters_sd_pending = false;
+    for(vector<iCubFT>::size_type i = 0; i != vectorFT.size(); i++) {
+        iCubFT ft = vectorFT[i];
+        if( !is_enabled[FTlimb[ft]] ) continue;
+        ftSnapshot & ft_work = work.ft[ft];
+        ft_work.read_count = read_sample_count[ft];
+        ft_work.fed_count = fed_sample_count[ft];
+        ft_work.calibrating = offsetCalibrators[ft] && offsetCalibrators[ft]->isCollecting();
+        const Vector & ft_offset = offset[ft];
+        for(int k=0; k < 6; k++ ) {
+            ft_work.offset[k] = (int)ft_offset.size() == 6 ? ft_offset[k] : 0.0;
+        }
+        for(unsigned int j=0; j < paramEstimators[ft].size(); j++ ) {
+            paramEstimators[ft][j]->copyParameters(ft_work.parameters[j]);
+            if( work.has_parameters_sd ) {
+                ft_work.parameters_sd_available[j] = paramEstimators[ft][j]->copyParametersStandardDeviation(ft_work.parameters_sd[j])
+                                                     && ft_work.parameters_sd[j].size() == ft_work.parameters[j].size();
+                if( !ft_work.parameters_sd_available[j] ) {
+                    //keep the buffer with the size given by initSnapshot
+                    ft_work.parameters_sd[j].resize(ft_work.parameters[j].size(),0.0);
+                }
+            }
+        }
+    }
+    
+    //sequence lock: snapshot_sequence is odd while snapshot_shared is overwritten
+    snapshot_sequence++;
+    snapshotBarrier();
+    copySnapshot(snapshot_work,snapshot_shared);
+    snapshotBarrier();
+    snapshot_sequence++;
+}
+
+bool inertiaObserver_thread::getSnapshot(observerSnapshot & snapshot)
+{
+    //the copy is valid if no publication started or ended during it, otherwise it is retried
+    for(;;) {
+        unsigned int sequence = snapshot_sequence;
+        if( sequence == 0 ) {
+            //nothing published yet
+            return false;
+        }
+        if( sequence % 2 == 1 ) {
+            yarp::os::Time::yield();
+            continue;
+        }
+        snapshotBarrier();
+        snapshot = snapshot_shared;
+        snapshotBarrier();
+        if( snapshot_sequence == sequence ) {
+            break;
+        }
+    }
+    //the standard deviations not requested, or not available, are returned empty
+    map<iCubFT,ftSnapshot>::iterator it;
+    for(it = snapshot.ft.begin(); it != snapshot.ft.end(); it++ ) {
+        ftSnapshot & ft_snapshot = it->second;
+        if( !snapshot.has_parameters_sd ) {
+            ft_snapshot.parameters_sd.clear();
+            continue;
+        }
+        for(unsigned int j=0; j < ft_snapshot.parameters_sd.size(); j++ ) {
+            if( !ft_snapshot.parameters_sd_available[j] ) {
+                ft_snapshot.parameters_sd[j].resize(0);
+            }
+        }
+    }
+    return snapshot.time >= 0.0;
+}
+
+bool inertiaObserver_thread::getSnapshotWithStandardDeviations(observerSnapshot & snapshot, double timeout)
+{
+    if( !getSnapshot(snapshot) ) {
+        return false;
+    }
+    //only a snapshot published after the request is accepted
+    const int request_call_count = snapshot.call_count;
+    request_mutex.wait();
+    requested_parameters_sd = true;
+    request_mutex.post();
+    
+    const double t_start = yarp::os::Time::now();
+    observerSnapshot last;
+    while( yarp::os::Time::now()-t_start < timeout ) {
+        yarp::os::Time::delay(0.005);
+        getSnapshot(last);
+        if( last.has_parameters_sd && last.call_count > request_call_count ) {
+            snapshot = last;
+            return true;
+        }
+    }
+    getSnapshot(snapshot);
+    snapshot.has_parameters_sd = false;
+    return true;
+}
+
+bool inertiaObserver_thread::requestReset(iCubFT ft, const string & learner_name)
+{
+    if( !is_enabled[FTlimb[ft]] ) {
+        return false;
+    }
+    //the names of the learners do not change after threadInit, the published ones are used
+    if( learner_name != "" ) {
+        observerSnapshot snapshot;
+        if( !getSnapshot(snapshot) ) {
+            return false;
+        }
+        const vector<string> & names = snapshot.ft[ft].names;
+        if( std::find(names.begin(),names.end(),learner_name) == names.end() ) {
+            return false;
+        }
+    }
+    request_mutex.wait();
+    requested_resets.push_back(make_pair(ft,learner_name));
+    request_mutex.post();
+    return true;
+}
+
+bool inertiaObserver_thread::requestCalibration()
+{
+    bool has_calibrator = false;
+    for(vector<iCubFT>::size_type i = 0; i != vectorFT.size(); i++) {
+        if( is_enabled[FTlimb[vectorFT[i]]] && offsetCalibrators[vectorFT[i]] ) {
+            has_calibrator = true;
+        }
+    }
+    if( !has_calibrator ) {
+        return false;
+    }
+    request_mutex.wait();
+    requested_calibration = true;
+    request_mutex.post();
+    return true;
+}
+
+bool inertiaObserver_thread::requestDecimation(int n)
+{
+    if( n < 1 ) {
+        return false;
+    }
+    request_mutex.wait();
+    requested_decimation = n;
+    request_mutex.post();
+    return true;
+}
+
+bool inertiaObserver_thread::getFT(const string & ft_name, iCubFT & ft)
+{
+    for(vector<iCubFT>::size_type i = 0; i != vectorFT.size(); i++) {
+        if( FTNames[vectorFT[i]] == ft_name ) {
+            ft = vectorFT[i];
+            return true;
+        }
+    }
+    return false;
 }
 
 
@@ -822,7 +1242,7 @@ void inertiaObserver_thread::threadRelease()
 	fprintf(stderr,"Closing the inertiaObserver thread\n");
     
     fprintf(stderr, "Closing inertial port\n");
-    closePort(port_inertial_thread);
+    closePort(port_inertial);
     
     
     for(vector<iCubLimb>::size_type i = 0; i != vectorLimbs.size(); i++) {
@@ -840,6 +1260,16 @@ void inertiaObserver_thread::threadRelease()
             for(unsigned int j=0; j < paramEstimators[vectorFT[i]].size(); j++ ) {
                 delete paramEstimators[vectorFT[i]][j];
             } 
+            if( offsetCalibrators[vectorFT[i]] ) {
+                offsetCalibrators[vectorFT[i]]->stop();
+                delete offsetCalibrators[vectorFT[i]];
+                offsetCalibrators[vectorFT[i]] = 0;
+            }
+            if( datasetRecorders[vectorFT[i]] ) {
+                cerr << "Closing the dataset of " << limbNames[FTlimb[vectorFT[i]]] << ", " << datasetRecorders[vectorFT[i]]->getInfo();
+                delete datasetRecorders[vectorFT[i]];
+                datasetRecorders[vectorFT[i]] = 0;
+            }
         }
     }
     
@@ -853,6 +1283,7 @@ void inertiaObserver_thread::threadRelease()
     
     closePort(mixed_estimated_out_port);
     closePort(static_estimated_out_port);
+    closePort(static_information_out_port);
 
 
     if( debug_out_enabled ) { 
@@ -889,15 +1320,13 @@ void inertiaObserver_thread::threadRelease()
     }
     
     if( dump_static ) {
-        std::cerr << "Dumping static measure to staticRegr.ymt, staticFT.yvc" << std::endl;
+        std::cerr << "Closing the static dataset files staticRegr_<limb>.ymt, staticFT_<limb>.yvc" << std::endl;
         for(vector<iCubFT>::size_type i = 0; i != vectorFT.size(); i++) {
             if( is_enabled[FTlimb[vectorFT[i]]] ) {
                 Vector cad_parameters;
-                std::cout << "Last col of regr " << allStaticRegr[vectorFT[i]].getCol(16).toString() << std::endl;
-                std::cerr << "Saving allStaticRegr[vectorFT[i]] " << allStaticRegr[vectorFT[i]].rows() << " " << allStaticRegr[vectorFT[i]].cols() << std::endl;
-                std::cerr << "Saving all allStaticFT[vectorFT[i]] " << allStaticFT[vectorFT[i]].size() << std::endl;
-                Vector_write("staticFT_"+limbNames[FTlimb[vectorFT[i]]]+".yvc",allStaticFT[vectorFT[i]]);
-                Matrix_write("staticRegr_"+limbNames[FTlimb[vectorFT[i]]]+".ymt",allStaticRegr[vectorFT[i]]);
+                std::cerr << "Saved " << static_dump_count[vectorFT[i]] << " still phases of " << limbNames[FTlimb[vectorFT[i]]] << std::endl;
+                if( static_regr_writer[vectorFT[i]] ) { static_regr_writer[vectorFT[i]]->close(); delete static_regr_writer[vectorFT[i]]; static_regr_writer[vectorFT[i]] = 0; }
+                if( static_ft_writer[vectorFT[i]] ) { static_ft_writer[vectorFT[i]]->close(); delete static_ft_writer[vectorFT[i]]; static_ft_writer[vectorFT[i]] = 0; }
                 Matrix_write("staticIdentiableParameters_"+limbNames[FTlimb[vectorFT[i]]]+".ymt",static_identifiable_parameters[vectorFT[i]]);
                 iCubLimbGetBeta(icub,FTNames[vectorFT[i]],cad_parameters);
                 Vector_write("cad_parameters_"+limbNames[FTlimb[vectorFT[i]]]+".yvc",cad_parameters);
@@ -950,7 +1379,7 @@ bool inertiaObserver_thread::estimateSensorWrench(iCubWholeBody &icub,const std:
     iCubLimbSetBeta(&icub,limb,beta);
     icub.upperTorso->solveWrench();
     Matrix F_sensor_up = icub.upperTorso->estimateSensorsWrench(F_ext_up,false);
-    wrench = F_sensor_up.getCol(0);
+    wrench = F_sensor_up.getCol(limb == "left_arm" ? 1 : 0);
     iCubLimbSetBeta(&icub,limb,old_beta);
     return true;
 }
@@ -961,9 +1390,12 @@ bool inertiaObserver_thread::readAvailableFT(iCubFT ft, iCubWholeBody & icub, iC
     AWPolyList * p_ft_list; 
     int i;
     
-    Vector q_limb,dq_limb,ddq_limb;
-    Vector q_head, dq_head, ddq_head;
-    Vector q_torso, dq_torso, ddq_torso;
+    //the state of the sample is read in the preallocated buffers of the workspace of the sensor
+    estimationWorkspace & ws = workspace[ft];
+    Vector & q_limb = ws.q_limb, & dq_limb = ws.dq_limb, & ddq_limb = ws.ddq_limb;
+    Vector & q_head = ws.q_head, & dq_head = ws.dq_head, & ddq_head = ws.ddq_head;
+    Vector & q_torso = ws.q_torso, & dq_torso = ws.dq_torso, & ddq_torso = ws.ddq_torso;
+    Vector & w0 = ws.w0, & dw0 = ws.dw0, & d2p0 = ws.d2p0;
     bool found_suitable_FT = false;
     
     //std::cerr << "readAvailableFT: started" << endl;
@@ -1034,6 +1466,8 @@ bool inertiaObserver_thread::readAvailableFT(iCubFT ft, iCubWholeBody & icub, iC
             }
             current_state_estimator.getAcc(FTlimb[ft],ddq_limb,(*p_ft_list)[i].time);
             if( ddq_limb.size() == 0 ) continue;
+            
+            if( !getInertialMeasure(current_state_estimator,(*p_ft_list)[i].time,w0,dw0,d2p0) && inertial_enabled ) continue;
             found_suitable_FT = true;
             break;
         }
@@ -1043,32 +1477,20 @@ bool inertiaObserver_thread::readAvailableFT(iCubFT ft, iCubWholeBody & icub, iC
 
     
     if( found_suitable_FT ) {
-         /**
-         *\todo Add switch to use inertial measure
-         * 
-         */ 
         //set Inertial measurment!!!
-        Vector F_up(6, 0.0);
-        Vector init_w0(3), init_dw0(3), init_d2p0(3);
-        init_w0.zero();
-        init_dw0.zero();
-        init_d2p0.zero();
-        init_d2p0[2] = 9.78;
-        icub.upperTorso->setInertialMeasure(init_w0,init_dw0,init_d2p0);
+        const Vector & F_up = ws.F_up;
+        icub.upperTorso->setInertialMeasure(w0,dw0,d2p0);
     
         icub.upperTorso->setSensorMeasurement(F_up,F_up,F_up);
         
         YARP_ASSERT(FTlimb[ft] == ICUB_RIGHT_ARM || FTlimb[ft] == ICUB_LEFT_ARM);
         
-		icub.upperTorso->setAng(limbNames[FTlimb[ft]],CTRL_DEG2RAD * q_limb);
-		icub.upperTorso->setDAng(limbNames[FTlimb[ft]],CTRL_DEG2RAD * dq_limb);
-		icub.upperTorso->setD2Ang(limbNames[FTlimb[ft]],CTRL_DEG2RAD * ddq_limb);
+		icub.upperTorso->setState(upperTorsoHandles[FTlimb[ft]],q_limb,dq_limb,ddq_limb,CTRL_DEG2RAD);
 
-		icub.upperTorso->setAng("head",CTRL_DEG2RAD * q_head);
-		icub.upperTorso->setDAng("head",CTRL_DEG2RAD * dq_head);
-		icub.upperTorso->setD2Ang("head",CTRL_DEG2RAD * ddq_head);
+		icub.upperTorso->setState(upperTorsoHandles[ICUB_HEAD],q_head,dq_head,ddq_head,CTRL_DEG2RAD);
         
-        icub.upperTorso->solveKinematics();
+        //only the kinematics of the head and of the limb of the FT sensor are needed
+        icub.upperTorso->solveLimbKinematics(upperTorsoHandles[FTlimb[ft]]);
         
         /**
          * 
@@ -1088,6 +1510,25 @@ bool inertiaObserver_thread::readAvailableFT(iCubFT ft, iCubWholeBody & icub, iC
     }
 }
 
+bool inertiaObserver_thread::getInertialMeasure(iCubStateEstimator & current_state_estimator, const double time, Vector & w0, Vector & dw0, Vector & d2p0, const bool still)
+{
+    if( inertial_enabled && current_state_estimator.getInertialKinematics(w0,dw0,d2p0,time) != -1.0 ) {
+        //the state estimator uses degrees, iDyn radians
+        w0 = CTRL_DEG2RAD*w0;
+        dw0 = CTRL_DEG2RAD*dw0;
+        if( still ) {
+            w0.zero();
+            dw0.zero();
+        }
+        return true;
+    }
+    w0 = Vector(3,0.0);
+    dw0 = Vector(3,0.0);
+    d2p0 = Vector(3,0.0);
+    d2p0[2] = 9.78;
+    return false;
+}
+
 //Should be improved to "readSuitableFT" based on some rules (for example for non causal speed estimation
 bool inertiaObserver_thread::readLastSuitableFT(std::string limbName, iCubWholeBody & icub, iCubStateEstimator & current_state_estimator, Vector & F_measured, double & F_timestamp )
 {
@@ -1136,18 +1577,11 @@ bool inertiaObserver_thread::readLastSuitableFT(std::string limbName, iCubWholeB
             return false; 
         }
         
-        /**
-         *\todo Add switch to use inertial measure
-         * 
-         */ 
     //set Inertial measurment!!!
         Vector F_up(6, 0.0);
-        Vector init_w0(3), init_dw0(3), init_d2p0(3);
-        init_w0.zero();
-        init_dw0.zero();
-        init_d2p0.zero();
-        init_d2p0[2] = 9.78;
-        icub.upperTorso->setInertialMeasure(init_w0,init_dw0,init_d2p0);
+        Vector w0, dw0, d2p0;
+        getInertialMeasure(current_state_estimator,ft_iter->time,w0,dw0,d2p0);
+        icub.upperTorso->setInertialMeasure(w0,dw0,d2p0);
     
     
         icub.upperTorso->setSensorMeasurement(F_up,F_up,F_up);
@@ -1238,29 +1672,19 @@ bool inertiaObserver_thread::calibrateOffset()
             this->resume(); 
             return false; 
         }
-        /**
-         *\todo Add switch to use inertial measure
-         * 
-         */ 
         Matrix F_ext_up;
         F_ext_up.resize(6,3);
         F_ext_up.zero();
         Vector F_up(6, 0.0);
-        Vector init_w0(3), init_dw0(3), init_d2p0(3);
-        init_w0.zero();
-        init_dw0.zero();
-        init_d2p0.zero();
-        init_d2p0[2] = 9.78;
-        icub->upperTorso->setInertialMeasure(init_w0,init_dw0,init_d2p0);
+        //the robot is assumed still, only the gravity direction is taken from the inertial sensor
+        Vector w0, dw0, d2p0;
+        getInertialMeasure(current_state_estimator,ft_iter->time,w0,dw0,d2p0,true);
+        icub->upperTorso->setInertialMeasure(w0,dw0,d2p0);
         icub->upperTorso->setSensorMeasurement(F_up,F_up,F_up);
          
-        icub->upperTorso->setAng(limbNames[currLimb],CTRL_DEG2RAD * q_pos);
-		icub->upperTorso->setDAng(limbNames[currLimb],CTRL_DEG2RAD * Vector(q_pos.size(),0.0) );
-		icub->upperTorso->setD2Ang(limbNames[currLimb],CTRL_DEG2RAD * Vector(q_pos.size(),0.0) );
+        icub->upperTorso->setState(upperTorsoHandles[currLimb],q_pos,Vector(q_pos.size(),0.0),Vector(q_pos.size(),0.0),CTRL_DEG2RAD);
 
-		icub->upperTorso->setAng("head",CTRL_DEG2RAD * q_head_pos);
-		icub->upperTorso->setDAng("head",CTRL_DEG2RAD * Vector(q_head_pos.size(),0.0));
-		icub->upperTorso->setD2Ang("head",CTRL_DEG2RAD * Vector(q_head_pos.size(),0.0));
+		icub->upperTorso->setState(upperTorsoHandles[ICUB_HEAD],q_head_pos,Vector(q_head_pos.size(),0.0),Vector(q_head_pos.size(),0.0),CTRL_DEG2RAD);
         
         icub->upperTorso->solveKinematics();
         icub->upperTorso->solveWrench();
@@ -1314,29 +1738,19 @@ bool inertiaObserver_thread::calibrateOffset()
             this->resume(); 
             return false; 
         }
-        /**
-         *\todo Add switch to use inertial measure
-         * 
-         */ 
         Matrix F_ext_up;
         F_ext_up.resize(6,3);
         F_ext_up.zero();
         Vector F_up(6, 0.0);
-        Vector init_w0(3), init_dw0(3), init_d2p0(3);
-        init_w0.zero();
-        init_dw0.zero();
-        init_d2p0.zero();
-        init_d2p0[2] = 9.78;
-        icub->upperTorso->setInertialMeasure(init_w0,init_dw0,init_d2p0);
+        //the robot is assumed still, only the gravity direction is taken from the inertial sensor
+        Vector w0, dw0, d2p0;
+        getInertialMeasure(current_state_estimator,ft_iter->time,w0,dw0,d2p0,true);
+        icub->upperTorso->setInertialMeasure(w0,dw0,d2p0);
         icub->upperTorso->setSensorMeasurement(F_up,F_up,F_up);
          
-        icub->upperTorso->setAng(limbNames[currLimb],CTRL_DEG2RAD * q_pos);
-		icub->upperTorso->setDAng(limbNames[currLimb],CTRL_DEG2RAD * Vector(q_pos.size(),0.0) );
-		icub->upperTorso->setD2Ang(limbNames[currLimb],CTRL_DEG2RAD * Vector(q_pos.size(),0.0) );
+        icub->upperTorso->setState(upperTorsoHandles[currLimb],q_pos,Vector(q_pos.size(),0.0),Vector(q_pos.size(),0.0),CTRL_DEG2RAD);
 
-		icub->upperTorso->setAng("head",CTRL_DEG2RAD * q_head_pos);
-		icub->upperTorso->setDAng("head",CTRL_DEG2RAD * Vector(q_head_pos.size(),0.0));
-		icub->upperTorso->setD2Ang("head",CTRL_DEG2RAD * Vector(q_head_pos.size(),0.0));
+		icub->upperTorso->setState(upperTorsoHandles[ICUB_HEAD],q_head_pos,Vector(q_head_pos.size(),0.0),Vector(q_head_pos.size(),0.0),CTRL_DEG2RAD);
         
         icub->upperTorso->solveKinematics();
         icub->upperTorso->solveWrench();
@@ -1451,7 +1865,7 @@ Matrix inertiaObserver_thread::getiCubLimbIdentifiableSubspace(string limb_name,
         icub_obs->upperTorso->solveKinematics();
         
         //fprintf(stderr,"computeRegressor");
-        iCubLimbRegressorSensorWrench(icub_obs,limb_name,A);
+        iCubLimbRegressorSensorWrench(icub_obs,limb_name,A,false,use_specialized_regressors);
         
         if( i == 0 ) {
              allA = Matrix(A.rows()*(num_samples),A.cols());
@@ -1480,6 +1894,55 @@ Matrix inertiaObserver_thread::getiCubLimbIdentifiableSubspace(string limb_name,
     return V1;
 }
 
+void inertiaObserver_thread::publishStaticInformation(int n_directions)
+{
+    ISufficientStatisticsLearner * static_stats_learner = dynamic_cast<ISufficientStatisticsLearner *>(staticParamEstimator);
+    if( static_stats_learner == 0 ) return;
+    
+    SufficientStatistics stats;
+    static_stats_learner->getSufficientStatistics(stats);
+    if( stats.sampleCount == 0 ) return;
+    
+    //the information matrix is symmetric and positive semidefinite: its singular vectors are the eigenvectors
+    Matrix U,V;
+    Vector S;
+    SVD(stats.gram,U,S,V);
+    
+    const Matrix & basis = static_identifiable_parameters[ICUB_FT_RIGHT_ARM];
+    const int n = basis.rows();
+    const int r = basis.cols();
+    const int m = std::min(n_directions,(int)S.size());
+    
+    Bottle & info_bot = static_information_out_port->prepare();
+    info_bot.clear();
+    Bottle & samples_bot = info_bot.addList();
+    samples_bot.addString("samples");
+    samples_bot.addInt(stats.sampleCount);
+    Bottle & eigenvalues_bot = info_bot.addList();
+    eigenvalues_bot.addString("eigenvalues");
+    Bottle & eigenvalues_list = eigenvalues_bot.addList();
+    Bottle & directions_bot = info_bot.addList();
+    directions_bot.addString("directions");
+    Bottle & directions_list = directions_bot.addList();
+    for(int k=0; k < m; k++ ) {
+        //from the least informed direction
+        const int c = S.size()-1-k;
+        eigenvalues_list.addDouble(S[c]);
+        Bottle & direction = directions_list.addList();
+        for(int i=0; i < n; i++ ) {
+            double d = 0.0;
+            for(int j=0; j < r; j++ ) {
+                d += basis(i,j)*U(j,c);
+            }
+            direction.addDouble(d);
+        }
+        for(int i=0; i < 6; i++ ) {
+            direction.addDouble(U(r+i,c));
+        }
+    }
+    static_information_out_port->write();
+}
+
 void inertiaObserver_thread::debug_generate_yarpscope_xml(iCubFT ft, bool debug_out_parameters_yarpscope) {
     
     ofstream xml_file;
@@ -1593,11 +2056,15 @@ void inertiaObserver_thread::debug_generate_yarpscope_xml(iCubFT ft, bool debug_
 }
 
 void inertiaObserver_thread::enableLearning() {
-    learning_enabled = true;
+    request_mutex.wait();
+    requested_learning = 1;
+    request_mutex.post();
 }
 
 void inertiaObserver_thread::disableLearning() {
-    learning_enabled = false;
+    request_mutex.wait();
+    requested_learning = 0;
+    request_mutex.post();
 }
 
 void inertiaObserver_thread::finalAnalysis() {
@@ -28,6 +28,7 @@
 #include <iCub/iDyn/iDynBody.h>
 
 #include <iCub/learningMachine/IParameterLearner.h>
+#include <iCub/learningMachine/MatrixDatasetRecorder.h>
 
 
 #include <iostream>
@@ -41,6 +42,12 @@
 
 #include "onlineMean.h"
 
+#include "estimationWorkspace.h"
+
+#include "offsetCalibrator.h"
+
+#include "MatVetIO.h"
+
 #define MAX_JN 12
 #define MAX_FILTER_ORDER 6
 
@@ -56,6 +63,36 @@ using namespace iCub::iDyn;
 
 
 
+/**
+ * State of the estimation of a FT sensor, as seen by the rpc queries
+ */
+struct ftSnapshot
+{
+    int read_count;              //number of FT samples read
+    int fed_count;               //number of FT samples fed to the learners
+    bool calibrating;            //true if the still samples are being collected for a new offset
+    Vector offset;               //offset from the last calibration
+    vector<string> names;        //names of the learners
+    vector<Vector> parameters;   //parameters of each learner
+    vector<Vector> parameters_sd; //standard deviations of the parameters (empty if not requested or not available)
+    vector<bool> parameters_sd_available; //used by the thread, that keeps the buffers of parameters_sd allocated
+};
+
+/**
+ * State of the observer thread, published periodically by run() for the rpc
+ * queries, that never access the learners directly
+ */
+struct observerSnapshot
+{
+    double time;
+    int call_count;
+    bool learning_enabled;
+    int decimation;
+    double run_period_mean, run_period_sd, run_period_max;
+    bool has_parameters_sd;     //true if the standard deviations were requested for this snapshot
+    map<iCubFT,ftSnapshot> ft;
+};
+
 /**
  * 
  * \todo Add synchronization between call to suspend and call to run !!!
@@ -71,6 +108,7 @@ private:
     vector<iCubFT> vectorFT;
     map<iCubFT,iCubLimb> FTlimb;
     map<iCubLimb,string> limbNames;
+    map<iCubLimb,TorsoNodeLimb> upperTorsoHandles; //handles of the limbs attached to the upper torso, resolved once from limbNames
     map<iCubFT,string> FTNames;    
     map<iCubFT,Vector> ftStdDev;
 
@@ -102,6 +140,16 @@ private:
     
     bool dump_static;
     
+    //if not empty, the regressors and the FT measures of all the samples are recorded in <record_dataset>_<limb>.lmds
+    string record_dataset;
+    
+    //if true the measure of the inertial sensor is used for the base kinematics
+    bool inertial_enabled;
+    
+    //if true the specialized regressors are used for the limbs that have them
+    //(the other ones use the generic implementation)
+    bool use_specialized_regressors;
+    
     bool verbose;
   
     onlineMean<double> run_period;
@@ -112,8 +160,13 @@ private:
     
     string xml_yarpscope_file;
     
-    map<iCubFT,Matrix> allStaticRegr;
-    map<iCubFT,Vector> allStaticFT;
+    //static dataset: the mean static regressor and FT measure of each still phase are appended to the files
+    map<iCubFT,MatVetWriter *> static_regr_writer;
+    map<iCubFT,MatVetWriter *> static_ft_writer;
+    //sums of the samples of the current still phase
+    map<iCubFT,Matrix> static_regr_sum;
+    map<iCubFT,Vector> static_ft_sum;
+    map<iCubFT,int> static_sample_count;
     map<iCubFT,int> static_dump_count;
 
         
@@ -121,7 +174,7 @@ private:
     map<iCubFT,FTCollector *> port_ft;
 
     
-    BufferedPort<Vector> *port_inertial_thread;
+    inertialCollector *port_inertial;
     
         
     map<iCubLimb,posCollector *> port_q;
@@ -132,6 +185,7 @@ private:
 
     //Map of estimator objects
     map<iCubFT, vector<iCub::learningmachine::IParameterLearner *> > paramEstimators;
+    map<iCubFT, iCub::learningmachine::MatrixDatasetRecorder *> datasetRecorders;
             
     map<iCubFT, BufferedPort<Vector> * > measured_out_port;
     map<iCubFT, vector<BufferedPort<Vector> * > > estimated_out_port; 
@@ -146,12 +200,16 @@ private:
     map<iCubFT, vector<BufferedPort<Vector> * > > measured_FT_sens_torques; 
 
     //Mixed static/dynamic estimation
-    iCub::learningmachine::IParameterLearner * staticParamEstimator;
-    iCub::learningmachine::IParameterLearner * dynamicParamEstimator;
+    iCub::learningmachine::MultiTaskLinearGPRLearner * staticParamEstimator;
+    iCub::learningmachine::MultiTaskLinearGPRLearner * dynamicParamEstimator;
 
     BufferedPort<Vector> * mixed_estimated_out_port;
     BufferedPort<Vector> * static_estimated_out_port;
 
+    //Information of the static estimation, for the selection of the targets of the trajectory generator
+    BufferedPort<Bottle> * static_information_out_port;
+    double last_information_time;
+
     
     map<iCubFT, vector<BufferedPort<Vector> * > > estimated_projected_torques_inc; 
 
@@ -169,6 +227,42 @@ private:
     int calibrate_call_count;
     
     bool learning_enabled;
+    
+    //only one every decimation FT samples is fed to the learners
+    int decimation;
+    map<iCubFT,int> read_sample_count;
+    map<iCubFT,int> fed_sample_count;
+    
+    //Snapshot of the state for the rpc queries: run() fills snapshot_work, with all the buffers
+    //allocated once by initSnapshot(), and copies it in place in snapshot_shared between two
+    //increments of snapshot_sequence (sequence lock, odd during the copy and 0 until the first one).
+    //The readers copy snapshot_shared without locking, and retry if the sequence was odd or
+    //changed during their copy, so run() never waits for the queries
+    observerSnapshot snapshot_work;
+    observerSnapshot snapshot_shared;
+    volatile unsigned int snapshot_sequence;
+    static const int snapshot_period = 10;
+    
+    //Requests coming from the rpc port, applied by run() at the beginning of a cycle
+    Semaphore request_mutex;
+    int requested_learning;         //-1 no request, 0 disable, 1 enable
+    int requested_decimation;       //0 no request
+    bool requested_calibration;
+    bool requested_parameters_sd;
+    vector< pair<iCubFT,string> > requested_resets; //empty learner name: all the learners of the FT
+    
+    //the standard deviations of the parameters cost a solve with the covariance of each learner,
+    //so they are added only to the next snapshot after a request
+    bool parameters_sd_pending;
+    
+    void applyRequests();
+    void initSnapshot(observerSnapshot & snapshot);
+    void publishSnapshot(int call_count);
+    static void copySnapshot(const observerSnapshot & from, observerSnapshot & to);
+    
+    //blocking calibration, waiting for 100 FT samples: only for threadInit,
+    //run() and the rpc commands use the offsetCalibrator threads
+    bool calibrateOffset();
 
     
     static const bool enable_log = true;
@@ -186,6 +280,9 @@ private:
     map<iCubFT,Vector> measuredW;
 
     map<iCubFT,Vector> offset;
+    //background offset calibration, from the still samples and the CAD parameters of the limb
+    //(each calibration thread has its own model, for the CAD wrenches)
+    map<iCubFT,offsetCalibrator *> offsetCalibrators;
     //Estimated Wrenches
     Vector W_ident_LArm, W_ident_RArm;
     Vector W_iDyn_LArm, W_iDyn_RArm, Offset_LArm, Offset_RArm;
@@ -219,6 +316,9 @@ private:
     //identifiable_parameters = static_identifiable_parameters + dynamic_identifiable_parameters
     //static_identifiable_parameters \cap  dynamic_identifiable_parameters = {0}
     
+    //Preallocated buffers for the estimation step, sized in threadInit
+    map<iCubFT,estimationWorkspace> workspace;
+    
 
     Matrix ATA;
     Matrix ATA_forces;
@@ -239,7 +339,7 @@ private:
     void init_lower();
 
 public:
-    inertiaObserver_thread(int _rate, int _rateEstimation, string _robot_name, string _local_name, version_tag icub_type, string _data_path, bool _autoconnect, bool _right_leg_enabled, bool _left_leg_enabled, bool _right_arm_enabled, bool _left_arm_enabled, bool _debug_out_enabled, bool _dump_static, string _xml_yarpscope_file);
+    inertiaObserver_thread(int _rate, int _rateEstimation, string _robot_name, string _local_name, version_tag icub_type, string _data_path, bool _autoconnect, bool _right_leg_enabled, bool _left_leg_enabled, bool _right_arm_enabled, bool _left_arm_enabled, bool _debug_out_enabled, bool _dump_static, string _xml_yarpscope_file, bool _inertial_enabled = true, string _record_dataset = "");
     bool threadInit();
     inline thread_status_enum getThreadStatus() 
     {
@@ -251,10 +351,19 @@ public:
     void openPort(Contactable *_port, string portName);
     Vector all_masses_regressor(int n);
     void closePort(Contactable *_port);
-    bool calibrateOffset();
     bool readAndUpdate(bool waitMeasure=false, bool _init=false);
     bool readLastSuitableFT(std::string limbName, iCubWholeBody & icub, iCubStateEstimator & current_state_estimator, Vector & F_measured, double & F_timestamp );
     bool readAvailableFT(iCubFT ft, iCubWholeBody & icub, iCubStateEstimator & current_state_estimator, Vector & F_measured, double & F_timestamp );
+    
+    /**
+     * Get the kinematics of the inertial sensor (in the form used by 
+     * iDynSensorNode::setInertialMeasure) for timestamp time. 
+     * If the inertial sensor is disabled or no measure is available
+     * for time, the head is assumed still and upright.
+     * @param still if true, the angular velocity and acceleration are set to zero
+     * @return true if the measure of the inertial sensor was used, false otherwise
+     */
+    bool getInertialMeasure(iCubStateEstimator & current_state_estimator, const double time, Vector & w0, Vector & dw0, Vector & d2p0, const bool still = false);
     void setZeroJntAngVelAcc();  
     bool estimateSensorWrench(iCub::iDyn::iCubWholeBody &icub,const std::string limb,const yarp::sig::Vector beta,yarp::sig::Vector & wrench);
     
@@ -271,6 +380,15 @@ public:
     * if the limb is specified, only that limb is assigned a random configuration
     */
     void fillRandomPosition(iCubWholeBody * icub, string limb_name);
+
+    /**
+     * Publish the least informed directions of the static estimation of the right arm
+     * parameters (the eigenvectors of its information matrix with the smallest eigenvalues),
+     * in the space of the parameters of the limb followed by the 6 offsets:
+     * (samples n) (eigenvalues (l_1 ... l_m)) (directions ((d_1) ... (d_m)))
+     * @param n_directions the number of directions published
+     */
+    void publishStaticInformation(int n_directions = 6);
     
     /**
      * Get 
@@ -279,8 +397,53 @@ public:
      
      void debug_generate_yarpscope_xml(iCubFT ft,bool debug_out_param_yarpscope = false);
      void debug_generate_yarpscope_xml_only_param(iCubFT ft);
+    /**
+     * Enable or disable the learning, the request is applied at the 
+     * beginning of the next run
+     */
     void enableLearning();
     void disableLearning();
+    
+    /**
+     * Copy the last published state of the estimation, without waiting for run()
+     * @return false if no state has been published yet
+     */
+    bool getSnapshot(observerSnapshot & snapshot);
+    
+    /**
+     * Request the standard deviations of the parameters of the learners, and wait 
+     * for the first snapshot published with them
+     * @param timeout maximum wait [s]: if it expires (e.g. the thread is suspended)
+     *        snapshot is the last published one, without the standard deviations
+     * @return false if no state has been published yet
+     */
+    bool getSnapshotWithStandardDeviations(observerSnapshot & snapshot, double timeout = 1.0);
+    
+    /**
+     * Request the reset of a learner of a FT sensor (of all its learners if learner_name is empty)
+     * @return false if the FT sensor or the learner are unknown
+     */
+    bool requestReset(iCubFT ft, const string & learner_name = "");
+    
+    /**
+     * Request a new calibration of the offsets: the samples read while the limb is
+     * still are collected, and the new offsets are installed when computed, 
+     * without stopping the estimation
+     * @return false if no FT sensor has an offset calibrator
+     */
+    bool requestCalibration();
+    
+    /**
+     * Request to feed the learners with only one every n FT samples
+     * @return false if n is not positive
+     */
+    bool requestDecimation(int n);
+    
+    /**
+     * Get the FT sensor from its name (e.g. right_arm)
+     */
+    bool getFT(const string & ft_name, iCubFT & ft);
+    string getFTName(iCubFT ft) { return FTNames[ft]; }
     void finalAnalysis();
     Matrix diagonalMatrix(Vector S);
     Matrix getOnlyDynamicParam(Matrix all_param, double tol = -1.0);
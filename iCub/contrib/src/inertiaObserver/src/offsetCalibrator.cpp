@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <iCub/ctrl/math.h>
+
+#include "offsetCalibrator.h"
+
+using namespace iCub::iDyn;
+using namespace iCub::ctrl;
+
+offsetCalibrator::offsetCalibrator(const version_tag & icub_type, const std::string & _limb, int _n_samples, double _huber_k) :
+    n_samples(_n_samples), huber_k(_huber_k), mutex(1), wake(0), limb(_limb), collecting(false), generation(0),
+    ring_capacity(_n_samples), ring_first(0), ring_count(0), dropped(0), result_ready(false), result(6,0.0),
+    collected_generation(0), F_zero(6,0.0), F_ext(6,3)
+{
+    icub = new iCubWholeBody(icub_type,DYNAMIC);
+    limb_handle = icub->upperTorso->getLimbHandle(limb);
+    head_handle = icub->upperTorso->getLimbHandle("head");
+    n_limb = icub->upperTorso->getAng(limb).size();
+    n_head = icub->upperTorso->getAng("head").size();
+    //state of the limb and of the head, inertial measure and measured wrench
+    stride = 3*n_limb+3*n_head+9+6;
+    ring.resize(ring_capacity*stride);
+    sample.resize(stride);
+    collected.reserve(6*n_samples);
+    component.reserve(n_samples);
+    F_ext.zero();
+}
+
+offsetCalibrator::~offsetCalibrator()
+{
+    delete icub;
+}
+
+void offsetCalibrator::startCollection()
+{
+    mutex.wait();
+    generation++;
+    ring_first = 0;
+    ring_count = 0;
+    dropped = 0;
+    collecting = true;
+    result_ready = false;
+    mutex.post();
+}
+
+bool offsetCalibrator::isCollecting()
+{
+    mutex.wait();
+    bool ret = collecting;
+    mutex.post();
+    return ret;
+}
+
+void offsetCalibrator::store(double * sample, int & pos, const yarp::sig::Vector & v, int n)
+{
+    for(int i=0; i < n; i++ ) {
+        sample[pos+i] = v[i];
+    }
+    pos += n;
+}
+
+void offsetCalibrator::load(const double * sample, int & pos, yarp::sig::Vector & v, int n)
+{
+    if( (int)v.size() != n ) {
+        v.resize(n);
+    }
+    for(int i=0; i < n; i++ ) {
+        v[i] = sample[pos+i];
+    }
+    pos += n;
+}
+
+bool offsetCalibrator::addSample(const yarp::sig::Vector & q_limb, const yarp::sig::Vector & dq_limb, const yarp::sig::Vector & ddq_limb,
+                                 const yarp::sig::Vector & q_head, const yarp::sig::Vector & dq_head, const yarp::sig::Vector & ddq_head,
+                                 const yarp::sig::Vector & w0, const yarp::sig::Vector & dw0, const yarp::sig::Vector & d2p0,
+                                 const yarp::sig::Vector & wrench)
+{
+    if( (int)q_limb.size() != n_limb || (int)dq_limb.size() != n_limb || (int)ddq_limb.size() != n_limb ||
+        (int)q_head.size() != n_head || (int)dq_head.size() != n_head || (int)ddq_head.size() != n_head ||
+        w0.size() != 3 || dw0.size() != 3 || d2p0.size() != 3 || wrench.size() != 6 ) {
+        return false;
+    }
+    bool added = false;
+    mutex.wait();
+    if( collecting ) {
+        if( ring_count < ring_capacity ) {
+            double * slot = &ring[((ring_first+ring_count)%ring_capacity)*stride];
+            int pos = 0;
+            store(slot,pos,q_limb,n_limb);
+            store(slot,pos,dq_limb,n_limb);
+            store(slot,pos,ddq_limb,n_limb);
+            store(slot,pos,q_head,n_head);
+            store(slot,pos,dq_head,n_head);
+            store(slot,pos,ddq_head,n_head);
+            store(slot,pos,w0,3);
+            store(slot,pos,dw0,3);
+            store(slot,pos,d2p0,3);
+            store(slot,pos,wrench,6);
+            ring_count++;
+            added = true;
+        } else {
+            //the calibration thread is late, the sample is lost
+            dropped++;
+        }
+    }
+    mutex.post();
+    if( added ) {
+        wake.post();
+    }
+    return added;
+}
+
+bool offsetCalibrator::getOffset(yarp::sig::Vector & offset)
+{
+    bool ret = false;
+    mutex.wait();
+    if( result_ready ) {
+        offset = result;
+        result_ready = false;
+        ret = true;
+    }
+    mutex.post();
+    return ret;
+}
+
+void offsetCalibrator::addResidual()
+{
+    int pos = 0;
+    const double * data = &sample[0];
+    load(data,pos,q_limb,n_limb);
+    load(data,pos,dq_limb,n_limb);
+    load(data,pos,ddq_limb,n_limb);
+    load(data,pos,q_head,n_head);
+    load(data,pos,dq_head,n_head);
+    load(data,pos,ddq_head,n_head);
+    load(data,pos,w0,3);
+    load(data,pos,dw0,3);
+    load(data,pos,d2p0,3);
+
+    //wrench of the sensor predicted by the CAD model, with no external wrenches
+    icub->upperTorso->setInertialMeasure(w0,dw0,d2p0);
+    icub->upperTorso->setSensorMeasurement(F_zero,F_zero,F_zero);
+    icub->upperTorso->setState(limb_handle,q_limb,dq_limb,ddq_limb,CTRL_DEG2RAD);
+    icub->upperTorso->setState(head_handle,q_head,dq_head,ddq_head,CTRL_DEG2RAD);
+    icub->upperTorso->solveKinematics();
+    icub->upperTorso->solveWrench();
+    yarp::sig::Matrix F_sensor = icub->upperTorso->estimateSensorsWrench(F_ext,false);
+    const int col = (limb == "left_arm") ? 1 : 0;
+
+    for(int i=0; i < 6; i++ ) {
+        collected.push_back(data[pos+i]-F_sensor(i,col));
+    }
+}
+
+double offsetCalibrator::huberLocation()
+{
+    const int n = component.size();
+    //median, as starting point and for the scale
+    std::vector<double> sorted(component);
+    std::nth_element(sorted.begin(),sorted.begin()+n/2,sorted.end());
+    double location = sorted[n/2];
+    for(int i=0; i < n; i++ ) {
+        sorted[i] = fabs(component[i]-location);
+    }
+    std::nth_element(sorted.begin(),sorted.begin()+n/2,sorted.end());
+    //median absolute deviation, scaled to be consistent with the standard deviation of gaussian noise
+    double scale = 1.4826*sorted[n/2];
+    if( scale <= 0.0 ) {
+        return location;
+    }
+    //iteratively reweighted mean, the weight of the outliers is huber_k*scale/|r-location|
+    const double threshold = huber_k*scale;
+    for(int iter=0; iter < 50; iter++ ) {
+        double sum = 0.0, sum_w = 0.0;
+        for(int i=0; i < n; i++ ) {
+            double r = fabs(component[i]-location);
+            double w = r <= threshold ? 1.0 : threshold/r;
+            sum += w*component[i];
+            sum_w += w;
+        }
+        double new_location = sum/sum_w;
+        bool converged = fabs(new_location-location) < 1e-6*scale;
+        location = new_location;
+        if( converged ) break;
+    }
+    return location;
+}
+
+void offsetCalibrator::run()
+{
+    while( !isStopping() ) {
+        wake.wait();
+
+        //the samples are taken from the ring one at a time, the CAD wrench
+        //is computed outside of the critical section
+        while( !isStopping() ) {
+            mutex.wait();
+            if( ring_count == 0 ) {
+                mutex.post();
+                break;
+            }
+            const double * slot = &ring[ring_first*stride];
+            std::copy(slot,slot+stride,sample.begin());
+            ring_first = (ring_first+1)%ring_capacity;
+            ring_count--;
+            //startCollection empties the ring, so the sample belongs to the current collection
+            unsigned int sample_generation = generation;
+            mutex.post();
+
+            if( sample_generation != collected_generation ) {
+                collected.clear();
+                collected_generation = sample_generation;
+            }
+            addResidual();
+            if( (int)collected.size() < 6*n_samples ) continue;
+
+            //the collection is complete: the samples still in the ring are discarded
+            mutex.wait();
+            bool current = ( collected_generation == generation );
+            if( current ) {
+                collecting = false;
+                ring_count = 0;
+            }
+            unsigned int n_dropped = dropped;
+            mutex.post();
+
+            if( current ) {
+                yarp::sig::Vector offset(6);
+                for(int c=0; c < 6; c++ ) {
+                    component.resize(n_samples);
+                    for(int i=0; i < n_samples; i++ ) {
+                        component[i] = collected[6*i+c];
+                    }
+                    offset[c] = huberLocation();
+                }
+                if( n_dropped > 0 ) {
+                    fprintf(stderr,"offsetCalibrator: %u samples of %s dropped during the calibration\n",n_dropped,limb.c_str());
+                }
+
+                mutex.wait();
+                //a collection started during the computation makes this result stale
+                if( collected_generation == generation ) {
+                    result = offset;
+                    result_ready = true;
+                }
+                mutex.post();
+            }
+            collected.clear();
+        }
+    }
+}
+
+void offsetCalibrator::onStop()
+{
+    wake.post();
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:  pegua1@gmail.com
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef OFFSET_CALIBRATOR
+#define OFFSET_CALIBRATOR
+
+#include <vector>
+#include <string>
+
+#include <yarp/os/Thread.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynBody.h>
+
+/**
+ * Background calibration of the offset of a FT sensor of an arm.
+ *
+ * The estimation thread hands over each FT sample read while the limb is
+ * still (the state of the limb and of the head, the inertial measure and the
+ * measured wrench) with addSample(), that only copies it in a preallocated
+ * ring (the samples arriving when the ring is full are dropped and counted).
+ * This thread owns a model of the robot with the CAD parameters: for each
+ * sample it solves the kinematics and the wrench predicted by the CAD model,
+ * and collects the difference with the measured one. When n_samples are
+ * collected, it computes a robust estimate of the offset (for each component,
+ * the Huber M-estimate of location, started from the median and with the
+ * scale given by the median absolute deviation) and publishes it. The
+ * estimation thread installs it with getOffset(), between two of its cycles.
+ *
+ * The semaphore only protects the ring and the result, the estimation thread
+ * never waits for the computation.
+ *
+ * Each collection has a generation number: the residuals and the calibration
+ * of a collection superseded by startCollection() are discarded.
+ */
+class offsetCalibrator : public yarp::os::Thread
+{
+private:
+    int n_samples;          ///< number of samples used for a calibration
+    double huber_k;         ///< threshold of the Huber loss, in units of the robust standard deviation
+
+    yarp::os::Semaphore mutex;
+    yarp::os::Semaphore wake;
+
+    iCub::iDyn::iCubWholeBody * icub;       ///< model with the CAD parameters, used only by this thread
+    std::string limb;
+    iCub::iDyn::TorsoNodeLimb limb_handle;
+    iCub::iDyn::TorsoNodeLimb head_handle;
+    int n_limb;                             ///< number of joints of the limb
+    int n_head;                             ///< number of joints of the head
+    int stride;                             ///< size of a sample in the ring
+
+    bool collecting;
+    unsigned int generation;            ///< generation of the current collection, incremented by startCollection()
+    std::vector<double> ring;           ///< samples handed over by the estimation thread, stride values each
+    int ring_capacity;                  ///< maximum number of samples in the ring
+    int ring_first;                     ///< index of the oldest sample of the ring
+    int ring_count;                     ///< number of samples in the ring
+    unsigned int dropped;               ///< samples dropped because the ring was full, in the current collection
+    bool result_ready;
+    yarp::sig::Vector result;
+
+    //buffers of this thread
+    unsigned int collected_generation;  ///< generation of the residuals in collected
+    std::vector<double> collected;      ///< residuals, 6 for each sample, at most 6*n_samples
+    std::vector<double> sample;         ///< sample taken from the ring
+    yarp::sig::Vector q_limb, dq_limb, ddq_limb;
+    yarp::sig::Vector q_head, dq_head, ddq_head;
+    yarp::sig::Vector w0, dw0, d2p0;
+    yarp::sig::Vector F_zero;
+    yarp::sig::Matrix F_ext;
+    std::vector<double> component;      ///< buffer for a component of the residuals
+
+    /**
+     * Copy the n values of v in the sample, from the position pos
+     */
+    static void store(double * sample, int & pos, const yarp::sig::Vector & v, int n);
+
+    /**
+     * Copy n values from the sample, from the position pos, in v
+     */
+    static void load(const double * sample, int & pos, yarp::sig::Vector & v, int n);
+
+    /**
+     * Add to collected the difference between the measured wrench of sample and the
+     * one predicted by the CAD model
+     */
+    void addResidual();
+
+    /**
+     * Robust estimate of the location of the values in component
+     */
+    double huberLocation();
+
+public:
+    /**
+     * @param icub_type version of the robot, for the CAD model
+     * @param limb name of the arm of the sensor ("right_arm" or "left_arm")
+     * @param n_samples number of still samples used for a calibration
+     * @param huber_k threshold of the Huber loss (1.345 gives 95% efficiency for gaussian noise)
+     */
+    offsetCalibrator(const iCub::iDyn::version_tag & icub_type, const std::string & limb, int n_samples = 100, double huber_k = 1.345);
+
+    ~offsetCalibrator();
+
+    /**
+     * Start collecting samples for a new calibration, discarding the ones
+     * of a calibration not completed yet and its result, also if it is 
+     * already being computed
+     */
+    void startCollection();
+
+    /**
+     * @return true if samples are being collected
+     */
+    bool isCollecting();
+
+    /**
+     * Add a still sample to the calibration in progress. The state is in degrees,
+     * as given by the state estimator (the sizes of the state of the limb and of
+     * the head must be the ones of the model). No memory is allocated.
+     * @param wrench measured wrench
+     * @return false if no calibration is in progress, the ring is full or the sizes are wrong
+     */
+    bool addSample(const yarp::sig::Vector & q_limb, const yarp::sig::Vector & dq_limb, const yarp::sig::Vector & ddq_limb,
+                   const yarp::sig::Vector & q_head, const yarp::sig::Vector & dq_head, const yarp::sig::Vector & ddq_head,
+                   const yarp::sig::Vector & w0, const yarp::sig::Vector & dw0, const yarp::sig::Vector & d2p0,
+                   const yarp::sig::Vector & wrench);
+
+    /**
+     * Get the offset of the last completed calibration, if not already returned
+     * @return true if a new offset is available
+     */
+    bool getOffset(yarp::sig::Vector & offset);
+
+    virtual void run();
+    virtual void onStop();
+};
+
+#endif
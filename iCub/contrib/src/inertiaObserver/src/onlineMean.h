@@ -1,65 +1,260 @@
+#ifndef __ONLINE_MEAN__
+#define __ONLINE_MEAN__
+
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+
+#include <vector>
+#include <cassert>
+#include <cstring>
+
+/**
+ * Access to the elements of the types supported by onlineMean, as a contiguous array of doubles
+ * (double, yarp::sig::Vector and yarp::sig::Matrix)
+ */
+template <class T>
+struct onlineMeanTraits {
+    static size_t size(const T &) { return 1; }
+    static double * data(T & x) { return &x; }
+    static const double * data(const T & x) { return &x; }
+    static void resizeLike(T &, const T &) {}
+};
+
+template <>
+struct onlineMeanTraits<yarp::sig::Vector> {
+    static size_t size(const yarp::sig::Vector & x) { return x.size(); }
+    static double * data(yarp::sig::Vector & x) { return x.data(); }
+    static const double * data(const yarp::sig::Vector & x) { return x.data(); }
+    static void resizeLike(yarp::sig::Vector & x, const yarp::sig::Vector & like) { if( x.size() != like.size() ) x.resize(like.size()); }
+};
+
+template <>
+struct onlineMeanTraits<yarp::sig::Matrix> {
+    static size_t size(const yarp::sig::Matrix & x) { return x.rows()*x.cols(); }
+    static double * data(yarp::sig::Matrix & x) { return x.data(); }
+    static const double * data(const yarp::sig::Matrix & x) { return x.data(); }
+    static void resizeLike(yarp::sig::Matrix & x, const yarp::sig::Matrix & like) { if( x.rows() != like.rows() || x.cols() != like.cols() ) x.resize(like.rows(),like.cols()); }
+};
+
 /**
- * A class for online mean calculation
+ * A class for online mean, variance, minimum and maximum calculation, of a double,
+ * of a yarp::sig::Vector or of a yarp::sig::Matrix (element wise)
  * Algorithm from: Donald E. Knuth (1998). The Art of Computer Programming, volume 2: Seminumerical Algorithms, 3rd edn., p. 232. Boston: Addison-Wesley.
- * operator* for non scalar T shold be the point wise operation
+ *
+ * The statistics are updated in place: after the first sample, feedSample does not allocate memory.
+ * Optionally the full covariance of the elements is computed (O(n^2) for each sample of n elements).
+ * Two onlineMean computed on different samples (for example in different threads) can be merged with
+ * the pairwise update of Chan, Golub, LeVeque (1979), Updating Formulae and a Pairwise Algorithm for Computing Sample Variances.
  */
 template <class T>
 class onlineMean {
+    typedef onlineMeanTraits<T> traits;
+
     T current_mean;
-    unsigned int sample_num;
     T M2;
-    
+    T min_sample;
+    T max_sample;
+    unsigned int sample_num;
+
+    bool full_covariance;
+    //sum of the products of the deviations from the mean (upper triangle)
+    yarp::sig::Matrix C;
+    std::vector<double> delta;
+
+    void init(const T & sample);
+
     public:
-    onlineMean();
+    /**
+     * @param full_covariance if true, the covariance of the elements of the samples is computed
+     */
+    onlineMean(bool full_covariance=false);
     ~onlineMean() {};
     void feedSample(const T& sample);
+    /**
+     * Add the statistics of another set of samples, as if they were fed to this object
+     * (the covariance is kept only if both objects compute it)
+     */
+    void merge(const onlineMean<T>& other);
     void reset();
-    T getMean();
-    T getVariance();
-    unsigned int getSampleNum();
+    const T & getMean() const;
+    T getVariance() const;
+    const T & getMin() const;
+    const T & getMax() const;
+    /**
+     * Covariance of the elements of the samples (in row major order for a Matrix),
+     * available if the object was created with full_covariance
+     */
+    yarp::sig::Matrix getCovariance() const;
+    bool hasCovariance() const;
+    unsigned int getSampleNum() const;
 };
 
 
 template<class T>
-onlineMean<T>::onlineMean() {
+onlineMean<T>::onlineMean(bool _full_covariance) : full_covariance(_full_covariance) {
     this->reset();
 }
 
+template<class T>
+void onlineMean<T>::init(const T & sample) {
+    const size_t n = traits::size(sample);
+    traits::resizeLike(current_mean,sample);
+    traits::resizeLike(M2,sample);
+    traits::resizeLike(min_sample,sample);
+    traits::resizeLike(max_sample,sample);
+    if( n > 0 ) {
+        memset(traits::data(M2),0,n*sizeof(double));
+    }
+    delta.resize(n);
+    if( full_covariance ) {
+        if( C.rows() != (int)n || C.cols() != (int)n ) {
+            C.resize(n,n);
+        }
+        C.zero();
+    }
+}
+
 template<class T>
 void onlineMean<T>::feedSample(const T& sample) {
-    T delta;
+    const size_t n = traits::size(sample);
     sample_num++;
     if( sample_num == 1 ) {
-        current_mean = sample;
-    } else {
-        delta = sample-current_mean;
-        current_mean += delta/sample_num;
-        if( sample == 2 ) {
-            M2 = delta*(sample-current_mean);
-        } else {
-            M2 = M2 + delta*(sample - current_mean);
+        init(sample);
+        if( n > 0 ) {
+            memcpy(traits::data(current_mean),traits::data(sample),n*sizeof(double));
+            memcpy(traits::data(min_sample),traits::data(sample),n*sizeof(double));
+            memcpy(traits::data(max_sample),traits::data(sample),n*sizeof(double));
+        }
+        return;
+    }
+    assert(n == delta.size());
+
+    const double * x = traits::data(sample);
+    double * mean = traits::data(current_mean);
+    double * m2 = traits::data(M2);
+    double * min_x = traits::data(min_sample);
+    double * max_x = traits::data(max_sample);
+    double * d = n > 0 ? &(delta[0]) : 0;
+    const double inv_num = 1.0/sample_num;
+
+    for(size_t i=0; i < n; i++ ) {
+        d[i] = x[i]-mean[i];
+        mean[i] += d[i]*inv_num;
+        m2[i] += d[i]*(x[i]-mean[i]);
+        if( x[i] < min_x[i] ) min_x[i] = x[i];
+        if( x[i] > max_x[i] ) max_x[i] = x[i];
+    }
+
+    if( full_covariance ) {
+        //C += delta*(sample-mean)^T, only the upper triangle
+        for(size_t i=0; i < n; i++ ) {
+            double * C_row = C[i];
+            for(size_t j=i; j < n; j++ ) {
+                C_row[j] += d[i]*(x[j]-mean[j]);
+            }
         }
     }
     return;
 }
 
+template<class T>
+void onlineMean<T>::merge(const onlineMean<T>& other) {
+    if( other.sample_num == 0 ) return;
+    if( sample_num == 0 ) {
+        bool keep_covariance = full_covariance && other.full_covariance;
+        *this = other;
+        full_covariance = keep_covariance;
+        return;
+    }
+    const size_t n = delta.size();
+    assert(n == other.delta.size());
+
+    const double n_a = sample_num, n_b = other.sample_num;
+    const double n_ab = n_a + n_b;
+    double * mean = traits::data(current_mean);
+    double * m2 = traits::data(M2);
+    double * min_x = traits::data(min_sample);
+    double * max_x = traits::data(max_sample);
+    const double * other_mean = traits::data(other.current_mean);
+    const double * other_m2 = traits::data(other.M2);
+    const double * other_min = traits::data(other.min_sample);
+    const double * other_max = traits::data(other.max_sample);
+    double * d = n > 0 ? &(delta[0]) : 0;
+
+    for(size_t i=0; i < n; i++ ) {
+        d[i] = other_mean[i]-mean[i];
+        mean[i] += d[i]*(n_b/n_ab);
+        m2[i] += other_m2[i] + d[i]*d[i]*(n_a*n_b/n_ab);
+        if( other_min[i] < min_x[i] ) min_x[i] = other_min[i];
+        if( other_max[i] > max_x[i] ) max_x[i] = other_max[i];
+    }
+
+    full_covariance = full_covariance && other.full_covariance;
+    if( full_covariance ) {
+        for(size_t i=0; i < n; i++ ) {
+            double * C_row = C[i];
+            const double * other_C_row = other.C[i];
+            for(size_t j=i; j < n; j++ ) {
+                C_row[j] += other_C_row[j] + d[i]*d[j]*(n_a*n_b/n_ab);
+            }
+        }
+    }
+    sample_num += other.sample_num;
+}
+
 template<class T>
 void onlineMean<T>::reset() {
     sample_num = 0;
 }
 
 template<class T>
-T onlineMean<T>::getMean() {
+const T & onlineMean<T>::getMean() const {
     return current_mean;
 }
 
 template<class T>
-T onlineMean<T>::getVariance() {
-    return M2/(sample_num-1);
+T onlineMean<T>::getVariance() const {
+    T variance = M2;
+    const size_t n = delta.size();
+    double * var = traits::data(variance);
+    for(size_t i=0; i < n; i++ ) {
+        var[i] = sample_num > 1 ? var[i]/(sample_num-1) : 0.0;
+    }
+    return variance;
+}
+
+template<class T>
+const T & onlineMean<T>::getMin() const {
+    return min_sample;
+}
+
+template<class T>
+const T & onlineMean<T>::getMax() const {
+    return max_sample;
+}
+
+template<class T>
+yarp::sig::Matrix onlineMean<T>::getCovariance() const {
+    const int n = delta.size();
+    yarp::sig::Matrix covariance(n,n);
+    covariance.zero();
+    if( !full_covariance || sample_num < 2 ) return covariance;
+    for(int i=0; i < n; i++ ) {
+        for(int j=i; j < n; j++ ) {
+            covariance(i,j) = covariance(j,i) = C(i,j)/(sample_num-1);
+        }
+    }
+    return covariance;
+}
+
+template<class T>
+bool onlineMean<T>::hasCovariance() const {
+    return full_covariance;
 }
 
 template<class T>
-unsigned int  onlineMean<T>::getSampleNum() {
+unsigned int  onlineMean<T>::getSampleNum() const {
     return sample_num;
 }
 
+#endif
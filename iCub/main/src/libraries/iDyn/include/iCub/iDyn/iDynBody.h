@@ -98,6 +98,13 @@ enum FlowType{ RBT_NODE_IN, RBT_NODE_OUT };
 // JAC_IKIN = inverse flow wrt kinematics
 enum JacobType{ JAC_KIN, JAC_IKIN }; 
 
+// Torso node limb
+// used to address one of the three limbs of a iDynSensorTorsoNode without
+// comparing its name at every call: the handle can be resolved once from the 
+// limb name with getLimbHandle()
+// TORSO_NODE_UNKNOWN_LIMB = the name does not match any limb of the node
+enum TorsoNodeLimb{ TORSO_NODE_UP, TORSO_NODE_LEFT, TORSO_NODE_RIGHT, TORSO_NODE_UNKNOWN_LIMB };
+
 
 #define RBT_HAS_SENSOR	    true
 #define RBT_NO_SENSOR	    false
@@ -154,6 +161,9 @@ protected:
 	///flag for sensor or not - only used for setWrenchMeasures()
 	bool hasSensor;
 
+	///flag for kinematics to be recomputed: true if the limb state or its kinematic input changed after the last computation
+	bool kinDirty;
+
 	// these variables are not redundant: because multiple RBT can be attached 
 	// to a node, and different policies of information sharing can exist
 
@@ -347,6 +357,28 @@ public:
 	*/
 	bool isSensorized() const;
 
+	/**
+	* Set the kinematic dirty flag of the limb, i.e. mark its kinematics as outdated
+	* (or as updated, if dirty=false).
+	* @param dirty true if the kinematics of the limb must be recomputed
+	*/
+	void setKinematicDirty(bool dirty=true);
+
+	/**
+	* Return the kinematic dirty flag of the limb. The flag is set when the joint state of the 
+	* limb or its kinematic input (measure or node kinematics) are changed, and cleared 
+	* when the kinematics of the limb is computed by the node.
+	* @return true if the kinematics of the limb must be recomputed, false otherwise
+	*/
+	bool isKinematicDirty() const;
+
+	/**
+	* Return a boolean, depending if the RBT is attached to the given limb.
+	* @param _limb pointer to a iDynLimb
+	* @return true if the RBT is attached to _limb, false otherwise
+	*/
+	bool isAttachedTo(const iDyn::iDynLimb *_limb) const;
+
 	/**
 	* Calls the compute kinematic of the limb
 	*/
@@ -600,6 +632,13 @@ protected:
 	*/
 	unsigned int howManyKinematicInputs(bool afterAttach=false) const;
 
+	/**
+	* Return the index of a limb attached to the node.
+	* @param limb pointer to the iDynLimb
+	* @return the index of the limb (its number of insertion in the node), the number of limbs if the limb is not attached to the node
+	*/
+	unsigned int getLimbIndex(const iDyn::iDynLimb *limb) const;
+
 public:
 
 	/**
@@ -655,6 +694,26 @@ public:
 	*/
 	bool solveKinematics();
 
+	/**
+	* Targeted version of solveKinematics(): the kinematics is propagated only along the path from
+	* the limb with kinematic input to the chosen limb, and only the limbs whose kinematic dirty flag
+	* is set are recomputed. The input limb is recomputed if its state or the kinematic measure changed,
+	* and in that case all the other limbs are marked as dirty; then the chosen limb is recomputed, if dirty.
+	* The other limbs keep their flag, and are updated by the next solveKinematics().
+	* Note that the flags are set by the limb calls of the nodes (and by setKinematicMeasure()), so
+	* changes made directly on the limbs must be notified with setLimbKinematicDirty().
+	* @param iLimb the index of the limb - the index is the number of insertion of the limb in the node
+	* @return true if succeeds, false otherwise
+	*/
+	bool solveLimbKinematics(const unsigned int iLimb);
+
+	/**
+	* Mark the kinematics of a limb attached to the node as outdated, so that it is recomputed
+	* by the next solveLimbKinematics().
+	* @param iLimb the index of the limb - the index is the number of insertion of the limb in the node
+	*/
+	void setLimbKinematicDirty(const unsigned int iLimb);
+
 	/**
 	* Set the kinematic measurement (w,dw,ddp) on the limb where the kinematic flow is of type RBT_NODE_IN.
 	*/
@@ -1158,12 +1217,50 @@ public:
 	*/
 	yarp::sig::Matrix getHUp() { return HUp; } 	
 
+	/**
+    * Return the handle of the chosen limb, to be used in place of its name in the 
+	* limb calls: the name is compared with the ones of the limbs only once.
+	* @param limbType a string with the limb name
+	* @return the limb handle, TORSO_NODE_UNKNOWN_LIMB if there is no limb with that name
+	*/
+	TorsoNodeLimb getLimbHandle(const std::string &limbType) const;
+
+	/**
+    * Return the chosen limb.
+	* @param limb the limb handle
+	* @return a pointer to the limb, NULL if the handle is TORSO_NODE_UNKNOWN_LIMB
+	*/
+	iDyn::iDynLimb * getLimb(const TorsoNodeLimb limb) const;
+
+	/**
+	* Targeted solution of the kinematics: only the central-up limb (which receives the
+	* inertial measure) and the chosen limb are recomputed, if their state changed. 
+	* See iDynNode::solveLimbKinematics().
+	* @param limb the limb handle
+	* @return true if succeeds, false otherwise
+	*/
+	bool solveLimbKinematics(const TorsoNodeLimb limb);
+
+	/**
+	* Redefinition from iDynNode.
+	* @param iLimb the index of the limb - the index is the number of insertion of the limb in the node
+	* @return true if succeeds, false otherwise
+	*/
+	bool solveLimbKinematics(const unsigned int iLimb)
+	{ return iDynNode::solveLimbKinematics(iLimb); }
+
 	/**
     * Return the chosen limb forces, as a 6xN matrix.
 	* @param limbType a string with the limb name
 	* @return the chosen limb forces
 	*/
 	yarp::sig::Matrix getForces(const std::string &limbType);	
+	/**
+    * Return the chosen limb forces, as a 6xN matrix.
+	* @param limb the limb handle
+	* @return the chosen limb forces
+	*/
+	yarp::sig::Matrix getForces(const TorsoNodeLimb limb);
 
 	/**
     * Return the chosen limb-link force, as a 3x1 vector
@@ -1179,6 +1276,12 @@ public:
 	* @return the chosen limb moments
 	*/
 	yarp::sig::Matrix getMoments(const std::string &limbType);
+	/**
+    * Return the chosen limb moments, as a 6xN matrix
+	* @param limb the limb handle
+	* @return the chosen limb moments
+	*/
+	yarp::sig::Matrix getMoments(const TorsoNodeLimb limb);
 
 	/**
     * Return the chosen limb-link moment, as a 3x1 vector
@@ -1194,6 +1297,12 @@ public:
 	* @return the chosen limb torques
 	*/
 	yarp::sig::Vector getTorques(const std::string &limbType);
+	/**
+    * Return the chosen limb torques, as a Nx1 vector
+	* @param limb the limb handle
+	* @return the chosen limb torques
+	*/
+	yarp::sig::Vector getTorques(const TorsoNodeLimb limb);
 
 	/**
     * Return the chosen limb-link torque, as a real value
@@ -1215,6 +1324,19 @@ public:
 	*/
 	bool EXPERIMENTAL_computeCOMjacobian();
 
+	/**
+	* Fast variant of computeCOM() and EXPERIMENTAL_computeCOMjacobian(): the COM of each limb, and 
+	* optionally its jacobian, are computed with a single forward pass along the chain, chaining 
+	* the (cached) link frames instead of computing the transform from the base for each link. 
+	* The cost is linear in the number of links; the only matrices allocated are the copy of H0 and 
+	* the base frame of each limb in the node, once per limb, before the pass.
+	* The results are stored in the same variables (total_COM_*, total_mass_*, COM_jacob_*); 
+	* the axis of the first joint of each limb includes the H0 matrix of the limb.
+	* @param computeJacobian if true the COM jacobians are computed too
+	* @return true if succeeds, false otherwise
+	*/
+	bool fastComputeCOM(bool computeJacobian=false);
+
 	/**
     * Return the torso force
 	* @return the torso force
@@ -1373,6 +1495,115 @@ public:
 	*/
 	unsigned int	  getNLinks(const std::string &limbType) const;
 
+	//------------------
+	//  LIMB CALLS (HANDLE)
+	//------------------
+
+    /**
+    * Set joints angle position in the chosen limb
+    * @param limb the limb handle
+    * @param _q the joints position
+    * @return the effective joint angles, considering min/max values
+    */
+	yarp::sig::Vector setAng(const TorsoNodeLimb limb, const yarp::sig::Vector &_q);
+    /**
+    * Get joints angle position in the chosen limb
+    * @param limb the limb handle
+    * @return the joint angles
+    */
+    yarp::sig::Vector getAng(const TorsoNodeLimb limb);
+    /**
+    * Set the i-th joint angle position in the chosen limb
+    * @param limb the limb handle
+    * @param i the link index in the limb
+    * @param _q the joint position
+    * @return the effective joint angle, considering min/max values
+    */
+    double            setAng(const TorsoNodeLimb limb, const unsigned int i, double _q);
+    /**
+    * Get a joint angle position in the chosen limb
+    * @param limb the limb handle
+    * @param i the link index in the limb
+    * @return the joint angle
+    */
+    double            getAng(const TorsoNodeLimb limb, const unsigned int i);
+
+    /**
+    * Set joints angle velocity in the chosen limb
+    * @param limb the limb handle
+    * @param _dq the joints velocity
+    * @return the effective joint velocity
+    */
+	yarp::sig::Vector setDAng(const TorsoNodeLimb limb, const yarp::sig::Vector &_dq);
+    /**
+    * Get joints angle velocity in the chosen limb
+    * @param limb the limb handle
+    * @return the joint velocity
+    */
+    yarp::sig::Vector getDAng(const TorsoNodeLimb limb);
+    /**
+    * Set the i-th joint angle velocity in the chosen limb
+    * @param limb the limb handle
+    * @param i the link index in the limb
+    * @param _dq the joint velocity
+    * @return the effective joint velocity
+    */
+    double            setDAng(const TorsoNodeLimb limb, const unsigned int i, double _dq);
+    /**
+    * Get a joint angle velocity in the chosen limb
+    * @param limb the limb handle
+    * @param i the link index in the limb
+    * @return the joint velocity
+    */
+    double            getDAng(const TorsoNodeLimb limb, const unsigned int i);
+
+    /**
+    * Set joints angle acceleration in the chosen limb
+    * @param limb the limb handle
+    * @param _ddq the joints acceleration
+    * @return the effective joint acceleration
+    */
+	yarp::sig::Vector setD2Ang(const TorsoNodeLimb limb, const yarp::sig::Vector &_ddq);
+    /**
+    * Get joints angle acceleration in the chosen limb
+    * @param limb the limb handle
+    * @return the joint acceleration
+    */
+    yarp::sig::Vector getD2Ang(const TorsoNodeLimb limb);
+    /**
+    * Set the i-th joint angle acceleration in the chosen limb
+    * @param limb the limb handle
+    * @param i the link index in the limb
+    * @param _ddq the joint acceleration
+    * @return the effective joint acceleration
+    */
+    double            setD2Ang(const TorsoNodeLimb limb, const unsigned int i, double _ddq);
+    /**
+    * Get a joint angle acceleration in the chosen limb
+    * @param limb the limb handle
+    * @param i the link index in the limb
+    * @return the joint acceleration
+    */
+    double            getD2Ang(const TorsoNodeLimb limb, const unsigned int i);
+
+	/**
+	* @param limb the limb handle
+	* @return the number of links of the chosen limb
+	*/
+	unsigned int	  getNLinks(const TorsoNodeLimb limb) const;
+
+	/**
+	* Set joints angle position, velocity and acceleration in the chosen limb with a single call, 
+	* writing them directly in the links: no intermediate vectors are built. 
+	* @param limb the limb handle
+	* @param _q the joints position
+	* @param _dq the joints velocity
+	* @param _ddq the joints acceleration
+	* @param scale a factor multiplying the three vectors (e.g. CTRL_DEG2RAD if they are expressed in degrees)
+	* @return true if succeeds (known limb and vectors with at least N elements), false otherwise
+	*/
+	bool setState(const TorsoNodeLimb limb, const yarp::sig::Vector &_q, const yarp::sig::Vector &_dq, const yarp::sig::Vector &_ddq, const double scale=1.0);
+
 	/**
 	* Redefinition from iDynSensorNode.
 	* Exploit iDynInvSensor methods to retrieve FT sensor measurements after
@@ -1497,6 +1728,8 @@ public:
 	/**
 	* Connect upper and lower torso: this procedure handles the exchange of kinematic and
 	* wrench variables between the two parts.
+	* The kinematic measure of the lower torso is marked as changed, so after the attach
+	* the lower torso can be solved only for the needed limb with solveLimbKinematics().
 	*/
 	void attachLowerTorso(const yarp::sig::Vector &FM_right_leg, const yarp::sig::Vector &FM_left_leg);
 
@@ -30,6 +30,8 @@
 #ifndef __IDYNCONT_H__
 #define __IDYNCONT_H__
 
+#include <vector>
+#include <yarp/os/Semaphore.h>
 #include <iCub/iDyn/iDyn.h>
 #include "iCub/skinDynLib/dynContactList.h"
 
@@ -59,10 +61,63 @@ protected:
     // body part related to this solver
     iCub::skinDynLib::BodyPart      bodyPart;
 
+    // true if the contacts are estimated with the live parameters instead of the ones of the links
+    bool liveParamsEnabled;
+    // double buffer of the live parameters: the reader uses liveParams[liveFront], the writer fills the other one
+    yarp::sig::Vector liveParams[2];
+    int liveFront;
+    // true if the writer published new parameters not yet swapped in by the reader
+    bool liveParamsFresh;
+    // protects the two buffers, their swap and the basis (liveBasis, liveOffset, liveExcludedLink)
+    yarp::os::Semaphore liveParamsMutex;
+    // basis of the live parameters: the inertial parameters of the links after the sensor are liveBasis*theta
+    yarp::sig::Matrix liveBasis;
+    // true if the last 6 live parameters are an offset of the F/T sensor
+    bool liveOffset;
+    // link excluded from the regressor (e.g. virtual link), -1 if none
+    int liveExcludedLink;
+    // copies used by the contact estimation out of the lock: inertial parameters of the links after 
+    // the sensor (liveBasis*theta), offset of the F/T sensor and excluded link
+    yarp::sig::Vector liveBeta;
+    yarp::sig::Vector liveSensorOffset;
+    int liveBetaExcludedLink;
+    // sensor wrench regressor
+    yarp::sig::Matrix liveY;
+
+    // contact set of the cached system: link and number of unknowns (1 force module, 3 force, 6 wrench) of each contact
+    std::vector<unsigned int> cachedContacts;
+    // matrix of the contact system: the blocks that depend only on the contact set are filled when
+    // the set changes, the ones that depend on the configuration at each call
+    yarp::sig::Matrix cachedA;
+    // A^T*A (or A*A^T) and its Cholesky factor, recomputed at each call since they depend on the configuration
+    yarp::sig::Matrix cachedM;
+    yarp::sig::Matrix cachedL;
+    // true if cachedL is the factor of A^T*A (overdetermined system), false if of A*A^T
+    bool cachedNormal;
+
     void findContactSubChain(unsigned int &firstLink, unsigned int &lastLink);
     
     yarp::sig::Matrix buildA(unsigned int firstContactLink, unsigned int lastContactLink);
     yarp::sig::Vector buildB(unsigned int firstContactLink, unsigned int lastContactLink);
+
+    /**
+     * Build the matrix A of the contact system expressing the contacts in the frame Href*<refLink>.
+     * The matrix is stored in cachedA: only the blocks that depend on the configuration are 
+     * written, unless the contact set changed since the last call.
+     */
+    const yarp::sig::Matrix &buildA(const yarp::sig::Matrix &Href, unsigned int refLink);
+
+    /**
+     * Build the vector B of the contact system in the sensor frame, using the live parameters.
+     */
+    bool buildLiveB(yarp::sig::Vector &B);
+
+    /**
+     * Solve the contact system A*X=B (least squares, minimum norm) with the Cholesky factor 
+     * of A^T*A (or A*A^T), computed in the preallocated buffers of the contact set. 
+     * The pseudoinverse is used if A is rank deficient.
+     */
+    yarp::sig::Vector solveContactSystem(const yarp::sig::Matrix &A, const yarp::sig::Vector &B);
     
     //***************************************************************************************
     // UTILITY METHODS
@@ -155,6 +210,40 @@ public:
      */
 	void computeWrenchFromSensorNewtonEuler();
 
+    //***************************************************************************************
+    // LIVE PARAMETERS
+    //***************************************************************************************
+
+    /**
+     * Set the basis of the live parameters, e.g. the identifiable parameters basis used by an online estimator. 
+     * The inertial parameters of the links after the sensor are basis*theta, where theta are the first 
+     * basis.cols() live parameters.
+     * @param basis matrix with 10 rows for each link after the sensor (excluded_link not considered)
+     * @param offset true if the live parameters end with 6 offsets of the F/T sensor measure
+     * @param excluded_link index of a link excluded from the regressor (usually a virtual link), -1 if none
+     * @return true if operation succeeded, false otherwise
+     */
+    bool setLiveParametersBasis(const yarp::sig::Matrix &basis, bool offset=false, const int excluded_link=-1);
+
+    /**
+     * Publish a new vector of live parameters. It can be called from another thread (e.g. the estimator one): 
+     * the parameters are copied in a back buffer, the contact estimation swaps it in at its next call.
+     * @param params the parameters, basis.cols() (+6 if offset) elements
+     * @return true if operation succeeded, false otherwise
+     */
+    bool publishLiveParameters(const yarp::sig::Vector &params);
+
+    /**
+     * Enable/disable the estimation of the contacts with the live parameters instead of the 
+     * dynamic parameters of the links. It is enabled only once parameters have been published.
+     */
+    void setLiveParametersEnabled(bool enabled);
+
+    /**
+     * @return true if the contacts are estimated with the live parameters
+     */
+    bool getLiveParametersEnabled() const;
+
     //***************************************************************************************
     // GET METHODS
     //***************************************************************************************
@@ -117,6 +117,8 @@ protected:
 	yarp::sig::Vector zm;	
 	///the corresponding iDynLink 
 	iDyn::iDynLink *link;	
+	///(3x1) buffer for passing the results of the recursion to the set methods without allocations
+	yarp::sig::Vector v3;
 
 	//~~~~~~~~~~~~~~~~~~~~~~
 	//   set methods  
@@ -1107,6 +1109,109 @@ public:
 
 
 
+/**
+* \ingroup RecursiveNewtonEuler
+*
+* A class for computing the classic Newton-Euler recursion of an iDynChain for many
+* configurations at once, e.g. to validate a set of inertial parameters on a dataset. 
+* The configurations are processed in blocks of BATCH_SIZE samples, and the state of
+* each link is stored in structure-of-arrays layout (one array of BATCH_SIZE elements
+* for each component), so that each step of the recursion is a loop over the samples
+* of the block that the compiler can vectorize. 
+* The DH parameters, the blocked links and H0 are read from the iDynChain at each
+* computation, the inertial parameters are a vector in identification format (see 
+* iDynChainGetLinkBeta). Only the DYNAMIC mode without rotor is implemented, and the
+* end-effector wrench is assumed to be zero.
+*/
+class BatchChainNewtonEuler
+{
+public:
+
+	/// number of samples processed together
+	static const int BATCH_SIZE = 32;
+
+protected:
+
+	/// state of a link for a block of samples
+	struct LinkState;
+
+	/// the kinematic chain of the robot
+	iDyn::iDynChain *chain;
+	/// the state of the base (0) and of the links (1..N)
+	LinkState *state;
+	/// number of links
+	unsigned int nLinks;
+	/// inertial parameters, 10 for each link in identification format
+	yarp::sig::Vector params;
+	/// verbosity flag
+	unsigned int verbose;
+
+	// not copyable
+	BatchChainNewtonEuler(const BatchChainNewtonEuler &);
+	BatchChainNewtonEuler &operator=(const BatchChainNewtonEuler &);
+
+public:
+
+	/**
+	* Constructor: the inertial parameters are initialized with the ones of the links of the chain
+	* @param _c the chain, not owned
+	*/
+	BatchChainNewtonEuler(iDyn::iDynChain *_c, unsigned int verb = iCub::skinDynLib::NO_VERBOSE);
+
+	/**
+	* Standard destructor
+	*/
+	~BatchChainNewtonEuler();
+
+	/**
+	* Set the inertial parameters of the links
+	* @param phi (10*N) vector, the parameters of each link in identification format
+	* @return true if succeeds, false otherwise
+	*/
+	bool setParameters(const yarp::sig::Vector &phi);
+
+	/**
+	* Set the inertial parameters to the ones currently stored in the links of the chain
+	*/
+	void setParametersFromChain();
+
+	/**
+	* @return the (10*N) vector of the inertial parameters in identification format
+	*/
+	const yarp::sig::Vector &getParameters() const;
+
+	/**
+	* Compute the joint torques and the base wrench for K configurations.
+	* @param q (KxDOF) joint angles, one configuration for each row
+	* @param dq (KxDOF) joint velocities
+	* @param ddq (KxDOF) joint accelerations
+	* @param kinBase (Kx9) or (1x9) kinematics of the base [w0 dw0 ddp0], expressed as in 
+	*        OneChainNewtonEuler::initKinematicBase; with one row the same is used for all samples
+	* @param tau (KxN) output joint torques
+	* @param FMbase (Kx6) output base wrench, as in OneChainNewtonEuler::getWrenchBase
+	* @return true if succeeds, false otherwise (wrong sizes)
+	*/
+	bool computeNewtonEuler(const yarp::sig::Matrix &q, const yarp::sig::Matrix &dq, const yarp::sig::Matrix &ddq,
+	                        const yarp::sig::Matrix &kinBase, yarp::sig::Matrix &tau, yarp::sig::Matrix &FMbase);
+
+	/**
+	* Compute the joint torques, the base wrench and the wrench transmitted to the link wrenchLink
+	* for K configurations. The latter is the wrench of the links wrenchLink..N-1, as the one measured
+	* by a F/T sensor in wrenchLink (see iDynChainRegressorSensorWrench).
+	* @param wrenchLink the link
+	* @param H (4x4) pose of the frame of the output wrench with respect to the frame of wrenchLink (e.g. iDynSensor::getH())
+	* @param FMlink (Kx6) output wrench of the link
+	* @return true if succeeds, false otherwise (wrong sizes or index)
+	*/
+	bool computeNewtonEuler(const yarp::sig::Matrix &q, const yarp::sig::Matrix &dq, const yarp::sig::Matrix &ddq,
+	                        const yarp::sig::Matrix &kinBase, yarp::sig::Matrix &tau, yarp::sig::Matrix &FMbase,
+	                        const unsigned int wrenchLink, const yarp::sig::Matrix &H, yarp::sig::Matrix &FMlink);
+
+};
+
+
+
+
 /**
  * \defgroup iDynInv iDynInv 
  *    
@@ -1308,9 +1413,9 @@ public:
 	
     /**
      * Get the sensor roto-translational matrix defining its position/orientation wrt the link
-	 * @return a (4x4) matrix
+	 * @return a reference to the (4x4) matrix, empty if the sensor is not set
      */
-	yarp::sig::Matrix getH() const;
+	const yarp::sig::Matrix & getH() const;
     
     /**
      * Get the sensor roto-translational matrix defining its position/orientation wrt the link i of the chain
@@ -113,9 +113,10 @@ namespace Regressor
     * @param p_sensor pointer to the given iDynSensor
     * @param Y reference to the matrix where store the output matrix
     * @param excluded_link optional index (referring to the original iDynChain) of a link excluded from calculation of regressor matrix (usually because it is a virtual link introduced to describe a joint with more than one DOF)
+    * @param use_specialized if true, use the code generated by scripts/generateSpecializedRegressors.py when the chain is supported (see iDynChainHasSpecializedRegressor)
     * @return false in case of error, true otherwise
     */
-     bool iDynChainRegressorSensorWrench(iCub::iDyn::iDynChain *p_chain,iCub::iDyn::iDynSensor * p_sensor, yarp::sig::Matrix & Y, const int excluded_link = -1);
+     bool iDynChainRegressorSensorWrench(iCub::iDyn::iDynChain *p_chain,iCub::iDyn::iDynSensor * p_sensor, yarp::sig::Matrix & Y, const int excluded_link = -1, bool use_specialized = false);
     
     /**
     * For a given iDynChain calculate the regressor matrix \f$Y_1\f$ such that \f${W \brack \tau} = Y_1 \phi\f$ 
@@ -223,9 +224,235 @@ namespace Regressor
     * @return false in case of error, true otherwise
     */
     bool iDynChainRegressorInternalWrench(iCub::iDyn::iDynChain *p_chain,iCub::iDyn::iDynSensor * p_sensor, yarp::sig::Matrix & A, int wrench_index, std::vector<bool> excluded_links);
-    
 
-    
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    //Projected regressors
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    /**
+    * Set of bases \f$ B_0 , \dots , B_{n-1} \f$ of subspaces of the parameter space of a chain
+    * (for example the identifiable subspace), stored as per link slices for calculating
+    * directly the projected regressors \f$ [ Y B_0 \ \dots \ Y B_{n-1} ] \f$ without building \f$ Y \f$.
+    *
+    * The slice of link \f$ j \f$ contains the 10 rows of \f$ [ B_0 \ \dots \ B_{n-1} ] \f$ relative
+    * to the parameters of the link, stored contiguously in row major order, and only
+    * for the columns that are not zero for that link.
+    */
+    class RegressorProjection
+    {
+    private:
+        int n_links;
+        int total_size;
+        std::vector<int> offsets;
+        std::vector<int> sizes;
+        std::vector< std::vector<int> > active_columns;
+        std::vector< std::vector<double> > slices;
+
+    public:
+        RegressorProjection();
+
+        /**
+        * Precompute the per link slices of the bases
+        * @param bases the basis matrices, all with the same number of rows (10 times the number of links considered in the regressor)
+        * @param tol absolute value under which an element of a basis is considered zero
+        * @return false if the bases have not compatible sizes, true otherwise
+        */
+        bool setBases(const std::vector<yarp::sig::Matrix> & bases, double tol = 0.0);
+
+        int getNumberOfLinks() const { return n_links; }
+        int getNumberOfBases() const { return (int)sizes.size(); }
+        /** number of columns of the output projected regressor */
+        int getTotalSize() const { return total_size; }
+        /** first column of the output projected regressor relative to basis b */
+        int getBasisOffset(int b) const { return offsets[b]; }
+        /** number of columns of basis b */
+        int getBasisSize(int b) const { return sizes[b]; }
+        /** columns of the output with non zero slice for the link j */
+        const std::vector<int> & getActiveColumns(int j) const { return active_columns[j]; }
+        /** 10 x getActiveColumns(j).size() slice of the link j, in row major order */
+        const double * getSlice(int j) const { return slices[j].empty() ? 0 : &(slices[j][0]); }
+    };
+
+    /**
+    * For a given iDynChain calculate \f$ Y_1 [ B_0 \ \dots \ B_{n-1} ] \f$, with \f$ Y_1 \f$ the regressor
+    * returned by iDynChainRegressorSensorWrench, applying the slices of the bases as each 6x10 link block is calculated.
+    * The 6 x getTotalSize() output is resized only if it has the wrong size.
+    * @param p_chain pointer to the given iDynChain
+    * @param p_sensor pointer to the given iDynSensor
+    * @param projection the precomputed slices of the bases
+    * @param Y_projected reference to the matrix where store the output matrix
+    * @param excluded_link optional index (referring to the original iDynChain) of a link excluded from calculation of regressor matrix
+    * @return false in case of error, true otherwise
+    */
+    bool iDynChainRegressorSensorWrenchProjected(iCub::iDyn::iDynChain *p_chain,iCub::iDyn::iDynSensor * p_sensor, const RegressorProjection & projection, yarp::sig::Matrix & Y_projected, const int excluded_link = -1);
+
+    /**
+    * For a given limb calculate \f$ \Phi [ B_0 \ \dots \ B_{n-1} ] \f$, with \f$ \Phi \f$ the regressor
+    * returned by iCubLimbRegressorSensorWrench (see iDynChainRegressorSensorWrenchProjected)
+    * @param icub pointer to an iCubWholeBody object, containing the kinematic information about the robot
+    * @param limbName one of right_arm,left_arm,right_leg,left_leg
+    * @param projection the precomputed slices of the bases
+    * @param Phi_projected the projected regressor matrix
+    * @param consider_virtual_link if true, include in the regressor calculation also the virtual link, by default false
+    * @return false if some error occured, true otherwise
+    */
+    bool iCubLimbRegressorSensorWrenchProjected(iCub::iDyn::iCubWholeBody * icub, const std::string & limbName, const RegressorProjection & projection, yarp::sig::Matrix & Phi_projected, bool consider_virtual_link = false);
+
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    //Specialized regressors
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    /**
+    * For a given iDynChain calculate the matrix \f$Y_{\tau}\f$ such that \f$\tau = Y_{\tau}\phi\f$,
+    * where \f$\tau\f$ is the vector of the torques on the joints placed in the chain after the FT sensor
+    * (one row for each joint_index from getSensorLink()+1 to getN()-1, the same rows returned by iDynChainRegressorTorqueEstimation)
+    * @param p_chain pointer to the given iDynChain
+    * @param p_sensor pointer to the given iDynSensor
+    * @param Y reference to the matrix where store the output matrix, resized only if it has the wrong size
+    * @param excluded_link optional index (referring to the original iDynChain) of a link excluded from calculation of regressor matrix
+    * @param use_specialized if true, use the code generated by scripts/generateSpecializedRegressors.py when the chain is supported
+    * @return false in case of error, true otherwise
+    */
+    bool iDynChainRegressorTorquesEstimation(iCub::iDyn::iDynChain *p_chain,iCub::iDyn::iDynSensor * p_sensor, yarp::sig::Matrix & Y, const int excluded_link = -1, bool use_specialized = false);
+
+    /**
+    * Check if a specialized regressor is available for a given iDynChain, i.e. if
+    * the DH parameters of the links after the sensor and the sensor link are the same of
+    * a chain supported by the generator (at the moment the arms of iCubArmNoTorsoDyn and the legs of iCubLegDynV2)
+    */
+    bool iDynChainHasSpecializedRegressor(iCub::iDyn::iDynChain *p_chain,iCub::iDyn::iDynSensor * p_sensor);
+
+    /**
+    * Same as iDynChainRegressorSensorWrench, using the specialized code for the chain
+    * \note the kinematic quantities of the links (w, dw, ddp) are the one calculated by iDyn,
+    *       only the transforms are calculated by the specialized code
+    * @return false if no specialized regressor is available for the chain, true otherwise
+    */
+    bool iDynChainRegressorSensorWrenchSpecialized(iCub::iDyn::iDynChain *p_chain,iCub::iDyn::iDynSensor * p_sensor, yarp::sig::Matrix & Y, const int excluded_link = -1);
+
+    /**
+    * Same as iDynChainRegressorTorquesEstimation, using the specialized code for the chain
+    * @return false if no specialized regressor is available for the chain, true otherwise
+    */
+    bool iDynChainRegressorTorquesEstimationSpecialized(iCub::iDyn::iDynChain *p_chain,iCub::iDyn::iDynSensor * p_sensor, yarp::sig::Matrix & Y, const int excluded_link = -1);
+
+    /**
+    * Compare the specialized regressors of a chain with the generic ones, in the current state of the chain
+    * @param max_error the maximum absolute difference between the elements of the regressors
+    * @return false if no specialized regressor is available for the chain, true otherwise
+    */
+    bool iDynChainRegressorCheckSpecialized(iCub::iDyn::iDynChain *p_chain,iCub::iDyn::iDynSensor * p_sensor, double & max_error, const int excluded_link = -1);
+
+
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    //Block sparse regressors
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    /**
+    * Block sparse storage of a regressor matrix: only the blocks that are not structurally zero are stored
+    * (as dense row major arrays), and the products skip the other elements.
+    *
+    * For the regressor of iDynChainRegressorComplete the blocks of each link are the 3x4 force block
+    * (the force does not depend on the inertia), the 3x10 moment block and the rows of the torques of the joints
+    * placed before the link (the torques of the joints after the link do not depend on its parameters).
+    *
+    * The blocks are defined once (the first time the regressor is calculated) and then overwritten in place.
+    */
+    class BlockSparseRegressor
+    {
+    private:
+        int n_rows;
+        int n_cols;
+        std::vector<int> block_row;
+        std::vector<int> block_col;
+        std::vector<int> block_rows;
+        std::vector<int> block_cols;
+        std::vector<int> block_offset;
+        std::vector<double> data;
+        std::vector<double> workspace;
+
+    public:
+        BlockSparseRegressor();
+
+        /**
+        * Set the size of the matrix, removing all the blocks
+        */
+        void resize(int rows, int cols);
+
+        /**
+        * Add a block (initialized to zero) to the matrix
+        * @return the index of the block
+        */
+        int addBlock(int row, int col, int rows, int cols);
+
+        int rows() const { return n_rows; }
+        int cols() const { return n_cols; }
+        int getNumberOfBlocks() const { return (int)block_row.size(); }
+        /** number of stored elements */
+        int getNonZeros() const { return (int)data.size(); }
+
+        int getBlockRow(int b) const { return block_row[b]; }
+        int getBlockCol(int b) const { return block_col[b]; }
+        int getBlockRows(int b) const { return block_rows[b]; }
+        int getBlockCols(int b) const { return block_cols[b]; }
+        /** elements of the block b, in row major order */
+        double * getBlock(int b) { return &(data[block_offset[b]]); }
+        const double * getBlock(int b) const { return &(data[block_offset[b]]); }
+
+        /**
+        * Buffer of at least size elements, used by the functions computing the regressor
+        * for their intermediate results (memory is allocated only if it is larger than in the
+        * previous calls)
+        */
+        double * getWorkspace(int size);
+
+        /**
+        * out = Y*phi, out is resized only if it has the wrong size
+        */
+        void multiply(const yarp::sig::Vector & phi, yarp::sig::Vector & out) const;
+
+        /**
+        * out = Y(first_row:first_row+out.rows()-1,:)*basis, if out is empty it is resized
+        * to (rows()-first_row) x basis.cols()
+        */
+        void project(const yarp::sig::Matrix & basis, yarp::sig::Matrix & out, int first_row = 0) const;
+
+        /**
+        * G = G + Y(first_row:last_row,:)^T*Y(first_row:last_row,:)
+        */
+        void addGram(int first_row, int last_row, yarp::sig::Matrix & G) const;
+
+        /**
+        * Copy the regressor in a dense matrix
+        */
+        void toDense(yarp::sig::Matrix & out) const;
+    };
+
+    /**
+    * Same as iDynChainRegressorComplete, storing in Y only the blocks that are not structurally zero
+    * @param p_chain pointer to the given iDynChain
+    * @param p_sensor pointer to the given iDynSensor
+    * @param Y the output regressor, its blocks are redefined only if its structure changed (size or excluded link),
+    *          otherwise they are overwritten without allocating memory
+    * @param excluded_link optional index (referring to the original iDynChain) of a link excluded from calculation of regressor matrix
+    * @return false in case of error, true otherwise
+    */
+    bool iDynChainRegressorCompleteBlockSparse(iCub::iDyn::iDynChain *p_chain,iCub::iDyn::iDynSensor * p_sensor, BlockSparseRegressor & Y, const int excluded_link = -1);
+
+    /**
+    * Same as iCubLimbRegressorComplete, storing in Phi only the blocks that are not structurally zero
+    * (see iDynChainRegressorCompleteBlockSparse)
+    * @param icub pointer to an iCubWholeBody object, containing the kinematic information about the robot
+    * @param limbName one of right_arm,left_arm,right_leg,left_leg
+    * @param Phi the output regressor
+    * @param consider_virtual_link if true, include in the regressor calculation also the virtual link, by default false
+    * @return false if some error occured, true otherwise
+    */
+    bool iCubLimbRegressorCompleteBlockSparse(iCub::iDyn::iCubWholeBody * icub, const std::string & limbName, BlockSparseRegressor & Phi, bool consider_virtual_link = false);
+
+
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //iCub Limb regressors
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -239,9 +466,10 @@ namespace Regressor
     * @param limbName one of right_arm,left_arm,right_leg,left_leg
     * @param Phi the regressor matrix
     * @param consider_virtual_link if true, include in the regressor calculation also the virtual link, by default false
+    * @param use_specialized if true, use the specialized regressor of the limb if available (see iDynChainRegressorSensorWrench)
     * @return false if some error occured, true otherwise
     */
-     bool iCubLimbRegressorSensorWrench(iCub::iDyn::iCubWholeBody * icub, const std::string & limbName,yarp::sig::Matrix & Phi, bool consider_virtual_link = false);
+     bool iCubLimbRegressorSensorWrench(iCub::iDyn::iCubWholeBody * icub, const std::string & limbName,yarp::sig::Matrix & Phi, bool consider_virtual_link = false, bool use_specialized = false);
     
     /**
     * For a given limb calculate the regressor matrix \f$\Phi\f$ such that \f${W \brack \tau} = \Phi \phi\f$ 
@@ -269,6 +497,137 @@ namespace Regressor
     */
     bool iCubLimbRegressorInternalWrench(iCub::iDyn::iCubWholeBody * icub, const std::string & limbName,int wrench_index,yarp::sig::Matrix & Phi, bool consider_virtual_link = false);
     
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    //Whole body regressors
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    /**
+    * Regressor of the four FT sensors of the iCub (right_arm, left_arm, right_leg, left_leg) with respect to a
+    * single parameter vector of the whole body, in which the parameters of each rigid body appear only once.
+    *
+    * The bodies are the links of the torso, of the head and of the four limbs, with the links containing
+    * a FT sensor split in the semilink after the sensor and the remaining part of the link before the sensor.
+    * Each body belongs to the subtree after one of the sensors, or to the base subtree (torso, head
+    * and the limb parts before the sensors). The parameters are ordered by limb (torso, head, right_arm, left_arm,
+    * right_leg, left_leg), and for each sensor the parameters of its subtree are contiguous and ordered as in
+    * iCubLimbGetBeta.
+    *
+    * The regressor has 30 rows:
+    * - rows \f$ 6s \dots 6s+5 \f$: wrench of the sensor \f$ s \f$, in the sensor frame (the same obtained calling getSensorForceMoment)
+    * - rows \f$ 24 \dots 29 \f$: net wrench of the base subtree, in the root frame (the frame of the lower torso node),
+    *   that is \f$ - \sum_s X_s W_s \f$ (see getMeasure)
+    *
+    * Each block of 6 rows is equal to the corresponding block of getMeasure only if there is no external contact
+    * on its subtree, whatever the contacts on the other subtrees. For example, when the robot is fixed on the pole
+    * the four sensor blocks are valid and the base block is not; when it stands on its feet the blocks of the arms 
+    * and of the base are valid and the ones of the legs are not.
+    *
+    * The kinematics of the whole body (both upper and lower torso) has to be computed before calling computeRegressor.
+    */
+    class iCubWholeBodyRegressor
+    {
+    public:
+        /** type of the rigid bodies */
+        enum BodyType { WHOLE_LINK, SEMILINK, PROXIMAL_LINK };
+
+        /** number of FT sensors */
+        static const int N_SENSORS = 4;
+        /** row of the regressor containing the net wrench of the base subtree */
+        static const int BASE_ROW = 6*N_SENSORS;
+
+    private:
+        struct Limb
+        {
+            std::string name;
+            iCub::iDyn::iDynChain * p_chain;
+            iCub::iDyn::iDynSensor * p_sensor;
+            /** H of the base of the limb with respect to the frame of its node */
+            yarp::sig::Matrix H_node;
+            bool upper;
+            int virtual_link;
+        };
+
+        struct Body
+        {
+            int limb;
+            int link;
+            BodyType type;
+            /** index of the sensor of the subtree containing the body, -1 for the base subtree */
+            int sensor;
+            int offset;
+        };
+
+        iCub::iDyn::iCubWholeBody * icub;
+        std::vector<Limb> limbs;
+        std::vector<Body> bodies;
+        /** index of the limb of each sensor */
+        int sensor_limb[N_SENSORS];
+        int sensor_offset[N_SENSORS];
+        int sensor_size[N_SENSORS];
+        int n_params;
+
+        void addBody(int limb, int link, BodyType type, int sensor);
+        /** H of the upper torso node with respect to the root frame */
+        yarp::sig::Matrix getUpperTorsoPose();
+        /** H of a link with respect to the root frame, given the H of the upper torso node */
+        yarp::sig::Matrix getLinkPose(const Limb & limb, int link, const yarp::sig::Matrix & H_upper);
+
+    public:
+        /**
+        * Constructor: define the parameter vector for the model of the robot
+        * @param icub pointer to the iCubWholeBody object, that must exist for the whole life of the regressor
+        * @param consider_virtual_link if true, the virtual links of the limbs (see iCubLimbGetData) are considered, by default false
+        */
+        iCubWholeBodyRegressor(iCub::iDyn::iCubWholeBody * icub, bool consider_virtual_link = false);
+
+        /** size of the parameter vector */
+        int getNrOfParameters() const { return n_params; }
+        int getNrOfBodies() const { return (int)bodies.size(); }
+
+        /** name of the body b, as limb_link (for example right_arm_2_semilink) */
+        std::string getBodyName(int b) const;
+        BodyType getBodyType(int b) const { return bodies[b].type; }
+        /** index of the sensor of the subtree containing the body b, -1 for the base subtree */
+        int getBodySensor(int b) const { return bodies[b].sensor; }
+        /** index of the first of the 10 parameters of the body b */
+        int getBodyOffset(int b) const { return bodies[b].offset; }
+
+        /** limb of the sensor s */
+        const std::string & getSensorName(int s) const { return limbs[sensor_limb[s]].name; }
+        /** index of the sensor of a limb (one of right_arm,left_arm,right_leg,left_leg), -1 if not found */
+        int getSensorIndex(const std::string & limbName) const;
+        /** the parameters of the subtree of the sensor s are the getSensorNrOfParameters(s) ones starting from getSensorOffset(s) */
+        int getSensorOffset(int s) const { return sensor_offset[s]; }
+        int getSensorNrOfParameters(int s) const { return sensor_size[s]; }
+
+        /**
+        * Get the parameters of the model of the robot
+        * @param phi the parameter vector
+        */
+        void getParameters(yarp::sig::Vector & phi) const;
+
+        /**
+        * Calculate the regressor
+        * @param Y the output regressor, its blocks are defined only if its structure changed
+        * @return false in case of error, true otherwise
+        */
+        bool computeRegressor(BlockSparseRegressor & Y);
+
+        /**
+        * Get the \f$ H \f$ of the sensor s with respect to the root frame (the frame of the lower torso node)
+        */
+        yarp::sig::Matrix getSensorPose(int s);
+
+        /**
+        * Build the measure corresponding to the rows of the regressor from the measured sensor wrenches
+        * @param sensor_wrenches the 6 element wrenches of the four sensors, in the sensor frames
+        * @param y the output measure, the 24 elements of the sensor wrenches followed by
+        *          \f$ - \sum_s X_s W_s \f$ with \f$ X_s \f$ the transformation of the wrenches from the sensor frame to the root frame
+        * @return false if the sizes are wrong, true otherwise
+        */
+        bool getMeasure(const std::vector<yarp::sig::Vector> & sensor_wrenches, yarp::sig::Vector & y);
+    };
+
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     // iDynChain Get & Set Parameters Functions
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
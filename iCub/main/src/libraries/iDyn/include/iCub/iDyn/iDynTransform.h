@@ -126,6 +126,7 @@ private:
 	yarp::sig::Vector p; // Vector distance of the FT sensor wrt the link reference frame on which the FT sensor is put 
 	yarp::sig::Matrix H; // Rototranslation matrix
 	yarp::sig::Vector FT;
+	unsigned int version; // incremented whenever R, p or H change
 public:
 	/* Default Constructor */
 	iGenericFrame();
@@ -206,6 +207,12 @@ public:
 	yarp::sig::Matrix getR(){return R;}
 	yarp::sig::Matrix getH(){return H;}
 
+	/* 
+	* Version of the frame: it is incremented whenever R, p or H are set, so that the
+	* transforms depending on the frame can be recomputed only when it changes
+	*/
+	unsigned int getVersion() const {return version;}
+
 	/*return the Wrench set with setFT*/
 	yarp::sig::Vector getFT(){return FT;}
 	
@@ -230,11 +237,25 @@ private:
 	iGenericFrame   *Link;
 	iKin::iKinChain *Limb;
 
+	// cache of the sensor kinematics: H is recomputed only if the link, the sensor frame
+	// or the joints before the link changed since the last computation
+	unsigned int version;
+	bool kinValid;
+	int lCache;
+	unsigned int sensorVersionCache;
+	yarp::sig::Vector qCache;
+
 	/*
 	* initializes the iFrameOnLink members to zero. Used in the constructors.
 	*/
 	void initSFrame();
 
+	/*
+	* Check if the cached sensor kinematics is still valid for the link _l, updating the cache keys
+	* @return true if H must be recomputed
+	*/
+	bool isSensorKinChanged(int _l);
+
 protected:
 
 	//set transformation variables of/ the sensor:
@@ -278,6 +299,16 @@ public:
 
 	//set transformation variables of the sensor, with respect to a base frame:
 	yarp::sig::Matrix getH();
+
+	/* 
+	* Version of the sensor transformation H: it is incremented whenever H is recomputed
+	*/
+	unsigned int getVersion() const {return version;}
+	/*
+	* Force the computation of the sensor kinematics at the next query: the joint angles 
+	* are checked automatically, other changes of the chain (H0, blocked links) must be notified
+	*/
+	void invalidate(){kinValid=false;}
 	
 	void setSensor(int _l, const yarp::sig::Vector &_FT);
 	void setSensor(const yarp::sig::Matrix &_H, const yarp::sig::Vector &_FT);
@@ -317,7 +348,19 @@ private:
 
 	bool ownLimb;
 
+	// versions of Hs and He, and the ones used for the last computation of Tse and Teb:
+	// the wrench transformations are recomputed only if the frames changed
+	unsigned int hsVersion;
+	unsigned int heVersion;
+	unsigned int sensorVersionCache;
+	bool heValid;
+	yarp::sig::Vector qeCache;
+	unsigned int hsVersionTse;
+	unsigned int heVersionTse;
+	unsigned int heVersionTeb;
+
 	void initiFTransformation();
+	void updateHs();
 
 public:
 	iFTransformation();
@@ -349,6 +392,12 @@ public:
 	yarp::sig::Matrix getHs(){return Hs;}
 	yarp::sig::Matrix getHe(){return He;}
 
+	/*
+	* Force the computation of all the transformations at the next query, to be called 
+	* after changes of the chain that are not joint angles (H0, blocked links)
+	*/
+	void invalidate();
+
 	
 };
 
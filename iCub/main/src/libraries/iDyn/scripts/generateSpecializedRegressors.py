@@ -0,0 +1,432 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2012
+# Author: Silvio Traversaro
+# CopyPolicy: Released under the terms of the GNU GPL v2.0.
+#
+# Generator of src/iDynRegressorSpecialized.cpp
+#
+# For each supported chain (DH parameters of the iCub limbs after the FT sensor)
+# emits a function computing the homogeneous transforms of the links with respect
+# to the sensor frame, with the constant DH terms folded (cos/sin of alpha and
+# of the offsets multiple of pi/2, zero A and D) and the structural zeros of
+# each DH matrix removed from the products.
+#
+# Usage: python generateSpecializedRegressors.py [output_file]
+#
+
+import math
+import sys
+
+PI = math.pi
+DEG2RAD = PI/180.0
+
+# name, sensor link index, DH table [A, D, alpha, offset] of all the links of the chain
+# (same values used in iCubArmNoTorsoDyn::allocate and iCubLegDynV2::allocate)
+CHAINS = [
+    ("right_arm", 2, [
+        [ 0.0,     -0.0,      PI/2.0, -PI/2.0],
+        [ 0.0,      0.0,     -PI/2.0, -PI/2.0],
+        [-0.015,   -0.15228, -PI/2.0, -105.0*DEG2RAD],
+        [ 0.015,    0.0,      PI/2.0,  0.0],
+        [ 0.0,     -0.1373,   PI/2.0, -PI/2.0],
+        [ 0.0,      0.0,      PI/2.0,  PI/2.0],
+        [ 0.0625,   0.016,    0.0,     PI]]),
+    ("left_arm", 2, [
+        [ 0.0,      0.0,     -PI/2.0,  PI/2.0],
+        [ 0.0,      0.0,      PI/2.0, -PI/2.0],
+        [ 0.015,    0.15228, -PI/2.0,  75.0*DEG2RAD],
+        [-0.015,    0.0,      PI/2.0,  0.0],
+        [ 0.0,      0.1373,   PI/2.0, -PI/2.0],
+        [ 0.0,      0.0,      PI/2.0,  PI/2.0],
+        [ 0.0625,  -0.016,    0.0,     0.0]]),
+    ("leg_v2", 1, [
+        [ 0.0,        0.0,       PI/2.0,  PI/2.0],
+        [ 0.0,        0.0,       PI/2.0,  PI/2.0],
+        [-0.0009175,  0.234545, -PI/2.0, -PI/2.0],
+        [-0.2005,     0.0,       PI,      PI/2.0],
+        [ 0.0,        0.0,       PI/2.0,  0.0],
+        [-0.0685,     0.0035,    PI,      0.0]]),
+]
+
+EPS = 1e-12
+
+
+def fold(x):
+    """Round the values that are 0, 1 or -1 up to numerical error"""
+    for v in (0.0, 1.0, -1.0):
+        if abs(x-v) < EPS:
+            return v
+    return x
+
+
+def num(x):
+    return repr(float(x))
+
+
+def lincomb(terms):
+    """terms: list of (coefficient, symbol), symbol None is the constant 1"""
+    out = []
+    for c, s in terms:
+        if c == 0.0:
+            continue
+        if s is None:
+            t = num(abs(c))
+        elif abs(c) == 1.0:
+            t = s
+        else:
+            t = num(abs(c)) + "*" + s
+        out.append(("-" if c < 0 else "+", t))
+    return out
+
+
+def dh_entries(A, D, alpha):
+    """DH matrix rows 0..2 as linear combinations of ct, st and 1"""
+    ca = fold(math.cos(alpha))
+    sa = fold(math.sin(alpha))
+    A = fold(A)
+    D = fold(D)
+    return [
+        [[(1.0, "ct")], [(-ca, "st")], [(sa, "st")], [(A, "ct")]],
+        [[(1.0, "st")], [(ca, "ct")], [(-sa, "ct")], [(A, "st")]],
+        [[], [(sa, None)], [(ca, None)], [(D, None)]],
+    ]
+
+
+def angle_code(offset):
+    """Code for ct = cos(q+offset), st = sin(q+offset) from c = cos(q), s = sin(q)"""
+    k = offset/(PI/2.0)
+    if abs(k-round(k)) < EPS:
+        k = int(round(k)) % 4
+        return [("c", "s"), ("-s", "c"), ("-c", "-s"), ("s", "-c")][k]
+    co = math.cos(offset)
+    so = math.sin(offset)
+    return ("c*%s-s*%s" % (num(co), num(so)), "s*%s+c*%s" % (num(co), num(so)))
+
+
+def product_code(prev, curr, dh):
+    """Code for curr = prev*DH, with prev and curr 3x4 arrays"""
+    lines = []
+    A = dh[0][3][0][0]
+    D = dh[2][3][0][0]
+    for r in range(3):
+        for c in range(4):
+            parts = []
+            if c == 3:
+                # the position column is A*(first column of curr) + D*(third column of prev) + (position of prev)
+                for coef, factor in ((A, "%s[%d][0]" % (curr, r)), (D, "%s[%d][2]" % (prev, r))):
+                    if coef != 0.0:
+                        parts.append(("-" if coef < 0 else "+", factor + ("" if abs(coef) == 1.0 else "*" + num(abs(coef)))))
+                parts.append(("+", "%s[%d][3]" % (prev, r)))
+                lines.append("        %s[%d][3] = %s;" % (curr, r, join_terms(parts)))
+                continue
+            for k in range(3):
+                comb = lincomb(dh[k][c])
+                if not comb:
+                    continue
+                factor = "%s[%d][%d]" % (prev, r, k)
+                if len(comb) == 1 and comb[0][1] in ("ct", "st"):
+                    parts.append((comb[0][0], factor + "*" + comb[0][1]))
+                elif len(comb) == 1 and comb[0][1] == "1.0":
+                    parts.append((comb[0][0], factor))
+                elif len(comb) == 1:
+                    parts.append((comb[0][0], factor + "*" + comb[0][1]))
+                else:
+                    inner = "".join(sg + t for sg, t in comb).lstrip("+")
+                    parts.append(("+", factor + "*(" + inner + ")"))
+            lines.append("        %s[%d][%d] = %s;" % (curr, r, c, join_terms(parts)))
+    return lines
+
+
+def join_terms(parts):
+    expr = "".join(" %s %s" % (sg, t) for sg, t in parts).strip()
+    if expr.startswith("+ "):
+        expr = expr[2:]
+    elif expr.startswith("- "):
+        expr = "-" + expr[2:]
+    if not expr:
+        expr = "0.0"
+    return expr
+
+
+def chain_code(name, sensor_link, table):
+    lines = []
+    lines.append("//%s: links %d..%d with respect to the sensor frame" % (name, sensor_link, len(table)-1))
+    lines.append("void %s_transforms(const double * q, double T[][3][4])" % name)
+    lines.append("{")
+    for l in range(sensor_link+1, len(table)):
+        A, D, alpha, offset = table[l]
+        k = l-sensor_link
+        ct, st = angle_code(offset)
+        lines.append("    //link %d" % l)
+        lines.append("    {")
+        lines.append("        const double c = cos(q[%d]);" % l)
+        lines.append("        const double s = sin(q[%d]);" % l)
+        lines.append("        const double ct = %s;" % ct)
+        lines.append("        const double st = %s;" % st)
+        lines.extend(product_code("T[%d]" % (k-1), "T[%d]" % k, dh_entries(A, D, alpha)))
+        lines.append("    }")
+    lines.append("}")
+    lines.append("")
+    lines.append("const double %s_dh[%d][4] = {" % (name, len(table)))
+    for row in table:
+        lines.append("    {%s}," % ", ".join(num(v) for v in row))
+    lines.append("};")
+    lines.append("")
+    return lines
+
+
+HEADER = """/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+// This file is generated by scripts/generateSpecializedRegressors.py, do not edit it directly
+
+#include <iCub/iDyn/iDynRegressor.h>
+
+#include <cmath>
+
+using namespace std;
+
+using namespace yarp::sig;
+
+using namespace iCub::iDyn;
+
+using namespace iCub::iDyn::Regressor;
+
+namespace
+{
+
+"""
+
+FOOTER_TEMPLATE = """
+typedef void (*transformsFunction)(const double * q, double T[][3][4]);
+
+struct specializedChain
+{
+    const char * name;
+    int n_links;
+    int sensor_link;
+    const double (*dh)[4];
+    transformsFunction transforms;
+};
+
+const specializedChain specialized_chains[] = {
+%(table)s};
+
+const int n_specialized_chains = %(n_chains)d;
+
+const int max_specialized_links = %(max_links)d;
+
+/**
+ * Return the specialized chain matching the DH parameters and the sensor link of p_chain, 0 if not found
+ */
+const specializedChain * findSpecializedChain(iDynChain * p_chain, iDynSensor * p_sensor)
+{
+    const double tol = 1e-9;
+    const int N = p_chain->getN();
+    const int sensor_link = p_sensor->getSensorLink();
+    for(int i=0; i < n_specialized_chains; i++ ) {
+        const specializedChain & chain = specialized_chains[i];
+        if( chain.n_links != N || chain.sensor_link != sensor_link ) continue;
+        bool match = true;
+        for(int l=sensor_link+1; l < N && match; l++ ) {
+            iCub::iKin::iKinLink & link = (*p_chain)[l];
+            match = fabs(link.getA()-chain.dh[l][0]) < tol &&
+                    fabs(link.getD()-chain.dh[l][1]) < tol &&
+                    fabs(link.getAlpha()-chain.dh[l][2]) < tol &&
+                    fabs(link.getOffset()-chain.dh[l][3]) < tol;
+        }
+        if( match ) return &chain;
+    }
+    return 0;
+}
+
+/**
+ * Compute the transforms of the links sensor_link..N-1 with respect to the sensor frame
+ */
+void computeTransforms(const specializedChain & chain, iDynChain * p_chain, iDynSensor * p_sensor, double T[][3][4])
+{
+    double q[max_specialized_links];
+    for(int l=chain.sensor_link+1; l < chain.n_links; l++ ) {
+        q[l] = (*p_chain)[l].getAng();
+    }
+    //T[0] = SE3inv(p_sensor->getH())
+    const Matrix H_s = p_sensor->getH();
+    for(int r=0; r < 3; r++ ) {
+        for(int c=0; c < 3; c++ ) {
+            T[0][r][c] = H_s(c,r);
+        }
+        T[0][r][3] = -(H_s(0,r)*H_s(0,3)+H_s(1,r)*H_s(1,3)+H_s(2,r)*H_s(2,3));
+    }
+    chain.transforms(q,T);
+}
+
+/**
+ * B = adjointInv(T)^T*N, with N the net wrench regressor of p_link
+ * (same as iDynLinkRegressorNetWrench), removing the structural zeros of N
+ */
+void linkBlock(iDynLink * p_link, const double T[3][4], double B[6][10])
+{
+    const Vector & ddp = p_link->getLinAcc();
+    const Vector & w = p_link->getW();
+    const Vector & dw = p_link->getdW();
+
+    //upper 3x4 block of N (the other columns are zero)
+    double Nf[3][4];
+    Nf[0][0] = ddp[0];                  Nf[1][0] = ddp[1];                  Nf[2][0] = ddp[2];
+    Nf[0][1] = -w[1]*w[1]-w[2]*w[2];    Nf[0][2] = -dw[2]+w[0]*w[1];        Nf[0][3] = dw[1]+w[0]*w[2];
+    Nf[1][1] = dw[2]+w[0]*w[1];         Nf[1][2] = -w[0]*w[0]-w[2]*w[2];    Nf[1][3] = -dw[0]+w[1]*w[2];
+    Nf[2][1] = -dw[1]+w[0]*w[2];        Nf[2][2] = dw[0]+w[1]*w[2];         Nf[2][3] = -w[0]*w[0]-w[1]*w[1];
+
+    //lower 3x10 block of N (the first column is zero)
+    double Nm[3][10];
+    Nm[0][0] = 0.0;         Nm[1][0] = 0.0;         Nm[2][0] = 0.0;
+    Nm[0][1] = 0.0;         Nm[0][2] = ddp[2];      Nm[0][3] = -ddp[1];
+    Nm[1][1] = -ddp[2];     Nm[1][2] = 0.0;         Nm[1][3] = ddp[0];
+    Nm[2][1] = ddp[1];      Nm[2][2] = -ddp[0];     Nm[2][3] = 0.0;
+    Nm[0][4] = dw[0];                Nm[0][5] = dw[1]-w[0]*w[2];      Nm[0][6] = dw[2]+w[0]*w[1];
+    Nm[0][7] = -w[1]*w[2];           Nm[0][8] = w[1]*w[1]-w[2]*w[2];  Nm[0][9] = w[1]*w[2];
+    Nm[1][4] = w[0]*w[2];            Nm[1][5] = dw[0]+w[1]*w[2];      Nm[1][6] = w[2]*w[2]-w[0]*w[0];
+    Nm[1][7] = dw[1];                Nm[1][8] = dw[2]-w[0]*w[1];      Nm[1][9] = -w[0]*w[2];
+    Nm[2][4] = -w[0]*w[1];           Nm[2][5] = w[0]*w[0]-w[1]*w[1];  Nm[2][6] = dw[0]-w[1]*w[2];
+    Nm[2][7] = w[0]*w[1];            Nm[2][8] = dw[1]+w[0]*w[2];      Nm[2][9] = dw[2];
+
+    //adjointInv(T)^T = [R 0; S(p)R R]
+    for(int c=0; c < 4; c++ ) {
+        for(int r=0; r < 3; r++ ) {
+            B[r][c] = T[r][0]*Nf[0][c] + T[r][1]*Nf[1][c] + T[r][2]*Nf[2][c];
+        }
+    }
+    for(int c=4; c < 10; c++ ) {
+        B[0][c] = 0.0;
+        B[1][c] = 0.0;
+        B[2][c] = 0.0;
+    }
+    for(int c=0; c < 10; c++ ) {
+        const double f0 = B[0][c], f1 = B[1][c], f2 = B[2][c];
+        for(int r=0; r < 3; r++ ) {
+            B[3+r][c] = T[r][0]*Nm[0][c] + T[r][1]*Nm[1][c] + T[r][2]*Nm[2][c];
+        }
+        B[3][c] += T[1][3]*f2 - T[2][3]*f1;
+        B[4][c] += T[2][3]*f0 - T[0][3]*f2;
+        B[5][c] += T[0][3]*f1 - T[1][3]*f0;
+    }
+}
+
+int numberOfIdentLinks(const specializedChain & chain, const int excluded_link)
+{
+    const int virtual_links = (excluded_link >= chain.sensor_link && excluded_link < chain.n_links) ? 1 : 0;
+    return chain.n_links-chain.sensor_link-virtual_links;
+}
+
+}
+
+bool iCub::iDyn::Regressor::iDynChainHasSpecializedRegressor(iDynChain * p_chain, iDynSensor * p_sensor)
+{
+    return findSpecializedChain(p_chain,p_sensor) != 0;
+}
+
+bool iCub::iDyn::Regressor::iDynChainRegressorSensorWrenchSpecialized(iDynChain * p_chain, iDynSensor * p_sensor, Matrix & A, const int excluded_link)
+{
+    const specializedChain * p_specialized = findSpecializedChain(p_chain,p_sensor);
+    if( !p_specialized ) return false;
+    const specializedChain & chain = *p_specialized;
+    if( excluded_link >= chain.n_links ) return false;
+
+    const int n_cols = 10*numberOfIdentLinks(chain,excluded_link);
+    if( A.rows() != 6 || A.cols() != n_cols ) {
+        A.resize(6,n_cols);
+    }
+
+    double T[max_specialized_links][3][4];
+    double B[6][10];
+    computeTransforms(chain,p_chain,p_sensor,T);
+    int start_col = 0;
+    for(int link_index=chain.sensor_link; link_index < chain.n_links; link_index++ ) {
+        if( link_index == excluded_link ) continue;
+        linkBlock((iDynLink *) &((*p_chain)[link_index]),T[link_index-chain.sensor_link],B);
+        for(int r=0; r < 6; r++ ) {
+            double * A_row = A[r]+start_col;
+            for(int c=0; c < 10; c++ ) {
+                A_row[c] = B[r][c];
+            }
+        }
+        start_col += 10;
+    }
+    return true;
+}
+
+bool iCub::iDyn::Regressor::iDynChainRegressorTorquesEstimationSpecialized(iDynChain * p_chain, iDynSensor * p_sensor, Matrix & A, const int excluded_link)
+{
+    const specializedChain * p_specialized = findSpecializedChain(p_chain,p_sensor);
+    if( !p_specialized ) return false;
+    const specializedChain & chain = *p_specialized;
+    if( excluded_link >= chain.n_links ) return false;
+
+    const int n_rows = chain.n_links-chain.sensor_link-1;
+    const int n_cols = 10*numberOfIdentLinks(chain,excluded_link);
+    if( A.rows() != n_rows || A.cols() != n_cols ) {
+        A.resize(n_rows,n_cols);
+    }
+    A.zero();
+
+    double T[max_specialized_links][3][4];
+    double B[6][10];
+    computeTransforms(chain,p_chain,p_sensor,T);
+    int start_col = 0;
+    for(int link_index=chain.sensor_link; link_index < chain.n_links-1; link_index++ ) {
+        if( link_index == excluded_link ) continue;
+        linkBlock((iDynLink *) &((*p_chain)[link_index]),T[link_index-chain.sensor_link],B);
+        //torque of the joint i is the z component of the moment in the frame i-1, for i-1 >= link_index
+        for(int joint_link=link_index; joint_link < chain.n_links-1; joint_link++ ) {
+            const double (*H)[4] = T[joint_link-chain.sensor_link];
+            const double z0 = H[0][2], z1 = H[1][2], z2 = H[2][2];
+            //z x o, with o the origin of the joint frame
+            const double b0 = z1*H[2][3]-z2*H[1][3];
+            const double b1 = z2*H[0][3]-z0*H[2][3];
+            const double b2 = z0*H[1][3]-z1*H[0][3];
+            double * A_row = A[joint_link-chain.sensor_link]+start_col;
+            for(int c=0; c < 10; c++ ) {
+                A_row[c] = -(z0*B[3][c]+z1*B[4][c]+z2*B[5][c]) + (b0*B[0][c]+b1*B[1][c]+b2*B[2][c]);
+            }
+        }
+        start_col += 10;
+    }
+    return true;
+}
+"""
+
+
+def generate():
+    lines = [HEADER.rstrip("\n"), ""]
+    for name, sensor_link, table in CHAINS:
+        lines.extend(chain_code(name, sensor_link, table))
+    entries = "".join('    {"%s", %d, %d, %s_dh, %s_transforms},\n' % (name, len(table), sensor_link, name, name)
+                      for name, sensor_link, table in CHAINS)
+    lines.append(FOOTER_TEMPLATE.strip("\n") % {
+        "table": entries,
+        "n_chains": len(CHAINS),
+        "max_links": max(len(t) for _, _, t in CHAINS)})
+    return "\n".join(lines) + "\n"
+
+
+if __name__ == "__main__":
+    output = sys.argv[1] if len(sys.argv) > 1 else "iDynRegressorSpecialized.cpp"
+    f = open(output, "w")
+    f.write(generate())
+    f.close()
@@ -50,6 +50,7 @@ RigidBodyTransformation::RigidBodyTransformation(iDynLimb *_limb, const yarp::si
 	mode = _mode;
 	info = _info;
 	hasSensor=_hasSensor;
+	kinDirty=true;
 	F.resize(3);	F.zero();
 	Mu.resize(3);	Mu.zero();
 	w.resize(3);	w.zero();
@@ -95,6 +96,7 @@ bool RigidBodyTransformation::setKinematic(const Vector &wNode, const Vector &dw
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 bool RigidBodyTransformation::setKinematicMeasure(const Vector &w0, const Vector &dw0, const Vector &ddp0)
 {
+	kinDirty = true;
 	return limb->initKinematicNewtonEuler(w0,dw0,ddp0);
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -276,6 +278,21 @@ bool RigidBodyTransformation::isSensorized() const
 	return hasSensor;
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void RigidBodyTransformation::setKinematicDirty(bool dirty)
+{
+	kinDirty = dirty;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool RigidBodyTransformation::isKinematicDirty() const
+{
+	return kinDirty;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool RigidBodyTransformation::isAttachedTo(const iDynLimb *_limb) const
+{
+	return limb==_limb;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void RigidBodyTransformation::computeLimbKinematic()
 {
 	limb->computeKinematicNewtonEuler();
@@ -473,6 +490,7 @@ bool iDynNode::solveKinematics()
 			// measures are already set
 			//then compute the kinematics pass in that limb 
 			rbtList[i].computeLimbKinematic();
+			rbtList[i].setKinematicDirty(false);
 			// and retrieve the kinematics data in the base/end
 			rbtList[i].getKinematic(w,dw,ddp);		
 			//check
@@ -492,6 +510,7 @@ bool iDynNode::solveKinematics()
 				rbtList[i].setKinematic(w,dw,ddp);
 				//solve kinematics in that limb/chain
 				rbtList[i].computeLimbKinematic();
+				rbtList[i].setKinematicDirty(false);
 			}
 		}
 		return true;
@@ -522,6 +541,7 @@ bool iDynNode::solveKinematics(const Vector &w0, const Vector &dw0, const Vector
 			rbtList[i].setKinematicMeasure(w0,dw0,ddp0);
 			//then compute the kinematics pass in that limb 
 			rbtList[i].computeLimbKinematic();
+			rbtList[i].setKinematicDirty(false);
 			// and retrieve the kinematics data in the base/end
 			rbtList[i].getKinematic(w,dw,ddp);		
 			//check
@@ -541,6 +561,7 @@ bool iDynNode::solveKinematics(const Vector &w0, const Vector &dw0, const Vector
 				rbtList[i].setKinematic(w,dw,ddp);
 				//solve kinematics in that limb/chain
 				rbtList[i].computeLimbKinematic();
+				rbtList[i].setKinematicDirty(false);
 			}
 		}
 		return true;
@@ -559,6 +580,72 @@ bool iDynNode::solveKinematics(const Vector &w0, const Vector &dw0, const Vector
 
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iDynNode::solveLimbKinematics(const unsigned int iLimb)
+{
+	if(iLimb>=rbtList.size())
+	{
+		if(verbose) fprintf(stderr,"iDynNode: error, could not solveLimbKinematics() due to out of range index: %d , while we have %d limbs. \n", iLimb, (int)rbtList.size() );
+		return false;
+	}
+
+	//find the limb (one!) which gets the measured kinematics data
+	unsigned int inputNode=0;
+	unsigned int iInput=0;
+	for(unsigned int i=0; i<rbtList.size(); i++)
+	{
+		if(rbtList[i].getKinematicFlow()==RBT_NODE_IN)
+		{
+			iInput=i;
+			inputNode++;
+		}
+	}
+	if(inputNode!=1)
+	{
+		if(verbose)
+        {
+            fprintf(stderr,"iDynNode error: there are %d limbs with Kinematic Flow = Input. Only one limb must have Kinematic Input from outside measurements/computations. \n",inputNode);
+            fprintf(stderr,"Please check the coherence of the limb configuration in the node <%s> \n",info.c_str());
+        }
+		return false;
+	}
+
+	//the input limb is solved only if its state or the measure changed: 
+	//in that case the node kinematics changes, and all the other limbs are outdated
+	if(rbtList[iInput].isKinematicDirty())
+	{
+		rbtList[iInput].computeLimbKinematic();
+		rbtList[iInput].setKinematicDirty(false);
+		rbtList[iInput].getKinematic(w,dw,ddp);
+		for(unsigned int i=0; i<rbtList.size(); i++)
+			if(i!=iInput) rbtList[i].setKinematicDirty(true);
+	}
+
+	//then only the chosen limb is solved, if outdated
+	if(iLimb!=iInput && rbtList[iLimb].isKinematicDirty())
+	{
+		rbtList[iLimb].setKinematic(w,dw,ddp);
+		rbtList[iLimb].computeLimbKinematic();
+		rbtList[iLimb].setKinematicDirty(false);
+	}
+	return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void iDynNode::setLimbKinematicDirty(const unsigned int iLimb)
+{
+	if(iLimb<rbtList.size())
+		rbtList[iLimb].setKinematicDirty(true);
+	else if(verbose)
+		fprintf(stderr,"iDynNode: error, could not setLimbKinematicDirty() due to out of range index: %d , while we have %d limbs. \n", iLimb, (int)rbtList.size() );
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+unsigned int iDynNode::getLimbIndex(const iDynLimb *limb) const
+{
+	for(unsigned int i=0; i<rbtList.size(); i++)
+		if(rbtList[i].isAttachedTo(limb))
+			return i;
+	return rbtList.size();
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 bool iDynNode::setKinematicMeasure(const Vector &w0, const Vector &dw0, const Vector &ddp0)
 {
 	if( (w0.length()==3)&&(dw0.length()==3)&&(ddp0.length()==3))
@@ -1864,38 +1951,90 @@ bool iDynSensorTorsoNode::update(const Vector &FM_right, const Vector &FM_left,
 	//----------------
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-Matrix iDynSensorTorsoNode::getForces(const string &limbType)
+TorsoNodeLimb iDynSensorTorsoNode::getLimbHandle(const string &limbType) const
 {
-	if(limbType==up_name)				return up->getForces();
-	else if(limbType==left_name)		return left->getForces();
-	else if(limbType==right_name)		return right->getForces();
+	if(limbType==up_name)			return TORSO_NODE_UP;
+	else if(limbType==left_name)	return TORSO_NODE_LEFT;
+	else if(limbType==right_name)	return TORSO_NODE_RIGHT;
 	else
 	{		
 		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+		return TORSO_NODE_UNKNOWN_LIMB;
+	}
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+iDynLimb * iDynSensorTorsoNode::getLimb(const TorsoNodeLimb limb) const
+{
+	switch(limb)
+	{
+		case TORSO_NODE_UP:		return up;
+		case TORSO_NODE_LEFT:		return left;
+		case TORSO_NODE_RIGHT:		return right;
+		default:					return NULL;
+	}
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iDynSensorTorsoNode::solveLimbKinematics(const TorsoNodeLimb limb)
+{
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb==NULL)
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
+		return false;
+	}
+	return iDynNode::solveLimbKinematics(getLimbIndex(p_limb));
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Matrix iDynSensorTorsoNode::getForces(const string &limbType)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return Matrix(0,0);
+	return getForces(limb);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Matrix iDynSensorTorsoNode::getForces(const TorsoNodeLimb limb)
+{
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)		return p_limb->getForces();
+	else
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return Matrix(0,0);
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 Matrix iDynSensorTorsoNode::getMoments(const string &limbType)
 {
-	if(limbType==up_name)			return up->getMoments();
-	else if(limbType==left_name)	return left->getMoments();
-	else if(limbType==right_name)	return right->getMoments();
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return Matrix(0,0);
+	return getMoments(limb);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Matrix iDynSensorTorsoNode::getMoments(const TorsoNodeLimb limb)
+{
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)		return p_limb->getMoments();
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return Matrix(0,0);
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 Vector iDynSensorTorsoNode::getTorques(const string &limbType)
 {
-	if(limbType==up_name)			return up->getTorques();
-	else if(limbType==left_name)	return left->getTorques();
-	else if(limbType==right_name)	return right->getTorques();
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return Vector(0);
+	return getTorques(limb);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynSensorTorsoNode::getTorques(const TorsoNodeLimb limb)
+{
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)		return p_limb->getTorques();
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return Vector(0);
 	}
 }
@@ -2057,6 +2196,131 @@ bool   iDynSensorTorsoNode::EXPERIMENTAL_computeCOMjacobian()
 	return true;
 }
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool   iDynSensorTorsoNode::fastComputeCOM(bool computeJacobian)
+{
+	iCub::iDyn::iDynLimb *limb =       0;
+	yarp::sig::Matrix    *orig =       0;
+	yarp::sig::Vector    *total_COM  = 0;        
+	double               *total_mass = 0;
+	yarp::sig::Matrix    *COM_jacob  = 0;   
+
+	for (int n=0; n<3; n++)
+	{
+		switch (n)
+		{
+			case 0:
+				limb =        (this->left);
+				orig =       &(this->HLeft);
+				total_COM  = &(total_COM_LF);        
+				total_mass = &(total_mass_LF);
+				COM_jacob  = &(COM_jacob_LF);     
+			break;
+			case 1:
+				limb =        (this->right);
+				orig =       &(this->HRight);
+				total_COM  = &(total_COM_RT);        
+				total_mass = &(total_mass_RT);
+				COM_jacob  = &(COM_jacob_RT);    
+			break;
+			case 2:
+				limb =        (this->up);
+				orig =       &(this->HUp);
+				total_COM  = &(total_COM_UP);        
+				total_mass = &(total_mass_UP);
+				COM_jacob  = &(COM_jacob_UP);        
+			break;
+		}
+
+		iDynChain * chain = limb->asChain();
+		const unsigned int N = chain->getN();
+
+		//the total mass is needed by the jacobian during the pass
+		(*total_mass)=0.0;
+		for (unsigned int i=0; i<N; i++)
+			(*total_mass)=(*total_mass)+chain->getMass(i);
+
+		//R,p: frame of the current joint axis with respect to the node, starting from orig*H0
+		double R[3][3], p[3], Rn[3][3];
+		Matrix H = (*orig) * chain->getH0();
+		for (int r=0; r<3; r++)
+		{
+			for (int c=0; c<3; c++) R[r][c]=H(r,c);
+			p[r]=H(r,3);
+		}
+
+		//mass-weighted sum of the link COMs, and mass of the links already visited
+		double mc[3] = {0.0, 0.0, 0.0};
+		double partial_mass = 0.0;
+
+		if (computeJacobian)
+			COM_jacob->resize(6,N);
+
+		for (unsigned int i=0; i<N; i++)
+		{
+			if (computeJacobian)
+			{
+				// the jacobian column i is Z x (sum_{k>=i} m_k c_k - (sum_{k>=i} m_k) o)/total_mass:
+				// the sums on the links k>=i are not known yet, so Z x (sum_{k<i} m_k c_k + (sum_{k>=i} m_k) o)
+				// is stored here, and subtracted from Z x (sum_k m_k c_k) at the end
+				double rest = (*total_mass)-partial_mass;
+				double v[3];
+				for (int r=0; r<3; r++) v[r]=mc[r]+rest*p[r];
+				(*COM_jacob)(0,i)=R[1][2]*v[2]-R[2][2]*v[1];
+				(*COM_jacob)(1,i)=R[2][2]*v[0]-R[0][2]*v[2];
+				(*COM_jacob)(2,i)=R[0][2]*v[1]-R[1][2]*v[0];
+				(*COM_jacob)(3,i)=R[0][2];
+				(*COM_jacob)(4,i)=R[1][2];
+				(*COM_jacob)(5,i)=R[2][2];
+			}
+
+			//chain the link frame (cached by iDynLink if the joint angle is not changed)
+			iDynLink * link = (iDynLink *) &((*chain)[i]);
+			const Matrix & A = link->getH();
+			for (int r=0; r<3; r++)
+			{
+				p[r]+=R[r][0]*A(0,3)+R[r][1]*A(1,3)+R[r][2]*A(2,3);
+				for (int c=0; c<3; c++)
+					Rn[r][c]=R[r][0]*A(0,c)+R[r][1]*A(1,c)+R[r][2]*A(2,c);
+			}
+			for (int r=0; r<3; r++)
+				for (int c=0; c<3; c++) R[r][c]=Rn[r][c];
+
+			//COM of the link with respect to the node
+			const Matrix & C = link->getCOM();
+			double m = link->getMass();
+			for (int r=0; r<3; r++)
+				mc[r]+=m*(p[r]+R[r][0]*C(0,3)+R[r][1]*C(1,3)+R[r][2]*C(2,3));
+			partial_mass+=m;
+		}
+
+		total_COM->resize(4);
+		if (fabs(*total_mass) > 0.00001)
+		{
+			for (int r=0; r<3; r++) (*total_COM)[r]=mc[r]/(*total_mass);
+			(*total_COM)[3]=1.0;
+			if (computeJacobian)
+			{
+				for (unsigned int i=0; i<N; i++)
+				{
+					double Z[3] = {(*COM_jacob)(3,i), (*COM_jacob)(4,i), (*COM_jacob)(5,i)};
+					(*COM_jacob)(0,i)=(Z[1]*mc[2]-Z[2]*mc[1]-(*COM_jacob)(0,i))/(*total_mass);
+					(*COM_jacob)(1,i)=(Z[2]*mc[0]-Z[0]*mc[2]-(*COM_jacob)(1,i))/(*total_mass);
+					(*COM_jacob)(2,i)=(Z[0]*mc[1]-Z[1]*mc[0]-(*COM_jacob)(2,i))/(*total_mass);
+				}
+			}
+		}
+		else
+		{
+			(*total_COM).zero();
+			if (computeJacobian)
+				for (unsigned int i=0; i<N; i++)
+					(*COM_jacob)(0,i)=(*COM_jacob)(1,i)=(*COM_jacob)(2,i)=0.0;
+		}
+	}
+	return true;
+}
+
 	//------------------
 	//    LIMB CALLS
 	//------------------
@@ -2064,160 +2328,288 @@ bool   iDynSensorTorsoNode::EXPERIMENTAL_computeCOMjacobian()
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 Vector iDynSensorTorsoNode::setAng(const string &limbType, const Vector &_q)
 {
-	if(limbType==up_name)			return up->setAng(_q);
-	else if(limbType==left_name)	return left->setAng(_q);
-	else if(limbType==right_name)	return right->setAng(_q);
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return Vector(0);
+	return setAng(limb,_q);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynSensorTorsoNode::getAng(const string &limbType)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return Vector(0);
+	return getAng(limb);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+double iDynSensorTorsoNode::setAng(const string &limbType, const unsigned int i, double _q)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return 0.0;
+	return setAng(limb,i,_q);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+double iDynSensorTorsoNode::getAng(const string &limbType, const unsigned int i)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return 0.0;
+	return getAng(limb,i);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynSensorTorsoNode::setDAng(const string &limbType, const Vector &_dq)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return Vector(0);
+	return setDAng(limb,_dq);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynSensorTorsoNode::getDAng(const string &limbType)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return Vector(0);
+	return getDAng(limb);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+double iDynSensorTorsoNode::setDAng(const string &limbType, const unsigned int i, double _dq)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return 0.0;
+	return setDAng(limb,i,_dq);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+double iDynSensorTorsoNode::getDAng(const string &limbType, const unsigned int i)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return 0.0;
+	return getDAng(limb,i);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynSensorTorsoNode::setD2Ang(const string &limbType, const Vector &_ddq)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return Vector(0);
+	return setD2Ang(limb,_ddq);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynSensorTorsoNode::getD2Ang(const string &limbType)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return Vector(0);
+	return getD2Ang(limb);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+double iDynSensorTorsoNode::setD2Ang(const string &limbType, const unsigned int i, double _ddq)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return 0.0;
+	return setD2Ang(limb,i,_ddq);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+double iDynSensorTorsoNode::getD2Ang(const string &limbType, const unsigned int i)
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return 0.0;
+	return getD2Ang(limb,i);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+unsigned int iDynSensorTorsoNode::getNLinks(const string &limbType) const
+{
+	TorsoNodeLimb limb = getLimbHandle(limbType);
+	if(limb==TORSO_NODE_UNKNOWN_LIMB)	return 0;
+	return getNLinks(limb);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynSensorTorsoNode::setAng(const TorsoNodeLimb limb, const Vector &_q)
+{
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)
+	{
+		setLimbKinematicDirty(getLimbIndex(p_limb));
+		return p_limb->setAng(_q);
+	}
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return Vector(0);
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-Vector iDynSensorTorsoNode::getAng(const string &limbType)
+Vector iDynSensorTorsoNode::getAng(const TorsoNodeLimb limb)
 {
-	if(limbType==up_name)			return up->getAng();
-	else if(limbType==left_name)	return left->getAng();
-	else if(limbType==right_name)	return right->getAng();
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)		return p_limb->getAng();
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return Vector(0);
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-double iDynSensorTorsoNode::setAng(const string &limbType, const unsigned int i, double _q)
+double iDynSensorTorsoNode::setAng(const TorsoNodeLimb limb, const unsigned int i, double _q)
 {
-	if(limbType==up_name)			return up->setAng(i,_q);
-	else if(limbType==left_name)	return left->setAng(i,_q);
-	else if(limbType==right_name)	return right->setAng(i,_q);
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)
+	{
+		setLimbKinematicDirty(getLimbIndex(p_limb));
+		return p_limb->setAng(i,_q);
+	}
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return 0.0;
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-double iDynSensorTorsoNode::getAng(const string &limbType, const unsigned int i)
+double iDynSensorTorsoNode::getAng(const TorsoNodeLimb limb, const unsigned int i)
 {
-	if(limbType==up_name)			return up->getAng(i);
-	else if(limbType==left_name)	return left->getAng(i);
-	else if(limbType==right_name)	return right->getAng(i);
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)		return p_limb->getAng(i);
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return 0.0;
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-Vector iDynSensorTorsoNode::setDAng(const string &limbType, const Vector &_dq)
+Vector iDynSensorTorsoNode::setDAng(const TorsoNodeLimb limb, const Vector &_dq)
 {
-	if(limbType==up_name)			return up->setDAng(_dq);
-	else if(limbType==left_name)	return left->setDAng(_dq);
-	else if(limbType==right_name)	return right->setDAng(_dq);
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)
+	{
+		setLimbKinematicDirty(getLimbIndex(p_limb));
+		return p_limb->setDAng(_dq);
+	}
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return Vector(0);
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-Vector iDynSensorTorsoNode::getDAng(const string &limbType)
+Vector iDynSensorTorsoNode::getDAng(const TorsoNodeLimb limb)
 {
-	if(limbType==up_name)			return up->getDAng();
-	else if(limbType==left_name)	return left->getDAng();
-	else if(limbType==right_name)	return right->getDAng();
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)		return p_limb->getDAng();
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return Vector(0);
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-double iDynSensorTorsoNode::setDAng(const string &limbType, const unsigned int i, double _dq)
+double iDynSensorTorsoNode::setDAng(const TorsoNodeLimb limb, const unsigned int i, double _dq)
 {
-	if(limbType==up_name)			return up->setDAng(i,_dq);
-	else if(limbType==left_name)	return left->setDAng(i,_dq);
-	else if(limbType==right_name)	return right->setDAng(i,_dq);
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)
+	{
+		setLimbKinematicDirty(getLimbIndex(p_limb));
+		return p_limb->setDAng(i,_dq);
+	}
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return 0.0;
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-double iDynSensorTorsoNode::getDAng(const string &limbType, const unsigned int i)    
+double iDynSensorTorsoNode::getDAng(const TorsoNodeLimb limb, const unsigned int i)
 {
-	if(limbType==up_name)			return up->getDAng(i);
-	else if(limbType==left_name)	return left->getDAng(i);
-	else if(limbType==right_name)	return right->getDAng(i);
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)		return p_limb->getDAng(i);
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return 0.0;
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-Vector iDynSensorTorsoNode::setD2Ang(const string &limbType, const Vector &_ddq)
+Vector iDynSensorTorsoNode::setD2Ang(const TorsoNodeLimb limb, const Vector &_ddq)
 {
-	if(limbType==up_name)			return up->setD2Ang(_ddq);
-	else if(limbType==left_name)	return left->setD2Ang(_ddq);
-	else if(limbType==right_name)	return right->setD2Ang(_ddq);
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)
+	{
+		setLimbKinematicDirty(getLimbIndex(p_limb));
+		return p_limb->setD2Ang(_ddq);
+	}
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return Vector(0);
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-Vector iDynSensorTorsoNode::getD2Ang(const string &limbType)
+Vector iDynSensorTorsoNode::getD2Ang(const TorsoNodeLimb limb)
 {
-	if(limbType==up_name)			return up->getD2Ang();
-	else if(limbType==left_name)	return left->getD2Ang();
-	else if(limbType==right_name)	return right->getD2Ang();
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)		return p_limb->getD2Ang();
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return Vector(0);
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-double iDynSensorTorsoNode::setD2Ang(const string &limbType, const unsigned int i, double _ddq)
+double iDynSensorTorsoNode::setD2Ang(const TorsoNodeLimb limb, const unsigned int i, double _ddq)
 {
-	if(limbType==up_name)			return up->setD2Ang(i,_ddq);
-	else if(limbType==left_name)	return left->setD2Ang(i,_ddq);
-	else if(limbType==right_name)	return right->setD2Ang(i,_ddq);
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)
+	{
+		setLimbKinematicDirty(getLimbIndex(p_limb));
+		return p_limb->setD2Ang(i,_ddq);
+	}
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return 0.0;
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-double iDynSensorTorsoNode::getD2Ang(const string &limbType, const unsigned int i)
+double iDynSensorTorsoNode::getD2Ang(const TorsoNodeLimb limb, const unsigned int i)
 {
-	if(limbType==up_name)			return up->getD2Ang(i);
-	else if(limbType==left_name)	return left->getD2Ang(i);
-	else if(limbType==right_name)	return right->getD2Ang(i);
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)		return p_limb->getD2Ang(i);
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return 0.0;
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-unsigned int iDynSensorTorsoNode::getNLinks(const string &limbType) const
+unsigned int iDynSensorTorsoNode::getNLinks(const TorsoNodeLimb limb) const
 {
-	if(limbType==up_name)			return up->getN();
-	else if(limbType==left_name)	return left->getN();
-	else if(limbType==right_name)	return right->getN();
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb!=NULL)		return p_limb->getN();
 	else
-	{		
-		if(verbose)	fprintf(stderr,"Node <%s> there's not a limb named %s. Only %s,%s,%s are available. \n",name.c_str(),limbType.c_str(),left_name.c_str(),right_name.c_str(),up_name.c_str());
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
 		return 0;
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iDynSensorTorsoNode::setState(const TorsoNodeLimb limb, const Vector &_q, const Vector &_dq, const Vector &_ddq, const double scale)
+{
+	iDynLimb * p_limb = getLimb(limb);
+	if(p_limb==NULL)
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> invalid limb handle %d. Only %s,%s,%s are available. \n",name.c_str(),(int)limb,left_name.c_str(),right_name.c_str(),up_name.c_str());
+		return false;
+	}
+	unsigned int n = p_limb->getN();
+	if( (unsigned int)_q.length()<n || (unsigned int)_dq.length()<n || (unsigned int)_ddq.length()<n )
+	{
+		if(verbose)	fprintf(stderr,"Node <%s> setState() failed: at least %d joint values needed, while q,dq,ddq have size %d,%d,%d \n",name.c_str(),n,(int)_q.length(),(int)_dq.length(),(int)_ddq.length());
+		return false;
+	}
+	setLimbKinematicDirty(getLimbIndex(p_limb));
+	// the links are set one by one, so that no temporary vectors are built;
+	// as in iDynChain::setDAng() only the first n values are used
+	for(unsigned int i=0; i<n; i++)
+	{
+		p_limb->setAng(i,scale*_q[i]);
+		p_limb->setDAng(i,scale*_dq[i]);
+		p_limb->setD2Ang(i,scale*_ddq[i]);
+	}
+	return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void iDynSensorTorsoNode::clearContactList()
 {
     leftSensor->clearContactList();
@@ -2455,7 +2847,7 @@ bool iCubWholeBody::computeCOM()
 	yarp::sig::Matrix T0 = lowerTorso->HUp;
 	yarp::sig::Matrix T1 = lowerTorso->up->getH(2,true);
 
-	upperTorso->computeCOM();
+	upperTorso->fastComputeCOM();
 
 	upper_mass =   upperTorso->total_mass_UP
 		          +upperTorso->total_mass_LF
@@ -2468,7 +2860,7 @@ bool iCubWholeBody::computeCOM()
 	upper_COM= T0 * T1 * upper_COM;
 
 	//lower torso COM computation
-	lowerTorso->computeCOM();
+	lowerTorso->fastComputeCOM();
 
 	lower_mass =   lowerTorso->total_mass_UP
 		          +lowerTorso->total_mass_LF
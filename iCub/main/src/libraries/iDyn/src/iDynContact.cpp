@@ -18,8 +18,10 @@
 
 #include <iostream>
 #include <iCub/iDyn/iDynContact.h>
+#include <iCub/iDyn/iDynRegressor.h>
 #include <yarp/math/SVD.h>
 #include <stdio.h>
+#include <math.h>
 
 using namespace std;
 using namespace yarp::sig;
@@ -29,6 +31,59 @@ using namespace iCub::iDyn;
 using namespace iCub::ctrl;
 using namespace iCub::skinDynLib;
 
+namespace
+{
+    // Cholesky factorization M = L*L^T of a symmetric positive semidefinite matrix:
+    // false if a pivot is not greater than tol times the largest diagonal element (rank deficient M)
+    bool choleskyFactor(const Matrix &M, Matrix &L, double tol)
+    {
+        const int n = M.rows();
+        L.resize(n,n);
+        L.zero();
+        double maxDiag = 0.0;
+        for(int i=0; i<n; i++)
+            if(M(i,i)>maxDiag)
+                maxDiag = M(i,i);
+        const double minPivot = tol*(maxDiag>1.0 ? maxDiag : 1.0);
+        for(int j=0; j<n; j++)
+        {
+            double d = M(j,j);
+            for(int k=0; k<j; k++)
+                d -= L(j,k)*L(j,k);
+            if(d<=minPivot)
+                return false;
+            L(j,j) = sqrt(d);
+            for(int i=j+1; i<n; i++)
+            {
+                double v = M(i,j);
+                for(int k=0; k<j; k++)
+                    v -= L(i,k)*L(j,k);
+                L(i,j) = v/L(j,j);
+            }
+        }
+        return true;
+    }
+
+    // solution of L*L^T*x = b
+    Vector choleskySolve(const Matrix &L, const Vector &b)
+    {
+        const int n = L.rows();
+        Vector x(b);
+        for(int i=0; i<n; i++)
+        {
+            for(int k=0; k<i; k++)
+                x[i] -= L(i,k)*x[k];
+            x[i] /= L(i,i);
+        }
+        for(int i=n-1; i>=0; i--)
+        {
+            for(int k=i+1; k<n; k++)
+                x[i] -= L(k,i)*x[k];
+            x[i] /= L(i,i);
+        }
+        return x;
+    }
+}
 
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -37,11 +92,15 @@ using namespace iCub::skinDynLib;
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 iDynContactSolver::iDynContactSolver(iDynChain *_c, const string &_info, const NewEulMode _mode, BodyPart _bodyPart, unsigned int verb)
-:iDynSensor(_c, _info, _mode, verb), bodyPart(_bodyPart){}
+:iDynSensor(_c, _info, _mode, verb), bodyPart(_bodyPart),
+liveParamsEnabled(false), liveFront(0), liveParamsFresh(false), liveOffset(false), liveExcludedLink(-1), 
+liveBetaExcludedLink(-1), cachedNormal(false){}
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 iDynContactSolver::iDynContactSolver(iDynChain *_c, unsigned int sensLink, SensorLinkNewtonEuler *sensor, 
                                     const string &_info, const NewEulMode _mode, BodyPart _bodyPart, unsigned int verb)
-:iDynSensor(_c, _info, _mode, verb), bodyPart(_bodyPart)
+:iDynSensor(_c, _info, _mode, verb), bodyPart(_bodyPart),
+liveParamsEnabled(false), liveFront(0), liveParamsFresh(false), liveOffset(false), liveExcludedLink(-1), 
+liveBetaExcludedLink(-1), cachedNormal(false)
 {
     lSens = sensLink;
     sens = sensor;
@@ -49,7 +108,9 @@ iDynContactSolver::iDynContactSolver(iDynChain *_c, unsigned int sensLink, Senso
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 iDynContactSolver::iDynContactSolver(iDynChain *_c, unsigned int sensLink, const Matrix &_H, const Matrix &_HC, double _m, 
                                      const Matrix &_I, const string &_info, const NewEulMode _mode, BodyPart _bodyPart, unsigned int verb)
-:iDynSensor(_c, sensLink, _H, _HC, _m, _I, _info, _mode, verb), bodyPart(_bodyPart){}
+:iDynSensor(_c, sensLink, _H, _HC, _m, _I, _info, _mode, verb), bodyPart(_bodyPart),
+liveParamsEnabled(false), liveFront(0), liveParamsFresh(false), liveOffset(false), liveExcludedLink(-1), 
+liveBetaExcludedLink(-1), cachedNormal(false){}
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 iDynContactSolver::~iDynContactSolver(){}
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -137,11 +198,23 @@ const dynContactList& iDynContactSolver::computeExternalContacts()
     chain->NE->BackwardWrenchFromAtoB(chain->getN()-1, lastContactLink);
 
     // BUILD AND SOLVE THE LINEAR SYSTEM AX=B RELATIVE TO THE CONTACT SUB-CHAIN
-    // the reference frame is the <firstContactLink-1> 
-    Matrix A = buildA(firstContactLink, lastContactLink);
-    Vector B = buildB(firstContactLink, lastContactLink);
-	Matrix pinv_A = pinv(A, TOLLERANCE);
-    Vector X = pinv_A * B;
+    // the reference frame is the <firstContactLink-1>, or the sensor if the live parameters are used
+    Matrix Href;
+    unsigned int refLink;
+    Vector B;
+    if(liveParamsEnabled && buildLiveB(B))
+    {
+        Href = SE3inv(getH());
+        refLink = lSens;
+    }
+    else
+    {
+        Href = eye(4,4);
+        refLink = firstContactLink-1;
+        B = buildB(firstContactLink, lastContactLink);
+    }
+    const Matrix &A = buildA(Href, refLink);
+    Vector X = solveContactSystem(A, B);
 	
     /*if(verbose){
         Vector AX = A*X;
@@ -160,8 +233,8 @@ const dynContactList& iDynContactSolver::computeExternalContacts()
             it->setForceModule( X(unknownInd++));
         else
         {
-            H = getHFromAtoB(it->getLinkNumber(), firstContactLink-1);
-            R = H.submatrix(0,2,0,2);
+            H = Href * getHFromAtoB(refLink, it->getLinkNumber());
+            R = H.submatrix(0,2,0,2).transposed();
             it->setForce( R * X.subVector(unknownInd, unknownInd+2));
             unknownInd += 3;
             if(!it->isMomentKnown())
@@ -195,25 +268,59 @@ void iDynContactSolver::computeWrenchFromSensorNewtonEuler()
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 Matrix iDynContactSolver::buildA(unsigned int firstContactLink, unsigned int lastContactLink)
 {
-    unsigned int unknownNum = getUnknownNumber();
-    Matrix A(6, unknownNum);
-
+    return buildA(eye(4,4), firstContactLink-1);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+const Matrix &iDynContactSolver::buildA(const Matrix &Href, unsigned int refLink)
+{
     // For each contact add some columns to A:
     //    * wrench: add 6 columns, 3 composed by I_3 above and the S(r_E) below, 3 composed by 0_3 above and I_3 below
     //    * pure force: add 3 columns composed by I_3 above and the S(r_E) below
     //    * force module: add 1 column composed by the force direction unit vector above and the cross product between 
     //          the contact point and the force direction unit vector below    
+    // The I_3 and 0_3 blocks depend only on the contact set, they are written when the set changes
+    bool sameContacts = cachedA.rows()==6 && cachedContacts.size()==2*contactList.size();
+    unsigned int n = 0;
+    dynContactList::const_iterator it = contactList.begin();
+    for(; sameContacts && it!=contactList.end(); it++, n+=2)
+    {
+        unsigned int unknowns = it->isForceDirectionKnown() ? 1 : (it->isMomentKnown() ? 3 : 6);
+        sameContacts = cachedContacts[n]==it->getLinkNumber() && cachedContacts[n+1]==unknowns;
+    }
+    if(!sameContacts)
+    {
+        cachedContacts.resize(0);
+        for(it=contactList.begin(); it!=contactList.end(); it++)
+        {
+            cachedContacts.push_back(it->getLinkNumber());
+            cachedContacts.push_back(it->isForceDirectionKnown() ? 1 : (it->isMomentKnown() ? 3 : 6));
+        }
+        unsigned int unknownNum = getUnknownNumber();
+        cachedA.resize(6, unknownNum);
+        cachedA.zero();
+        unsigned int colInd = 0;
+        for(n=1; n<cachedContacts.size(); n+=2)
+        {
+            for(int i=0; i<3 && cachedContacts[n]>=3; i++)
+                cachedA(i, colInd+i) = 1.0;
+            for(int i=0; i<3 && cachedContacts[n]==6; i++)
+                cachedA(3+i, colInd+3+i) = 1.0;
+            colInd += cachedContacts[n];
+        }
+        // the system has at most 6 equations: Cholesky of A^T*A if it is (over)determined,
+        // of A*A^T for the minimum norm solution if it is underdetermined
+        cachedNormal = unknownNum<=6;
+        cachedM.resize(cachedNormal ? unknownNum : 6, cachedNormal ? unknownNum : 6);
+    }
+
+    // the blocks that depend on the configuration
     unsigned int colInd = 0;
     Matrix H, R;
-    Matrix eye3x3 = eye(3,3);
-    Matrix zero3x3 = zeros(3,3);
     Vector r, temp1, temp2;
-    dynContactList::const_iterator it = contactList.begin();
-
-    for(; it!=contactList.end(); it++)
+    for(it=contactList.begin(); it!=contactList.end(); it++)
     {
-        // compute the rototranslation matrix from <firstContactLink-1> to the current link
-        H = getHFromAtoB(firstContactLink-1, it->getLinkNumber());
+        // compute the rototranslation matrix from the reference frame to the current link
+        H = Href * getHFromAtoB(refLink, it->getLinkNumber());
         R = H.submatrix(0,2,0,2);
         r = H.subcol(0,3,3);
 
@@ -222,26 +329,21 @@ Matrix iDynContactSolver::buildA(unsigned int firstContactLink, unsigned int las
             temp1 = R*it->getForceDirection();       // force direction unit vector
             temp2 = R*it->getCoP();
             temp2 += r;
-            A.setSubcol(temp1, 0, colInd);
-            A.setSubcol(cross(temp2, temp1), 3, colInd++);
+            cachedA.setSubcol(temp1, 0, colInd);
+            cachedA.setSubcol(cross(temp2, temp1), 3, colInd++);
         }
         else
         {                                              // 3 UNKNOWNS: FORCE
             temp1 = R*it->getCoP();
             temp1 += r;
-            A.setSubmatrix(eye3x3, 0, colInd);
-            A.setSubmatrix(crossProductMatrix(temp1), 3, colInd);
+            cachedA.setSubmatrix(crossProductMatrix(temp1), 3, colInd);
             colInd += 3;
             
-            if(!it->isMomentKnown())
-            {                       // 6 UNKNOWNS: FORCE AND MOMENT
-                A.setSubmatrix(zero3x3, 0, colInd);
-                A.setSubmatrix(eye3x3, 3, colInd);
+            if(!it->isMomentKnown())                   // 6 UNKNOWNS: FORCE AND MOMENT
                 colInd += 3;
-            }
         }
     }
-    return A;
+    return cachedA;
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 Vector iDynContactSolver::buildB(unsigned int firstContactLink, unsigned int lastContactLink)
@@ -298,6 +400,119 @@ Vector iDynContactSolver::buildB(unsigned int firstContactLink, unsigned int las
     return cat(Bforce, Bmoment);
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iDynContactSolver::buildLiveB(Vector &B)
+{
+    // swap in the last published parameters, if any: the writer only touches the back buffer.
+    // The basis is read under the lock too, since setLiveParametersBasis can change it
+    liveParamsMutex.wait();
+    if(liveParamsFresh)
+    {
+        liveFront = 1-liveFront;
+        liveParamsFresh = false;
+        const Vector &theta = liveParams[liveFront];
+        const int nTheta = liveBasis.cols();
+        liveBeta = liveBasis * theta.subVector(0, nTheta-1);
+        if(liveOffset)
+            liveSensorOffset = theta.subVector(nTheta, nTheta+5);
+        else
+            liveSensorOffset.resize(0);
+        liveBetaExcludedLink = liveExcludedLink;
+    }
+    bool published = liveParams[liveFront].size()>0;
+    liveParamsMutex.post();
+
+    if(!published)
+        return false;       // nothing published yet (with the current basis)
+
+    if(!Regressor::iDynChainRegressorSensorWrench(chain, this, liveY, liveBetaExcludedLink) || liveY.cols()!=liveBeta.size())
+    {
+        if(verbose)
+            fprintf(stderr, "iDynContactSolver: live parameters do not match the sensor wrench regressor, using the link parameters\n");
+        return false;
+    }
+
+    // the sensor measures the wrench predicted by the parameters minus the contribution of the contacts
+    B = liveY * liveBeta;
+    if(liveSensorOffset.size()>0)
+        B += liveSensorOffset;
+    B -= getSensorForceMoment();
+    return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Vector iDynContactSolver::solveContactSystem(const Matrix &A, const Vector &B)
+{
+    // the buffers and the kind of system are the ones of the contact set (see buildA),
+    // only A^T*A (or A*A^T) and its factor are recomputed, since they depend on the configuration
+    const int n = cachedM.rows();
+    for(int i=0; i<n; i++)
+        for(int j=0; j<=i; j++)
+        {
+            double v = 0.0;
+            if(cachedNormal)
+                for(int k=0; k<A.rows(); k++)
+                    v += A(k,i)*A(k,j);
+            else
+                for(int k=0; k<A.cols(); k++)
+                    v += A(i,k)*A(j,k);
+            cachedM(i,j) = cachedM(j,i) = v;
+        }
+    if(!choleskyFactor(cachedM, cachedL, TOLLERANCE))
+        return pinv(A, TOLLERANCE) * B;     // rank deficient
+    if(cachedNormal)
+        return choleskySolve(cachedL, A.transposed()*B);
+    return A.transposed() * choleskySolve(cachedL, B);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iDynContactSolver::setLiveParametersBasis(const Matrix &basis, bool offset, const int excluded_link)
+{
+    int nLinks = 0;
+    for(int i=lSens; i<(int)chain->getN(); i++)
+        if(i!=excluded_link)
+            nLinks++;
+    if(basis.rows()!=10*nLinks)
+    {
+        if(verbose)
+            fprintf(stderr, "iDynContactSolver: the basis of the live parameters has %d rows instead of %d\n", basis.rows(), 10*nLinks);
+        return false;
+    }
+    liveParamsMutex.wait();
+    liveBasis = basis;
+    liveOffset = offset;
+    liveExcludedLink = excluded_link;
+    liveParams[0].resize(0);
+    liveParams[1].resize(0);
+    liveParamsFresh = false;
+    liveParamsMutex.post();
+    return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iDynContactSolver::publishLiveParameters(const Vector &params)
+{
+    liveParamsMutex.wait();
+    const int expected = liveBasis.cols() + (liveOffset ? 6 : 0);
+    if(liveBasis.cols()==0 || (int)params.size()!=expected)
+    {
+        liveParamsMutex.post();
+        if(verbose)
+            fprintf(stderr, "iDynContactSolver: published %d live parameters instead of %d\n", (int)params.size(), expected);
+        return false;
+    }
+    liveParams[1-liveFront] = params;
+    liveParamsFresh = true;
+    liveParamsMutex.post();
+    return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void iDynContactSolver::setLiveParametersEnabled(bool enabled)
+{
+    liveParamsEnabled = enabled;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool iDynContactSolver::getLiveParametersEnabled() const
+{
+    return liveParamsEnabled;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 const dynContactList& iDynContactSolver::getContactList() const
 {
     return contactList;
@@ -22,9 +22,12 @@
 #include <iCub/iKin/iKinFwd.h>
 #include <iCub/iDyn/iDyn.h>
 #include <iCub/iDyn/iDynInv.h>
+#include <iCub/iDyn/iDynRegressor.h>
 #include <stdio.h>
+#include <math.h>
 #include <deque>
 #include <string>
+#include <vector>
 #include <sstream>  // for debug
 
 using namespace std;
@@ -36,6 +39,96 @@ using namespace iCub::iDyn;
 using namespace iCub::skinDynLib;
 
 
+//================================
+//
+//		FIXED SIZE HELPERS
+//
+//================================
+
+// The Newton-Euler recursion only needs 3x1 vectors and 3x3 matrices: these helpers
+// work on double[3] arrays on the stack and read yarp vectors and matrices in place,
+// so that one step of the recursion does not allocate any temporary.
+// The output can always be one of the inputs.
+namespace
+{
+    // out = v
+    inline void copy3(const Vector &v, double *out)
+    {
+        out[0] = v[0]; out[1] = v[1]; out[2] = v[2];
+    }
+    // copy v in the (3x1) vector out, and return out
+    inline const Vector& toVector3(const double *v, Vector &out)
+    {
+        out[0] = v[0]; out[1] = v[1]; out[2] = v[2];
+        return out;
+    }
+    // v = a*v
+    inline void scale3(const double a, double *v)
+    {
+        v[0] *= a; v[1] *= a; v[2] *= a;
+    }
+    // out = a x b
+    inline void cross3(const double *a, const double *b, double *out)
+    {
+        const double x = a[1]*b[2]-a[2]*b[1];
+        const double y = a[2]*b[0]-a[0]*b[2];
+        const double z = a[0]*b[1]-a[1]*b[0];
+        out[0] = x; out[1] = y; out[2] = z;
+    }
+    // out = M*v, M (3x3)
+    inline void mul3(const Matrix &M, const double *v, double *out)
+    {
+        const double *M0 = M[0], *M1 = M[1], *M2 = M[2];
+        const double x = M0[0]*v[0]+M0[1]*v[1]+M0[2]*v[2];
+        const double y = M1[0]*v[0]+M1[1]*v[1]+M1[2]*v[2];
+        const double z = M2[0]*v[0]+M2[1]*v[1]+M2[2]*v[2];
+        out[0] = x; out[1] = y; out[2] = z;
+    }
+    // out = M^T*v = v*M, M (3x3)
+    inline void mulT3(const Matrix &M, const double *v, double *out)
+    {
+        const double *M0 = M[0], *M1 = M[1], *M2 = M[2];
+        const double x = M0[0]*v[0]+M1[0]*v[1]+M2[0]*v[2];
+        const double y = M0[1]*v[0]+M1[1]*v[1]+M2[1]*v[2];
+        const double z = M0[2]*v[0]+M1[2]*v[1]+M2[2]*v[2];
+        out[0] = x; out[1] = y; out[2] = z;
+    }
+    // acc += dw x r + w x (w x r)
+    inline void addAccelerationTerms3(const double *w, const double *dw, const double *r, double *acc)
+    {
+        double a[3], b[3];
+        cross3(dw,r,a);
+        cross3(w,r,b);
+        cross3(w,b,b);
+        acc[0] += a[0]+b[0]; acc[1] += a[1]+b[1]; acc[2] += a[2]+b[2];
+    }
+    // out = r x F + (r+rc) x (m*ddpC) + Mu, Mu can be NULL
+    inline void linkMoment3(const double *r, const double *rc, const double m, const double *ddpC,
+                            const double *F, const double *Mu, double *out)
+    {
+        double a[3], b[3], rrc[3], mddpC[3];
+        rrc[0] = r[0]+rc[0]; rrc[1] = r[1]+rc[1]; rrc[2] = r[2]+rc[2];
+        mddpC[0] = m*ddpC[0]; mddpC[1] = m*ddpC[1]; mddpC[2] = m*ddpC[2];
+        cross3(r,F,a);
+        cross3(rrc,mddpC,b);
+        out[0] = a[0]+b[0]; out[1] = a[1]+b[1]; out[2] = a[2]+b[2];
+        if(Mu)
+        {
+            out[0] += Mu[0]; out[1] += Mu[1]; out[2] += Mu[2];
+        }
+    }
+    // out += I*dw + w x (I*w)
+    inline void addInertialMoment3(const Matrix &I, const double *w, const double *dw, double *out)
+    {
+        double a[3], b[3];
+        mul3(I,dw,a);
+        mul3(I,w,b);
+        cross3(w,b,b);
+        out[0] += a[0]+b[0]; out[1] += a[1]+b[1]; out[2] += a[2]+b[2];
+    }
+}
+
+
 //================================
 //
 //		ONE LINK NEWTON EULER
@@ -51,6 +144,7 @@ OneLinkNewtonEuler::OneLinkNewtonEuler(iDynLink *dlink)
 	link = dlink;
 	z0.resize(3); z0.zero(); z0(2)=1;	
 	zm.resize(3); zm.zero();
+	v3.resize(3); v3.zero();
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 OneLinkNewtonEuler::OneLinkNewtonEuler(const NewEulMode _mode, unsigned int verb, iDynLink *dlink)
@@ -61,6 +155,7 @@ OneLinkNewtonEuler::OneLinkNewtonEuler(const NewEulMode _mode, unsigned int verb
 	link = dlink;
 	z0.resize(3); z0.zero(); z0(2)=1;	
 	zm.resize(3); zm.zero();
+	v3.resize(3); v3.zero();
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::zero()
@@ -393,14 +488,17 @@ void OneLinkNewtonEuler::computeAngVel(OneLinkNewtonEuler *prev)
 	case DYNAMIC:
 	case DYNAMIC_W_ROTOR:
         {
-            Vector w = prev->getAngVel();
+            double w[3];
+            copy3(prev->getAngVel(),w);
             w[2] += getDq();
-		    setAngVel(w*getR());
+            mulT3(getR(),w,w);
+		    setAngVel(toVector3(w,v3));
 		    //setAngVel( getR().transposed() * ( prev->getAngVel() + getDq() * z0 ));
 		    break;
         }
 	case STATIC:
-		setAngVel(zeros(3));
+		v3.zero();
+		setAngVel(v3);
 		break;
 	}
 }
@@ -413,14 +511,16 @@ void OneLinkNewtonEuler::computeAngVelBackward(OneLinkNewtonEuler *next)
 	case DYNAMIC:
 	case DYNAMIC_W_ROTOR:
         {
-            Vector w = next->getR() * next->getAngVel();
+            double w[3];
+            mul3(next->getR(),next->getAngVel().data(),w);
             w[2] -= next->getDq();
-		    setAngVel(w);
+		    setAngVel(toVector3(w,v3));
             //setAngVel( next->getR() * next->getAngVel() - next->getDq() * z0 );
 		    break;
         }
 	case STATIC:
-		setAngVel(zeros(3));
+		v3.zero();
+		setAngVel(v3);
 		break;
 	}
 }
@@ -432,27 +532,32 @@ void OneLinkNewtonEuler::computeAngAcc(OneLinkNewtonEuler *prev)
 	case DYNAMIC:
 	case DYNAMIC_W_ROTOR:
         {
-            Vector dw = prev->getAngAcc();
+            double dw[3];
             const Vector& prevW = prev->getAngVel();
+            copy3(prev->getAngAcc(),dw);
             dw[0] += getDq()*prevW[1];
             dw[1] -= getDq()*prevW[0];
             dw[2] += getD2q();
-            setAngAcc(dw * getR());
+            mulT3(getR(),dw,dw);
+            setAngAcc(toVector3(dw,v3));
 		    //setAngAcc( (getR()).transposed() * ( prev->getAngAcc() + getD2q()*z0 + getDq() * cross(prev->getAngVel(),z0));
 		    break;
         }
 	case DYNAMIC_CORIOLIS_GRAVITY:
         {
-            Vector dw = prev->getAngAcc();
+            double dw[3];
             const Vector& prevW = prev->getAngVel();
+            copy3(prev->getAngAcc(),dw);
             dw[0] += getDq()*prevW[1];
             dw[1] -= getDq()*prevW[0];
-            setAngAcc(dw * getR());
+            mulT3(getR(),dw,dw);
+            setAngAcc(toVector3(dw,v3));
 		    //setAngAcc( (getR()).transposed() * ( prev->getAngAcc() + getDq() * cross(prev->getAngVel(),z0) ));
 		    break;
         }
 	case STATIC:
-		setAngAcc(zeros(3));
+		v3.zero();
+		setAngAcc(v3);
 		break;
 	}
 }
@@ -464,27 +569,30 @@ void OneLinkNewtonEuler::computeAngAccBackward(OneLinkNewtonEuler *next)
 	case DYNAMIC:
 	case DYNAMIC_W_ROTOR:
         {
-            Vector nextDw = next->getR() * next->getAngAcc();
+            double nextDw[3];
             const Vector& w = getAngVel();
+            mul3(next->getR(),next->getAngAcc().data(),nextDw);
             nextDw[0] -= getDq()*w[1];
             nextDw[1] += getDq()*w[0];
             nextDw[2] -= getD2q();
-            setAngAcc(nextDw);
+            setAngAcc(toVector3(nextDw,v3));
 		    //setAngAcc( next->getR() * next->getAngAcc() - next->getD2q() * z0 - next->getDq() * cross(getAngVel(),z0) );
 		    break;
         }
 	case DYNAMIC_CORIOLIS_GRAVITY:
         {
-            Vector nextDw = next->getR() * next->getAngAcc();
+            double nextDw[3];
             const Vector& w = getAngVel();
+            mul3(next->getR(),next->getAngAcc().data(),nextDw);
             nextDw[0] -= getDq()*w[1];
             nextDw[1] += getDq()*w[0];
-            setAngAcc(nextDw);
+            setAngAcc(toVector3(nextDw,v3));
 		    //setAngAcc( next->getR() * next->getAngAcc() - next->getDq() * cross(getAngVel(),z0) );
 		    break;
         }
 	case STATIC:
-		setAngAcc(zeros(3));
+		v3.zero();
+		setAngAcc(v3);
 		break;
 	}
 }
@@ -492,24 +600,24 @@ void OneLinkNewtonEuler::computeAngAccBackward(OneLinkNewtonEuler *next)
 void OneLinkNewtonEuler::computeLinAcc(OneLinkNewtonEuler *prev)
 {
     const Matrix& R = getR();
+    double temp[3];
+    mulT3(R,prev->getLinAcc().data(),temp);
 	switch(mode)
 	{
 	case DYNAMIC:
 	case DYNAMIC_CORIOLIS_GRAVITY:
 	case DYNAMIC_W_ROTOR:
         {
-            const Vector& r = getr(true);
-            Vector temp = prev->getLinAcc()*R;
-            temp += cross(link->dw, r);
-            temp += cross(link->w, cross(link->w, r));
-            setLinAcc(temp);
+            addAccelerationTerms3(link->w.data(),link->dw.data(),getr(true).data(),temp);
+            setLinAcc(toVector3(temp,v3));
 		    /*setLinAcc( prev->getLinAcc()*R
 			    + cross(getAngAcc(), r)
 			    + cross(getAngVel(), cross(getAngVel(), r)) );*/
 		    break;
         }
 	case STATIC:
-		setLinAcc( prev->getLinAcc()*R );
+		setLinAcc(toVector3(temp,v3));
+		//setLinAcc( prev->getLinAcc()*R );
 		break;
 	}
 }
@@ -517,24 +625,29 @@ void OneLinkNewtonEuler::computeLinAcc(OneLinkNewtonEuler *prev)
 void OneLinkNewtonEuler::computeLinAccBackward(OneLinkNewtonEuler *next)
 {
     const Matrix& R = next->getR();
+    double temp[3];
+    copy3(next->getLinAcc(),temp);
 	switch(mode)
 	{
 	case DYNAMIC:
 	case DYNAMIC_CORIOLIS_GRAVITY:
 	case DYNAMIC_W_ROTOR:
         {
-            const Vector& r = getr(true);
-            Vector temp = next->getLinAcc();
-            temp -= cross(next->getAngAcc(), r);
-            temp -= cross(next->getAngVel(), cross(next->getAngVel(), r));
-            setLinAcc(R*temp);
+            double r[3];
+            copy3(getr(true),r);
+            scale3(-1.0,r);
+            addAccelerationTerms3(next->getAngVel().data(),next->getAngAcc().data(),r,temp);
+            mul3(R,temp,temp);
+            setLinAcc(toVector3(temp,v3));
 		    /*setLinAcc(R * (next->getLinAcc() 
 			    - cross(next->getAngAcc(), r) 
 			    - cross(next->getAngVel(), cross(next->getAngVel(), r)) ));*/
 		    break;
         }
 	case STATIC:
-		setLinAcc( R * next->getLinAcc() );
+        mul3(R,temp,temp);
+		setLinAcc(toVector3(temp,v3));
+		//setLinAcc( R * next->getLinAcc() );
 		break;
 	}
 }
@@ -547,10 +660,10 @@ void OneLinkNewtonEuler::computeLinAccC()
 	case DYNAMIC_CORIOLIS_GRAVITY:
 	case DYNAMIC_W_ROTOR:
         {
-            Vector temp = getLinAcc();
-            temp += cross(getAngAcc(),getrC());
-            temp += cross(getAngVel(),cross(getAngVel(),getrC()));
-            setLinAccC(temp);
+            double temp[3];
+            copy3(getLinAcc(),temp);
+            addAccelerationTerms3(getAngVel().data(),getAngAcc().data(),getrC().data(),temp);
+            setLinAccC(toVector3(temp,v3));
 		    //setLinAccC( getLinAcc() + cross(getAngAcc(),getrC()) + cross(getAngVel(),cross(getAngVel(),getrC())));
 		    break;
         }
@@ -580,16 +693,26 @@ void OneLinkNewtonEuler::computeAngAccM(OneLinkNewtonEuler *prev)
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::computeForceBackward(OneLinkNewtonEuler *next)
 {
-    Vector temp = next->getMass() * next->getLinAccC();
-    temp += next->getForce();
-	setForce(next->getR() * temp);
+    double temp[3];
+    const double m = next->getMass();
+    const Vector& ddpC = next->getLinAccC();
+    const Vector& F = next->getForce();
+    for(int i=0; i<3; i++)
+        temp[i] = m*ddpC[i] + F[i];
+    mul3(next->getR(),temp,temp);
+	setForce(toVector3(temp,v3));
+	//setForce( next->getR() * ( next->getMass() * next->getLinAccC() + next->getForce() ) );
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void OneLinkNewtonEuler::computeForceForward(OneLinkNewtonEuler *prev)
 {
-    Vector temp = prev->getForce()*getR();
-    temp -= getMass() * getLinAccC();
-    setForce(temp);
+    double temp[3];
+    const double m = getMass();
+    const Vector& ddpC = getLinAccC();
+    mulT3(getR(),prev->getForce().data(),temp);
+    for(int i=0; i<3; i++)
+        temp[i] -= m*ddpC[i];
+    setForce(toVector3(temp,v3));
 	//setForce( prev->getForce()*getR() - getMass() * getLinAccC() );
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -602,12 +725,12 @@ void OneLinkNewtonEuler::computeMomentBackward(OneLinkNewtonEuler *next)
 	case DYNAMIC_CORIOLIS_GRAVITY:
 	case DYNAMIC:
         {
-            Vector temp = cross(rnp , next->getForce());
-            temp += cross(rnp + next->getrC() , next->getMass() * next->getLinAccC());
-            temp += next->getMoment(false);
-            temp += next->getInertia() * next->getAngAcc();
-            temp += cross( next->getAngVel() , next->getInertia() * next->getAngVel());
-            setMoment(Rn*temp);
+            double temp[3];
+            linkMoment3(rnp.data(),next->getrC().data(),next->getMass(),next->getLinAccC().data(),
+                        next->getForce().data(),next->getMoment(false).data(),temp);
+            addInertialMoment3(next->getInertia(),next->getAngVel().data(),next->getAngAcc().data(),temp);
+            mul3(Rn,temp,temp);
+            setMoment(toVector3(temp,v3));
 	        /*setMoment( Rn * ( cross(rnp , next->getForce()) 
 			                + cross(rnp + next->getrC() , next->getMass() * next->getLinAccC())
 			                + next->getMoment(false)
@@ -627,10 +750,11 @@ void OneLinkNewtonEuler::computeMomentBackward(OneLinkNewtonEuler *next)
 		break;
 	case STATIC:
         {
-            Vector temp = cross(rnp , next->getForce());
-            temp += cross(rnp + next->getrC() , next->getMass() * next->getLinAccC());
-            temp += next->getMoment(false);
-            setMoment(Rn*temp);
+            double temp[3];
+            linkMoment3(rnp.data(),next->getrC().data(),next->getMass(),next->getLinAccC().data(),
+                        next->getForce().data(),next->getMoment(false).data(),temp);
+            mul3(Rn,temp,temp);
+            setMoment(toVector3(temp,v3));
 	        /*setMoment( Rn * ( cross(rnp , next->getForce()) 
 			            + cross(rnp + next->getrC() , next->getMass() * next->getLinAccC())
 			            + next->getMoment(false)));*/
@@ -648,12 +772,14 @@ void OneLinkNewtonEuler::computeMomentForward( OneLinkNewtonEuler *prev)
 	case DYNAMIC_CORIOLIS_GRAVITY:
 	case DYNAMIC:
         {
-            Vector temp = prev->getMoment(false)*R;
-            temp -= cross(RTr, link->F);
-            temp -= cross(RTr + link->rc, link->m * link->ddpC);
-            temp -= link->I * link->dw;
-            temp -= cross( link->w, link->I * link->w);
-            setMoment(temp);
+            //temp = prev->getMoment(false)*R - (terms of the backward recursion, with this link as next)
+            double temp[3], mu[3];
+            linkMoment3(RTr.data(),link->rc.data(),link->m,link->ddpC.data(),link->F.data(),0,temp);
+            addInertialMoment3(link->I,link->w.data(),link->dw.data(),temp);
+            mulT3(R,prev->getMoment(false).data(),mu);
+            for(int i=0; i<3; i++)
+                temp[i] = mu[i] - temp[i];
+            setMoment(toVector3(temp,v3));
 		    /*setMoment( prev->getMoment(false)*R- cross(RTr, getForce())
 			    - cross(RTr + getrC(), getMass() * getLinAccC())
 			    - getInertia() * getAngAcc()
@@ -684,10 +810,12 @@ void OneLinkNewtonEuler::computeMomentForward( OneLinkNewtonEuler *prev)
         }
 	case STATIC:
         {
-            Vector temp = prev->getMoment(false)*R;
-            temp -= cross(RTr, getForce());
-            temp -= cross(RTr + getrC(), getMass() * getLinAccC());
-            setMoment(temp);
+            double temp[3], mu[3];
+            linkMoment3(RTr.data(),getrC().data(),getMass(),getLinAccC().data(),getForce().data(),0,temp);
+            mulT3(R,prev->getMoment(false).data(),mu);
+            for(int i=0; i<3; i++)
+                temp[i] = mu[i] - temp[i];
+            setMoment(toVector3(temp,v3));
 		    /*setMoment( prev->getMoment(false)*R - cross(RTr, getForce())
 			    - cross(RTr + getrC(), getMass() * getLinAccC()));*/
 		    break;
@@ -1506,30 +1634,41 @@ bool	SensorLinkNewtonEuler::setAngAccM	(const Vector &_dwM)
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void SensorLinkNewtonEuler::computeAngVel( iDynLink *link)
 {
-	w = link->getW() * R;
+	double temp[3];
+	mulT3(R,link->getW().data(),temp);
+	toVector3(temp,w);
+	//w = link->getW() * R;
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void SensorLinkNewtonEuler::computeAngAcc( iDynLink *link)
 {
-	dw = link->getdW() * R;
+	double temp[3];
+	mulT3(R,link->getdW().data(),temp);
+	toVector3(temp,dw);
+	//dw = link->getdW() * R;
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void SensorLinkNewtonEuler::computeLinAcc( iDynLink *link)
 {
+    double temp[3];
+    mulT3(R,link->getLinAcc().data(),temp);
 	switch(mode)
 	{
 	case DYNAMIC:
 	case DYNAMIC_CORIOLIS_GRAVITY:
 	case DYNAMIC_W_ROTOR:
-        ddp = link->getLinAcc() * R;
+        addAccelerationTerms3(w.data(),dw.data(),r_proj.data(),temp);
+        toVector3(temp,ddp);
+        /*ddp = link->getLinAcc() * R;
         ddp += cross(dw, r_proj);
-        ddp += cross(w, cross(w, r_proj));
+        ddp += cross(w, cross(w, r_proj));*/
 		/*ddp = getR().transposed() * link->getLinAcc() 
 			- cross(dw,getr(true))
 			- cross(w,cross(w,getr(true)));*/
 		break;
 	case STATIC:
-		ddp = getR().transposed() * link->getLinAcc();
+        toVector3(temp,ddp);
+		//ddp = getR().transposed() * link->getLinAcc();
 		break;
 	}
 }
@@ -1541,11 +1680,14 @@ void SensorLinkNewtonEuler::computeLinAccC()
 	case DYNAMIC:
 	case DYNAMIC_CORIOLIS_GRAVITY:
 	case DYNAMIC_W_ROTOR:
-        ddpC = ddp;
-        ddpC += cross(dw,rc);
-        ddpC += cross(w,cross(w,rc));
-		//ddpC = ddp + cross(dw,rc) + cross(w,cross(w,rc));
-		break;
+        {
+            double temp[3];
+            copy3(ddp,temp);
+            addAccelerationTerms3(w.data(),dw.data(),rc.data(),temp);
+            toVector3(temp,ddpC);
+		    //ddpC = ddp + cross(dw,rc) + cross(w,cross(w,rc));
+		    break;
+        }
 	case STATIC:
 		ddpC = ddp;
 		break;
@@ -1554,16 +1696,21 @@ void SensorLinkNewtonEuler::computeLinAccC()
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void SensorLinkNewtonEuler::computeForce(iDynLink *link)
 {
-    F = link->getForce() * R;
-    F += m * ddpC;
+    double temp[3];
+    mulT3(R,link->getForce().data(),temp);
+    for(int i=0; i<3; i++)
+        temp[i] += m*ddpC[i];
+    toVector3(temp,F);
 	//F = getR().transposed() * link->getForce() + m * getLinAccC()  ;
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 void SensorLinkNewtonEuler::computeForceToLink ( iDynLink *link)
 {
-    Vector temp = F;
-    temp -= m*ddpC;
-    link->setForce(R*temp);
+    double temp[3];
+    for(int i=0; i<3; i++)
+        temp[i] = F[i] - m*ddpC[i];
+    mul3(R,temp,temp);
+    link->setForce(toVector3(temp,v3));
 	//link->setForce( R*( F - m * ddpC ) );
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -1573,13 +1720,26 @@ void SensorLinkNewtonEuler::computeMomentToLink( iDynLink *link)
 	{
 	case DYNAMIC_CORIOLIS_GRAVITY:
 	case DYNAMIC:
+	case STATIC:
         {
-            Vector temp = Mu;
-            temp += cross(r_proj, link->getForce()*R);
-			temp -= cross(rc, m*ddpC);
-			temp -= I * (dw);
-			temp -= cross( w , I*(w));
-            link->setMoment(R*temp);
+            //temp = Mu + r_proj x (link->F*R) - rc x (m*ddpC) [ - I*dw - w x (I*w) ]
+            double temp[3], linkF[3], a[3], mddpC[3];
+            mulT3(R,link->getForce().data(),linkF);
+            cross3(r_proj.data(),linkF,a);
+            for(int i=0; i<3; i++)
+                mddpC[i] = m*ddpC[i];
+            cross3(rc.data(),mddpC,mddpC);
+            for(int i=0; i<3; i++)
+                temp[i] = Mu[i] + a[i] - mddpC[i];
+            if(mode!=STATIC)
+            {
+                a[0] = a[1] = a[2] = 0.0;
+                addInertialMoment3(I,w.data(),dw.data(),a);
+                for(int i=0; i<3; i++)
+                    temp[i] -= a[i];
+            }
+            mul3(R,temp,temp);
+            link->setMoment(toVector3(temp,v3));
 		    /*link->setMoment( getR()*( Mu + cross(getr(true),getR().transposed()*link->getForce())
 			    - cross(getrC(),(m * getLinAccC()))
 			    - getInertia() * getR().transposed() * getAngAcc() 
@@ -1596,16 +1756,6 @@ void SensorLinkNewtonEuler::computeMomentToLink( iDynLink *link)
 			- link->getKr() * link->getDAng() * link->getIm() * cross(getAngVel(),getZM())
 			));
 		break;
-	case STATIC:
-        {
-            Vector temp = Mu;
-            temp += cross(r_proj, link->getForce()*R);
-            temp -= cross(rc, m*ddpC);
-            link->setMoment(R*temp);
-		    /*link->setMoment( getR() * ( Mu + cross(getr(true),getR().transposed()*link->getForce()) )			
-			    - cross(getrC(), m*getLinAccC()) );*/
-	        break;
-        }
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -1615,17 +1765,28 @@ void SensorLinkNewtonEuler::computeMoment(iDynLink *link)
 	{
 	case DYNAMIC_CORIOLIS_GRAVITY:
 	case DYNAMIC:
-            Mu = cross(rc, m*ddpC);
-            Mu -= cross(r_proj, link->getForce()*R);
-            Mu += link->getMoment()*R;
-            Mu += I * (dw);
-            Mu += cross( w , I*(w));
+	case STATIC:
+        {
+            //Mu = rc x (m*ddpC) - r_proj x (link->F*R) + link->Mu*R [ + I*dw + w x (I*w) ]
+            double temp[3], linkF[3], a[3], mddpC[3];
+            mulT3(R,link->getForce().data(),linkF);
+            cross3(r_proj.data(),linkF,a);
+            for(int i=0; i<3; i++)
+                mddpC[i] = m*ddpC[i];
+            cross3(rc.data(),mddpC,mddpC);
+            mulT3(R,link->getMoment().data(),temp);
+            for(int i=0; i<3; i++)
+                temp[i] += mddpC[i] - a[i];
+            if(mode!=STATIC)
+                addInertialMoment3(I,w.data(),dw.data(),temp);
+            toVector3(temp,Mu);
 	        /*Mu = cross(getrC(),(m * getLinAccC()))
                 - cross(getr(true),getR().transposed()*link->getForce()) 
 			    + getR().transposed() * link->getMoment()
 			    + getInertia() * getR().transposed() * getAngAcc() 
 			    + cross( getR().transposed() * getAngVel() , getInertia() * getR().transposed() * getAngVel());*/
 		    break;
+        }
 	case DYNAMIC_W_ROTOR:
 	Mu =    cross(getrC(),(m * getLinAccC()))  
             - cross(getr(true),getR().transposed()*link->getForce()) 
@@ -1636,14 +1797,6 @@ void SensorLinkNewtonEuler::computeMoment(iDynLink *link)
 			+ link->getKr() * link->getDAng() * link->getIm() * cross(getAngVel(),getZM()) ;
 
 		break;
-	case STATIC:
-        Mu = cross(rc, m*ddpC);
-        Mu -= cross(r_proj, link->getForce()*R);
-        Mu += link->getMoment()*R;
-		/*Mu = cross(getrC(), m*getLinAccC()) 
-            - cross(getr(true),getR().transposed()*link->getForce()) 
-			+ getR().transposed() * link->getMoment();*/
-	    break;
 	}
 }
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -2015,6 +2168,288 @@ bool OneChainNewtonEuler::BackwardWrenchFromAtoB(unsigned int lA, unsigned int l
 	}
 }
 
+//======================================
+//
+//		BATCH CHAIN NEWTON EULER
+//
+//======================================
+
+const int BatchChainNewtonEuler::BATCH_SIZE;
+
+// each component of the state is an array over the samples of the block
+struct BatchChainNewtonEuler::LinkState
+{
+	// joint position (cos, sin), velocity, acceleration
+	double c[BATCH_SIZE], s[BATCH_SIZE], dq[BATCH_SIZE], ddq[BATCH_SIZE];
+	// angular velocity, angular acceleration, linear acceleration of the origin, in the link frame
+	double w[3][BATCH_SIZE], dw[3][BATCH_SIZE], ddp[3][BATCH_SIZE];
+	// wrench transmitted by the previous link, in the link frame w.r.t. the link origin
+	double F[3][BATCH_SIZE], Mu[3][BATCH_SIZE];
+	// joint torque
+	double tau[BATCH_SIZE];
+};
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+BatchChainNewtonEuler::BatchChainNewtonEuler(iDynChain *_c, unsigned int verb)
+{
+	chain = _c;
+	nLinks = chain->getN();
+	state = new LinkState[nLinks+1];
+	verbose = verb;
+	setParametersFromChain();
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+BatchChainNewtonEuler::~BatchChainNewtonEuler()
+{
+	delete [] state;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool BatchChainNewtonEuler::setParameters(const Vector &phi)
+{
+	if((int)phi.size()!=10*(int)nLinks)
+	{
+		if(verbose)
+			fprintf(stderr,"BatchChainNewtonEuler error: %d parameters instead of %d \n",(int)phi.size(),10*nLinks);
+		return false;
+	}
+	params = phi;
+	return true;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+void BatchChainNewtonEuler::setParametersFromChain()
+{
+	params.resize(10*nLinks);
+	Vector phi(10);
+	for(unsigned int i=0; i<nLinks; i++)
+	{
+		Regressor::iDynChainGetLinkBeta(chain,i,phi);
+		params.setSubvector(10*i,phi);
+	}
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+const Vector &BatchChainNewtonEuler::getParameters() const
+{
+	return params;
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool BatchChainNewtonEuler::computeNewtonEuler(const Matrix &q, const Matrix &dq, const Matrix &ddq,
+                                               const Matrix &kinBase, Matrix &tau, Matrix &FMbase)
+{
+	Matrix FMlink;
+	return computeNewtonEuler(q,dq,ddq,kinBase,tau,FMbase,nLinks,eye(4,4),FMlink);
+}
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+bool BatchChainNewtonEuler::computeNewtonEuler(const Matrix &q, const Matrix &dq, const Matrix &ddq,
+                                               const Matrix &kinBase, Matrix &tau, Matrix &FMbase,
+                                               const unsigned int wrenchLink, const Matrix &H, Matrix &FMlink)
+{
+	// wrenchLink==nLinks is used internally for no output wrench
+	const int K = q.rows();
+	const int DOF = chain->getDOF();
+	if( q.cols()!=DOF || dq.rows()!=K || dq.cols()!=DOF || ddq.rows()!=K || ddq.cols()!=DOF ||
+		kinBase.cols()!=9 || (kinBase.rows()!=1 && kinBase.rows()!=K) || wrenchLink>nLinks || H.rows()!=4 || H.cols()!=4 )
+	{
+		if(verbose)
+			fprintf(stderr,"BatchChainNewtonEuler error: wrong size of the inputs, expected %d columns for the joints, 9 for the base, a (4x4) H and a link < %d \n",DOF,nLinks);
+		return false;
+	}
+
+	// the link model is read from the chain
+	const int N = nLinks;
+	std::vector<double> ca(N), sa(N), r1(N), r2(N), a(N), offset(N), qBlocked(N);
+	std::vector<int> dof(N);
+	for(int j=0, d=0; j<N; j++)
+	{
+		iKinLink &link = (*chain)[j];
+		ca[j] = cos(link.getAlpha());
+		sa[j] = sin(link.getAlpha());
+		a[j] = link.getA();
+		// the origin of the link in its own frame, R^T*p, does not depend on the joint angle
+		r1[j] = link.getD()*sa[j];
+		r2[j] = link.getD()*ca[j];
+		offset[j] = link.getOffset();
+		dof[j] = link.isBlocked() ? -1 : d++;
+		qBlocked[j] = link.getAng();
+	}
+	const Matrix R0 = chain->getH0().submatrix(0,2,0,2);
+	const Matrix Rh = H.submatrix(0,2,0,2);
+	const double ph[3] = { H(0,3), H(1,3), H(2,3) };
+
+	tau.resize(K,N);
+	FMbase.resize(K,6);
+	if(wrenchLink<nLinks)
+		FMlink.resize(K,6);
+
+	LinkState &base = state[0];
+	for(int k0=0; k0<K; k0+=BATCH_SIZE)
+	{
+		const int n = (K-k0<BATCH_SIZE) ? K-k0 : BATCH_SIZE;
+
+		// base kinematics in frame 0
+		for(int k=0; k<n; k++)
+		{
+			const double *kb = kinBase.rows()==1 ? kinBase[0] : kinBase[k0+k];
+			for(int i=0; i<3; i++)
+			{
+				base.w[i][k] = R0(0,i)*kb[0]+R0(1,i)*kb[1]+R0(2,i)*kb[2];
+				base.dw[i][k] = R0(0,i)*kb[3]+R0(1,i)*kb[4]+R0(2,i)*kb[5];
+				base.ddp[i][k] = R0(0,i)*kb[6]+R0(1,i)*kb[7]+R0(2,i)*kb[8];
+			}
+		}
+
+		// joint state
+		for(int j=0; j<N; j++)
+		{
+			LinkState &L = state[j+1];
+			if(dof[j]<0)
+			{
+				const double c = cos(qBlocked[j]+offset[j]), s = sin(qBlocked[j]+offset[j]);
+				for(int k=0; k<n; k++)
+				{
+					L.c[k] = c; L.s[k] = s; L.dq[k] = 0.0; L.ddq[k] = 0.0;
+				}
+			}
+			else
+			{
+				for(int k=0; k<n; k++)
+				{
+					const double th = q(k0+k,dof[j])+offset[j];
+					L.c[k] = cos(th);
+					L.s[k] = sin(th);
+					L.dq[k] = dq(k0+k,dof[j]);
+					L.ddq[k] = ddq(k0+k,dof[j]);
+				}
+			}
+		}
+
+		// forward kinematics:
+		// w = R^T*(w_prev + dq*z), dw = R^T*(dw_prev + ddq*z + dq*w_prev x z)
+		// ddp = R^T*ddp_prev + dw x r + w x (w x r)
+		for(int j=0; j<N; j++)
+		{
+			const LinkState &P = state[j];
+			LinkState &L = state[j+1];
+			const double caj = ca[j], saj = sa[j], r0 = a[j], r1j = r1[j], r2j = r2[j];
+			for(int k=0; k<n; k++)
+			{
+				const double ct = L.c[k], st = L.s[k], dqk = L.dq[k];
+				double v0, v1, v2, u;
+				// R^T*v = (ct*v0+st*v1, ca*u+sa*v2, -sa*u+ca*v2), u = -st*v0+ct*v1
+				v0 = P.w[0][k]; v1 = P.w[1][k]; v2 = P.w[2][k]+dqk;
+				u = -st*v0+ct*v1;
+				const double w0 = ct*v0+st*v1, w1 = caj*u+saj*v2, w2 = -saj*u+caj*v2;
+				v0 = P.dw[0][k]+dqk*P.w[1][k]; v1 = P.dw[1][k]-dqk*P.w[0][k]; v2 = P.dw[2][k]+L.ddq[k];
+				u = -st*v0+ct*v1;
+				const double dw0 = ct*v0+st*v1, dw1 = caj*u+saj*v2, dw2 = -saj*u+caj*v2;
+				v0 = P.ddp[0][k]; v1 = P.ddp[1][k]; v2 = P.ddp[2][k];
+				u = -st*v0+ct*v1;
+				// w x r
+				const double wr0 = w1*r2j-w2*r1j, wr1 = w2*r0-w0*r2j, wr2 = w0*r1j-w1*r0;
+				L.ddp[0][k] = ct*v0+st*v1 + dw1*r2j-dw2*r1j + w1*wr2-w2*wr1;
+				L.ddp[1][k] = caj*u+saj*v2 + dw2*r0-dw0*r2j + w2*wr0-w0*wr2;
+				L.ddp[2][k] = -saj*u+caj*v2 + dw0*r1j-dw1*r0 + w0*wr1-w1*wr0;
+				L.w[0][k] = w0; L.w[1][k] = w1; L.w[2][k] = w2;
+				L.dw[0][k] = dw0; L.dw[1][k] = dw1; L.dw[2][k] = dw2;
+			}
+		}
+
+		// backward wrench, with the net wrench of each link w.r.t. its origin:
+		// f = m*ddp + dw x mc + w x (w x mc), mu = mc x ddp + I*dw + w x (I*w)
+		// F = f + R_next*F_next, Mu = mu + R_next*(Mu_next + r_next x F_next)
+		for(int j=N-1; j>=0; j--)
+		{
+			LinkState &L = state[j+1];
+			const double *phi = params.data()+10*j;
+			const double m = phi[0], mc0 = phi[1], mc1 = phi[2], mc2 = phi[3];
+			const double Ixx = phi[4], Ixy = phi[5], Ixz = phi[6], Iyy = phi[7], Iyz = phi[8], Izz = phi[9];
+			for(int k=0; k<n; k++)
+			{
+				const double w0 = L.w[0][k], w1 = L.w[1][k], w2 = L.w[2][k];
+				const double dw0 = L.dw[0][k], dw1 = L.dw[1][k], dw2 = L.dw[2][k];
+				const double ddp0 = L.ddp[0][k], ddp1 = L.ddp[1][k], ddp2 = L.ddp[2][k];
+				const double wmc0 = w1*mc2-w2*mc1, wmc1 = w2*mc0-w0*mc2, wmc2 = w0*mc1-w1*mc0;
+				L.F[0][k] = m*ddp0 + dw1*mc2-dw2*mc1 + w1*wmc2-w2*wmc1;
+				L.F[1][k] = m*ddp1 + dw2*mc0-dw0*mc2 + w2*wmc0-w0*wmc2;
+				L.F[2][k] = m*ddp2 + dw0*mc1-dw1*mc0 + w0*wmc1-w1*wmc0;
+				const double Iw0 = Ixx*w0+Ixy*w1+Ixz*w2, Iw1 = Ixy*w0+Iyy*w1+Iyz*w2, Iw2 = Ixz*w0+Iyz*w1+Izz*w2;
+				L.Mu[0][k] = mc1*ddp2-mc2*ddp1 + Ixx*dw0+Ixy*dw1+Ixz*dw2 + w1*Iw2-w2*Iw1;
+				L.Mu[1][k] = mc2*ddp0-mc0*ddp2 + Ixy*dw0+Iyy*dw1+Iyz*dw2 + w2*Iw0-w0*Iw2;
+				L.Mu[2][k] = mc0*ddp1-mc1*ddp0 + Ixz*dw0+Iyz*dw1+Izz*dw2 + w0*Iw1-w1*Iw0;
+			}
+			if(j<N-1)
+			{
+				const LinkState &X = state[j+2];
+				const double can = ca[j+1], san = sa[j+1], r0 = a[j+1], r1n = r1[j+1], r2n = r2[j+1];
+				for(int k=0; k<n; k++)
+				{
+					// R*v = (ct*v0-st*t, st*v0+ct*t, sa*v1+ca*v2), t = ca*v1-sa*v2
+					const double ct = X.c[k], st = X.s[k];
+					const double F0 = X.F[0][k], F1 = X.F[1][k], F2 = X.F[2][k];
+					double t = can*F1-san*F2;
+					L.F[0][k] += ct*F0-st*t;
+					L.F[1][k] += st*F0+ct*t;
+					L.F[2][k] += san*F1+can*F2;
+					const double M0 = X.Mu[0][k] + r1n*F2-r2n*F1;
+					const double M1 = X.Mu[1][k] + r2n*F0-r0*F2;
+					const double M2 = X.Mu[2][k] + r0*F1-r1n*F0;
+					t = can*M1-san*M2;
+					L.Mu[0][k] += ct*M0-st*t;
+					L.Mu[1][k] += st*M0+ct*t;
+					L.Mu[2][k] += san*M1+can*M2;
+				}
+			}
+			// the torque is the z component of the wrench in the previous frame
+			const double caj = ca[j], saj = sa[j], r0 = a[j], r1j = r1[j], r2j = r2[j];
+			for(int k=0; k<n; k++)
+			{
+				const double M1 = L.Mu[1][k] + r2j*L.F[0][k]-r0*L.F[2][k];
+				const double M2 = L.Mu[2][k] + r0*L.F[1][k]-r1j*L.F[0][k];
+				L.tau[k] = saj*M1+caj*M2;
+			}
+		}
+
+		// outputs
+		const LinkState &L0 = state[1];
+		for(int k=0; k<n; k++)
+		{
+			const int row = k0+k;
+			for(int j=0; j<N; j++)
+				tau(row,j) = state[j+1].tau[k];
+
+			// base wrench: R0*R_0*(F, Mu + r_0 x F)
+			const double ct = L0.c[k], st = L0.s[k];
+			const double F0 = L0.F[0][k], F1 = L0.F[1][k], F2 = L0.F[2][k];
+			const double M0 = L0.Mu[0][k] + r1[0]*F2-r2[0]*F1;
+			const double M1 = L0.Mu[1][k] + r2[0]*F0-a[0]*F2;
+			const double M2 = L0.Mu[2][k] + a[0]*F1-r1[0]*F0;
+			double t = ca[0]*F1-sa[0]*F2;
+			const double Fb[3] = { ct*F0-st*t, st*F0+ct*t, sa[0]*F1+ca[0]*F2 };
+			t = ca[0]*M1-sa[0]*M2;
+			const double Mb[3] = { ct*M0-st*t, st*M0+ct*t, sa[0]*M1+ca[0]*M2 };
+			for(int i=0; i<3; i++)
+			{
+				FMbase(row,i) = R0(i,0)*Fb[0]+R0(i,1)*Fb[1]+R0(i,2)*Fb[2];
+				FMbase(row,3+i) = R0(i,0)*Mb[0]+R0(i,1)*Mb[1]+R0(i,2)*Mb[2];
+			}
+
+			// link wrench in the frame H: (Rh^T*F, Rh^T*(Mu - ph x F))
+			if(wrenchLink<nLinks)
+			{
+				const LinkState &W = state[wrenchLink+1];
+				const double F[3] = { W.F[0][k], W.F[1][k], W.F[2][k] };
+				const double Mu[3] = { W.Mu[0][k]-ph[1]*F[2]+ph[2]*F[1],
+				                       W.Mu[1][k]-ph[2]*F[0]+ph[0]*F[2],
+				                       W.Mu[2][k]-ph[0]*F[1]+ph[1]*F[0] };
+				for(int i=0; i<3; i++)
+				{
+					FMlink(row,i) = Rh(0,i)*F[0]+Rh(1,i)*F[1]+Rh(2,i)*F[2];
+					FMlink(row,3+i) = Rh(0,i)*Mu[0]+Rh(1,i)*Mu[1]+Rh(2,i)*Mu[2];
+				}
+			}
+		}
+	}
+	return true;
+}
+
 //======================================
 //
 //			  iDYN INV SENSOR
@@ -2194,7 +2629,7 @@ bool iDynInvSensor::setDynamicParameters(const double _m, const yarp::sig::Matri
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 string iDynInvSensor::getInfo()					const	{return info;}
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-Matrix iDynInvSensor::getH()					const	
+const Matrix & iDynInvSensor::getH()					const	
 {
     if(sens != NULL) 
         return sens->getH();
@@ -2202,7 +2637,8 @@ Matrix iDynInvSensor::getH()					const
     {
         if(verbose)
             fprintf(stderr,"iDynInvSensor error: could not get H of the FT sensor, because the sensor is not set yet.\n");
-        return Matrix(0,0);
+        static const Matrix empty(0,0);
+        return empty;
     }
 
 }
@@ -4,6 +4,7 @@
 #include <iCub/ctrl/math.h>
 
 #include <iostream>
+#include <cmath>
 
 
 //should be fixed in iDyn 
@@ -20,13 +21,13 @@ using namespace iCub::ctrl;
 using namespace iCub::iDyn::Regressor;
 
 
-bool iCub::iDyn::Regressor::iCubLimbRegressorSensorWrench(iCubWholeBody * icub, const std::string & limbName,Matrix & Phi, bool consider_virtual_link)
+bool iCub::iDyn::Regressor::iCubLimbRegressorSensorWrench(iCubWholeBody * icub, const std::string & limbName,Matrix & Phi, bool consider_virtual_link, bool use_specialized)
 {
     iDynChain * p_chain;
     iDynSensor * p_sensor;
     int VIRTUAL_LINK;
 	if( iCubLimbGetData(icub,limbName,consider_virtual_link,p_chain,p_sensor,VIRTUAL_LINK) == false ) return false;
-	iDynChainRegressorSensorWrench(p_chain,p_sensor,Phi,VIRTUAL_LINK);
+	iDynChainRegressorSensorWrench(p_chain,p_sensor,Phi,VIRTUAL_LINK,use_specialized);
     return true;
 }
 
@@ -50,8 +51,11 @@ bool iCub::iDyn::Regressor::iCubLimbRegressorInternalWrench(iCubWholeBody * icub
     return true;
 }
 
-bool iCub::iDyn::Regressor::iDynChainRegressorSensorWrench(iDynChain * p_chain,iDynSensor * p_sensor, Matrix & A,const int excluded_link)
+bool iCub::iDyn::Regressor::iDynChainRegressorSensorWrench(iDynChain * p_chain,iDynSensor * p_sensor, Matrix & A,const int excluded_link, bool use_specialized)
 {
+    if( use_specialized && iDynChainRegressorSensorWrenchSpecialized(p_chain,p_sensor,A,excluded_link) ) {
+        return true;
+    }
     vector<bool> excluded_links;
     excluded_links.resize(p_chain->getN());
 	if( setOnlyOneElement(excluded_links,excluded_link) == false ) return false;
@@ -182,6 +186,654 @@ bool iCub::iDyn::Regressor::iDynChainRegressorInternalWrench(iDynChain *  p_chai
 }
 
 
+iCub::iDyn::Regressor::RegressorProjection::RegressorProjection() : n_links(0), total_size(0)
+{
+}
+
+bool iCub::iDyn::Regressor::RegressorProjection::setBases(const vector<Matrix> & bases, double tol)
+{
+    if( bases.size() == 0 ) return false;
+    const int n_param = bases[0].rows();
+    if( n_param % 10 != 0 ) return false;
+    
+    n_links = n_param/10;
+    total_size = 0;
+    offsets.resize(bases.size());
+    sizes.resize(bases.size());
+    for(int b=0; b < (int)bases.size(); b++ ) {
+        if( bases[b].rows() != n_param ) return false;
+        offsets[b] = total_size;
+        sizes[b] = bases[b].cols();
+        total_size += bases[b].cols();
+    }
+    
+    active_columns.resize(n_links);
+    slices.resize(n_links);
+    for(int j=0; j < n_links; j++ ) {
+        active_columns[j].clear();
+        slices[j].clear();
+        //columns of [B_0 ... B_{n-1}] not zero for the link j
+        for(int b=0; b < (int)bases.size(); b++ ) {
+            for(int c=0; c < sizes[b]; c++ ) {
+                for(int k=0; k < 10; k++ ) {
+                    if( fabs(bases[b](10*j+k,c)) > tol ) {
+                        active_columns[j].push_back(offsets[b]+c);
+                        break;
+                    }
+                }
+            }
+        }
+        //row major 10 x active_columns[j].size() slice
+        const int n_active = active_columns[j].size();
+        slices[j].resize(10*n_active);
+        for(int k=0; k < 10; k++ ) {
+            for(int a=0; a < n_active; a++ ) {
+                int col = active_columns[j][a];
+                int b = 0;
+                while( b+1 < (int)bases.size() && col >= offsets[b+1] ) b++;
+                slices[j][k*n_active+a] = bases[b](10*j+k,col-offsets[b]);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * T = H, for the homogeneous transform H
+ */
+static void homogeneousCopy(const Matrix & H, double T[4][4])
+{
+    for(int i=0; i < 4; i++ ) {
+        for(int j=0; j < 4; j++ ) {
+            T[i][j] = H(i,j);
+        }
+    }
+}
+
+/**
+ * T = H^{-1}, for the homogeneous transform H (same as SE3inv)
+ */
+static void homogeneousInverse(const Matrix & H, double T[4][4])
+{
+    for(int i=0; i < 3; i++ ) {
+        T[i][3] = 0.0;
+        for(int j=0; j < 3; j++ ) {
+            T[i][j] = H(j,i);
+            T[i][3] -= H(j,i)*H(j,3);
+        }
+    }
+    T[3][0] = 0.0; T[3][1] = 0.0; T[3][2] = 0.0; T[3][3] = 1.0;
+}
+
+/**
+ * T = T*H, for the homogeneous transforms T and H
+ */
+static void homogeneousMultiply(double T[4][4], const Matrix & H)
+{
+    for(int i=0; i < 3; i++ ) {
+        double row[4];
+        for(int j=0; j < 4; j++ ) {
+            row[j] = T[i][0]*H(0,j) + T[i][1]*H(1,j) + T[i][2]*H(2,j) + T[i][3]*H(3,j);
+        }
+        for(int j=0; j < 4; j++ ) {
+            T[i][j] = row[j];
+        }
+    }
+}
+
+/**
+ * B = adjointInv(H)^T*iDynLinkRegressorNetWrench(p_link), skipping the structural zeros
+ * of the net wrench regressor
+ */
+static void linkRegressorInFrame(iDynLink * p_link, const double H[4][4], double B[6][10])
+{
+    double N[6][10];
+    //6x10 net wrench regressor of the link (same as iDynLinkRegressorNetWrench)
+    const Vector & ddp = p_link->getLinAcc();
+    const Vector & w = p_link->getW();
+    const Vector & dw = p_link->getdW();
+    for(int r=0; r < 6; r++ ) {
+        for(int c=0; c < 10; c++ ) {
+            N[r][c] = 0.0;
+        }
+    }
+    N[0][0] = ddp[0];
+    N[1][0] = ddp[1];
+    N[2][0] = ddp[2];
+    //crossProductMatrix(dw)+crossProductMatrix(w)*crossProductMatrix(w)
+    N[0][1] = -w[1]*w[1]-w[2]*w[2];   N[0][2] = -dw[2]+w[0]*w[1];       N[0][3] = dw[1]+w[0]*w[2];
+    N[1][1] = dw[2]+w[0]*w[1];        N[1][2] = -w[0]*w[0]-w[2]*w[2];   N[1][3] = -dw[0]+w[1]*w[2];
+    N[2][1] = -dw[1]+w[0]*w[2];       N[2][2] = dw[0]+w[1]*w[2];        N[2][3] = -w[0]*w[0]-w[1]*w[1];
+    //-crossProductMatrix(ddp)
+    N[3][2] = ddp[2];   N[3][3] = -ddp[1];
+    N[4][1] = -ddp[2];  N[4][3] = ddp[0];
+    N[5][1] = ddp[1];   N[5][2] = -ddp[0];
+    //EulerEquationsRegressor(w,dw)
+    N[3][4] = dw[0];                N[3][5] = dw[1]-w[0]*w[2];      N[3][6] = dw[2]+w[0]*w[1];
+    N[3][7] = -w[1]*w[2];           N[3][8] = w[1]*w[1]-w[2]*w[2];  N[3][9] = w[1]*w[2];
+    N[4][4] = w[0]*w[2];            N[4][5] = dw[0]+w[1]*w[2];      N[4][6] = w[2]*w[2]-w[0]*w[0];
+    N[4][7] = dw[1];                N[4][8] = dw[2]-w[0]*w[1];      N[4][9] = -w[0]*w[2];
+    N[5][4] = -w[0]*w[1];           N[5][5] = w[0]*w[0]-w[1]*w[1];  N[5][6] = dw[0]-w[1]*w[2];
+    N[5][7] = w[0]*w[1];            N[5][8] = dw[1]+w[0]*w[2];      N[5][9] = dw[2];
+    
+    //B = adjointInv(H)^T*N = [R 0; S(p)*R R]*N, with R and p the rotation and the
+    //origin of H, skipping the structural zeros of N
+    double SR[3][3];
+    for(int j=0; j < 3; j++ ) {
+        SR[0][j] = H[1][3]*H[2][j] - H[2][3]*H[1][j];
+        SR[1][j] = H[2][3]*H[0][j] - H[0][3]*H[2][j];
+        SR[2][j] = H[0][3]*H[1][j] - H[1][3]*H[0][j];
+    }
+    for(int r=0; r < 3; r++ ) {
+        for(int c=0; c < 4; c++ ) {
+            B[r][c] = H[r][0]*N[0][c] + H[r][1]*N[1][c] + H[r][2]*N[2][c];
+            B[3+r][c] = SR[r][0]*N[0][c] + SR[r][1]*N[1][c] + SR[r][2]*N[2][c]
+                      + H[r][0]*N[3][c] + H[r][1]*N[4][c] + H[r][2]*N[5][c];
+        }
+        for(int c=4; c < 10; c++ ) {
+            B[r][c] = 0.0;
+            B[3+r][c] = H[r][0]*N[3][c] + H[r][1]*N[4][c] + H[r][2]*N[5][c];
+        }
+    }
+}
+
+/**
+ * Same as linkRegressorInFrame, with H stored in a Matrix
+ */
+static void linkRegressorInFrame(iDynLink * p_link, const Matrix & H, double B[6][10])
+{
+    double T[4][4];
+    homogeneousCopy(H,T);
+    linkRegressorInFrame(p_link,T,B);
+}
+
+bool iCub::iDyn::Regressor::iCubLimbRegressorSensorWrenchProjected(iCubWholeBody * icub, const std::string & limbName, const RegressorProjection & projection, Matrix & Phi_projected, bool consider_virtual_link)
+{
+    iDynChain * p_chain;
+    iDynSensor * p_sensor;
+    int VIRTUAL_LINK;
+    if( iCubLimbGetData(icub,limbName,consider_virtual_link,p_chain,p_sensor,VIRTUAL_LINK) == false ) return false;
+    return iDynChainRegressorSensorWrenchProjected(p_chain,p_sensor,projection,Phi_projected,VIRTUAL_LINK);
+}
+
+bool iCub::iDyn::Regressor::iDynChainRegressorSensorWrenchProjected(iDynChain * p_chain, iDynSensor * p_sensor, const RegressorProjection & projection, Matrix & A, const int excluded_link)
+{
+    const int SENSOR_LINK_INDEX = p_sensor->getSensorLink();
+    const int FINAL_LINK_INDEX = p_chain->getN()-1;
+    const int VIRTUAL_LINKS = (excluded_link >= SENSOR_LINK_INDEX && excluded_link <= FINAL_LINK_INDEX) ? 1 : 0;
+    const int TOTAL_IDENT_LINKS = FINAL_LINK_INDEX - SENSOR_LINK_INDEX+1-VIRTUAL_LINKS;
+    if( projection.getNumberOfLinks() != TOTAL_IDENT_LINKS ) return false;
+    
+    if( A.rows() != 6 || A.cols() != projection.getTotalSize() ) {
+        A.resize(6,projection.getTotalSize());
+    }
+    A.zero();
+    
+    //the transforms are kept in fixed size arrays, so that no memory is allocated
+    double H_current[4][4];
+    double B[6][10];
+    int j = 0;
+    for(int link_index = SENSOR_LINK_INDEX;link_index <= FINAL_LINK_INDEX; link_index++) {
+        iDynLink * p_link = (iDynLink *) &((*p_chain)[link_index]);
+        if( link_index == SENSOR_LINK_INDEX ) {
+            //the H contained in the sensor is \f$ H^s_i
+            homogeneousInverse(p_sensor->getH(),H_current);
+        } else {
+            //iDynLink::getH returns the cached transform of the link
+            homogeneousMultiply(H_current,p_link->getH());
+        }
+        if( link_index == excluded_link ) continue;
+        
+        linkRegressorInFrame(p_link,H_current,B);
+        
+        //A(:,active) += B*slice
+        const std::vector<int> & active = projection.getActiveColumns(j);
+        const double * slice = projection.getSlice(j);
+        const int n_active = active.size();
+        for(int r=0; r < 6; r++ ) {
+            double * A_row = A[r];
+            for(int a=0; a < n_active; a++ ) {
+                double sum = 0.0;
+                for(int k=0; k < 10; k++ ) {
+                    sum += B[r][k]*slice[k*n_active+a];
+                }
+                A_row[active[a]] += sum;
+            }
+        }
+        j++;
+    }
+    return true;
+}
+
+iCub::iDyn::Regressor::BlockSparseRegressor::BlockSparseRegressor() : n_rows(0), n_cols(0)
+{
+}
+
+void iCub::iDyn::Regressor::BlockSparseRegressor::resize(int rows, int cols)
+{
+    n_rows = rows;
+    n_cols = cols;
+    block_row.clear();
+    block_col.clear();
+    block_rows.clear();
+    block_cols.clear();
+    block_offset.clear();
+    data.clear();
+}
+
+int iCub::iDyn::Regressor::BlockSparseRegressor::addBlock(int row, int col, int rows, int cols)
+{
+    YARP_ASSERT(row >= 0 && row+rows <= n_rows);
+    YARP_ASSERT(col >= 0 && col+cols <= n_cols);
+    block_row.push_back(row);
+    block_col.push_back(col);
+    block_rows.push_back(rows);
+    block_cols.push_back(cols);
+    block_offset.push_back(data.size());
+    data.resize(data.size()+rows*cols,0.0);
+    return block_row.size()-1;
+}
+
+double * iCub::iDyn::Regressor::BlockSparseRegressor::getWorkspace(int size)
+{
+    if( (int)workspace.size() < size ) {
+        workspace.resize(size);
+    }
+    return &(workspace[0]);
+}
+
+void iCub::iDyn::Regressor::BlockSparseRegressor::multiply(const Vector & phi, Vector & out) const
+{
+    YARP_ASSERT((int)phi.size() == n_cols);
+    if( (int)out.size() != n_rows ) {
+        out.resize(n_rows);
+    }
+    out.zero();
+    for(int b=0; b < getNumberOfBlocks(); b++ ) {
+        const double * block = getBlock(b);
+        const double * phi_block = phi.data()+block_col[b];
+        for(int i=0; i < block_rows[b]; i++ ) {
+            double sum = 0.0;
+            for(int j=0; j < block_cols[b]; j++ ) {
+                sum += block[i*block_cols[b]+j]*phi_block[j];
+            }
+            out[block_row[b]+i] += sum;
+        }
+    }
+}
+
+void iCub::iDyn::Regressor::BlockSparseRegressor::project(const Matrix & basis, Matrix & out, int first_row) const
+{
+    YARP_ASSERT(basis.rows() == n_cols);
+    YARP_ASSERT(first_row >= 0 && first_row <= n_rows);
+    if( out.rows() == 0 ) {
+        out.resize(n_rows-first_row,basis.cols());
+    }
+    YARP_ASSERT(first_row+out.rows() <= n_rows && out.cols() == basis.cols());
+    out.zero();
+    const int r = basis.cols();
+    const int last_row = first_row+out.rows()-1;
+    for(int b=0; b < getNumberOfBlocks(); b++ ) {
+        const double * block = getBlock(b);
+        for(int i=0; i < block_rows[b]; i++ ) {
+            const int row = block_row[b]+i;
+            if( row < first_row || row > last_row ) continue;
+            double * out_row = out[row-first_row];
+            for(int j=0; j < block_cols[b]; j++ ) {
+                const double a = block[i*block_cols[b]+j];
+                if( a == 0.0 ) continue;
+                const double * basis_row = basis[block_col[b]+j];
+                for(int c=0; c < r; c++ ) {
+                    out_row[c] += a*basis_row[c];
+                }
+            }
+        }
+    }
+}
+
+void iCub::iDyn::Regressor::BlockSparseRegressor::addGram(int first_row, int last_row, Matrix & G) const
+{
+    YARP_ASSERT(G.rows() == n_cols && G.cols() == n_cols);
+    YARP_ASSERT(first_row >= 0 && last_row < n_rows);
+    //for each row, the products of the pairs of blocks containing it
+    for(int row=first_row; row <= last_row; row++ ) {
+        for(int b1=0; b1 < getNumberOfBlocks(); b1++ ) {
+            if( row < block_row[b1] || row >= block_row[b1]+block_rows[b1] ) continue;
+            const double * row1 = getBlock(b1)+(row-block_row[b1])*block_cols[b1];
+            for(int b2=0; b2 < getNumberOfBlocks(); b2++ ) {
+                if( row < block_row[b2] || row >= block_row[b2]+block_rows[b2] ) continue;
+                const double * row2 = getBlock(b2)+(row-block_row[b2])*block_cols[b2];
+                for(int i=0; i < block_cols[b1]; i++ ) {
+                    const double a = row1[i];
+                    if( a == 0.0 ) continue;
+                    double * G_row = G[block_col[b1]+i]+block_col[b2];
+                    for(int j=0; j < block_cols[b2]; j++ ) {
+                        G_row[j] += a*row2[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void iCub::iDyn::Regressor::BlockSparseRegressor::toDense(Matrix & out) const
+{
+    if( out.rows() != n_rows || out.cols() != n_cols ) {
+        out.resize(n_rows,n_cols);
+    }
+    out.zero();
+    for(int b=0; b < getNumberOfBlocks(); b++ ) {
+        const double * block = getBlock(b);
+        for(int i=0; i < block_rows[b]; i++ ) {
+            for(int j=0; j < block_cols[b]; j++ ) {
+                out(block_row[b]+i,block_col[b]+j) = block[i*block_cols[b]+j];
+            }
+        }
+    }
+}
+
+bool iCub::iDyn::Regressor::iCubLimbRegressorCompleteBlockSparse(iCubWholeBody * icub, const std::string & limbName, BlockSparseRegressor & Phi, bool consider_virtual_link)
+{
+    iDynChain * p_chain;
+    iDynSensor * p_sensor;
+    int VIRTUAL_LINK;
+    if( iCubLimbGetData(icub,limbName,consider_virtual_link,p_chain,p_sensor,VIRTUAL_LINK) == false ) return false;
+    return iDynChainRegressorCompleteBlockSparse(p_chain,p_sensor,Phi,VIRTUAL_LINK);
+}
+
+bool iCub::iDyn::Regressor::iDynChainRegressorCompleteBlockSparse(iDynChain * p_chain, iDynSensor * p_sensor, BlockSparseRegressor & A, const int excluded_link)
+{
+    if( excluded_link >= (int)p_chain->getN() ) return false;
+    const int SENSOR_LINK_INDEX = p_sensor->getSensorLink();
+    const int FINAL_LINK_INDEX = p_chain->getN()-1;
+    const int VIRTUAL_LINKS = (excluded_link >= SENSOR_LINK_INDEX && excluded_link <= FINAL_LINK_INDEX) ? 1 : 0;
+    const int TOTAL_IDENT_LINKS = FINAL_LINK_INDEX - SENSOR_LINK_INDEX+1-VIRTUAL_LINKS;
+    
+    //Blocks of each link: force (3x4), moment (3x10), torques of the joints before the link
+    const int N_ROWS = 6+FINAL_LINK_INDEX-SENSOR_LINK_INDEX;
+    bool same_pattern = ( A.rows() == N_ROWS && A.cols() == 10*TOTAL_IDENT_LINKS );
+    if( same_pattern ) {
+        int b = 0;
+        for(int link_index = SENSOR_LINK_INDEX;link_index <= FINAL_LINK_INDEX && same_pattern; link_index++) {
+            if( link_index == excluded_link ) continue;
+            b += 2;
+            if( link_index > SENSOR_LINK_INDEX ) {
+                same_pattern = ( b < A.getNumberOfBlocks() && A.getBlockRows(b) == link_index-SENSOR_LINK_INDEX );
+                b++;
+            }
+        }
+        same_pattern = same_pattern && ( b == A.getNumberOfBlocks() );
+    }
+    if( !same_pattern ) {
+        A.resize(N_ROWS,10*TOTAL_IDENT_LINKS);
+        int j = 0;
+        for(int link_index = SENSOR_LINK_INDEX;link_index <= FINAL_LINK_INDEX; link_index++) {
+            if( link_index == excluded_link ) continue;
+            A.addBlock(0,10*j,3,4);
+            A.addBlock(3,10*j,3,10);
+            if( link_index > SENSOR_LINK_INDEX ) {
+                A.addBlock(6,10*j,link_index-SENSOR_LINK_INDEX,10);
+            }
+            j++;
+        }
+    }
+    
+    //transform of the current link with respect to the sensor frame, and for each
+    //link its z axis and z x o (o the origin), stored in the workspace of A
+    double H_current[4][4];
+    double * axes = A.getWorkspace(6*(FINAL_LINK_INDEX-SENSOR_LINK_INDEX+1));
+    double B[6][10];
+    int b = 0;
+    for(int link_index = SENSOR_LINK_INDEX;link_index <= FINAL_LINK_INDEX; link_index++) {
+        iDynLink * p_link = (iDynLink *) &((*p_chain)[link_index]);
+        const int h = link_index-SENSOR_LINK_INDEX;
+        if( link_index == SENSOR_LINK_INDEX ) {
+            //the H contained in the sensor is \f$ H^s_i
+            homogeneousInverse(p_sensor->getH(),H_current);
+        } else {
+            homogeneousMultiply(H_current,p_link->getH());
+        }
+        double * axis = axes+6*h;
+        axis[0] = H_current[0][2];
+        axis[1] = H_current[1][2];
+        axis[2] = H_current[2][2];
+        axis[3] = axis[1]*H_current[2][3]-axis[2]*H_current[1][3];
+        axis[4] = axis[2]*H_current[0][3]-axis[0]*H_current[2][3];
+        axis[5] = axis[0]*H_current[1][3]-axis[1]*H_current[0][3];
+        if( link_index == excluded_link ) continue;
+        
+        linkRegressorInFrame(p_link,H_current,B);
+        
+        double * force = A.getBlock(b++);
+        for(int r=0; r < 3; r++ ) {
+            for(int c=0; c < 4; c++ ) {
+                force[4*r+c] = B[r][c];
+            }
+        }
+        double * moment = A.getBlock(b++);
+        for(int r=0; r < 3; r++ ) {
+            for(int c=0; c < 10; c++ ) {
+                moment[10*r+c] = B[3+r][c];
+            }
+        }
+        if( link_index > SENSOR_LINK_INDEX ) {
+            //torque of the joint p is the z component of the moment in the frame p-1, for p <= link_index
+            double * torques = A.getBlock(b++);
+            for(int p = SENSOR_LINK_INDEX+1; p <= link_index; p++ ) {
+                const double * axis = axes+6*(p-1-SENSOR_LINK_INDEX);
+                const double z0 = axis[0], z1 = axis[1], z2 = axis[2];
+                //z x o, with o the origin of the joint frame
+                const double o0 = axis[3], o1 = axis[4], o2 = axis[5];
+                double * row = torques+10*(p-SENSOR_LINK_INDEX-1);
+                for(int c=0; c < 10; c++ ) {
+                    row[c] = (z0*B[3][c]+z1*B[4][c]+z2*B[5][c]) - (o0*B[0][c]+o1*B[1][c]+o2*B[2][c]);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+const int iCub::iDyn::Regressor::iCubWholeBodyRegressor::N_SENSORS;
+const int iCub::iDyn::Regressor::iCubWholeBodyRegressor::BASE_ROW;
+
+iCub::iDyn::Regressor::iCubWholeBodyRegressor::iCubWholeBodyRegressor(iCubWholeBody * _icub, bool consider_virtual_link) : icub(_icub), n_params(0)
+{
+    //limbs, in the order of the parameter vector (the torso is the first one, see getUpperTorsoPose)
+    const std::string names[6] = {"torso","head","right_arm","left_arm","right_leg","left_leg"};
+    limbs.resize(6);
+    for(int l=0; l < 6; l++ ) {
+        limbs[l].name = names[l];
+        limbs[l].p_sensor = 0;
+        limbs[l].virtual_link = -1;
+        if( l >= 2 ) {
+            iCubLimbGetData(icub,names[l],consider_virtual_link,limbs[l].p_chain,limbs[l].p_sensor,limbs[l].virtual_link);
+        }
+    }
+    limbs[0].p_chain = icub->lowerTorso->up->asChain();
+    limbs[1].p_chain = icub->upperTorso->up->asChain();
+    limbs[0].H_node = icub->lowerTorso->HUp;     limbs[0].upper = false;
+    limbs[1].H_node = icub->upperTorso->HUp;     limbs[1].upper = true;
+    limbs[2].H_node = icub->upperTorso->HRight;  limbs[2].upper = true;
+    limbs[3].H_node = icub->upperTorso->HLeft;   limbs[3].upper = true;
+    limbs[4].H_node = icub->lowerTorso->HRight;  limbs[4].upper = false;
+    limbs[5].H_node = icub->lowerTorso->HLeft;   limbs[5].upper = false;
+    
+    int s = 0;
+    for(int l=0; l < (int)limbs.size(); l++ ) {
+        const int N = limbs[l].p_chain->getN();
+        if( limbs[l].p_sensor == 0 ) {
+            for(int i=0; i < N; i++ ) {
+                addBody(l,i,WHOLE_LINK,-1);
+            }
+            continue;
+        }
+        //the part of the sensor link before the sensor belongs to the base subtree, the semilink to the sensor subtree
+        const int SENSOR_LINK_INDEX = limbs[l].p_sensor->getSensorLink();
+        for(int i=0; i < SENSOR_LINK_INDEX; i++ ) {
+            addBody(l,i,WHOLE_LINK,-1);
+        }
+        addBody(l,SENSOR_LINK_INDEX,PROXIMAL_LINK,-1);
+        sensor_limb[s] = l;
+        sensor_offset[s] = n_params;
+        addBody(l,SENSOR_LINK_INDEX,SEMILINK,s);
+        for(int i=SENSOR_LINK_INDEX+1; i < N; i++ ) {
+            if( i != limbs[l].virtual_link ) {
+                addBody(l,i,WHOLE_LINK,s);
+            }
+        }
+        sensor_size[s] = n_params-sensor_offset[s];
+        s++;
+    }
+    YARP_ASSERT(s == N_SENSORS);
+}
+
+void iCub::iDyn::Regressor::iCubWholeBodyRegressor::addBody(int limb, int link, BodyType type, int sensor)
+{
+    Body body;
+    body.limb = limb;
+    body.link = link;
+    body.type = type;
+    body.sensor = sensor;
+    body.offset = n_params;
+    bodies.push_back(body);
+    n_params += 10;
+}
+
+std::string iCub::iDyn::Regressor::iCubWholeBodyRegressor::getBodyName(int b) const
+{
+    const Body & body = bodies[b];
+    char name[64];
+    sprintf(name,"%s_%d%s",limbs[body.limb].name.c_str(),body.link,
+            body.type == SEMILINK ? "_semilink" : ( body.type == PROXIMAL_LINK ? "_proximal" : "" ));
+    return std::string(name);
+}
+
+int iCub::iDyn::Regressor::iCubWholeBodyRegressor::getSensorIndex(const std::string & limbName) const
+{
+    for(int s=0; s < N_SENSORS; s++ ) {
+        if( getSensorName(s) == limbName ) return s;
+    }
+    return -1;
+}
+
+void iCub::iDyn::Regressor::iCubWholeBodyRegressor::getParameters(Vector & phi) const
+{
+    if( (int)phi.size() != n_params ) {
+        phi.resize(n_params);
+    }
+    Vector beta(10), beta_semiLink(10);
+    for(int b=0; b < (int)bodies.size(); b++ ) {
+        const Body & body = bodies[b];
+        const Limb & limb = limbs[body.limb];
+        if( body.type == SEMILINK ) {
+            iDynSensorGetSemilinkBeta(limb.p_sensor,beta);
+        } else {
+            iDynChainGetLinkBeta(limb.p_chain,body.link,beta);
+            if( body.type == PROXIMAL_LINK ) {
+                //the parameters in the ident format are additive
+                iDynSensorGetSemilinkBeta(limb.p_sensor,beta_semiLink);
+                beta = beta - beta_semiLink;
+            }
+        }
+        phi.setSubvector(body.offset,beta);
+    }
+}
+
+Matrix iCub::iDyn::Regressor::iCubWholeBodyRegressor::getUpperTorsoPose()
+{
+    //the upper torso node is attached to the end of the torso chain with an identity transformation
+    return limbs[0].H_node * limbs[0].p_chain->getH();
+}
+
+Matrix iCub::iDyn::Regressor::iCubWholeBodyRegressor::getLinkPose(const Limb & limb, int link, const Matrix & H_upper)
+{
+    if( limb.upper ) {
+        return H_upper * limb.H_node * limb.p_chain->getH(link,true);
+    } else {
+        return limb.H_node * limb.p_chain->getH(link,true);
+    }
+}
+
+Matrix iCub::iDyn::Regressor::iCubWholeBodyRegressor::getSensorPose(int s)
+{
+    const Limb & limb = limbs[sensor_limb[s]];
+    return getLinkPose(limb,limb.p_sensor->getSensorLink(),getUpperTorsoPose()) * limb.p_sensor->getH();
+}
+
+bool iCub::iDyn::Regressor::iCubWholeBodyRegressor::computeRegressor(BlockSparseRegressor & Y)
+{
+    //Blocks of each body: force (3x4) and moment (3x10), in the rows of its subtree
+    const int N_ROWS = BASE_ROW+6;
+    const int N_BODIES = bodies.size();
+    if( Y.rows() != N_ROWS || Y.cols() != n_params || Y.getNumberOfBlocks() != 2*N_BODIES ) {
+        Y.resize(N_ROWS,n_params);
+        for(int b=0; b < N_BODIES; b++ ) {
+            const int row = ( bodies[b].sensor == -1 ) ? BASE_ROW : 6*bodies[b].sensor;
+            Y.addBlock(row,bodies[b].offset,3,4);
+            Y.addBlock(row+3,bodies[b].offset,3,10);
+        }
+    }
+    
+    const Matrix H_upper = getUpperTorsoPose();
+    Matrix H_current;
+    int current_link = -1;
+    double B[6][10];
+    for(int b=0; b < N_BODIES; b++ ) {
+        const Body & body = bodies[b];
+        const Limb & limb = limbs[body.limb];
+        if( body.sensor == -1 ) {
+            //base subtree: H with respect to the root frame
+            H_current = getLinkPose(limb,body.link,H_upper);
+        } else if( body.type == SEMILINK ) {
+            //the H contained in the sensor is \f$ H^s_i
+            H_current = SE3inv(limb.p_sensor->getH());
+            current_link = body.link;
+        } else {
+            //sensor subtree: H with respect to the sensor frame (the links are ordered, the virtual link can be skipped)
+            for(int i=current_link+1; i <= body.link; i++ ) {
+                H_current = H_current * (*limb.p_chain)[i].getH();
+            }
+            current_link = body.link;
+        }
+        
+        linkRegressorInFrame((iDynLink *) &((*limb.p_chain)[body.link]),H_current,B);
+        
+        double * force = Y.getBlock(2*b);
+        for(int r=0; r < 3; r++ ) {
+            for(int c=0; c < 4; c++ ) {
+                force[4*r+c] = B[r][c];
+            }
+        }
+        double * moment = Y.getBlock(2*b+1);
+        for(int r=0; r < 3; r++ ) {
+            for(int c=0; c < 10; c++ ) {
+                moment[10*r+c] = B[3+r][c];
+            }
+        }
+    }
+    return true;
+}
+
+bool iCub::iDyn::Regressor::iCubWholeBodyRegressor::getMeasure(const std::vector<Vector> & sensor_wrenches, Vector & y)
+{
+    if( (int)sensor_wrenches.size() != N_SENSORS ) return false;
+    for(int s=0; s < N_SENSORS; s++ ) {
+        if( sensor_wrenches[s].size() != 6 ) return false;
+    }
+    if( (int)y.size() != BASE_ROW+6 ) {
+        y.resize(BASE_ROW+6);
+    }
+    //the distal subtree of the sensor s exerts -W_s on the base subtree
+    Vector W_base(6,0.0);
+    for(int s=0; s < N_SENSORS; s++ ) {
+        y.setSubvector(6*s,sensor_wrenches[s]);
+        W_base = W_base - adjointInv(getSensorPose(s)).transposed()*sensor_wrenches[s];
+    }
+    y.setSubvector(BASE_ROW,W_base);
+    return true;
+}
+
 Vector iCub::iDyn::Regressor::iDynChainRegressorTorqueEstimation(iDynChain * p_chain,iDynSensor * p_sensor,const int joint_index, const int excluded_link)
 {
     vector<bool> excluded_links;
@@ -220,6 +872,51 @@ Vector iCub::iDyn::Regressor::iDynChainRegressorTorqueEstimation(iDynChain *p_ch
     return A.getRow(5);
 }
 
+bool iCub::iDyn::Regressor::iDynChainRegressorTorquesEstimation(iDynChain * p_chain,iDynSensor * p_sensor, Matrix & A, const int excluded_link, bool use_specialized)
+{
+    if( use_specialized && iDynChainRegressorTorquesEstimationSpecialized(p_chain,p_sensor,A,excluded_link) ) {
+        return true;
+    }
+    if( excluded_link >= (int)p_chain->getN() ) return false;
+    const int SENSOR_LINK_INDEX = p_sensor->getSensorLink();
+    const int FINAL_LINK_INDEX = p_chain->getN()-1;
+    const int VIRTUAL_LINKS = (excluded_link >= SENSOR_LINK_INDEX && excluded_link <= FINAL_LINK_INDEX) ? 1 : 0;
+    const int TOTAL_IDENT_LINKS = FINAL_LINK_INDEX - SENSOR_LINK_INDEX+1-VIRTUAL_LINKS;
+    if( A.rows() != FINAL_LINK_INDEX-SENSOR_LINK_INDEX || A.cols() != 10*TOTAL_IDENT_LINKS ) {
+        A.resize(FINAL_LINK_INDEX-SENSOR_LINK_INDEX,10*TOTAL_IDENT_LINKS);
+    }
+    for(int joint_index = SENSOR_LINK_INDEX+1; joint_index <= FINAL_LINK_INDEX; joint_index++ ) {
+        A.setRow(joint_index-SENSOR_LINK_INDEX-1,iDynChainRegressorTorqueEstimation(p_chain,p_sensor,joint_index,excluded_link));
+    }
+    return true;
+}
+
+bool iCub::iDyn::Regressor::iDynChainRegressorCheckSpecialized(iDynChain * p_chain,iDynSensor * p_sensor, double & max_error, const int excluded_link)
+{
+    max_error = 0.0;
+    Matrix Y_specialized, Y_generic;
+    if( !iDynChainRegressorSensorWrenchSpecialized(p_chain,p_sensor,Y_specialized,excluded_link) ) return false;
+
+    //generic implementations
+    bool ret = iDynChainRegressorSensorWrench(p_chain,p_sensor,Y_generic,excluded_link,false);
+    ret = ret && Y_generic.rows() == Y_specialized.rows() && Y_generic.cols() == Y_specialized.cols();
+    for(int i=0; ret && i < Y_generic.rows(); i++ ) {
+        for(int j=0; j < Y_generic.cols(); j++ ) {
+            max_error = max(max_error,fabs(Y_generic(i,j)-Y_specialized(i,j)));
+        }
+    }
+
+    ret = ret && iDynChainRegressorTorquesEstimationSpecialized(p_chain,p_sensor,Y_specialized,excluded_link);
+    ret = ret && iDynChainRegressorTorquesEstimation(p_chain,p_sensor,Y_generic,excluded_link,false);
+    ret = ret && Y_generic.rows() == Y_specialized.rows() && Y_generic.cols() == Y_specialized.cols();
+    for(int i=0; ret && i < Y_generic.rows(); i++ ) {
+        for(int j=0; j < Y_generic.cols(); j++ ) {
+            max_error = max(max_error,fabs(Y_generic(i,j)-Y_specialized(i,j)));
+        }
+    }
+    return ret;
+}
+
 Matrix iCub::iDyn::Regressor::iDynChainRegressorWrenchEstimation(iDynChain * p_chain,iDynSensor * p_sensor,const int link_index, const int excluded_link)
 {
     vector<bool> excluded_links;
@@ -692,7 +1389,7 @@ bool iCub::iDyn::Regressor::iCubLimbGetData(const iCubWholeBody * const icub, co
 			p_chain =  icub->lowerTorso->right->asChain();
 			p_sensor = icub->lowerTorso->rightSensor;
 		}
-		if( limbName== "left_arm" ) {
+		if( limbName== "left_leg" ) {
 			p_chain =  icub->lowerTorso->left->asChain();
 			p_sensor = icub->lowerTorso->leftSensor;
 		}
@@ -0,0 +1,505 @@
+/*
+ * Copyright (C) 2012
+ * Author: Silvio Traversaro
+ * email:
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+// This file is generated by scripts/generateSpecializedRegressors.py, do not edit it directly
+
+#include <iCub/iDyn/iDynRegressor.h>
+
+#include <cmath>
+
+using namespace std;
+
+using namespace yarp::sig;
+
+using namespace iCub::iDyn;
+
+using namespace iCub::iDyn::Regressor;
+
+namespace
+{
+
+//right_arm: links 2..6 with respect to the sensor frame
+void right_arm_transforms(const double * q, double T[][3][4])
+{
+    //link 3
+    {
+        const double c = cos(q[3]);
+        const double s = sin(q[3]);
+        const double ct = c;
+        const double st = s;
+        T[1][0][0] = T[0][0][0]*ct + T[0][0][1]*st;
+        T[1][0][1] = T[0][0][2];
+        T[1][0][2] = T[0][0][0]*st - T[0][0][1]*ct;
+        T[1][0][3] = T[1][0][0]*0.015 + T[0][0][3];
+        T[1][1][0] = T[0][1][0]*ct + T[0][1][1]*st;
+        T[1][1][1] = T[0][1][2];
+        T[1][1][2] = T[0][1][0]*st - T[0][1][1]*ct;
+        T[1][1][3] = T[1][1][0]*0.015 + T[0][1][3];
+        T[1][2][0] = T[0][2][0]*ct + T[0][2][1]*st;
+        T[1][2][1] = T[0][2][2];
+        T[1][2][2] = T[0][2][0]*st - T[0][2][1]*ct;
+        T[1][2][3] = T[1][2][0]*0.015 + T[0][2][3];
+    }
+    //link 4
+    {
+        const double c = cos(q[4]);
+        const double s = sin(q[4]);
+        const double ct = s;
+        const double st = -c;
+        T[2][0][0] = T[1][0][0]*ct + T[1][0][1]*st;
+        T[2][0][1] = T[1][0][2];
+        T[2][0][2] = T[1][0][0]*st - T[1][0][1]*ct;
+        T[2][0][3] = -T[1][0][2]*0.1373 + T[1][0][3];
+        T[2][1][0] = T[1][1][0]*ct + T[1][1][1]*st;
+        T[2][1][1] = T[1][1][2];
+        T[2][1][2] = T[1][1][0]*st - T[1][1][1]*ct;
+        T[2][1][3] = -T[1][1][2]*0.1373 + T[1][1][3];
+        T[2][2][0] = T[1][2][0]*ct + T[1][2][1]*st;
+        T[2][2][1] = T[1][2][2];
+        T[2][2][2] = T[1][2][0]*st - T[1][2][1]*ct;
+        T[2][2][3] = -T[1][2][2]*0.1373 + T[1][2][3];
+    }
+    //link 5
+    {
+        const double c = cos(q[5]);
+        const double s = sin(q[5]);
+        const double ct = -s;
+        const double st = c;
+        T[3][0][0] = T[2][0][0]*ct + T[2][0][1]*st;
+        T[3][0][1] = T[2][0][2];
+        T[3][0][2] = T[2][0][0]*st - T[2][0][1]*ct;
+        T[3][0][3] = T[2][0][3];
+        T[3][1][0] = T[2][1][0]*ct + T[2][1][1]*st;
+        T[3][1][1] = T[2][1][2];
+        T[3][1][2] = T[2][1][0]*st - T[2][1][1]*ct;
+        T[3][1][3] = T[2][1][3];
+        T[3][2][0] = T[2][2][0]*ct + T[2][2][1]*st;
+        T[3][2][1] = T[2][2][2];
+        T[3][2][2] = T[2][2][0]*st - T[2][2][1]*ct;
+        T[3][2][3] = T[2][2][3];
+    }
+    //link 6
+    {
+        const double c = cos(q[6]);
+        const double s = sin(q[6]);
+        const double ct = -c;
+        const double st = -s;
+        T[4][0][0] = T[3][0][0]*ct + T[3][0][1]*st;
+        T[4][0][1] = -T[3][0][0]*st + T[3][0][1]*ct;
+        T[4][0][2] = T[3][0][2];
+        T[4][0][3] = T[4][0][0]*0.0625 + T[3][0][2]*0.016 + T[3][0][3];
+        T[4][1][0] = T[3][1][0]*ct + T[3][1][1]*st;
+        T[4][1][1] = -T[3][1][0]*st + T[3][1][1]*ct;
+        T[4][1][2] = T[3][1][2];
+        T[4][1][3] = T[4][1][0]*0.0625 + T[3][1][2]*0.016 + T[3][1][3];
+        T[4][2][0] = T[3][2][0]*ct + T[3][2][1]*st;
+        T[4][2][1] = -T[3][2][0]*st + T[3][2][1]*ct;
+        T[4][2][2] = T[3][2][2];
+        T[4][2][3] = T[4][2][0]*0.0625 + T[3][2][2]*0.016 + T[3][2][3];
+    }
+}
+
+const double right_arm_dh[7][4] = {
+    {0.0, -0.0, 1.5707963267948966, -1.5707963267948966},
+    {0.0, 0.0, -1.5707963267948966, -1.5707963267948966},
+    {-0.015, -0.15228, -1.5707963267948966, -1.8325957145940461},
+    {0.015, 0.0, 1.5707963267948966, 0.0},
+    {0.0, -0.1373, 1.5707963267948966, -1.5707963267948966},
+    {0.0, 0.0, 1.5707963267948966, 1.5707963267948966},
+    {0.0625, 0.016, 0.0, 3.141592653589793},
+};
+
+//left_arm: links 2..6 with respect to the sensor frame
+void left_arm_transforms(const double * q, double T[][3][4])
+{
+    //link 3
+    {
+        const double c = cos(q[3]);
+        const double s = sin(q[3]);
+        const double ct = c;
+        const double st = s;
+        T[1][0][0] = T[0][0][0]*ct + T[0][0][1]*st;
+        T[1][0][1] = T[0][0][2];
+        T[1][0][2] = T[0][0][0]*st - T[0][0][1]*ct;
+        T[1][0][3] = -T[1][0][0]*0.015 + T[0][0][3];
+        T[1][1][0] = T[0][1][0]*ct + T[0][1][1]*st;
+        T[1][1][1] = T[0][1][2];
+        T[1][1][2] = T[0][1][0]*st - T[0][1][1]*ct;
+        T[1][1][3] = -T[1][1][0]*0.015 + T[0][1][3];
+        T[1][2][0] = T[0][2][0]*ct + T[0][2][1]*st;
+        T[1][2][1] = T[0][2][2];
+        T[1][2][2] = T[0][2][0]*st - T[0][2][1]*ct;
+        T[1][2][3] = -T[1][2][0]*0.015 + T[0][2][3];
+    }
+    //link 4
+    {
+        const double c = cos(q[4]);
+        const double s = sin(q[4]);
+        const double ct = s;
+        const double st = -c;
+        T[2][0][0] = T[1][0][0]*ct + T[1][0][1]*st;
+        T[2][0][1] = T[1][0][2];
+        T[2][0][2] = T[1][0][0]*st - T[1][0][1]*ct;
+        T[2][0][3] = T[1][0][2]*0.1373 + T[1][0][3];
+        T[2][1][0] = T[1][1][0]*ct + T[1][1][1]*st;
+        T[2][1][1] = T[1][1][2];
+        T[2][1][2] = T[1][1][0]*st - T[1][1][1]*ct;
+        T[2][1][3] = T[1][1][2]*0.1373 + T[1][1][3];
+        T[2][2][0] = T[1][2][0]*ct + T[1][2][1]*st;
+        T[2][2][1] = T[1][2][2];
+        T[2][2][2] = T[1][2][0]*st - T[1][2][1]*ct;
+        T[2][2][3] = T[1][2][2]*0.1373 + T[1][2][3];
+    }
+    //link 5
+    {
+        const double c = cos(q[5]);
+        const double s = sin(q[5]);
+        const double ct = -s;
+        const double st = c;
+        T[3][0][0] = T[2][0][0]*ct + T[2][0][1]*st;
+        T[3][0][1] = T[2][0][2];
+        T[3][0][2] = T[2][0][0]*st - T[2][0][1]*ct;
+        T[3][0][3] = T[2][0][3];
+        T[3][1][0] = T[2][1][0]*ct + T[2][1][1]*st;
+        T[3][1][1] = T[2][1][2];
+        T[3][1][2] = T[2][1][0]*st - T[2][1][1]*ct;
+        T[3][1][3] = T[2][1][3];
+        T[3][2][0] = T[2][2][0]*ct + T[2][2][1]*st;
+        T[3][2][1] = T[2][2][2];
+        T[3][2][2] = T[2][2][0]*st - T[2][2][1]*ct;
+        T[3][2][3] = T[2][2][3];
+    }
+    //link 6
+    {
+        const double c = cos(q[6]);
+        const double s = sin(q[6]);
+        const double ct = c;
+        const double st = s;
+        T[4][0][0] = T[3][0][0]*ct + T[3][0][1]*st;
+        T[4][0][1] = -T[3][0][0]*st + T[3][0][1]*ct;
+        T[4][0][2] = T[3][0][2];
+        T[4][0][3] = T[4][0][0]*0.0625 - T[3][0][2]*0.016 + T[3][0][3];
+        T[4][1][0] = T[3][1][0]*ct + T[3][1][1]*st;
+        T[4][1][1] = -T[3][1][0]*st + T[3][1][1]*ct;
+        T[4][1][2] = T[3][1][2];
+        T[4][1][3] = T[4][1][0]*0.0625 - T[3][1][2]*0.016 + T[3][1][3];
+        T[4][2][0] = T[3][2][0]*ct + T[3][2][1]*st;
+        T[4][2][1] = -T[3][2][0]*st + T[3][2][1]*ct;
+        T[4][2][2] = T[3][2][2];
+        T[4][2][3] = T[4][2][0]*0.0625 - T[3][2][2]*0.016 + T[3][2][3];
+    }
+}
+
+const double left_arm_dh[7][4] = {
+    {0.0, 0.0, -1.5707963267948966, 1.5707963267948966},
+    {0.0, 0.0, 1.5707963267948966, -1.5707963267948966},
+    {0.015, 0.15228, -1.5707963267948966, 1.3089969389957472},
+    {-0.015, 0.0, 1.5707963267948966, 0.0},
+    {0.0, 0.1373, 1.5707963267948966, -1.5707963267948966},
+    {0.0, 0.0, 1.5707963267948966, 1.5707963267948966},
+    {0.0625, -0.016, 0.0, 0.0},
+};
+
+//leg_v2: links 1..5 with respect to the sensor frame
+void leg_v2_transforms(const double * q, double T[][3][4])
+{
+    //link 2
+    {
+        const double c = cos(q[2]);
+        const double s = sin(q[2]);
+        const double ct = s;
+        const double st = -c;
+        T[1][0][0] = T[0][0][0]*ct + T[0][0][1]*st;
+        T[1][0][1] = -T[0][0][2];
+        T[1][0][2] = -T[0][0][0]*st + T[0][0][1]*ct;
+        T[1][0][3] = -T[1][0][0]*0.0009175 + T[0][0][2]*0.234545 + T[0][0][3];
+        T[1][1][0] = T[0][1][0]*ct + T[0][1][1]*st;
+        T[1][1][1] = -T[0][1][2];
+        T[1][1][2] = -T[0][1][0]*st + T[0][1][1]*ct;
+        T[1][1][3] = -T[1][1][0]*0.0009175 + T[0][1][2]*0.234545 + T[0][1][3];
+        T[1][2][0] = T[0][2][0]*ct + T[0][2][1]*st;
+        T[1][2][1] = -T[0][2][2];
+        T[1][2][2] = -T[0][2][0]*st + T[0][2][1]*ct;
+        T[1][2][3] = -T[1][2][0]*0.0009175 + T[0][2][2]*0.234545 + T[0][2][3];
+    }
+    //link 3
+    {
+        const double c = cos(q[3]);
+        const double s = sin(q[3]);
+        const double ct = -s;
+        const double st = c;
+        T[2][0][0] = T[1][0][0]*ct + T[1][0][1]*st;
+        T[2][0][1] = T[1][0][0]*st - T[1][0][1]*ct;
+        T[2][0][2] = -T[1][0][2];
+        T[2][0][3] = -T[2][0][0]*0.2005 + T[1][0][3];
+        T[2][1][0] = T[1][1][0]*ct + T[1][1][1]*st;
+        T[2][1][1] = T[1][1][0]*st - T[1][1][1]*ct;
+        T[2][1][2] = -T[1][1][2];
+        T[2][1][3] = -T[2][1][0]*0.2005 + T[1][1][3];
+        T[2][2][0] = T[1][2][0]*ct + T[1][2][1]*st;
+        T[2][2][1] = T[1][2][0]*st - T[1][2][1]*ct;
+        T[2][2][2] = -T[1][2][2];
+        T[2][2][3] = -T[2][2][0]*0.2005 + T[1][2][3];
+    }
+    //link 4
+    {
+        const double c = cos(q[4]);
+        const double s = sin(q[4]);
+        const double ct = c;
+        const double st = s;
+        T[3][0][0] = T[2][0][0]*ct + T[2][0][1]*st;
+        T[3][0][1] = T[2][0][2];
+        T[3][0][2] = T[2][0][0]*st - T[2][0][1]*ct;
+        T[3][0][3] = T[2][0][3];
+        T[3][1][0] = T[2][1][0]*ct + T[2][1][1]*st;
+        T[3][1][1] = T[2][1][2];
+        T[3][1][2] = T[2][1][0]*st - T[2][1][1]*ct;
+        T[3][1][3] = T[2][1][3];
+        T[3][2][0] = T[2][2][0]*ct + T[2][2][1]*st;
+        T[3][2][1] = T[2][2][2];
+        T[3][2][2] = T[2][2][0]*st - T[2][2][1]*ct;
+        T[3][2][3] = T[2][2][3];
+    }
+    //link 5
+    {
+        const double c = cos(q[5]);
+        const double s = sin(q[5]);
+        const double ct = c;
+        const double st = s;
+        T[4][0][0] = T[3][0][0]*ct + T[3][0][1]*st;
+        T[4][0][1] = T[3][0][0]*st - T[3][0][1]*ct;
+        T[4][0][2] = -T[3][0][2];
+        T[4][0][3] = -T[4][0][0]*0.0685 + T[3][0][2]*0.0035 + T[3][0][3];
+        T[4][1][0] = T[3][1][0]*ct + T[3][1][1]*st;
+        T[4][1][1] = T[3][1][0]*st - T[3][1][1]*ct;
+        T[4][1][2] = -T[3][1][2];
+        T[4][1][3] = -T[4][1][0]*0.0685 + T[3][1][2]*0.0035 + T[3][1][3];
+        T[4][2][0] = T[3][2][0]*ct + T[3][2][1]*st;
+        T[4][2][1] = T[3][2][0]*st - T[3][2][1]*ct;
+        T[4][2][2] = -T[3][2][2];
+        T[4][2][3] = -T[4][2][0]*0.0685 + T[3][2][2]*0.0035 + T[3][2][3];
+    }
+}
+
+const double leg_v2_dh[6][4] = {
+    {0.0, 0.0, 1.5707963267948966, 1.5707963267948966},
+    {0.0, 0.0, 1.5707963267948966, 1.5707963267948966},
+    {-0.0009175, 0.234545, -1.5707963267948966, -1.5707963267948966},
+    {-0.2005, 0.0, 3.141592653589793, 1.5707963267948966},
+    {0.0, 0.0, 1.5707963267948966, 0.0},
+    {-0.0685, 0.0035, 3.141592653589793, 0.0},
+};
+
+typedef void (*transformsFunction)(const double * q, double T[][3][4]);
+
+struct specializedChain
+{
+    const char * name;
+    int n_links;
+    int sensor_link;
+    const double (*dh)[4];
+    transformsFunction transforms;
+};
+
+const specializedChain specialized_chains[] = {
+    {"right_arm", 7, 2, right_arm_dh, right_arm_transforms},
+    {"left_arm", 7, 2, left_arm_dh, left_arm_transforms},
+    {"leg_v2", 6, 1, leg_v2_dh, leg_v2_transforms},
+};
+
+const int n_specialized_chains = 3;
+
+const int max_specialized_links = 7;
+
+/**
+ * Return the specialized chain matching the DH parameters and the sensor link of p_chain, 0 if not found
+ */
+const specializedChain * findSpecializedChain(iDynChain * p_chain, iDynSensor * p_sensor)
+{
+    const double tol = 1e-9;
+    const int N = p_chain->getN();
+    const int sensor_link = p_sensor->getSensorLink();
+    for(int i=0; i < n_specialized_chains; i++ ) {
+        const specializedChain & chain = specialized_chains[i];
+        if( chain.n_links != N || chain.sensor_link != sensor_link ) continue;
+        bool match = true;
+        for(int l=sensor_link+1; l < N && match; l++ ) {
+            iCub::iKin::iKinLink & link = (*p_chain)[l];
+            match = fabs(link.getA()-chain.dh[l][0]) < tol &&
+                    fabs(link.getD()-chain.dh[l][1]) < tol &&
+                    fabs(link.getAlpha()-chain.dh[l][2]) < tol &&
+                    fabs(link.getOffset()-chain.dh[l][3]) < tol;
+        }
+        if( match ) return &chain;
+    }
+    return 0;
+}
+
+/**
+ * Compute the transforms of the links sensor_link..N-1 with respect to the sensor frame
+ */
+void computeTransforms(const specializedChain & chain, iDynChain * p_chain, iDynSensor * p_sensor, double T[][3][4])
+{
+    double q[max_specialized_links];
+    for(int l=chain.sensor_link+1; l < chain.n_links; l++ ) {
+        q[l] = (*p_chain)[l].getAng();
+    }
+    //T[0] = SE3inv(p_sensor->getH())
+    const Matrix H_s = p_sensor->getH();
+    for(int r=0; r < 3; r++ ) {
+        for(int c=0; c < 3; c++ ) {
+            T[0][r][c] = H_s(c,r);
+        }
+        T[0][r][3] = -(H_s(0,r)*H_s(0,3)+H_s(1,r)*H_s(1,3)+H_s(2,r)*H_s(2,3));
+    }
+    chain.transforms(q,T);
+}
+
+/**
+ * B = adjointInv(T)^T*N, with N the net wrench regressor of p_link
+ * (same as iDynLinkRegressorNetWrench), removing the structural zeros of N
+ */
+void linkBlock(iDynLink * p_link, const double T[3][4], double B[6][10])
+{
+    const Vector & ddp = p_link->getLinAcc();
+    const Vector & w = p_link->getW();
+    const Vector & dw = p_link->getdW();
+
+    //upper 3x4 block of N (the other columns are zero)
+    double Nf[3][4];
+    Nf[0][0] = ddp[0];                  Nf[1][0] = ddp[1];                  Nf[2][0] = ddp[2];
+    Nf[0][1] = -w[1]*w[1]-w[2]*w[2];    Nf[0][2] = -dw[2]+w[0]*w[1];        Nf[0][3] = dw[1]+w[0]*w[2];
+    Nf[1][1] = dw[2]+w[0]*w[1];         Nf[1][2] = -w[0]*w[0]-w[2]*w[2];    Nf[1][3] = -dw[0]+w[1]*w[2];
+    Nf[2][1] = -dw[1]+w[0]*w[2];        Nf[2][2] = dw[0]+w[1]*w[2];         Nf[2][3] = -w[0]*w[0]-w[1]*w[1];
+
+    //lower 3x10 block of N (the first column is zero)
+    double Nm[3][10];
+    Nm[0][0] = 0.0;         Nm[1][0] = 0.0;         Nm[2][0] = 0.0;
+    Nm[0][1] = 0.0;         Nm[0][2] = ddp[2];      Nm[0][3] = -ddp[1];
+    Nm[1][1] = -ddp[2];     Nm[1][2] = 0.0;         Nm[1][3] = ddp[0];
+    Nm[2][1] = ddp[1];      Nm[2][2] = -ddp[0];     Nm[2][3] = 0.0;
+    Nm[0][4] = dw[0];                Nm[0][5] = dw[1]-w[0]*w[2];      Nm[0][6] = dw[2]+w[0]*w[1];
+    Nm[0][7] = -w[1]*w[2];           Nm[0][8] = w[1]*w[1]-w[2]*w[2];  Nm[0][9] = w[1]*w[2];
+    Nm[1][4] = w[0]*w[2];            Nm[1][5] = dw[0]+w[1]*w[2];      Nm[1][6] = w[2]*w[2]-w[0]*w[0];
+    Nm[1][7] = dw[1];                Nm[1][8] = dw[2]-w[0]*w[1];      Nm[1][9] = -w[0]*w[2];
+    Nm[2][4] = -w[0]*w[1];           Nm[2][5] = w[0]*w[0]-w[1]*w[1];  Nm[2][6] = dw[0]-w[1]*w[2];
+    Nm[2][7] = w[0]*w[1];            Nm[2][8] = dw[1]+w[0]*w[2];      Nm[2][9] = dw[2];
+
+    //adjointInv(T)^T = [R 0; S(p)R R]
+    for(int c=0; c < 4; c++ ) {
+        for(int r=0; r < 3; r++ ) {
+            B[r][c] = T[r][0]*Nf[0][c] + T[r][1]*Nf[1][c] + T[r][2]*Nf[2][c];
+        }
+    }
+    for(int c=4; c < 10; c++ ) {
+        B[0][c] = 0.0;
+        B[1][c] = 0.0;
+        B[2][c] = 0.0;
+    }
+    for(int c=0; c < 10; c++ ) {
+        const double f0 = B[0][c], f1 = B[1][c], f2 = B[2][c];
+        for(int r=0; r < 3; r++ ) {
+            B[3+r][c] = T[r][0]*Nm[0][c] + T[r][1]*Nm[1][c] + T[r][2]*Nm[2][c];
+        }
+        B[3][c] += T[1][3]*f2 - T[2][3]*f1;
+        B[4][c] += T[2][3]*f0 - T[0][3]*f2;
+        B[5][c] += T[0][3]*f1 - T[1][3]*f0;
+    }
+}
+
+int numberOfIdentLinks(const specializedChain & chain, const int excluded_link)
+{
+    const int virtual_links = (excluded_link >= chain.sensor_link && excluded_link < chain.n_links) ? 1 : 0;
+    return chain.n_links-chain.sensor_link-virtual_links;
+}
+
+}
+
+bool iCub::iDyn::Regressor::iDynChainHasSpecializedRegressor(iDynChain * p_chain, iDynSensor * p_sensor)
+{
+    return findSpecializedChain(p_chain,p_sensor) != 0;
+}
+
+bool iCub::iDyn::Regressor::iDynChainRegressorSensorWrenchSpecialized(iDynChain * p_chain, iDynSensor * p_sensor, Matrix & A, const int excluded_link)
+{
+    const specializedChain * p_specialized = findSpecializedChain(p_chain,p_sensor);
+    if( !p_specialized ) return false;
+    const specializedChain & chain = *p_specialized;
+    if( excluded_link >= chain.n_links ) return false;
+
+    const int n_cols = 10*numberOfIdentLinks(chain,excluded_link);
+    if( A.rows() != 6 || A.cols() != n_cols ) {
+        A.resize(6,n_cols);
+    }
+
+    double T[max_specialized_links][3][4];
+    double B[6][10];
+    computeTransforms(chain,p_chain,p_sensor,T);
+    int start_col = 0;
+    for(int link_index=chain.sensor_link; link_index < chain.n_links; link_index++ ) {
+        if( link_index == excluded_link ) continue;
+        linkBlock((iDynLink *) &((*p_chain)[link_index]),T[link_index-chain.sensor_link],B);
+        for(int r=0; r < 6; r++ ) {
+            double * A_row = A[r]+start_col;
+            for(int c=0; c < 10; c++ ) {
+                A_row[c] = B[r][c];
+            }
+        }
+        start_col += 10;
+    }
+    return true;
+}
+
+bool iCub::iDyn::Regressor::iDynChainRegressorTorquesEstimationSpecialized(iDynChain * p_chain, iDynSensor * p_sensor, Matrix & A, const int excluded_link)
+{
+    const specializedChain * p_specialized = findSpecializedChain(p_chain,p_sensor);
+    if( !p_specialized ) return false;
+    const specializedChain & chain = *p_specialized;
+    if( excluded_link >= chain.n_links ) return false;
+
+    const int n_rows = chain.n_links-chain.sensor_link-1;
+    const int n_cols = 10*numberOfIdentLinks(chain,excluded_link);
+    if( A.rows() != n_rows || A.cols() != n_cols ) {
+        A.resize(n_rows,n_cols);
+    }
+    A.zero();
+
+    double T[max_specialized_links][3][4];
+    double B[6][10];
+    computeTransforms(chain,p_chain,p_sensor,T);
+    int start_col = 0;
+    for(int link_index=chain.sensor_link; link_index < chain.n_links-1; link_index++ ) {
+        if( link_index == excluded_link ) continue;
+        linkBlock((iDynLink *) &((*p_chain)[link_index]),T[link_index-chain.sensor_link],B);
+        //torque of the joint i is the z component of the moment in the frame i-1, for i-1 >= link_index
+        for(int joint_link=link_index; joint_link < chain.n_links-1; joint_link++ ) {
+            const double (*H)[4] = T[joint_link-chain.sensor_link];
+            const double z0 = H[0][2], z1 = H[1][2], z2 = H[2][2];
+            //z x o, with o the origin of the joint frame
+            const double b0 = z1*H[2][3]-z2*H[1][3];
+            const double b1 = z2*H[0][3]-z0*H[2][3];
+            const double b2 = z0*H[1][3]-z1*H[0][3];
+            double * A_row = A[joint_link-chain.sensor_link]+start_col;
+            for(int c=0; c < 10; c++ ) {
+                A_row[c] = -(z0*B[3][c]+z1*B[4][c]+z2*B[5][c]) + (b0*B[0][c]+b1*B[1][c]+b2*B[2][c]);
+            }
+        }
+        start_col += 10;
+    }
+    return true;
+}
@@ -26,6 +26,27 @@ using namespace yarp::math;
 using namespace iCub::iKin;
 using namespace iCub::iDyn;
 
+// compare the first n joint angles of the chain with the cached ones, and update the cache
+// return true if the angles (or their number) changed
+static bool isJointsChanged(iKinChain *chain, unsigned int n, Vector &q)
+{
+	if(n>chain->getDOF())
+		n=chain->getDOF();
+	bool changed=(q.size()!=n);
+	if(changed)
+		q.resize(n);
+	for(unsigned int i=0; i<n; i++)
+	{
+		double qi=(*chain)(i).getAng();
+		if(changed || q[i]!=qi)
+		{
+			q[i]=qi;
+			changed=true;
+		}
+	}
+	return changed;
+}
+
 //////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////
@@ -57,20 +78,24 @@ void iGenericFrame::initFTransform()
 	R=eye(3,3);
 	H=eye(4,4);
 	FT=0.0;
+	version=1;
 }
 void iGenericFrame::setR(const Matrix &_R)
 {
 	R=_R;
+	version++;
 }
 void iGenericFrame::setP(double _x, double _y, double _z)
 {
 	p(0)=_x;
 	p(1)=_y;
 	p(2)=_z;
+	version++;
 }
 void iGenericFrame::setP(const Vector &_p)
 {
 	p=_p;
+	version++;
 }
 
 void iGenericFrame::setPRH(const Matrix &_H)
@@ -85,6 +110,7 @@ void iGenericFrame::setPRH()
 	for(int i=0;i<3;i++)
 		p(i)=H(i,3);
 	R=H.submatrix(0,2,0,2);
+	version++;
 }
 void iGenericFrame::setPRH(const Matrix &_R,const Vector &_p)
 {
@@ -100,6 +126,7 @@ void iGenericFrame::setH(const Matrix &_R, double _x, double _y, double _z)
 	H(0,3)=_x;
 	H(1,3)=_y;
 	H(2,3)=_z;
+	version++;
 }
 void iGenericFrame::setH(const Matrix &_R, const Vector &_p)
 {
@@ -112,6 +139,7 @@ void iGenericFrame::setH(const Matrix &_R, const Vector &_p)
 		}
 		H(i,3)=_p(i);
 	}
+	version++;
 }
 void iGenericFrame::setH(const Matrix &_H)
 {
@@ -119,6 +147,7 @@ void iGenericFrame::setH(const Matrix &_H)
 	for(int i=0;i<3;i++)
 		p(i)=_H(i,3);
 	H=_H;
+	version++;
 }
 yarp::sig::Vector iGenericFrame::setFT(const Vector &_FT)
 {
@@ -150,12 +179,28 @@ void iFrameOnLink::initSFrame()
 	Sensor=0;
 	Limb=0;
 	Link=new iGenericFrame();
+	version=1;
+	kinValid=false;
+	lCache=-1;
+	sensorVersionCache=0;
 }
 
 void iFrameOnLink::setLink(int _l)
 {
 	l=_l;
 }
+
+bool iFrameOnLink::isSensorKinChanged(int _l)
+{
+	// isJointsChanged is always called, to keep the cached angles updated
+	bool changed=isJointsChanged(Limb,_l+1,qCache);
+	if(!kinValid || _l!=lCache || Sensor->getVersion()!=sensorVersionCache)
+		changed=true;
+	kinValid=true;
+	lCache=_l;
+	sensorVersionCache=Sensor->getVersion();
+	return changed;
+}
 void iFrameOnLink::setFT(const yarp::sig::Vector &_FT)
 {
 	FT=Sensor->setFT(_FT);
@@ -164,22 +209,25 @@ void iFrameOnLink::setFT(const yarp::sig::Vector &_FT)
 
 void iFrameOnLink::setSensorKin(int _l)
 {
+	if(!isSensorKinChanged(_l))
+		return;
 	Link->setPRH(Limb->getH(_l));
 	H=Link->getH()*Sensor->getH();
+	version++;
 }
 
 void iFrameOnLink::setSensorKin()
 {	
-	Link->setPRH(Limb->getH(l));
-	Matrix H1 = Link->getH();
-	Matrix H2 = Sensor->getH();
-	H=Link->getH()*Sensor->getH();
+	setSensorKin(l);
 }
 
 void iFrameOnLink::setSensorKin(const Matrix &_H)
 {
+	// the link H is given explicitly: the cache of the chain kinematics is no more valid
+	kinValid=false;
 	Link->setPRH(_H);
 	H=_H*Sensor->getH();
+	version++;
 }
 
 void iFrameOnLink::setSensor(int _l, const yarp::sig::Vector &_FT)
@@ -212,11 +260,13 @@ Matrix iFrameOnLink::getH()
 void iFrameOnLink::attach(iKinChain *_Limb)
 {	
 	Limb=_Limb;
+	kinValid=false;
 }
 
 void iFrameOnLink::attach(iGenericFrame *_Sensor)
 {
 	Sensor=_Sensor;
+	kinValid=false;
 }
 
 iFrameOnLink::~iFrameOnLink()
@@ -270,6 +320,7 @@ void iFTransformation::attach(iKinChain *_Limb)
 	Limb=_Limb;
 	Sensor->attach(_Limb);
     ownLimb=false;
+	heValid=false;
 }
 void iFTransformation::attach(iGenericFrame *_Sensor)
 {    
@@ -302,6 +353,32 @@ void iFTransformation::initiFTransformation()
 	R=0.0;
 
 	SensorFrame=0;
+
+	hsVersion=1;
+	heVersion=1;
+	sensorVersionCache=0;
+	heValid=false;
+	hsVersionTse=0;
+	heVersionTse=0;
+	heVersionTeb=0;
+}
+void iFTransformation::invalidate()
+{
+	Sensor->invalidate();
+	heValid=false;
+	hsVersionTse=0;
+	heVersionTse=0;
+	heVersionTeb=0;
+}
+void iFTransformation::updateHs()
+{
+	// Hs is copied only if the sensor transformation was recomputed
+	if(Sensor->getVersion()!=sensorVersionCache)
+	{
+		Hs=Sensor->getH();
+		sensorVersionCache=Sensor->getVersion();
+		hsVersion++;
+	}
 }
 void iFTransformation::setLink(int _l)
 {
@@ -312,39 +389,52 @@ void iFTransformation::setSensor(const Vector &_FT)
 {
 	Fs=_FT;	
 	Sensor->setSensor(_FT);
-	Hs=Sensor->getH();
+	updateHs();
 }
 void iFTransformation::setSensor(int _l, const Vector &_FT)
 {
 	Fs=_FT;
 	l=_l;
 	Sensor->setSensor(_l, _FT);
-	Hs=Sensor->getH();
+	updateHs();
 }
 void iFTransformation::setSensor(const Matrix &_H, const Vector &_FT)
 {
 	Fs=_FT;
 	Sensor->setSensor(_H, _FT);
-	Hs=Sensor->getH();
+	updateHs();
 }
 void iFTransformation::setHe()
 {
-	EndEffector->setH(Limb->getH());
-	He=EndEffector->getH();
+	// the end effector depends on all the joints of the chain
+	if(isJointsChanged(Limb,Limb->getDOF(),qeCache) || !heValid)
+	{
+		EndEffector->setH(Limb->getH());
+		He=EndEffector->getH();
+		heVersion++;
+		heValid=true;
+	}
 }
 void iFTransformation::setHe(int _l)
 {
+	heValid=false;
 	EndEffector->setH(Limb->getH(_l));
 	He=EndEffector->getH();
+	heVersion++;
 }
 void iFTransformation::setHe(const Matrix &_H)
 {
+	heValid=false;
 	EndEffector->setH(_H);
 	He=EndEffector->getH();
+	heVersion++;
 }
 void iFTransformation::setTeb()
 {
 	setHe();
+	if(heVersion==heVersionTeb)
+		return;
+	heVersionTeb=heVersion;
 	for(int i=0;i<3;i++)
 	{
 		for(int j=0; j<3; j++)
@@ -382,6 +472,10 @@ void iFTransformation::setFe()
 }
 void iFTransformation::setTse()
 {	
+	if(hsVersion==hsVersionTse && heVersion==heVersionTse)
+		return;
+	hsVersionTse=hsVersion;
+	heVersionTse=heVersion;
 	S=0.0;
 	Tse=0.0;
 	R=0.0;
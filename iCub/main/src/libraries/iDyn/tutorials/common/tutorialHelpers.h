@@ -0,0 +1,116 @@
+/**
+* Copyright: 2012
+* Author: Silvio Traversaro
+* CopyPolicy: Released under the terms of the GNU GPL v2.0.
+**/
+
+//
+// Helpers shared by the iDyn tutorials that check an implementation against
+// another one: random states of the iCub, differences between the results and
+// a tolerance check that decides the exit code of the tutorial
+//
+
+#ifndef IDYN_TUTORIAL_HELPERS
+#define IDYN_TUTORIAL_HELPERS
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <iCub/iDyn/iDynBody.h>
+
+namespace tutorial
+{
+
+// random number in [-range,range]
+inline double randomDouble(double range)
+{
+    return range*(2.0*rand()/RAND_MAX-1.0);
+}
+
+// random vector with elements in [-range,range]
+inline yarp::sig::Vector randomVector(int n, double range)
+{
+    yarp::sig::Vector v(n);
+    for(int i=0; i < n; i++ ) {
+        v[i] = randomDouble(range);
+    }
+    return v;
+}
+
+// random matrix with elements in [-range,range]
+inline yarp::sig::Matrix randomMatrix(int r, int c, double range)
+{
+    yarp::sig::Matrix M(r,c);
+    for(int i=0; i < r; i++ ) {
+        for(int j=0; j < c; j++ ) {
+            M(i,j) = randomDouble(range);
+        }
+    }
+    return M;
+}
+
+// maximum absolute difference between two vectors, infinite if the sizes are different
+inline double maxDifference(const yarp::sig::Vector & a, const yarp::sig::Vector & b)
+{
+    if( a.size() != b.size() ) return HUGE_VAL;
+    double max_diff = 0.0;
+    for(int i=0; i < (int)a.size(); i++ ) {
+        max_diff = std::max(max_diff,fabs(a[i]-b[i]));
+    }
+    return max_diff;
+}
+
+// maximum absolute difference between two matrices, infinite if the sizes are different
+inline double maxDifference(const yarp::sig::Matrix & A, const yarp::sig::Matrix & B)
+{
+    if( A.rows() != B.rows() || A.cols() != B.cols() ) return HUGE_VAL;
+    double max_diff = 0.0;
+    for(int r=0; r < A.rows(); r++ ) {
+        for(int c=0; c < A.cols(); c++ ) {
+            max_diff = std::max(max_diff,fabs(A(r,c)-B(r,c)));
+        }
+    }
+    return max_diff;
+}
+
+// set a random state for all the limbs, and compute the kinematics of the
+// upper torso and of the attached lower torso
+inline void setRandomState(iCub::iDyn::iCubWholeBody & icub)
+{
+    const std::string upperLimbs[3] = {"right_arm","left_arm","head"};
+    const std::string lowerLimbs[3] = {"right_leg","left_leg","torso"};
+    for(int l=0; l < 3; l++ ) {
+        int n = icub.upperTorso->getAng(upperLimbs[l]).size();
+        icub.upperTorso->setAng(upperLimbs[l],randomVector(n,1.0));
+        icub.upperTorso->setDAng(upperLimbs[l],randomVector(n,2.0));
+        icub.upperTorso->setD2Ang(upperLimbs[l],randomVector(n,5.0));
+        n = icub.lowerTorso->getAng(lowerLimbs[l]).size();
+        icub.lowerTorso->setAng(lowerLimbs[l],randomVector(n,1.0));
+        icub.lowerTorso->setDAng(lowerLimbs[l],randomVector(n,2.0));
+        icub.lowerTorso->setD2Ang(lowerLimbs[l],randomVector(n,5.0));
+    }
+    yarp::sig::Vector ddp0 = randomVector(3,1.0);
+    ddp0[2] += 9.81;
+    icub.upperTorso->setInertialMeasure(randomVector(3,1.0),randomVector(3,1.0),ddp0);
+    icub.upperTorso->solveKinematics();
+    icub.attachLowerTorso(yarp::sig::Vector(6,0.0),yarp::sig::Vector(6,0.0));
+    icub.lowerTorso->solveKinematics();
+}
+
+// print the result of a check, return true if error is not greater than tolerance
+inline bool checkError(const std::string & what, double error, double tolerance)
+{
+    bool ok = error <= tolerance;
+    std::cout << std::setw(40) << std::left << what << std::right << " max error " << std::setw(12) << error
+              << (ok ? "  ok" : "  FAILED") << " (tolerance " << tolerance << ")" << std::endl;
+    return ok;
+}
+
+}
+
+#endif
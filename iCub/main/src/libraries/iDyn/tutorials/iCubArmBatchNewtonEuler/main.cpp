@@ -0,0 +1,106 @@
+/**
+* Copyright: 2012
+* Author: Silvio Traversaro
+* CopyPolicy: Released under the terms of the GNU GPL v2.0.
+**/
+
+//
+// An example of the use of BatchChainNewtonEuler: the joint torques, the base wrench
+// and the wrench measured by the F/T sensor of the right arm are computed for many
+// random configurations at once, and compared with the ones computed one configuration
+// at a time by the Newton-Euler of the iDynChain (torques and base wrench) and by
+// the sensor wrench regressor. The time needed by the batch and by the iDynChain is
+// measured. The tutorial exits with 1 if an output differs by more than a tolerance
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynInv.h>
+#include <iCub/iDyn/iDynRegressor.h>
+
+#include "tutorialHelpers.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::iDyn;
+using namespace iCub::iDyn::Regressor;
+using namespace tutorial;
+
+////////////////
+//   MAIN
+///////////////
+
+int main()
+{
+    const int n_configurations = 10000;
+    srand(0);
+
+    iCubArmDyn arm("right");
+    iDynChain * p_chain = arm.asChain();
+    iDynSensorArm sensor(&arm,DYNAMIC);
+    const int dof = p_chain->getDOF();
+    const int n = p_chain->getN();
+    const int sensor_link = sensor.getSensorLink();
+    const double tolerance = 1e-9;
+
+    Matrix q = randomMatrix(n_configurations,dof,1.0);
+    Matrix dq = randomMatrix(n_configurations,dof,2.0);
+    Matrix ddq = randomMatrix(n_configurations,dof,5.0);
+    Matrix kinBase = randomMatrix(n_configurations,9,1.0);
+    for(int k=0; k < n_configurations; k++ ) {
+        kinBase(k,8) += 9.81;
+    }
+
+    // all the configurations at once
+    BatchChainNewtonEuler batch(p_chain);
+    Matrix tau, FMbase, FMsensor;
+    double t0 = Time::now();
+    batch.computeNewtonEuler(q,dq,ddq,kinBase,tau,FMbase);
+    double t_batch = Time::now()-t0;
+    batch.computeNewtonEuler(q,dq,ddq,kinBase,tau,FMbase,sensor_link,sensor.getH(),FMsensor);
+
+    // one configuration at a time
+    // (the parameters of the links after the sensor are the ones used by the batch)
+    const Vector phi_sensor = batch.getParameters().subVector(10*sensor_link,10*n-1);
+    p_chain->prepareNewtonEuler(DYNAMIC);
+    double tau_error = 0.0, base_error = 0.0, sensor_error = 0.0;
+    double t_sequential = 0.0;
+    Matrix Y;
+    for(int k=0; k < n_configurations; k++ ) {
+        p_chain->setAng(q.getRow(k));
+        p_chain->setDAng(dq.getRow(k));
+        p_chain->setD2Ang(ddq.getRow(k));
+        Vector kb = kinBase.getRow(k);
+        t0 = Time::now();
+        p_chain->computeNewtonEuler(kb.subVector(0,2),kb.subVector(3,5),kb.subVector(6,8),zeros(3),zeros(3));
+        Vector tau_k = p_chain->getTorques();
+        t_sequential += Time::now()-t0;
+        tau_error = max(tau_error,maxDifference(tau_k,tau.getRow(k)));
+
+        Vector FMbase_k = cat(p_chain->getForcesNewtonEuler().getCol(0),p_chain->getMomentsNewtonEuler().getCol(0));
+        base_error = max(base_error,maxDifference(FMbase_k,FMbase.getRow(k)));
+
+        iDynChainRegressorSensorWrench(p_chain,&sensor,Y);
+        sensor_error = max(sensor_error,maxDifference(Y*phi_sensor,FMsensor.getRow(k)));
+    }
+
+    cout << "right_arm, " << n_configurations << " configurations" << endl;
+    int failures = 0;
+    if( !checkError("joint torques",tau_error,tolerance) ) failures++;
+    if( !checkError("base wrench",base_error,tolerance) ) failures++;
+    if( !checkError("sensor wrench",sensor_error,tolerance) ) failures++;
+    cout << "batch " << 1e6*t_batch/n_configurations << " us"
+         << ", sequential " << 1e6*t_sequential/n_configurations << " us"
+         << ", speedup " << t_sequential/t_batch << endl;
+
+    return failures ? 1 : 0;
+}
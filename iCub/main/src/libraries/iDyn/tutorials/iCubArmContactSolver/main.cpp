@@ -0,0 +1,237 @@
+/**
+* Copyright: 2012
+* Author: Silvio Traversaro
+* CopyPolicy: Released under the terms of the GNU GPL v2.0.
+**/
+
+//
+// A check of the solution of the contact system of iDynContactSolver and of
+// its live parameters.
+// First the Cholesky solve of solveContactSystem is compared with the
+// pseudoinverse solution (least squares, minimum norm) for well conditioned
+// and rank deficient systems of 6 equations, over and underdetermined, and the
+// time of the two solves is measured.
+// Then the contacts on the right arm estimated with the live parameters are
+// compared with the ones estimated with the parameters of the links: the live
+// parameters are the inertial parameters of the links after the sensor, published
+// before enabling them, after a reset of the basis, twice before a single
+// estimation (the last one must be used) and, with an offset of the sensor,
+// from another thread while the contacts are estimated.
+// The tutorial exits with 1 if a check fails
+//
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <yarp/os/Time.h>
+#include <yarp/os/Thread.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <yarp/math/SVD.h>
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynInv.h>
+#include <iCub/iDyn/iDynContact.h>
+#include <iCub/iDyn/iDynRegressor.h>
+
+#include "tutorialHelpers.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::iDyn;
+using namespace iCub::iDyn::Regressor;
+using namespace iCub::skinDynLib;
+using namespace tutorial;
+
+// access to the solve of the contact system, with the buffers set up as buildA
+// does for a contact set with A.cols() unknowns
+class contactSystemSolver : public iDynContactSolver
+{
+public:
+    contactSystemSolver(iDynChain * chain) : iDynContactSolver(chain) {}
+
+    Vector solve(const Matrix & A, const Vector & B)
+    {
+        cachedNormal = A.cols() <= 6;
+        const int n = cachedNormal ? A.cols() : 6;
+        cachedM.resize(n,n);
+        return solveContactSystem(A,B);
+    }
+};
+
+// publishes the same live parameters until stopped
+class liveParametersWriter : public Thread
+{
+    iDynContactSolver * solver;
+    Vector params;
+public:
+    volatile int published;
+
+    liveParametersWriter(iDynContactSolver * _solver, const Vector & _params) : solver(_solver), params(_params), published(0) {}
+
+    virtual void run()
+    {
+        while( !isStopping() ) {
+            if( solver->publishLiveParameters(params) ) published++;
+            Time::delay(0.0001);
+        }
+    }
+};
+
+// relative difference of the solutions, with respect to the largest element of the reference
+double relativeDifference(const Vector & x, const Vector & x_ref)
+{
+    double norm = 1.0;
+    for(int i=0; i < (int)x_ref.size(); i++ ) {
+        norm = max(norm,fabs(x_ref[i]));
+    }
+    return maxDifference(x,x_ref)/norm;
+}
+
+// wrenches of all the contacts of the solver, in a single vector
+Vector contactWrenches(iDynContactSolver & solver, const Vector & FMsens)
+{
+    const dynContactList & contacts = solver.computeExternalContacts(FMsens);
+    Vector wrenches;
+    for(dynContactList::const_iterator it = contacts.begin(); it != contacts.end(); it++ ) {
+        wrenches = cat(wrenches,cat(it->getForce(),it->getMoment()));
+    }
+    return wrenches;
+}
+
+////////////////
+//   MAIN
+///////////////
+
+int main()
+{
+    srand(0);
+    int failures = 0;
+
+    // SOLVE OF THE CONTACT SYSTEM
+    iCubArmNoTorsoDyn system_arm("right");
+    contactSystemSolver system_solver(system_arm.asChain());
+    const int n_systems = 1000;
+    const double system_tolerance = 1e-8;
+    const int n_unknowns[5] = {1, 3, 6, 9, 12};
+    for(int u=0; u < 5; u++ ) {
+        for(int deficient=0; deficient < 2; deficient++ ) {
+            const int n = n_unknowns[u];
+            // the rank deficient systems have rank n-1 (or 5 if underdetermined)
+            const int rank = min(n,6)-1;
+            if( deficient && rank < 1 ) continue;
+            double error = 0.0, t_cholesky = 0.0, t_pinv = 0.0;
+            for(int k=0; k < n_systems; k++ ) {
+                Matrix A = randomMatrix(6,n,1.0);
+                if( deficient ) {
+                    A = randomMatrix(6,rank,1.0)*randomMatrix(rank,n,1.0);
+                }
+                Vector B = randomVector(6,1.0);
+                double t0 = Time::now();
+                Vector X = system_solver.solve(A,B);
+                t_cholesky += Time::now()-t0;
+                t0 = Time::now();
+                Vector X_ref = pinv(A,TOLLERANCE)*B;
+                t_pinv += Time::now()-t0;
+                error = max(error,relativeDifference(X,X_ref));
+            }
+            char name[64];
+            sprintf(name,"6x%d system%s",n,deficient ? " (rank deficient)" : "");
+            if( !checkError(name,error,system_tolerance) ) failures++;
+            cout << "    cholesky " << 1e6*t_cholesky/n_systems << " us, pinv " << 1e6*t_pinv/n_systems << " us" << endl;
+        }
+    }
+
+    // LIVE PARAMETERS
+    iCubArmNoTorsoDyn arm("right");
+    iDynChain * p_chain = arm.asChain();
+    const unsigned int sensor_link = 2;
+    iDynContactSolver solver(p_chain,sensor_link,new iCubArmSensorLink("right",DYNAMIC),"rightArmContactSolver",DYNAMIC,RIGHT_ARM);
+    const int n_configurations = 100;
+    const double live_tolerance = 1e-7;
+    // a wrench on the forearm (square system), then also one on the hand (underdetermined system)
+    const unsigned int contact_links[2] = {4, 6};
+    double error_not_published = 0.0, error_live = 0.0, error_last = 0.0, error_offset = 0.0, error_reset = 0.0, error_thread = 0.0;
+    int published = 0;
+    p_chain->prepareNewtonEuler(DYNAMIC);
+    bool wrong_size_rejected = true;
+    for(int c=0; c < 2; c++ ) {
+        solver.clearContactList();
+        for(int i=0; i <= c; i++ ) {
+            solver.addContact(dynContact(RIGHT_ARM,contact_links[i],randomVector(3,0.05)));
+        }
+        for(int k=0; k < n_configurations; k++ ) {
+            p_chain->setAng(randomVector(p_chain->getDOF(),1.0));
+            p_chain->setDAng(randomVector(p_chain->getDOF(),2.0));
+            p_chain->setD2Ang(randomVector(p_chain->getDOF(),5.0));
+            Vector ddp0 = randomVector(3,1.0);
+            ddp0[2] += 9.81;
+            p_chain->initNewtonEuler(randomVector(3,1.0),randomVector(3,1.0),ddp0,zeros(3),zeros(3));
+            Vector FMsens = randomVector(6,2.0);
+            Vector offset = randomVector(6,0.5);
+
+            // parameters of the links after the sensor, with the identity basis
+            Vector beta;
+            iDynChainGetBeta(p_chain,&solver,beta,-1);
+            const Vector no_offset(6,0.0);
+
+            solver.setLiveParametersEnabled(false);
+            solver.setLiveParametersBasis(eye(beta.size(),beta.size()),true);
+            Vector X_ref = contactWrenches(solver,FMsens);
+
+            solver.setLiveParametersEnabled(true);
+            error_not_published = max(error_not_published,relativeDifference(contactWrenches(solver,FMsens),X_ref));
+
+            solver.publishLiveParameters(cat(beta,no_offset));
+            error_live = max(error_live,relativeDifference(contactWrenches(solver,FMsens),X_ref));
+
+            // the offset is subtracted from the measure
+            solver.publishLiveParameters(cat(beta,offset));
+            Vector X_offset = contactWrenches(solver,FMsens);
+            solver.setLiveParametersEnabled(false);
+            error_offset = max(error_offset,relativeDifference(X_offset,contactWrenches(solver,FMsens-offset)));
+            solver.setLiveParametersEnabled(true);
+
+            // only the last parameters published before an estimation are used
+            solver.publishLiveParameters(cat(beta,offset));
+            solver.publishLiveParameters(cat(beta,no_offset));
+            error_last = max(error_last,relativeDifference(contactWrenches(solver,FMsens),X_ref));
+
+            wrong_size_rejected = wrong_size_rejected && !solver.publishLiveParameters(beta);
+
+            // a new basis discards the published parameters
+            solver.setLiveParametersBasis(eye(beta.size(),beta.size()),true);
+            error_reset = max(error_reset,relativeDifference(contactWrenches(solver,FMsens),X_ref));
+
+            // parameters published by another thread during the estimation
+            liveParametersWriter writer(&solver,cat(beta,offset));
+            writer.start();
+            while( writer.published == 0 ) {
+                Time::delay(0.0001);
+            }
+            for(int r=0; r < 10; r++ ) {
+                error_thread = max(error_thread,relativeDifference(contactWrenches(solver,FMsens),X_offset));
+            }
+            writer.stop();
+            published += writer.published;
+        }
+        cout << "right_arm, " << c+1 << " wrench contacts, " << n_configurations << " configurations" << endl;
+        if( !checkError("live parameters not published",error_not_published,live_tolerance) ) failures++;
+        if( !checkError("live parameters",error_live,live_tolerance) ) failures++;
+        if( !checkError("live parameters with offset",error_offset,live_tolerance) ) failures++;
+        if( !checkError("last published live parameters",error_last,live_tolerance) ) failures++;
+        if( !checkError("live parameters after a new basis",error_reset,live_tolerance) ) failures++;
+        if( !checkError("live parameters from a thread",error_thread,live_tolerance) ) failures++;
+    }
+    cout << published << " live parameters published by the writer threads" << endl;
+    if( !wrong_size_rejected ) {
+        cout << "live parameters of the wrong size accepted  FAILED" << endl;
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
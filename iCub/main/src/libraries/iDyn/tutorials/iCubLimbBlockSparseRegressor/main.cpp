@@ -0,0 +1,147 @@
+/**
+* Copyright: 2012
+* Author: Silvio Traversaro
+* CopyPolicy: Released under the terms of the GNU GPL v2.0.
+**/
+
+//
+// A check of the BlockSparseRegressor of the complete regressor of the iCub
+// limbs: in some random configurations the regressor computed by
+// iCubLimbRegressorCompleteBlockSparse (overwriting the same blocks) is
+// compared with the dense one of iCubLimbRegressorComplete, and multiply,
+// project and addGram with the corresponding dense products.
+// Then the parameters estimated by a MultiTaskLinearGPRLearner fed with the
+// sensor rows of the regressor (using its cached pattern of the non zeros)
+// are compared with the solution of the dense normal equations.
+// The tutorial exits with 1 if a check fails
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <yarp/math/SVD.h>
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynBody.h>
+#include <iCub/iDyn/iDynRegressor.h>
+#include <iCub/learningMachine/MultiTaskLinearGPRLearner.h>
+
+#include "tutorialHelpers.h"
+
+using namespace std;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::iDyn;
+using namespace iCub::iDyn::Regressor;
+using namespace iCub::learningmachine;
+using namespace tutorial;
+
+////////////////
+//   MAIN
+///////////////
+
+int main()
+{
+    version_tag icub_type;
+    iCubWholeBody icub(icub_type,DYNAMIC,iCub::skinDynLib::NO_VERBOSE);
+
+    const int n_configurations = 200;
+    const double tolerance = 1e-8;
+    const double learner_tolerance = 1e-6;
+    int failures = 0;
+    const string limbNames[4] = {"right_arm","left_arm","right_leg","left_leg"};
+
+    for(int l=0; l < 4; l++ ) {
+        for(int v=0; v < 2; v++ ) {
+            const bool consider_virtual_link = ( v == 1 );
+            const string name = limbNames[l] + ( consider_virtual_link ? " (virtual link)" : "" );
+
+            BlockSparseRegressor Y;
+            Matrix Y_dense, Phi, G;
+            Vector y;
+            double regressor_error = 0.0, multiply_error = 0.0, project_error = 0.0, gram_error = 0.0;
+
+            // learner with a prior on the parameters, so that the Cholesky factor is updated from the first sample
+            MultiTaskLinearGPRLearner * learner = 0;
+            Vector noise_std(6), beta;
+            for(int r=0; r < 6; r++ ) {
+                noise_std[r] = r < 3 ? 0.5 : 0.05;
+            }
+            const double weight_std = 10.0;
+            Matrix A_ref;
+            Vector b_ref;
+
+            for(int i=0; i < n_configurations; i++ ) {
+                setRandomState(icub);
+                if( !iCubLimbRegressorCompleteBlockSparse(&icub,limbNames[l],Y,consider_virtual_link) ) {
+                    cout << name << ": iCubLimbRegressorCompleteBlockSparse failed" << endl;
+                    failures++;
+                    break;
+                }
+                iCubLimbRegressorComplete(&icub,limbNames[l],Phi,consider_virtual_link);
+                Y.toDense(Y_dense);
+                regressor_error = max(regressor_error,maxDifference(Y_dense,Phi));
+
+                Vector phi = randomVector(Phi.cols(),1.0);
+                Y.multiply(phi,y);
+                multiply_error = max(multiply_error,maxDifference(y,Vector(Phi*phi)));
+
+                Matrix basis = randomMatrix(Phi.cols(),5,1.0);
+                Matrix Y_projected;
+                Y.project(basis,Y_projected,6);
+                project_error = max(project_error,maxDifference(Y_projected,Matrix(Phi.submatrix(6,Phi.rows()-1,0,Phi.cols()-1)*basis)));
+
+                G = zeros(Phi.cols(),Phi.cols());
+                Y.addGram(0,Phi.rows()-1,G);
+                gram_error = max(gram_error,maxDifference(G,Matrix(Phi.transposed()*Phi)));
+
+                // the sensor rows of the regressor, with the wrench of some random parameters
+                Matrix Phi_sensor = Phi.submatrix(0,5,0,Phi.cols()-1);
+                if( learner == 0 ) {
+                    learner = new MultiTaskLinearGPRLearner(Phi.cols(),6);
+                    learner->setNoiseStandardDeviation(noise_std);
+                    learner->setWeightsStandardDeviation(Vector(Phi.cols(),weight_std));
+                    beta = randomVector(Phi.cols(),1.0);
+                    A_ref = (1.0/(weight_std*weight_std))*eye(Phi.cols(),Phi.cols());
+                    b_ref = zeros(Phi.cols());
+                }
+                Vector wrench = Phi_sensor*beta;
+                for(int r=0; r < 6; r++ ) {
+                    wrench[r] += noise_std[r]*randomDouble(1.0);
+                }
+                learner->feedSample(Phi_sensor,wrench);
+                for(int r=0; r < 6; r++ ) {
+                    const double weight = 1.0/(noise_std[r]*noise_std[r]);
+                    for(int j=0; j < Phi_sensor.cols(); j++ ) {
+                        for(int k=0; k < Phi_sensor.cols(); k++ ) {
+                            A_ref(j,k) += weight*Phi_sensor(r,j)*Phi_sensor(r,k);
+                        }
+                        b_ref[j] += weight*wrench[r]*Phi_sensor(r,j);
+                    }
+                }
+            }
+            if( !checkError(name+" regressor",regressor_error,tolerance) ) failures++;
+            if( !checkError(name+" multiply",multiply_error,tolerance) ) failures++;
+            if( !checkError(name+" project",project_error,tolerance) ) failures++;
+            if( !checkError(name+" addGram",gram_error,tolerance) ) failures++;
+            cout << name << ": " << Y.rows() << "x" << Y.cols() << ", " << Y.getNumberOfBlocks() << " blocks, "
+                 << Y.getNonZeros() << " stored elements" << endl;
+
+            if( learner != 0 ) {
+                Vector w_ref = pinv(A_ref)*b_ref;
+                double w_norm = 0.0;
+                for(int k=0; k < (int)w_ref.size(); k++ ) {
+                    w_norm = max(w_norm,fabs(w_ref[k]));
+                }
+                double learner_error = maxDifference(learner->getParameters(),w_ref)/max(1.0,w_norm);
+                if( !checkError(name+" learner parameters",learner_error,learner_tolerance) ) failures++;
+                delete learner;
+            }
+        }
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+/**
+* Copyright: 2012
+* Author: Silvio Traversaro
+* CopyPolicy: Released under the terms of the GNU GPL v2.0.
+**/
+
+//
+// An example of the use of the specialized regressors generated by
+// iDyn/scripts/generateSpecializedRegressors.py: for each limb of the iCub
+// the specialized regressors are compared with the generic ones in some
+// random configurations, and the time needed by both is measured.
+// The tutorial exits with 1 if the two implementations differ by more than
+// a tolerance
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynBody.h>
+#include <iCub/iDyn/iDynRegressor.h>
+
+#include "tutorialHelpers.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::iDyn;
+using namespace iCub::iDyn::Regressor;
+using namespace tutorial;
+
+////////////////
+//   MAIN
+///////////////
+
+int main()
+{
+    // The specialized regressors are available for the arms and for the legs of the version 2
+    version_tag icub_type;
+    icub_type.legs_version = 2;
+    iCubWholeBody icub(icub_type,DYNAMIC,iCub::skinDynLib::NO_VERBOSE);
+
+    const int n_configurations = 1000;
+    const double tolerance = 1e-10;
+    int failures = 0;
+    const string limbNames[4] = {"right_arm","left_arm","right_leg","left_leg"};
+
+    for(int l=0; l < 4; l++ ) {
+        iDynChain * p_chain;
+        iDynSensor * p_sensor;
+        int virtual_link;
+        if( !iCubLimbGetData(&icub,limbNames[l],false,p_chain,p_sensor,virtual_link) ) {
+            cout << limbNames[l] << ": iCubLimbGetData failed" << endl;
+            failures++;
+            continue;
+        }
+        if( !iDynChainHasSpecializedRegressor(p_chain,p_sensor) ) {
+            cout << limbNames[l] << ": no specialized regressor available" << endl;
+            continue;
+        }
+
+        // equivalence with the generic implementation
+        double max_error = 0.0;
+        for(int i=0; i < n_configurations; i++ ) {
+            setRandomState(icub);
+            double error;
+            if( !iDynChainRegressorCheckSpecialized(p_chain,p_sensor,error,virtual_link) ) {
+                cout << limbNames[l] << ": check failed" << endl;
+                return 1;
+            }
+            max_error = max(max_error,error);
+        }
+
+        // time of the two implementations
+        Matrix Y, Y_tau;
+        double t_generic = 0.0, t_specialized = 0.0;
+        for(int i=0; i < n_configurations; i++ ) {
+            setRandomState(icub);
+            double t0 = Time::now();
+            iDynChainRegressorSensorWrench(p_chain,p_sensor,Y,virtual_link,false);
+            iDynChainRegressorTorquesEstimation(p_chain,p_sensor,Y_tau,virtual_link,false);
+            t_generic += Time::now()-t0;
+            t0 = Time::now();
+            iDynChainRegressorSensorWrench(p_chain,p_sensor,Y,virtual_link,true);
+            iDynChainRegressorTorquesEstimation(p_chain,p_sensor,Y_tau,virtual_link,true);
+            t_specialized += Time::now()-t0;
+        }
+
+        if( !checkError(limbNames[l]+" specialized vs generic",max_error,tolerance) ) {
+            failures++;
+        }
+        cout << setw(10) << limbNames[l] << ": generic " << 1e6*t_generic/n_configurations << " us"
+             << ", specialized " << 1e6*t_specialized/n_configurations << " us" << endl;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,227 @@
+/**
+* Copyright: 2012
+* Author: Silvio Traversaro
+* CopyPolicy: Released under the terms of the GNU GPL v2.0.
+**/
+
+//
+// A benchmark of the Newton-Euler recursion on the whole iCub: the kinematic and
+// wrench phases (solveKinematics + solveWrench) of the upper and lower torso are
+// executed in a set of random configurations, and the mean time is printed.
+// The random states are generated with a fixed seed, so the printed checksum of
+// the estimated joint torques can be used to compare different builds of iDyn.
+// On each limb of the whole body the recursion of iDyn (fixed-size link
+// computations) is compared with the same recursion written with the yarp
+// Vector/Matrix expressions used before, and both are timed.
+// The targeted kinematics (solveLimbKinematics), used when only the right arm and
+// the head change, is also checked against the full one and timed.
+// The benchmark exits with 1 if a check fails
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynBody.h>
+
+#include "tutorialHelpers.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::iDyn;
+using namespace tutorial;
+
+const string upperLimbs[3] = {"right_arm","left_arm","head"};
+const string lowerLimbs[3] = {"right_leg","left_leg","torso"};
+
+// Newton-Euler recursion of a chain (forward kinematics from the base, backward
+// wrench from the end effector) with the Vector/Matrix expressions of the link
+// recursion before the fixed-size implementation; the torque of each link is the
+// z component of the moment of the previous one, as in computeTorque()
+void matrixNewtonEuler(iDynChain * chain, const Vector & w0, const Vector & dw0, const Vector & ddp0,
+                       const Vector & Fend, const Vector & Muend, Vector & tau)
+{
+    const unsigned int N = chain->getN();
+    vector<Vector> w(N), dw(N), ddpC(N);
+    Vector z0(3,0.0);
+    z0[2] = 1.0;
+
+    Vector w_prev = w0, dw_prev = dw0, ddp_prev = ddp0;
+    for(unsigned int i=0; i < N; i++ ) {
+        iDynLink * link = (iDynLink *) &((*chain)[i]);
+        const Matrix & R = link->getR();
+        const Vector & r = link->getr(true);
+        const Vector & rC = link->getrC();
+        w[i] = R.transposed() * ( w_prev + link->getDAng() * z0 );
+        dw[i] = R.transposed() * ( dw_prev + link->getD2Ang() * z0 + link->getDAng() * cross(w_prev,z0) );
+        Vector ddp = ddp_prev*R + cross(dw[i],r) + cross(w[i],cross(w[i],r));
+        ddpC[i] = ddp + cross(dw[i],rC) + cross(w[i],cross(w[i],rC));
+        w_prev = w[i];
+        dw_prev = dw[i];
+        ddp_prev = ddp;
+    }
+
+    // the final link has no mass and an identity rotation: the wrench of the
+    // last link is the one at the end effector
+    Vector F = Fend, Mu = Muend;
+    tau.resize(N);
+    for(int i=N-1; i >= 0; i-- ) {
+        iDynLink * link = (iDynLink *) &((*chain)[i]);
+        const Matrix & R = link->getR();
+        const Vector & r = link->getr(true);
+        const Matrix & I = link->getInertia();
+        const double m = link->getMass();
+        Vector Mu_prev = R * ( cross(r,F)
+                             + cross(r + link->getrC(), m * ddpC[i])
+                             + Mu
+                             + I * dw[i]
+                             + cross(w[i], I * w[i]) );
+        F = R * ( m * ddpC[i] + F );
+        Mu = Mu_prev;
+        tau[i] = Mu[2];
+    }
+}
+
+// kinematic and wrench phases of the upper torso, then of the attached lower torso
+void solveWholeBody(iCubWholeBody & icub, const Vector & FM_right_leg, const Vector & FM_left_leg)
+{
+    icub.upperTorso->solveKinematics();
+    icub.upperTorso->solveWrench();
+    icub.attachLowerTorso(FM_right_leg,FM_left_leg);
+    icub.lowerTorso->solveKinematics();
+    icub.lowerTorso->solveWrench();
+}
+
+////////////////
+//   MAIN
+///////////////
+
+int main()
+{
+    version_tag icub_type;
+    iCubWholeBody icub(icub_type,DYNAMIC,iCub::skinDynLib::NO_VERBOSE);
+
+    const int n_configurations = 1000;
+    const int n_repetitions = 10;
+    const double torque_tolerance = 1e-9;
+    const double kinematics_tolerance = 1e-10;
+    int failures = 0;
+
+    iDynLimb * limbs[6] = {icub.upperTorso->right, icub.upperTorso->left, icub.upperTorso->up,
+                           icub.lowerTorso->right, icub.lowerTorso->left, icub.lowerTorso->up};
+    double torque_error[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    double t_fixed = 0.0, t_matrix = 0.0;
+    double t_body = 0.0, t_kin[2] = {0.0, 0.0};
+    double kinematics_error = 0.0;
+    // checksum of the joint torques, to compare the results of different builds
+    double checksum = 0.0;
+
+    srand(0);
+    for(int i=0; i < n_configurations; i++ ) {
+        setRandomState(icub);
+
+        // WHOLE BODY
+        Vector FM_right_arm = randomVector(6,5.0);
+        Vector FM_left_arm = randomVector(6,5.0);
+        Vector FM_right_leg = randomVector(6,20.0);
+        Vector FM_left_leg = randomVector(6,20.0);
+        icub.upperTorso->setSensorMeasurement(FM_right_arm,FM_left_arm);
+        double t0 = Time::now();
+        for(int r=0; r < n_repetitions; r++ ) {
+            solveWholeBody(icub,FM_right_leg,FM_left_leg);
+        }
+        t_body += Time::now()-t0;
+        for(int l=0; l < 3; l++ ) {
+            Vector tau = icub.upperTorso->getTorques(upperLimbs[l]);
+            for(size_t j=0; j < tau.size(); j++ ) checksum += fabs(tau[j]);
+            tau = icub.lowerTorso->getTorques(lowerLimbs[l]);
+            for(size_t j=0; j < tau.size(); j++ ) checksum += fabs(tau[j]);
+        }
+
+        // TARGETED KINEMATICS
+        // the kinematics of the right arm after the full solve, then after the
+        // targeted solve of another state of the right arm and the head and of
+        // the original one again
+        icub.upperTorso->solveKinematics();
+        Vector w_full, dw_full, ddp_full;
+        icub.upperTorso->right->getKinematicNewtonEuler(w_full,dw_full,ddp_full);
+        Vector q_arm = icub.upperTorso->getAng("right_arm"), dq_arm = icub.upperTorso->getDAng("right_arm"), ddq_arm = icub.upperTorso->getD2Ang("right_arm");
+        Vector q_head = icub.upperTorso->getAng("head"), dq_head = icub.upperTorso->getDAng("head"), ddq_head = icub.upperTorso->getD2Ang("head");
+        icub.upperTorso->setState(TORSO_NODE_RIGHT,randomVector(q_arm.size(),1.0),randomVector(q_arm.size(),2.0),randomVector(q_arm.size(),5.0));
+        icub.upperTorso->setState(TORSO_NODE_UP,randomVector(q_head.size(),1.0),randomVector(q_head.size(),2.0),randomVector(q_head.size(),5.0));
+        icub.upperTorso->solveLimbKinematics(TORSO_NODE_RIGHT);
+        icub.upperTorso->setState(TORSO_NODE_RIGHT,q_arm,dq_arm,ddq_arm);
+        icub.upperTorso->setState(TORSO_NODE_UP,q_head,dq_head,ddq_head);
+        icub.upperTorso->solveLimbKinematics(TORSO_NODE_RIGHT);
+        Vector w_targ, dw_targ, ddp_targ;
+        icub.upperTorso->right->getKinematicNewtonEuler(w_targ,dw_targ,ddp_targ);
+        kinematics_error = max(kinematics_error,norm(w_full-w_targ)+norm(dw_full-dw_targ)+norm(ddp_full-ddp_targ));
+        for(int k=0; k < 2; k++ ) {
+            t0 = Time::now();
+            for(int r=0; r < n_repetitions; r++ ) {
+                if( k == 1 ) {
+                    icub.upperTorso->solveLimbKinematics(TORSO_NODE_RIGHT);
+                } else {
+                    icub.upperTorso->solveKinematics();
+                }
+            }
+            t_kin[k] += Time::now()-t0;
+        }
+
+        // FIXED-SIZE VS MATRIX RECURSION
+        // each limb in its state, with random kinematics of the base and wrench
+        // at the end effector, iterating kinematics forward and wrench backward
+        for(int l=0; l < 6; l++ ) {
+            iDynLimb * chain = limbs[l];
+            const ChainIterationMode kinematics_mode = chain->getIterModeKinematic();
+            const ChainIterationMode wrench_mode = chain->getIterModeWrench();
+            chain->setIterMode(KINFWD_WREBWD);
+            Vector w0 = randomVector(3,1.0), dw0 = randomVector(3,1.0), ddp0 = randomVector(3,1.0);
+            ddp0[2] += 9.81;
+            Vector Fend = randomVector(3,5.0), Muend = randomVector(3,1.0);
+
+            Vector tau_matrix;
+            t0 = Time::now();
+            for(int r=0; r < n_repetitions; r++ ) {
+                matrixNewtonEuler(chain,w0,dw0,ddp0,Fend,Muend,tau_matrix);
+            }
+            t_matrix += Time::now()-t0;
+
+            t0 = Time::now();
+            for(int r=0; r < n_repetitions; r++ ) {
+                chain->computeNewtonEuler(w0,dw0,ddp0,Fend,Muend);
+            }
+            t_fixed += Time::now()-t0;
+            torque_error[l] = max(torque_error[l],maxDifference(chain->getTorques(),tau_matrix));
+
+            chain->setIterModeKinematic(kinematics_mode);
+            chain->setIterModeWrench(wrench_mode);
+        }
+    }
+
+    const double n_solves = n_repetitions*n_configurations;
+    cout.precision(12);
+    cout << "torques checksum " << checksum << endl;
+    cout.precision(6);
+    cout << "solveKinematics + solveWrench: " << 1e6*t_body/n_solves << " us" << endl;
+    cout << "Newton-Euler of the 6 limbs: fixed-size " << 1e6*t_fixed/n_solves << " us"
+         << ", Vector/Matrix " << 1e6*t_matrix/n_solves << " us" << endl;
+    cout << "right arm kinematics: full " << 1e6*t_kin[0]/n_solves << " us"
+         << ", targeted " << 1e6*t_kin[1]/n_solves << " us" << endl;
+    for(int l=0; l < 6; l++ ) {
+        const string name = (l < 3 ? "upper " + upperLimbs[l] : "lower " + lowerLimbs[l-3]) + " fixed-size vs Matrix torques";
+        if( !checkError(name,torque_error[l],torque_tolerance) ) failures++;
+    }
+    if( !checkError("targeted vs full kinematics",kinematics_error,kinematics_tolerance) ) failures++;
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/**
+* Copyright: 2012
+* Author: Silvio Traversaro
+* CopyPolicy: Released under the terms of the GNU GPL v2.0.
+**/
+
+//
+// A check of fastComputeCOM of the torso nodes of the iCub: in some random
+// configurations the masses, the COMs and the COM jacobians of the limbs of the
+// upper and lower torso computed by fastComputeCOM(true) are compared with the
+// ones of computeCOM and EXPERIMENTAL_computeCOMjacobian, and the time of the two
+// computations is measured.
+// The axis of the first joint of each limb is the one of the base frame of the
+// chain (the frame of the limb in the node times H0): as EXPERIMENTAL_computeCOMjacobian
+// uses the frame of the limb in the node without H0, the first column of the
+// jacobian is compared with the one computed from that frame and the COM.
+// The tutorial exits with 1 if a check fails
+//
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynBody.h>
+
+#include "tutorialHelpers.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::iDyn;
+using namespace tutorial;
+
+// COM jacobian of EXPERIMENTAL_computeCOMjacobian, with the first column
+// computed from the base frame of the chain (orig*H0) and the COM of the limb
+Matrix referenceJacobian(const Matrix & J, iDynLimb * limb, const Matrix & orig, const Vector & COM)
+{
+    Matrix J_ref = J;
+    Matrix H = orig*limb->getH0();
+    Vector Z = H.subcol(0,2,3);
+    Vector w = cross(Z,COM.subVector(0,2)-H.subcol(0,3,3));
+    for(int r=0; r < 3; r++ ) {
+        J_ref(r,0) = w[r];
+        J_ref(3+r,0) = Z[r];
+    }
+    return J_ref;
+}
+
+////////////////
+//   MAIN
+///////////////
+
+int main()
+{
+    version_tag icub_type;
+    iCubWholeBody icub(icub_type,DYNAMIC,iCub::skinDynLib::NO_VERBOSE);
+
+    const int n_configurations = 500;
+    const double tolerance = 1e-10;
+    int failures = 0;
+
+    iDynSensorTorsoNode * nodes[2] = {icub.upperTorso, icub.lowerTorso};
+    const string nodeNames[2] = {"upper torso", "lower torso"};
+    const string limbNames[3] = {"left", "right", "up"};
+    double mass_error[2][3], COM_error[2][3], jacobian_error[2][3];
+    for(int n=0; n < 2; n++ ) {
+        for(int l=0; l < 3; l++ ) {
+            mass_error[n][l] = COM_error[n][l] = jacobian_error[n][l] = 0.0;
+        }
+    }
+    double t_reference = 0.0, t_fast = 0.0;
+
+    srand(0);
+    for(int i=0; i < n_configurations; i++ ) {
+        setRandomState(icub);
+        for(int n=0; n < 2; n++ ) {
+            iDynSensorTorsoNode * node = nodes[n];
+            iDynLimb * limbs[3] = {node->left, node->right, node->up};
+            const Matrix * origs[3] = {&node->HLeft, &node->HRight, &node->HUp};
+
+            double t0 = Time::now();
+            node->computeCOM();
+            node->EXPERIMENTAL_computeCOMjacobian();
+            t_reference += Time::now()-t0;
+            const double masses[3] = {node->total_mass_LF, node->total_mass_RT, node->total_mass_UP};
+            const Vector COMs[3] = {node->total_COM_LF, node->total_COM_RT, node->total_COM_UP};
+            const Matrix jacobians[3] = {node->COM_jacob_LF, node->COM_jacob_RT, node->COM_jacob_UP};
+
+            t0 = Time::now();
+            node->fastComputeCOM(true);
+            t_fast += Time::now()-t0;
+            const double fast_masses[3] = {node->total_mass_LF, node->total_mass_RT, node->total_mass_UP};
+            const Vector * fast_COMs[3] = {&node->total_COM_LF, &node->total_COM_RT, &node->total_COM_UP};
+            const Matrix * fast_jacobians[3] = {&node->COM_jacob_LF, &node->COM_jacob_RT, &node->COM_jacob_UP};
+
+            for(int l=0; l < 3; l++ ) {
+                mass_error[n][l] = max(mass_error[n][l],fabs(fast_masses[l]-masses[l]));
+                COM_error[n][l] = max(COM_error[n][l],maxDifference(*fast_COMs[l],COMs[l]));
+                jacobian_error[n][l] = max(jacobian_error[n][l],maxDifference(*fast_jacobians[l],referenceJacobian(jacobians[l],limbs[l],*origs[l],COMs[l])));
+            }
+        }
+    }
+
+    for(int n=0; n < 2; n++ ) {
+        for(int l=0; l < 3; l++ ) {
+            const string name = nodeNames[n] + " " + limbNames[l];
+            if( !checkError(name+" mass",mass_error[n][l],tolerance) ) failures++;
+            if( !checkError(name+" COM",COM_error[n][l],tolerance) ) failures++;
+            if( !checkError(name+" COM jacobian",jacobian_error[n][l],tolerance) ) failures++;
+        }
+    }
+    cout << "computeCOM + EXPERIMENTAL_computeCOMjacobian " << 1e6*t_reference/(2*n_configurations) << " us"
+         << ", fastComputeCOM(true) " << 1e6*t_fast/(2*n_configurations) << " us" << endl;
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+/**
+* Copyright: 2012
+* Author: Silvio Traversaro
+* CopyPolicy: Released under the terms of the GNU GPL v2.0.
+**/
+
+//
+// An example of the use of iCubWholeBodyRegressor: the parameter vector of the
+// whole body is printed, then in some random configurations the rows of each
+// FT sensor are compared with the regressor of the limb (iCubLimbRegressorSensorWrench)
+// and the parameters of each sensor subtree with the ones of the limb (iCubLimbGetBeta).
+// The rows of the base subtree are compared with the wrench computed by the Newton-Euler
+// of iCubWholeBody: the random states are not balanced, so the robot is considered fixed
+// on the pole and the root receives from it the wrench W_root. The base subtree then
+// has the net wrench W_root - sum_s X_s W_s, where W_s are the sensor wrenches.
+// The tutorial exits with 1 if a check fails
+//
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+#include <iCub/iDyn/iDyn.h>
+#include <iCub/iDyn/iDynBody.h>
+#include <iCub/iDyn/iDynRegressor.h>
+
+#include "tutorialHelpers.h"
+
+using namespace std;
+using namespace yarp::sig;
+using namespace yarp::math;
+using namespace iCub::iDyn;
+using namespace iCub::iDyn::Regressor;
+using namespace tutorial;
+
+////////////////
+//   MAIN
+///////////////
+
+int main()
+{
+    version_tag icub_type;
+    iCubWholeBody icub(icub_type,DYNAMIC,iCub::skinDynLib::NO_VERBOSE);
+    iCubWholeBodyRegressor regressor(&icub);
+
+    // the parameter vector
+    cout << "Parameters: " << regressor.getNrOfParameters() << endl;
+    for(int b=0; b < regressor.getNrOfBodies(); b++ ) {
+        int s = regressor.getBodySensor(b);
+        cout << setw(22) << regressor.getBodyName(b) << " offset " << setw(4) << regressor.getBodyOffset(b)
+             << " subtree " << ( s == -1 ? string("base") : regressor.getSensorName(s) ) << endl;
+    }
+
+    const double tolerance = 1e-8;
+    int failures = 0;
+
+    // the parameters of each sensor subtree are the ones of the limb
+    Vector phi;
+    regressor.getParameters(phi);
+    for(int s=0; s < iCubWholeBodyRegressor::N_SENSORS; s++ ) {
+        Vector beta;
+        iCubLimbGetBeta(&icub,regressor.getSensorName(s),beta);
+        double error = maxDifference(beta,phi.subVector(regressor.getSensorOffset(s),regressor.getSensorOffset(s)+regressor.getSensorNrOfParameters(s)-1));
+        if( !checkError(regressor.getSensorName(s)+" parameters",error,tolerance) ) failures++;
+    }
+
+    // the rows of each sensor are the regressor of the limb,
+    // the rows of the base are the net wrench of the base subtree
+    const int n_configurations = 100;
+    const int right_arm = regressor.getSensorIndex("right_arm");
+    const int left_arm = regressor.getSensorIndex("left_arm");
+    const int right_leg = regressor.getSensorIndex("right_leg");
+    const int left_leg = regressor.getSensorIndex("left_leg");
+    BlockSparseRegressor Y;
+    Matrix Y_dense, Phi;
+    Vector y_model, y_measure;
+    vector<Vector> sensor_wrenches(iCubWholeBodyRegressor::N_SENSORS);
+    double max_error[iCubWholeBodyRegressor::N_SENSORS] = {0.0, 0.0, 0.0, 0.0};
+    double base_error = 0.0;
+    for(int i=0; i < n_configurations; i++ ) {
+        setRandomState(icub);
+        regressor.computeRegressor(Y);
+        Y.toDense(Y_dense);
+        for(int s=0; s < iCubWholeBodyRegressor::N_SENSORS; s++ ) {
+            iCubLimbRegressorSensorWrench(&icub,regressor.getSensorName(s),Phi);
+            Matrix Y_s = Y_dense.submatrix(6*s,6*s+5,regressor.getSensorOffset(s),regressor.getSensorOffset(s)+regressor.getSensorNrOfParameters(s)-1);
+            max_error[s] = max(max_error[s],maxDifference(Y_s,Phi));
+        }
+
+        // wrench of the root with the sensor wrenches predicted by the model
+        y_model = Y_dense*phi;
+        for(int s=0; s < iCubWholeBodyRegressor::N_SENSORS; s++ ) {
+            sensor_wrenches[s] = y_model.subVector(6*s,6*s+5);
+        }
+        icub.upperTorso->setSensorMeasurement(sensor_wrenches[right_arm],sensor_wrenches[left_arm]);
+        icub.upperTorso->solveWrench();
+        icub.attachLowerTorso(sensor_wrenches[right_leg],sensor_wrenches[left_leg]);
+        icub.lowerTorso->solveKinematics();
+        icub.lowerTorso->solveWrench();
+        Vector W_root = cat(icub.lowerTorso->getTorsoForce(),icub.lowerTorso->getTorsoMoment());
+
+        regressor.getMeasure(sensor_wrenches,y_measure);
+        Vector W_base = W_root+y_measure.subVector(iCubWholeBodyRegressor::BASE_ROW,iCubWholeBodyRegressor::BASE_ROW+5);
+        base_error = max(base_error,maxDifference(y_model.subVector(iCubWholeBodyRegressor::BASE_ROW,iCubWholeBodyRegressor::BASE_ROW+5),W_base));
+    }
+    for(int s=0; s < iCubWholeBodyRegressor::N_SENSORS; s++ ) {
+        if( !checkError(regressor.getSensorName(s)+" regressor",max_error[s],tolerance) ) failures++;
+    }
+    if( !checkError("base regressor",base_error,tolerance) ) failures++;
+    cout << "Regressor " << Y.rows() << "x" << Y.cols() << ", " << Y.getNumberOfBlocks() << " blocks, "
+         << Y.getNonZeros() << " stored elements" << endl;
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2007-2012 RobotCub Consortium, European Commission FP6 Project IST-004370
+ * author:  Silvio Traversaro
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef LM_DATASETREADER__
+#define LM_DATASETREADER__
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace iCub {
+namespace learningmachine {
+
+/**
+ * \ingroup icub_libLM_learning_machines
+ *
+ * Sequential reader of the binary datasets written by the DatasetWriter
+ * (e.g. the files of the DatasetRecorder and of the MatrixDatasetRecorder
+ * with the binary format). The header is read when the file is opened,
+ * then the records are read one at a time in the order they were written.
+ *
+ * \see iCub::learningmachine::DatasetWriter
+ *
+ * \author Silvio Traversaro
+ */
+class DatasetReader {
+private:
+    /**
+     * The filestream.
+     */
+    std::ifstream stream;
+
+    /**
+     * The sizes of the groups of columns in a record.
+     */
+    std::vector<int> groups;
+
+    /**
+     * The names of the columns.
+     */
+    std::vector<std::string> names;
+
+    /**
+     * Number of doubles in a record.
+     */
+    int columns;
+
+    /**
+     * Copy constructor (private, the reader owns a file).
+     */
+    DatasetReader(const DatasetReader& other);
+
+    /**
+     * Assignment operator (private, the reader owns a file).
+     */
+    DatasetReader& operator=(const DatasetReader& other);
+
+public:
+    /**
+     * The characters at the beginning of a binary dataset.
+     */
+    static const char binaryMagic[4];
+
+    /**
+     * The version of the binary format.
+     */
+    static const int binaryVersion;
+
+    /**
+     * Constructor.
+     */
+    DatasetReader();
+
+    /**
+     * Destructor, closes the file.
+     */
+    ~DatasetReader();
+
+    /**
+     * Opens a binary dataset and reads its header.
+     *
+     * @param filename the name of the file
+     * @throw runtime error if the file cannot be opened or its header is
+     *        not valid
+     */
+    void open(const std::string& filename);
+
+    /**
+     * Reads the next record.
+     *
+     * @param record pointer to the doubles of the record, as many as the
+     *        number of columns
+     * @return false if there are no more complete records in the file
+     */
+    bool read(double* record);
+
+    /**
+     * Closes the file.
+     */
+    void close();
+
+    /**
+     * Accessor for the state of the file.
+     */
+    bool isOpen() const { return this->stream.is_open(); }
+
+    /**
+     * Accessor for the sizes of the groups of columns.
+     */
+    const std::vector<int>& getGroups() const { return this->groups; }
+
+    /**
+     * Accessor for the names of the columns.
+     */
+    const std::vector<std::string>& getNames() const { return this->names; }
+
+    /**
+     * Accessor for the number of doubles in a record.
+     */
+    int getColumns() const { return this->columns; }
+};
+
+} // learningmachine
+} // iCub
+#endif
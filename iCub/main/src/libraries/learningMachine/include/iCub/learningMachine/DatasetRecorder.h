@@ -19,9 +19,11 @@
 #ifndef LM_DATASETRECORDER__
 #define LM_DATASETRECORDER__
 
-#include <fstream>
+#include <string>
+#include <vector>
 
 #include "iCub/learningMachine/IMachineLearner.h"
+#include "iCub/learningMachine/DatasetWriter.h"
 
 
 namespace iCub {
@@ -33,7 +35,13 @@ namespace learningmachine {
  * This 'machine learner' demonstrates how the IMachineLearner interface can
  * be used to easily record samples to a file.
  *
+ * The samples are written by a DatasetWriter, either as text or as raw
+ * doubles with a header containing the dimensions and the names of the
+ * columns. By default the writes are buffered and done by a background
+ * thread, so that recording does not delay the caller.
+ *
  * \see iCub::contrib::IMachineLearner
+ * \see iCub::learningmachine::DatasetWriter
  *
  * \author Arjan Gijsberts
  *
@@ -46,25 +54,67 @@ private:
     std::string filename;
 
     /**
-     * The filestream.
+     * The file format, either "text" or "binary".
      */
-    std::ofstream stream;
+    std::string format;
 
     /**
      * Precision for the serialization of the doubles.
      */
     int precision;
 
+    /**
+     * Whether the samples are written by a background thread.
+     */
+    bool async;
+
+    /**
+     * Number of buffered samples that triggers a write.
+     */
+    int flushSize;
+
+    /**
+     * Maximum time in seconds between two writes.
+     */
+    double flushInterval;
+
+    /**
+     * Names of the input columns.
+     */
+    std::vector<std::string> inputNames;
+
+    /**
+     * Names of the output columns.
+     */
+    std::vector<std::string> outputNames;
+
     /**
      * Number of recorded samples.
      */
     int sampleCount;
 
+    /**
+     * The writer, created when the first sample is fed.
+     */
+    DatasetWriter* writer;
+
+    /**
+     * Buffer for the concatenation of the input and output of a sample.
+     */
+    std::vector<double> record;
+
+    /**
+     * Opens the writer for samples of the given dimensions.
+     */
+    void open(int inputSize, int outputSize);
+
 public:
     /**
      * Constructor.
      */
-    DatasetRecorder() : filename("dataset.dat"), precision(8), sampleCount(0) {
+    DatasetRecorder()
+      : filename("dataset.dat"), format("text"), precision(8), async(true),
+        flushSize(1000), flushInterval(1.), sampleCount(0), writer((DatasetWriter*) 0) {
         this->setName("Recorder");
     }
 
@@ -72,17 +122,18 @@ public:
      * Copy constructor.
      */
     DatasetRecorder(const DatasetRecorder& other)
-      : IMachineLearner(other), filename(other.filename),
-        precision(other.precision), sampleCount(other.sampleCount) {
+      : IMachineLearner(other), filename(other.filename), format(other.format),
+        precision(other.precision), async(other.async), flushSize(other.flushSize),
+        flushInterval(other.flushInterval), inputNames(other.inputNames),
+        outputNames(other.outputNames), sampleCount(other.sampleCount),
+        writer((DatasetWriter*) 0) {
     }
 
     /**
      * Destructor.
      */
     virtual ~DatasetRecorder() {
-        if(!this->stream.is_open()) {
-            this->stream.close();
-        }
+        delete this->writer;
     }
 
     /**
@@ -96,9 +147,14 @@ public:
     virtual void feedSample(const yarp::sig::Vector& input, const yarp::sig::Vector& output);
 
     /*
-     * Inherited from IMachineLearner.
+     * Inherited from IMachineLearner. Hands over the buffered samples for
+     * writing.
      */
-    virtual void train() { }
+    virtual void train() {
+        if(this->writer != (DatasetWriter*) 0) {
+            this->writer->flush();
+        }
+    }
 
     /*
      * Inherited from IMachineLearner.
@@ -111,7 +167,8 @@ public:
      * Inherited from IMachineLearner.
      */
     void reset() {
-        this->stream.close();
+        delete this->writer;
+        this->writer = (DatasetWriter*) 0;
         this->sampleCount = 0;
     }
 
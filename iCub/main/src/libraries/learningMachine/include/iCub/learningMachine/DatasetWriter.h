@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2007-2012 RobotCub Consortium, European Commission FP6 Project IST-004370
+ * author:  Silvio Traversaro
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef LM_DATASETWRITER__
+#define LM_DATASETWRITER__
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace iCub {
+namespace learningmachine {
+
+class DatasetWriterThread;
+
+/**
+ * \ingroup icub_libLM_learning_machines
+ *
+ * Buffered writer for datasets of fixed size records, used by the dataset
+ * recorders. Each record is a sequence of doubles, divided in groups of
+ * columns (e.g. the inputs and the outputs of a sample).
+ *
+ * Records are appended to a buffer in memory, which is written to the file
+ * when it contains a given number of records or when a given time interval
+ * has passed since the last write. In asynchronous mode the buffer is handed
+ * over to a background thread, which does the formatting and the disk I/O:
+ * the caller only copies the record and, once in a while, swaps two buffers.
+ * The thread keeps a bounded ring of pendingBuffers buffers, allocated when
+ * the file is opened: if the disk is so slow that the ring is full, the
+ * handed over records are dropped, and counted by getDroppedCount().
+ *
+ * Two file formats are supported:
+ *  - text: a line for each record, groups separated by two spaces;
+ *  - binary: a header, followed by the records as raw doubles in the byte
+ *    order of the machine. The header is made of the characters "LMDS", the
+ *    format version, the number of groups and the size of each group (32 bit
+ *    integers), and the name of each column (32 bit length and characters).
+ *
+ * Appending to an existing binary file is only allowed if its group sizes
+ * match the ones of the new records. The binary files are read back by the
+ * DatasetReader.
+ *
+ * \see iCub::learningmachine::DatasetRecorder
+ * \see iCub::learningmachine::DatasetReader
+ *
+ * \author Silvio Traversaro
+ */
+class DatasetWriter {
+private:
+    /**
+     * The filestream.
+     */
+    std::ofstream stream;
+
+    /**
+     * Whether the records are written in binary format.
+     */
+    bool binary;
+
+    /**
+     * Precision for the text serialization of the doubles.
+     */
+    int precision;
+
+    /**
+     * Whether the records are written by a background thread.
+     */
+    bool async;
+
+    /**
+     * Number of buffered records that triggers a write.
+     */
+    int flushSize;
+
+    /**
+     * Maximum time in seconds between two writes (disabled if not positive).
+     */
+    double flushInterval;
+
+    /**
+     * The sizes of the groups of columns in a record.
+     */
+    std::vector<int> groups;
+
+    /**
+     * Number of doubles in a record.
+     */
+    int columns;
+
+    /**
+     * Records that have not been handed over for writing yet.
+     */
+    std::vector<double> buffer;
+
+    /**
+     * Time of the last write.
+     */
+    double lastFlush;
+
+    /**
+     * Number of records appended since opening the file.
+     */
+    int recordCount;
+
+    /**
+     * Number of records dropped by the background writers that have been
+     * stopped since opening the file.
+     */
+    int droppedCount;
+
+    /**
+     * The background writer, if writing asynchronously.
+     */
+    DatasetWriterThread* thread;
+
+    /**
+     * Writes the header of a binary file.
+     */
+    void writeHeader(const std::vector<std::string>& names);
+
+    /**
+     * Checks whether an existing binary file can be appended to.
+     *
+     * @param filename the name of the file
+     * @return true if the file is empty or does not exist, false if its
+     *         header has to be kept
+     * @throw runtime error if the file has a different layout
+     */
+    bool checkExisting(const std::string& filename);
+
+    /**
+     * Copy constructor (private, the writer owns a file and a thread).
+     */
+    DatasetWriter(const DatasetWriter& other);
+
+    /**
+     * Assignment operator (private, the writer owns a file and a thread).
+     */
+    DatasetWriter& operator=(const DatasetWriter& other);
+
+public:
+    /**
+     * Number of buffers handed over to the background thread that can wait
+     * to be written.
+     */
+    static const int pendingBuffers = 4;
+
+    /**
+     * Constructor.
+     *
+     * @param binary whether to use the binary format
+     * @param precision number of digits of the doubles in the text format
+     * @param async whether to write from a background thread
+     * @param flushSize number of buffered records that triggers a write
+     * @param flushInterval maximum time in seconds between two writes
+     */
+    DatasetWriter(bool binary = false, int precision = 8, bool async = true,
+                  int flushSize = 1000, double flushInterval = 1.);
+
+    /**
+     * Destructor, writes the remaining records and closes the file.
+     */
+    ~DatasetWriter();
+
+    /**
+     * Opens a file for appending records.
+     *
+     * @param filename the name of the file
+     * @param groups the sizes of the groups of columns in a record
+     * @param names the names of the columns (stored in the binary header),
+     *        missing names are left empty
+     * @throw runtime error if the file cannot be opened or has a different
+     *        layout
+     */
+    void open(const std::string& filename, const std::vector<int>& groups,
+              const std::vector<std::string>& names);
+
+    /**
+     * Appends a record to the buffer, writing the buffer if needed.
+     *
+     * @param record pointer to the doubles of the record, as many as the sum
+     *        of the group sizes
+     */
+    void write(const double* record);
+
+    /**
+     * Hands over the buffered records for writing.
+     */
+    void flush();
+
+    /**
+     * Writes the remaining records, stops the background thread and closes
+     * the file.
+     */
+    void close();
+
+    /**
+     * Writes a sequence of records to the file and flushes the stream. This
+     * is called by the background thread in asynchronous mode.
+     *
+     * @param records the records
+     */
+    void writeRecords(const std::vector<double>& records);
+
+    /**
+     * Accessor for the state of the file.
+     */
+    bool isOpen() const { return this->stream.is_open(); }
+
+    /**
+     * Accessor for the number of doubles in a record.
+     */
+    int getColumns() const { return this->columns; }
+
+    /**
+     * Accessor for the number of records appended since opening the file.
+     */
+    int getRecordCount() const { return this->recordCount; }
+
+    /**
+     * Accessor for the number of records dropped since opening the file,
+     * because the background thread was lagging behind.
+     */
+    int getDroppedCount();
+};
+
+} // learningmachine
+} // iCub
+#endif
@@ -102,6 +102,12 @@ public:
         return new FixedRangeScaler(*this);
     }
 
+    /*
+     * Inherited from IScaler. The offset and scale only change on
+     * configuration, hence the transformation is always affine.
+     */
+    virtual bool isAffine() { return true; }
+
     /**
      * Accessor for the desired lower bound.
      */
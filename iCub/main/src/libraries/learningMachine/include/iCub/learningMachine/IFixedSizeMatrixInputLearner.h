@@ -80,6 +80,16 @@ protected:
      */
     void validateDomainSizes(const yarp::sig::Matrix& input, const yarp::sig::Vector& output);
 
+    /**
+     * Validates whether the stacked inputs and outputs of a batch are of the
+     * desired dimensionality. An exception will be thrown if this is not the case.
+     *
+     * @param inputs the stacked sample inputs
+     * @param outputs the stacked corresponding outputs
+     * @return the number of samples in the batch
+     */
+    int validateBatchSizes(const yarp::sig::Matrix& inputs, const yarp::sig::Vector& outputs);
+
     /*
      * Inherited from IMachineLearner.
      */
@@ -111,6 +121,19 @@ public:
      */
      virtual void feedSample(const yarp::sig::Matrix& input, const yarp::sig::Vector& output);
 
+    /**
+     * Provide the learning machine with a batch of examples. The inputs of
+     * the samples are stacked in a (num_samples*domainRows x domainCols)
+     * matrix, the outputs in a vector of size num_samples*coDomainSize.
+     * The default implementation calls feedSample for each sample, learning
+     * machines that can update their state once for the whole batch should
+     * override it.
+     *
+     * @param inputs the stacked sample inputs
+     * @param outputs the stacked corresponding outputs
+     */
+    virtual void feedBatch(const yarp::sig::Matrix& inputs, const yarp::sig::Vector& outputs);
+
     /*
      * Inherited from IMachineLearner.
      */
@@ -77,6 +77,17 @@ protected:
      */
     void validateDomainSizes(const yarp::sig::Vector& input, const yarp::sig::Vector& output);
 
+    /**
+     * Validates whether the columns of a batch of inputs are of the desired
+     * dimensionality and resizes the output matrix to the number of samples
+     * and the codomain size. An exception will be thrown if the input is of
+     * the wrong dimensionality.
+     *
+     * @param input a batch of sample inputs
+     * @param output the matrix for the corresponding outputs
+     */
+    void validateBatchSizes(const yarp::sig::Matrix& input, yarp::sig::Matrix& output);
+
     /*
      * Inherited from ITransformer.
      */
@@ -101,6 +112,11 @@ public:
      */
     virtual yarp::sig::Vector transform(const yarp::sig::Vector& input);
 
+    /*
+     * Inherited from ITransformer.
+     */
+    virtual void transformBatch(const yarp::sig::Matrix& input, yarp::sig::Matrix& output);
+
     /**
      * Returns the size (dimensionality) of the input domain.
      *
@@ -85,6 +85,43 @@ class IParameterLearner : public IFixedSizeMatrixInputLearner {
          */
         virtual void setWeightsStandardDeviation(const yarp::sig::Vector& s) = 0;
         
+        /**
+         * Returns the standard deviation of the learned parameters, for
+         * the learning machines that estimate their uncertainty.
+         * 
+         * @return a yarp::sig::Vector of the standard deviations, empty if
+         *         the uncertainty is not available
+         */
+        virtual yarp::sig::Vector getParametersStandardDeviation() const { return yarp::sig::Vector(); }
+        
+        /**
+         * Copies the learned parameters in a preallocated vector, resized
+         * only if its size is wrong. The default implementation uses
+         * getParameters(), the learning machines override it so that no
+         * memory is allocated.
+         * 
+         * @param parameters a yarp::sig::Vector for the learned parameters
+         */
+        virtual void copyParameters(yarp::sig::Vector& parameters) const { parameters = this->getParameters(); }
+        
+        /**
+         * Copies the standard deviation of the learned parameters (see
+         * getParametersStandardDeviation()) in a preallocated vector, resized
+         * only if its size is wrong. The learning machines that estimate
+         * their uncertainty override it so that no memory is allocated,
+         * using their internal buffers.
+         * 
+         * @param sd a yarp::sig::Vector for the standard deviations
+         * @return false if the uncertainty is not available (sd is not modified)
+         */
+        virtual bool copyParametersStandardDeviation(yarp::sig::Vector& sd) {
+            yarp::sig::Vector s = this->getParametersStandardDeviation();
+            if( s.size() == 0 ) {
+                return false;
+            }
+            sd = s;
+            return true;
+        }
         
 
 };
@@ -106,6 +106,41 @@ public:
      */
     virtual double transform(double val);
 
+    /**
+     * Transforms a strided sequence of sample values, i.e. the values
+     * input[k * inStride] for k in [0, count), into output[k * outStride].
+     * If the scaler is affine, the whole sequence is transformed with a
+     * single loop on the offset and scale, otherwise the values are
+     * transformed one by one in order.
+     *
+     * @param input pointer to the first sample
+     * @param inStride the distance between two consecutive samples
+     * @param output pointer to the first transformed sample
+     * @param outStride the distance between two consecutive outputs
+     * @param count the number of samples
+     */
+    virtual void transformBatch(const double* input, int inStride,
+                                double* output, int outStride, int count);
+
+    /**
+     * Returns whether the transformation is a fixed affine map, i.e. whether
+     * the scaler leaves its offset and scale untouched while transforming.
+     * By default this is the case if updating is disabled; scalers that never
+     * update return true regardless of the update state.
+     *
+     * @return true if the transform operation is a fixed affine map
+     */
+    virtual bool isAffine() { return !this->updateEnabled; }
+
+    /**
+     * Retrieves the affine map output = (input - shift) * gain that is used
+     * by the transform operation when the scaler is affine.
+     *
+     * @param shift the value that is subtracted from the input
+     * @param gain the factor for the shifted input
+     */
+    virtual void getAffine(double& shift, double& gain);
+
     /**
      * Untransforms a single sample value according to the state of the
      * scaler. This operation is the inverse of the transform operation.
@@ -218,6 +253,19 @@ public:
         return val;
     }
 
+    /*
+     * Inherited from IScaler.
+     */
+    virtual bool isAffine() { return true; }
+
+    /*
+     * Inherited from IScaler.
+     */
+    virtual void getAffine(double& shift, double& gain) {
+        shift = 0.;
+        gain = 1.;
+    }
+
     /*
      * Inherited from IScaler.
      */
@@ -26,6 +26,7 @@
 #include <yarp/os/Portable.h>
 #include <yarp/os/Bottle.h>
 #include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
 
 namespace iCub {
 namespace learningmachine {
@@ -107,6 +108,33 @@ public:
         return yarp::sig::Vector();
     }
 
+    /**
+     * Transforms a batch of input vectors, stored as the rows of a contiguous
+     * row-major matrix. The output matrix is resized if needed, so that each
+     * of its rows contains the transformed sample of the corresponding input
+     * row. The default implementation transforms the rows one by one;
+     * transformers that can process the whole block at once should override
+     * this method.
+     *
+     * @param input the matrix of input vectors
+     * @param output the matrix of output vectors
+     */
+    virtual void transformBatch(const yarp::sig::Matrix& input, yarp::sig::Matrix& output) {
+        yarp::sig::Vector sample(input.cols());
+        for(int r = 0; r < input.rows(); r++) {
+            for(int c = 0; c < input.cols(); c++) {
+                sample(c) = input(r, c);
+            }
+            yarp::sig::Vector result = this->transform(sample);
+            if(output.rows() != input.rows() || output.cols() != int(result.size())) {
+                output.resize(input.rows(), result.size());
+            }
+            for(int c = 0; c < output.cols(); c++) {
+                output(r, c) = result(c);
+            }
+        }
+    }
+
     /**
      * Asks the transformer to return a string containing statistics on its
      * operation so far.
@@ -25,6 +25,7 @@
 #include <yarp/sig/Matrix.h>
 
 #include "iCub/learningMachine/IFixedSizeLearner.h"
+#include "iCub/learningMachine/SufficientStatistics.h"
 
 
 namespace iCub {
@@ -56,7 +57,7 @@ namespace learningmachine {
  *
  */
 
-class LinearGPRLearner : public IFixedSizeLearner {
+class LinearGPRLearner : public IFixedSizeLearner, public ISufficientStatisticsLearner {
 private:
     /**
      * Cholesky factor of the covariance matrix.
@@ -185,6 +186,16 @@ public:
      */
     virtual bool configure(yarp::os::Searchable& config);
 
+    /*
+     * Inherited from ISufficientStatisticsLearner.
+     */
+    virtual void getSufficientStatistics(SufficientStatistics& stats);
+
+    /*
+     * Inherited from ISufficientStatisticsLearner.
+     */
+    virtual void mergeSufficientStatistics(const SufficientStatistics& stats);
+
 };
 
 } // learningmachine
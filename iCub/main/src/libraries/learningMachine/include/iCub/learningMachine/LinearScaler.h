@@ -73,6 +73,12 @@ public:
         return new LinearScaler(*this);
     }
 
+    /*
+     * Inherited from IScaler. The offset and scale only change on
+     * configuration, hence the transformation is always affine.
+     */
+    virtual bool isAffine() { return true; }
+
     /**
      * Accessor for the scaling factor.
      */
@@ -19,6 +19,8 @@
 #ifndef LM_MATH__
 #define LM_MATH__
 
+#include <vector>
+
 #include <gsl/gsl_linalg.h>
 
 #include <yarp/sig/Matrix.h>
@@ -50,6 +52,8 @@ namespace math {
  *   z: set of nz column vectors to be updated (ldz x nz, typically ldz == p)
  *   y: nz dimensional vector
  *   rho: nz dimensional vector of norms of residuals
+ *   xwork: optional p dimensional buffer for the working copy of x, allocated
+ *          if NULL
  * Output:
  *   r: updated cholesky factor
  *   z: updated column vectors
@@ -71,14 +75,14 @@ namespace math {
  */
 void dchud(double* r, int ldr, int p, double* x, double* z, int ldz, int nz,
            double* y, double* rho, double* c, double* s,
-           unsigned char rtrans = 0, unsigned char ztrans = 0);
+           unsigned char rtrans = 0, unsigned char ztrans = 0, double* xwork = NULL);
 
 /*
  * GSL type wrapper function for C implementation of dchud.
  */
 void gsl_linalg_cholesky_update(gsl_matrix* R, gsl_vector* x, gsl_vector* c, gsl_vector* s,
                                 gsl_matrix* Z = NULL, gsl_vector* y = NULL, gsl_vector* rho = NULL,
-                                unsigned char rtrans = 0, unsigned char ztrans = 0);
+                                unsigned char rtrans = 0, unsigned char ztrans = 0, gsl_vector* work = NULL);
 #endif /* DOXYGEN_SHOULD_SKIP_THIS */
 
 /**
@@ -111,6 +115,20 @@ void cholupdate(yarp::sig::Matrix& R, const yarp::sig::Vector& x, yarp::sig::Vec
  */
 void cholupdate(yarp::sig::Matrix& R, const yarp::sig::Vector& x, bool rtrans = 0);
 
+/**
+ * Perform a rank-1 update to a Cholesky factor, using preallocated buffers
+ * so that no memory is allocated.
+ *
+ * @param R  an upper triangular Cholesky factor
+ * @param x  the vector used to update the Cholesky factor
+ * @param c  on output, the cosines of the Given's rotations (size R.cols())
+ * @param s  on output, the sines of the Given's rotations (size R.cols())
+ * @param work  buffer for the working copy of x (size R.cols())
+ * @param rtrans  flag indicating whether R is provided transposed
+ */
+void cholupdate(yarp::sig::Matrix& R, const yarp::sig::Vector& x, yarp::sig::Vector& c, yarp::sig::Vector& s,
+                yarp::sig::Vector& work, bool rtrans = 0);
+
 /**
  * Solves a system A*x=b for multiple row vectors in B using a precomputed
  * Cholesky factor R.
@@ -165,6 +183,15 @@ yarp::sig::Vector cholsolve(const yarp::sig::Matrix& R, const yarp::sig::Vector&
  */
  yarp::sig::Matrix choldecomp(const yarp::sig::Matrix& A);
  
+/**
+ * Computes the matrix A = R^T*R of which R is the Cholesky factor (in Gsl
+ * sense, the upper triangle of R is used)
+ * 
+ * @param R the Cholesky factor
+ * @return the matrix A
+ */
+yarp::sig::Matrix cholgram(const yarp::sig::Matrix& R);
+ 
  /**
  * Computes the Cholesky factor R (in Gsl sense) of input matrix A 
  * 
@@ -418,6 +445,70 @@ bool isfullrank(const yarp::sig::Matrix& M, double tol = -1.0);
  */
 yarp::sig::Vector diagonal(yarp::sig::Matrix & mat);
 
+/**
+ * Adds the weighted Gram matrix of M to A inplace, i.e. A += M^T*diag(w)*M.
+ * Only the products of the non zero elements of each row of M are computed,
+ * but the zeros are searched at each call: for repeated updates with
+ * matrices with the same structure use the version with a pattern.
+ * 
+ * @param A  a reference to the (M.cols() x M.cols()) matrix to update
+ * @param M  a constant reference to the matrix
+ * @param w  a constant reference to the weights of the rows of M, if empty
+ *           all the weights are equal to one
+ */
+void addgram(yarp::sig::Matrix& A, const yarp::sig::Matrix& M, const yarp::sig::Vector& w);
+
+/**
+ * Adds the weighted transposed product of M and y to b inplace, i.e. 
+ * b += M^T*diag(w)*y, skipping the zero elements of M.
+ * 
+ * @param b  a reference to the vector to update, of size M.cols()
+ * @param M  a constant reference to the matrix
+ * @param w  a constant reference to the weights of the rows of M, if empty
+ *           all the weights are equal to one
+ * @param y  a constant reference to the vector, of size M.rows()
+ */
+void addtransposedproduct(yarp::sig::Vector& b, const yarp::sig::Matrix& M, const yarp::sig::Vector& w, const yarp::sig::Vector& y);
+
+/**
+ * Sets the pattern of the non zero elements of the rows of a (rows x cols)
+ * matrix to empty. For each row r, columns[r*cols ... r*cols+nonzeros[r]-1]
+ * are the columns in the pattern, followed by the other ones.
+ * This is the only function of the pattern that allocates memory.
+ * 
+ * @param columns  on output, the columns of each row
+ * @param nonzeros  on output, the number of columns in the pattern of each row
+ * @param rows  the number of rows of the matrix
+ * @param cols  the number of columns of the matrix
+ */
+void resizepattern(std::vector<int>& columns, std::vector<int>& nonzeros, int rows, int cols);
+
+/**
+ * Adds to the pattern the non zero elements of M. Only the columns not yet
+ * in the pattern are checked, so for a matrix with structural zeros (e.g. a 
+ * regressor) the pattern is found with the first samples and then the
+ * cost is proportional to the number of structural zeros.
+ * 
+ * @param columns  the columns of each row (see resizepattern)
+ * @param nonzeros  the number of columns in the pattern of each row
+ * @param M  a constant reference to the matrix
+ */
+void updatepattern(std::vector<int>& columns, std::vector<int>& nonzeros, const yarp::sig::Matrix& M);
+
+/**
+ * Same as addgram, considering only the elements of M in the pattern
+ * (see resizepattern and updatepattern).
+ */
+void addgram(yarp::sig::Matrix& A, const yarp::sig::Matrix& M, const yarp::sig::Vector& w,
+             const std::vector<int>& columns, const std::vector<int>& nonzeros);
+
+/**
+ * Same as addtransposedproduct, considering only the elements of M in the
+ * pattern (see resizepattern and updatepattern).
+ */
+void addtransposedproduct(yarp::sig::Vector& b, const yarp::sig::Matrix& M, const yarp::sig::Vector& w, const yarp::sig::Vector& y,
+                          const std::vector<int>& columns, const std::vector<int>& nonzeros);
+
 
 } // math
 } // learningmachine
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2007-2012 RobotCub Consortium, European Commission FP6 Project IST-004370
+ * author:  Silvio Traversaro
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef LM_MATRIXDATASETRECORDER__
+#define LM_MATRIXDATASETRECORDER__
+
+#include <string>
+#include <vector>
+
+#include "iCub/learningMachine/IFixedSizeMatrixInputLearner.h"
+#include "iCub/learningMachine/DatasetWriter.h"
+
+
+namespace iCub {
+namespace learningmachine {
+
+/**
+ * \ingroup icub_libLM_learning_machines
+ *
+ * The matrix input counterpart of the DatasetRecorder: a 'machine learner'
+ * that records the (M x P) input matrices and the outputs of the samples
+ * (e.g. the regressors and the measured wrenches of an F/T sensor), so that
+ * the same samples can be used for offline fitting.
+ *
+ * Each sample is written by a DatasetWriter as a record with four groups of
+ * columns: the timestamp, the identifier of the source (e.g. the limb), the
+ * input matrix in row major order and the output. The default format is
+ * binary, with the writes done by a background thread.
+ *
+ * \see iCub::learningmachine::DatasetRecorder
+ * \see iCub::learningmachine::DatasetWriter
+ *
+ * \author Silvio Traversaro
+ */
+class MatrixDatasetRecorder : public IFixedSizeMatrixInputLearner {
+private:
+    /**
+     * The filename of the file we are writing to.
+     */
+    std::string filename;
+
+    /**
+     * The file format, either "text" or "binary".
+     */
+    std::string format;
+
+    /**
+     * Precision for the text serialization of the doubles.
+     */
+    int precision;
+
+    /**
+     * Whether the samples are written by a background thread.
+     */
+    bool async;
+
+    /**
+     * Number of buffered samples that triggers a write.
+     */
+    int flushSize;
+
+    /**
+     * Maximum time in seconds between two writes.
+     */
+    double flushInterval;
+
+    /**
+     * Identifier of the source of the samples.
+     */
+    int source;
+
+    /**
+     * Timestamp of the samples, if negative the time of feedSample is used.
+     */
+    double timestamp;
+
+    /**
+     * Number of recorded samples.
+     */
+    int sampleCount;
+
+    /**
+     * The writer, created when the first sample is fed.
+     */
+    DatasetWriter* writer;
+
+    /**
+     * Buffer for the record of a sample.
+     */
+    std::vector<double> record;
+
+    /**
+     * Opens the writer for the current domain and codomain sizes.
+     */
+    void open();
+
+    /*
+     * Inherited from IMachineLearner.
+     */
+    virtual void writeBottle(yarp::os::Bottle& bot);
+
+    /*
+     * Inherited from IMachineLearner.
+     */
+    virtual void readBottle(yarp::os::Bottle& bot);
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param domRows the initial domain rows
+     * @param domCols the initial domain cols
+     * @param cod the initial codomain size
+     */
+    MatrixDatasetRecorder(unsigned int domRows = 6, unsigned int domCols = 1, unsigned int cod = 6);
+
+    /**
+     * Copy constructor.
+     */
+    MatrixDatasetRecorder(const MatrixDatasetRecorder& other);
+
+    /**
+     * Destructor.
+     */
+    virtual ~MatrixDatasetRecorder();
+
+    /**
+     * Assignment operator.
+     */
+    MatrixDatasetRecorder& operator=(const MatrixDatasetRecorder& other);
+
+    /*
+     * Inherited from IMachineMatrixInputLearner.
+     */
+    virtual void feedSample(const yarp::sig::Matrix& input, const yarp::sig::Vector& output);
+
+    /*
+     * Inherited from IMachineLearner. Hands over the buffered samples for
+     * writing.
+     */
+    virtual void train();
+
+    /*
+     * Inherited from IMachineMatrixInputLearner.
+     */
+    virtual Prediction predict(const yarp::sig::Matrix& input) {
+        return Prediction();
+    }
+
+    /*
+     * Inherited from IMachineLearner.
+     */
+    virtual void reset();
+
+    /*
+     * Inherited from IMachineLearner.
+     */
+    virtual MatrixDatasetRecorder* clone() {
+        return new MatrixDatasetRecorder(*this);
+    }
+
+    /**
+     * Sets the timestamp of the following samples.
+     *
+     * @param t the timestamp, if negative the time at which the samples are
+     *        fed is used
+     */
+    void setTimestamp(double t) { this->timestamp = t; }
+
+    /**
+     * Sets the identifier of the source of the following samples.
+     *
+     * @param id the identifier (e.g. the limb)
+     */
+    void setSource(int id) { this->source = id; }
+
+    /*
+     * Inherited from IFixedSizeMatrixInputLearner.
+     */
+    virtual void setDomainRows(unsigned int rows);
+
+    /*
+     * Inherited from IFixedSizeMatrixInputLearner.
+     */
+    virtual void setDomainCols(unsigned int cols);
+
+    /*
+     * Inherited from IFixedSizeMatrixInputLearner.
+     */
+    virtual void setCoDomainSize(unsigned int size);
+
+    /*
+     * Inherited from IMachineLearner.
+     */
+    virtual std::string getInfo();
+
+    /*
+     * Inherited from IMachineLearner.
+     */
+    virtual std::string getConfigHelp();
+
+    /*
+     * Inherited from IConfig.
+     */
+    virtual bool configure(yarp::os::Searchable& config);
+};
+
+} // learningmachine
+} // iCub
+#endif
@@ -143,6 +143,11 @@ public:
      */
     virtual yarp::sig::Vector getParameters() const;
     
+    /*
+     * Inherited from IParameterLearner
+     */
+    virtual void copyParameters(yarp::sig::Vector& parameters) const;
+    
     /**
      * Set desired fixed parameters, and reset
      * @param parameters desired parameters
@@ -24,6 +24,7 @@
 #include <yarp/sig/Matrix.h>
 
 #include "iCub/learningMachine/IParameterLearner.h"
+#include "iCub/learningMachine/SufficientStatistics.h"
 
 
 namespace iCub {
@@ -75,7 +76,7 @@ namespace learningmachine {
  *
  */
 
-class MultiTaskLinearGPRLearner : public IParameterLearner {
+class MultiTaskLinearGPRLearner : public IParameterLearner, public ISufficientStatisticsLearner {
 private:
     /**
      * Cholesky factor of the covariance matrix.
@@ -132,6 +133,33 @@ private:
      */
     int sampleCount;
 
+    /**
+     * Weights of the rows of the input matrix, i.e. the diagonal of inv_Sigma_n,
+     * empty if no output error is considered
+     */
+    yarp::sig::Vector row_weights;
+
+    /**
+     * Pattern of the non zero elements of the input matrices, (see 
+     * math::resizepattern), updated with each sample
+     */
+    std::vector<int> pattern_columns;
+    std::vector<int> pattern_nonzeros;
+
+    /**
+     * Buffers of feedSample and of the in place predict, so that once the
+     * Cholesky factor R is used no memory is allocated
+     */
+    yarp::sig::Vector row_buffer;
+    yarp::sig::Vector c_buffer;
+    yarp::sig::Vector s_buffer;
+    yarp::sig::Vector work_buffer;
+
+    /**
+     * Resizes the buffers and the pattern to the domain size
+     */
+    void resizeBuffers();
+
 public:
     /**
      * Constructor.
@@ -157,11 +185,18 @@ public:
      */
     MultiTaskLinearGPRLearner& operator=(const MultiTaskLinearGPRLearner& other);
 
-    /*
-     * Inherited from IFixedSizeMatrixInputLearner.
+    /**
+     * Inherited from IFixedSizeMatrixInputLearner. Once the information matrix 
+     * is full rank (and the Cholesky factor is updated) no memory is allocated.
      */
     void feedSample(const yarp::sig::Matrix& input_matrix, const yarp::sig::Vector& output);
 
+    /**
+     * Inherited from IFixedSizeMatrixInputLearner. The statistics of all the
+     * samples are accumulated, then the weights are solved once for the batch.
+     */
+    void feedBatch(const yarp::sig::Matrix& inputs, const yarp::sig::Vector& outputs);
+
     /*
      * Inherited from IMachineLearner.
      */
@@ -177,6 +212,17 @@ public:
      */
     virtual Prediction predict(const yarp::sig::Matrix& input);
 
+    /**
+     * Same as predict(const yarp::sig::Matrix&), writing the prediction and its
+     * standard deviation in preallocated vectors (resized only if their size is
+     * wrong), so that once the Cholesky factor R is used no memory is allocated.
+     *
+     * @param input  the input matrix
+     * @param output  on output, the predicted outputs
+     * @param std  on output, the standard deviations of the predicted outputs
+     */
+    void predict(const yarp::sig::Matrix& input, yarp::sig::Vector& output, yarp::sig::Vector& std);
+
     /*
      * Inherited from IMachineLearner.
      */
@@ -267,6 +313,35 @@ public:
      */
     virtual yarp::sig::Vector getParameters() const;
     
+    /**
+     * Inherited from IParameterLearner. The standard deviations are the
+     * square roots of the diagonal of the posterior covariance of the
+     * weights, not available until the information matrix is full rank.
+     */
+    virtual yarp::sig::Vector getParametersStandardDeviation() const;
+    
+    /**
+     * Inherited from IParameterLearner.
+     */
+    virtual void copyParameters(yarp::sig::Vector& parameters) const;
+    
+    /**
+     * Inherited from IParameterLearner. Each standard deviation is computed
+     * with a solve with the Cholesky factor, in the buffers of feedSample.
+     */
+    virtual bool copyParametersStandardDeviation(yarp::sig::Vector& sd);
+    
+    /**
+     * Inherited from ISufficientStatisticsLearner. The statistics are
+     * weighted by the inverse of the noise covariance of this learner,
+     * rhs has a single row.
+     */
+    virtual void getSufficientStatistics(SufficientStatistics& stats);
+
+    /**
+     * Inherited from ISufficientStatisticsLearner.
+     */
+    virtual void mergeSufficientStatistics(const SufficientStatistics& stats);
 
 
 
@@ -273,6 +273,11 @@ public:
      */
     virtual yarp::sig::Vector getParameters() const;
     
+    /**
+     * Inherited from IParameterLearner
+     */
+    virtual void copyParameters(yarp::sig::Vector& parameters) const;
+    
 
 
 
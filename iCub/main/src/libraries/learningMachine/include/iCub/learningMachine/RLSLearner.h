@@ -22,6 +22,7 @@
 #include <yarp/sig/Matrix.h>
 
 #include "iCub/learningMachine/IFixedSizeLearner.h"
+#include "iCub/learningMachine/SufficientStatistics.h"
 
 
 namespace iCub {
@@ -43,7 +44,7 @@ namespace learningmachine {
  *
  */
 
-class RLSLearner : public IFixedSizeLearner {
+class RLSLearner : public IFixedSizeLearner, public ISufficientStatisticsLearner {
 private:
     /**
      * Cholesky factor of the covariance matrix.
@@ -171,6 +172,16 @@ public:
      * Inherited from IConfig.
      */
     virtual bool configure(yarp::os::Searchable& config);
+
+    /*
+     * Inherited from ISufficientStatisticsLearner.
+     */
+    virtual void getSufficientStatistics(SufficientStatistics& stats);
+
+    /*
+     * Inherited from ISufficientStatisticsLearner.
+     */
+    virtual void mergeSufficientStatistics(const SufficientStatistics& stats);
 };
 
 } // learningmachine
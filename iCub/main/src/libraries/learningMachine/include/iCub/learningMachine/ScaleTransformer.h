@@ -128,6 +128,19 @@ public:
      */
     virtual yarp::sig::Vector transform(const yarp::sig::Vector& input);
 
+    /**
+     * Transforms a batch of input vectors, stored as the rows of a row-major
+     * matrix. If all scalers are affine, the batch is transformed by a single
+     * fused loop over the rows, with the offsets and scales of all columns
+     * gathered beforehand. Otherwise each column is passed to its scaler, which
+     * preserves the order in which updating scalers see the samples. The output
+     * may be the same matrix as the input.
+     *
+     * @param input the matrix of input vectors
+     * @param output the matrix of output vectors
+     */
+    virtual void transformBatch(const yarp::sig::Matrix& input, yarp::sig::Matrix& output);
+
     /*
      * Inherited from ITransformer.
      */
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2007-2012 RobotCub Consortium, European Commission FP6 Project IST-004370
+ * author:  Silvio Traversaro
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef LM_SUFFICIENTSTATISTICS__
+#define LM_SUFFICIENTSTATISTICS__
+
+#include <yarp/sig/Matrix.h>
+#include <yarp/os/Bottle.h>
+
+namespace iCub {
+namespace learningmachine {
+
+/**
+ * \ingroup icub_libLM_learning_machines
+ *
+ * Sufficient statistics of the samples fed to a linear Gaussian learner.
+ * For the model y = X w + e, with noise covariance Sigma_n, the posterior
+ * of the weights depends on the samples only through:
+ *  - gram = sum X^T Sigma_n^{-1} X, a (p x p) matrix
+ *  - rhs  = sum Y^T Sigma_n^{-1} X, a (m x p) matrix, with a row for each
+ *    output that has its own weights (a single row for the multi task learners)
+ *  - sampleCount, the number of samples
+ *
+ * The statistics do not include the prior, so the statistics of disjoint
+ * sets of samples (for example the shards of a dataset, fitted in
+ * different processes) are merged by summing them.
+ *
+ * \see iCub::learningmachine::ISufficientStatisticsLearner
+ *
+ * \author Silvio Traversaro
+ */
+class SufficientStatistics {
+public:
+    /**
+     * Gram matrix of the inputs, weighted by the inverse of the noise covariance.
+     */
+    yarp::sig::Matrix gram;
+
+    /**
+     * Product of the outputs and the inputs, weighted by the inverse of the noise covariance.
+     */
+    yarp::sig::Matrix rhs;
+
+    /**
+     * Number of samples.
+     */
+    int sampleCount;
+
+    /**
+     * Constructor.
+     *
+     * @param p the number of weights of each output
+     * @param m the number of rows of rhs
+     */
+    SufficientStatistics(unsigned int p = 0, unsigned int m = 1);
+
+    /**
+     * Sets all the statistics to zero, with the given sizes.
+     */
+    void reset(unsigned int p, unsigned int m = 1);
+
+    /**
+     * Adds the statistics of another set of samples. An exception is
+     * thrown if the sizes do not match.
+     */
+    void add(const SufficientStatistics& other);
+
+    /**
+     * Writes the statistics to a bottle.
+     */
+    void writeBottle(yarp::os::Bottle& bot) const;
+
+    /**
+     * Reads the statistics from a bottle.
+     */
+    void readBottle(yarp::os::Bottle& bot);
+};
+
+/**
+ * \ingroup icub_libLM_learning_machines
+ *
+ * Interface of the learners whose state can be exported as
+ * iCub::learningmachine::SufficientStatistics, and merged with the ones
+ * of other learners of the same kind (same sizes, prior and noise).
+ *
+ * \author Silvio Traversaro
+ */
+class ISufficientStatisticsLearner {
+public:
+    /**
+     * Destructor (empty).
+     */
+    virtual ~ISufficientStatisticsLearner() { }
+
+    /**
+     * Returns the statistics of the samples fed to the learner, without the prior.
+     *
+     * @param stats the statistics
+     */
+    virtual void getSufficientStatistics(SufficientStatistics& stats) = 0;
+
+    /**
+     * Adds the statistics of other samples (fed to a learner with the same
+     * sizes, prior and noise) to the learner, and updates the weights, as if
+     * the samples were fed to this learner.
+     *
+     * @param stats the statistics to merge
+     */
+    virtual void mergeSufficientStatistics(const SufficientStatistics& stats) = 0;
+};
+
+} // learningmachine
+} // iCub
+
+#endif
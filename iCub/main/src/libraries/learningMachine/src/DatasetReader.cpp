@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2007-2012 RobotCub Consortium, European Commission FP6 Project IST-004370
+ * author:  Silvio Traversaro
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include <stdexcept>
+#include <cstring>
+
+#include "iCub/learningMachine/DatasetReader.h"
+
+namespace iCub {
+namespace learningmachine {
+
+namespace {
+    bool readInt(std::ifstream& stream, int& val) {
+        return bool(stream.read(reinterpret_cast<char*>(&val), sizeof(val)));
+    }
+}
+
+const char DatasetReader::binaryMagic[4] = { 'L', 'M', 'D', 'S' };
+const int DatasetReader::binaryVersion = 1;
+
+
+DatasetReader::DatasetReader() : columns(0) {
+}
+
+DatasetReader::~DatasetReader() {
+    this->close();
+}
+
+void DatasetReader::open(const std::string& filename) {
+    this->close();
+
+    this->stream.open(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+    if(!this->stream.is_open()) {
+        throw std::runtime_error("Could not open dataset file " + filename);
+    }
+
+    char magic[4];
+    int version, nrGroups;
+    if(!this->stream.read(magic, sizeof(magic)) || std::memcmp(magic, binaryMagic, sizeof(magic)) != 0 ||
+       !readInt(this->stream, version) || version != binaryVersion ||
+       !readInt(this->stream, nrGroups) || nrGroups < 0) {
+        this->close();
+        throw std::runtime_error("Not a binary dataset file: " + filename);
+    }
+    this->groups.resize(nrGroups);
+    for(int i = 0; i < nrGroups; i++) {
+        if(!readInt(this->stream, this->groups[i]) || this->groups[i] < 0) {
+            this->close();
+            throw std::runtime_error("Corrupted header in dataset file " + filename);
+        }
+        this->columns += this->groups[i];
+    }
+    this->names.resize(this->columns);
+    for(int i = 0; i < this->columns; i++) {
+        int length;
+        if(!readInt(this->stream, length) || length < 0) {
+            this->close();
+            throw std::runtime_error("Corrupted header in dataset file " + filename);
+        }
+        this->names[i].resize(length);
+        if(length > 0 && !this->stream.read(&this->names[i][0], length)) {
+            this->close();
+            throw std::runtime_error("Corrupted header in dataset file " + filename);
+        }
+    }
+}
+
+bool DatasetReader::read(double* record) {
+    if(!this->stream.is_open() || this->columns == 0) {
+        return false;
+    }
+    // a record that was being written when the file was copied is incomplete
+    return bool(this->stream.read(reinterpret_cast<char*>(record), this->columns * sizeof(double)));
+}
+
+void DatasetReader::close() {
+    if(this->stream.is_open()) {
+        this->stream.close();
+    }
+    this->stream.clear();
+    this->groups.clear();
+    this->names.clear();
+    this->columns = 0;
+}
+
+} // learningmachine
+} // iCub
@@ -16,52 +16,111 @@
  * Public License for more details
  */
 
-#include <iomanip>
+#include <algorithm>
 #include <sstream>
+#include <stdexcept>
 
 #include "iCub/learningMachine/DatasetRecorder.h"
 
 namespace iCub {
 namespace learningmachine {
 
+namespace {
+    void writeNames(yarp::os::Bottle& bot, const std::vector<std::string>& names) {
+        for(size_t i = 0; i < names.size(); i++) {
+            bot.addString(names[i].c_str());
+        }
+        bot.addInt(names.size());
+    }
+
+    void readNames(yarp::os::Bottle& bot, std::vector<std::string>& names) {
+        names.resize(bot.pop().asInt());
+        for(int i = int(names.size()) - 1; i >= 0; i--) {
+            names[i] = bot.pop().asString().c_str();
+        }
+    }
+
+    bool configureNames(yarp::os::Searchable& config, const char* key, std::vector<std::string>& names) {
+        if(!config.find(key).isList()) {
+            return false;
+        }
+        yarp::os::Bottle* list = config.find(key).asList();
+        names.resize(list->size());
+        for(int i = 0; i < list->size(); i++) {
+            names[i] = list->get(i).asString().c_str();
+        }
+        return true;
+    }
+
+    void defaultNames(std::vector<std::string>& names, int size, const char* prefix) {
+        for(int i = int(names.size()); i < size; i++) {
+            std::ostringstream name;
+            name << prefix << i;
+            names.push_back(name.str());
+        }
+    }
+}
+
 DatasetRecorder& DatasetRecorder::operator=(const DatasetRecorder& other) {
     if(this == &other) return *this; // handle self initialization
 
     this->IMachineLearner::operator=(other);
+    this->reset();
     this->filename = other.filename;
+    this->format = other.format;
     this->precision = other.precision;
+    this->async = other.async;
+    this->flushSize = other.flushSize;
+    this->flushInterval = other.flushInterval;
+    this->inputNames = other.inputNames;
+    this->outputNames = other.outputNames;
     this->sampleCount = other.sampleCount;
 
     return *this;
 }
 
+void DatasetRecorder::open(int inputSize, int outputSize) {
+    std::vector<int> groups(2);
+    groups[0] = inputSize;
+    groups[1] = outputSize;
+
+    std::vector<std::string> in = this->inputNames;
+    std::vector<std::string> out = this->outputNames;
+    in.resize(std::min(int(in.size()), inputSize));
+    out.resize(std::min(int(out.size()), outputSize));
+    defaultNames(in, inputSize, "x");
+    defaultNames(out, outputSize, "y");
+    std::vector<std::string> names(in);
+    names.insert(names.end(), out.begin(), out.end());
+
+    this->writer = new DatasetWriter(this->format == "binary", this->precision, this->async,
+                                     this->flushSize, this->flushInterval);
+    try {
+        this->writer->open(this->filename, groups, names);
+    } catch(const std::runtime_error&) {
+        delete this->writer;
+        this->writer = (DatasetWriter*) 0;
+        throw;
+    }
+    this->record.resize(inputSize + outputSize);
+}
 
 void DatasetRecorder::feedSample(const yarp::sig::Vector& input, const yarp::sig::Vector& output) {
-    // open stream if not opened yet
-    if(!this->stream.is_open()) {
-        // perhaps check if file already exists
-        this->stream.open(this->filename.c_str(), std::ios_base::out | std::ios_base::app);
-        // set precision
-        this->stream.precision(this->precision);
+    // open writer if not opened yet
+    if(this->writer == (DatasetWriter*) 0) {
+        this->open(input.size(), output.size());
     }
 
-    // first write inputs
-    for(size_t i = 0; i < input.size(); i++) {
-        if(i > 0) this->stream << " ";
-        this->stream << std::setw(this->precision + 4) << input[i];
+    if(int(input.size() + output.size()) != this->writer->getColumns() ||
+       int(this->record.size()) != this->writer->getColumns()) {
+        throw std::runtime_error("Sample has a different dimensionality than the recorded ones");
     }
-    this->stream << "  ";
 
-    // then write outputs
-    for(size_t i = 0; i < output.size(); i++) {
-        if(i > 0) this->stream << " ";
-        this->stream << std::setw(this->precision + 4) << output[i] << " ";
-    }
+    // first inputs, then outputs
+    std::copy(input.data(), input.data() + input.size(), this->record.begin());
+    std::copy(output.data(), output.data() + output.size(), this->record.begin() + input.size());
+    this->writer->write(&this->record[0]);
     this->sampleCount++;
-
-    this->stream << std::endl;
-
-    this->stream.flush();
 }
 
 
@@ -69,17 +128,37 @@ std::string DatasetRecorder::getInfo() {
     std::ostringstream buffer;
     buffer << this->IMachineLearner::getInfo();
     buffer << "Filename: " << this->filename << std::endl;
+    buffer << "Format: " << this->format << std::endl;
     buffer << "Precision: " << this->precision << std::endl;
+    buffer << "Asynchronous: " << (this->async ? "yes" : "no") << std::endl;
+    buffer << "Flush: every " << this->flushSize << " samples or "
+           << this->flushInterval << " seconds" << std::endl;
     buffer << "Sample Count: " << this->sampleCount << std::endl;
+    if(this->writer != (DatasetWriter*) 0) {
+        buffer << "Dropped Samples: " << this->writer->getDroppedCount() << std::endl;
+    }
     return buffer.str();
 }
 
 void DatasetRecorder::writeBottle(yarp::os::Bottle& bot) {
     bot.addString(this->filename.c_str());
     bot.addInt(this->precision);
+    bot.addString(this->format.c_str());
+    bot.addInt(this->async);
+    bot.addInt(this->flushSize);
+    bot.addDouble(this->flushInterval);
+    writeNames(bot, this->inputNames);
+    writeNames(bot, this->outputNames);
 }
 
 void DatasetRecorder::readBottle(yarp::os::Bottle& bot) {
+    this->reset();
+    readNames(bot, this->outputNames);
+    readNames(bot, this->inputNames);
+    this->flushInterval = bot.pop().asDouble();
+    this->flushSize = bot.pop().asInt();
+    this->async = bot.pop().asInt();
+    this->format = bot.pop().asString().c_str();
     this->precision = bot.pop().asInt();
     this->filename = bot.pop().asString().c_str();
 }
@@ -88,7 +167,13 @@ std::string DatasetRecorder::getConfigHelp() {
     std::ostringstream buffer;
     buffer << this->IMachineLearner::getConfigHelp();
     buffer << "  filename name         Filename to write to" << std::endl;
+    buffer << "  format text|binary    File format (default text)" << std::endl;
     buffer << "  precision n           Number of digits precision for doubles" << std::endl;
+    buffer << "  async 0|1             Write from a background thread" << std::endl;
+    buffer << "  flush_size n          Number of buffered samples that triggers a write" << std::endl;
+    buffer << "  flush_interval t      Maximum time in seconds between writes (0 disables)" << std::endl;
+    buffer << "  input_names (n1 ..)   Names of the input columns (binary header)" << std::endl;
+    buffer << "  output_names (n1 ..)  Names of the output columns (binary header)" << std::endl;
     return buffer.str();
 }
 
@@ -102,12 +187,53 @@ bool DatasetRecorder::configure(yarp::os::Searchable& config) {
         success = true;
     }
 
+    // set the file format
+    if(config.find("format").isString()) {
+        std::string f = config.find("format").asString().c_str();
+        if(f == "text" || f == "binary") {
+            this->reset();
+            this->format = f;
+            success = true;
+        }
+    }
+
     // set the precision
     if(config.find("precision").isInt()) {
         this->precision = config.find("precision").asInt();
         success = true;
     }
 
+    // enable or disable the background writer
+    if(config.find("async").isInt()) {
+        this->reset();
+        this->async = (config.find("async").asInt() != 0);
+        success = true;
+    }
+
+    // set the number of samples that triggers a write
+    if(config.find("flush_size").isInt()) {
+        this->reset();
+        this->flushSize = config.find("flush_size").asInt();
+        success = true;
+    }
+
+    // set the maximum time between writes
+    if(config.find("flush_interval").isDouble() || config.find("flush_interval").isInt()) {
+        this->reset();
+        this->flushInterval = config.find("flush_interval").asDouble();
+        success = true;
+    }
+
+    // set the names of the columns
+    if(configureNames(config, "input_names", this->inputNames)) {
+        this->reset();
+        success = true;
+    }
+    if(configureNames(config, "output_names", this->outputNames)) {
+        this->reset();
+        success = true;
+    }
+
     return success;
 }
 
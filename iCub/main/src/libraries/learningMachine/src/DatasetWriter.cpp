@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2007-2012 RobotCub Consortium, European Commission FP6 Project IST-004370
+ * author:  Silvio Traversaro
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+#include <yarp/os/Thread.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/os/Time.h>
+
+#include "iCub/learningMachine/DatasetWriter.h"
+#include "iCub/learningMachine/DatasetReader.h"
+
+namespace iCub {
+namespace learningmachine {
+
+namespace {
+    void writeInt(std::ofstream& stream, int val) {
+        stream.write(reinterpret_cast<const char*>(&val), sizeof(val));
+    }
+}
+
+/**
+ * Background thread of the DatasetWriter. The records are handed over in a
+ * buffer, which is swapped with an empty slot of a bounded ring of pending
+ * buffers, so that the caller never waits for the disk. All the buffers are
+ * allocated when the file is opened; if the ring is full (the thread is
+ * lagging behind) the handed over records are dropped and counted. The
+ * semaphore only protects the swaps of the buffers.
+ */
+class DatasetWriterThread : public yarp::os::Thread {
+private:
+    DatasetWriter& writer;
+    yarp::os::Semaphore mutex;
+    yarp::os::Semaphore wake;
+    std::vector<std::vector<double> > pending;
+    std::vector<double> writing;
+    size_t head;
+    size_t count;
+    int columns;
+    int dropped;
+
+    bool next() {
+        this->mutex.wait();
+        bool available = this->count > 0;
+        if(available) {
+            this->writing.swap(this->pending[this->head]);
+            this->head = (this->head + 1) % this->pending.size();
+            this->count--;
+        }
+        this->mutex.post();
+        return available;
+    }
+
+    void drain() {
+        while(this->next()) {
+            this->writer.writeRecords(this->writing);
+            this->writing.clear();
+        }
+    }
+
+public:
+    DatasetWriterThread(DatasetWriter& w, size_t capacity, int slots, int c)
+      : writer(w), mutex(1), wake(0), pending(std::max(slots, 1)), head(0), count(0),
+        columns(std::max(c, 1)), dropped(0) {
+        for(size_t i = 0; i < this->pending.size(); i++) {
+            this->pending[i].reserve(capacity);
+        }
+        this->writing.reserve(capacity);
+    }
+
+    void handoff(std::vector<double>& records) {
+        this->mutex.wait();
+        if(this->count < this->pending.size()) {
+            // the buffers are exchanged, records gets the capacity of the empty slot
+            this->pending[(this->head + this->count) % this->pending.size()].swap(records);
+            this->count++;
+        } else {
+            // the thread is lagging behind and all the slots are full
+            this->dropped += int(records.size()) / this->columns;
+            records.clear();
+        }
+        this->mutex.post();
+        this->wake.post();
+    }
+
+    int getDropped() {
+        this->mutex.wait();
+        int d = this->dropped;
+        this->mutex.post();
+        return d;
+    }
+
+    virtual void run() {
+        while(!this->isStopping()) {
+            this->wake.wait();
+            this->drain();
+        }
+        this->drain();
+    }
+
+    virtual void onStop() {
+        this->wake.post();
+    }
+};
+
+
+DatasetWriter::DatasetWriter(bool b, int p, bool a, int fs, double fi)
+  : binary(b), precision(p), async(a), flushSize(fs), flushInterval(fi),
+    columns(0), lastFlush(0.), recordCount(0), droppedCount(0), thread((DatasetWriterThread*) 0) {
+}
+
+DatasetWriter::~DatasetWriter() {
+    this->close();
+}
+
+bool DatasetWriter::checkExisting(const std::string& filename) {
+    {
+        std::ifstream existing(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+        if(!existing.is_open() || existing.peek() == std::ifstream::traits_type::eof()) {
+            return true;
+        }
+    }
+
+    DatasetReader reader;
+    try {
+        reader.open(filename);
+    } catch(const std::runtime_error&) {
+        throw std::runtime_error("Existing dataset file has a different format");
+    }
+    if(reader.getGroups() != this->groups) {
+        throw std::runtime_error("Existing dataset file has a different format");
+    }
+    return false;
+}
+
+void DatasetWriter::writeHeader(const std::vector<std::string>& names) {
+    this->stream.write(DatasetReader::binaryMagic, sizeof(DatasetReader::binaryMagic));
+    writeInt(this->stream, DatasetReader::binaryVersion);
+    writeInt(this->stream, int(this->groups.size()));
+    for(size_t i = 0; i < this->groups.size(); i++) {
+        writeInt(this->stream, this->groups[i]);
+    }
+    for(int i = 0; i < this->columns; i++) {
+        std::string name = (i < int(names.size())) ? names[i] : std::string("");
+        writeInt(this->stream, int(name.size()));
+        this->stream.write(name.c_str(), name.size());
+    }
+    this->stream.flush();
+}
+
+void DatasetWriter::open(const std::string& filename, const std::vector<int>& g,
+                         const std::vector<std::string>& names) {
+    this->close();
+
+    this->groups = g;
+    this->columns = 0;
+    for(size_t i = 0; i < this->groups.size(); i++) {
+        this->columns += this->groups[i];
+    }
+
+    if(this->binary) {
+        bool empty = this->checkExisting(filename);
+        this->stream.open(filename.c_str(), std::ios_base::out | std::ios_base::app | std::ios_base::binary);
+        if(this->stream.is_open() && empty) {
+            this->writeHeader(names);
+        }
+    } else {
+        this->stream.open(filename.c_str(), std::ios_base::out | std::ios_base::app);
+        this->stream.precision(this->precision);
+    }
+    if(!this->stream.is_open()) {
+        throw std::runtime_error("Could not open dataset file " + filename);
+    }
+
+    size_t capacity = size_t(std::max(this->flushSize, 1)) * this->columns;
+    this->buffer.clear();
+    this->buffer.reserve(capacity);
+    this->recordCount = 0;
+    this->droppedCount = 0;
+    this->lastFlush = yarp::os::Time::now();
+
+    if(this->async) {
+        this->thread = new DatasetWriterThread(*this, capacity, DatasetWriter::pendingBuffers, this->columns);
+        this->thread->start();
+    }
+}
+
+void DatasetWriter::write(const double* record) {
+    this->buffer.insert(this->buffer.end(), record, record + this->columns);
+    this->recordCount++;
+
+    if(int(this->buffer.size()) >= this->flushSize * this->columns) {
+        this->flush();
+    } else if(this->flushInterval > 0.) {
+        double now = yarp::os::Time::now();
+        if(now - this->lastFlush >= this->flushInterval) {
+            this->flush();
+        }
+    }
+}
+
+void DatasetWriter::flush() {
+    this->lastFlush = yarp::os::Time::now();
+    if(this->buffer.empty()) {
+        return;
+    }
+    if(this->thread != (DatasetWriterThread*) 0) {
+        this->thread->handoff(this->buffer);
+    } else {
+        this->writeRecords(this->buffer);
+        this->buffer.clear();
+    }
+}
+
+void DatasetWriter::close() {
+    // the thread writes the pending buffers before stopping, then the
+    // remaining records are written here, so that none is dropped
+    if(this->thread != (DatasetWriterThread*) 0) {
+        this->thread->stop();
+        this->droppedCount += this->thread->getDropped();
+        delete this->thread;
+        this->thread = (DatasetWriterThread*) 0;
+    }
+    if(this->stream.is_open()) {
+        this->flush();
+        this->stream.close();
+    }
+    this->buffer.clear();
+}
+
+int DatasetWriter::getDroppedCount() {
+    if(this->thread != (DatasetWriterThread*) 0) {
+        return this->droppedCount + this->thread->getDropped();
+    }
+    return this->droppedCount;
+}
+
+void DatasetWriter::writeRecords(const std::vector<double>& records) {
+    if(records.empty() || this->columns == 0) {
+        return;
+    }
+
+    if(this->binary) {
+        this->stream.write(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(double));
+    } else {
+        const double* record = &records[0];
+        const double* end = record + records.size();
+        for(; record < end; record += this->columns) {
+            int k = 0;
+            for(size_t g = 0; g < this->groups.size(); g++) {
+                if(g > 0) this->stream << "  ";
+                for(int i = 0; i < this->groups[g]; i++, k++) {
+                    if(i > 0) this->stream << " ";
+                    this->stream << std::setw(this->precision + 4) << record[k];
+                }
+            }
+            this->stream << '\n';
+        }
+    }
+
+    this->stream.flush();
+}
+
+} // learningmachine
+} // iCub
@@ -32,6 +32,24 @@ void IFixedSizeMatrixInputLearner::feedSample(const yarp::sig::Matrix& input, co
     this->validateDomainSizes(input,output);
 }
 
+void IFixedSizeMatrixInputLearner::feedBatch(const yarp::sig::Matrix& inputs, const yarp::sig::Vector& outputs) {
+    int num_samples = this->validateBatchSizes(inputs,outputs);
+    yarp::sig::Matrix input(this->getDomainRows(),this->getDomainCols());
+    yarp::sig::Vector output(this->getCoDomainSize());
+    for(int s = 0; s < num_samples; s++) {
+        for(int r = 0; r < input.rows(); r++) {
+            const double* row = inputs[s*input.rows()+r];
+            for(int c = 0; c < input.cols(); c++) {
+                input(r,c) = row[c];
+            }
+        }
+        for(size_t i = 0; i < output.size(); i++) {
+            output[i] = outputs[s*output.size()+i];
+        }
+        this->feedSample(input,output);
+    }
+}
+
 
 void IFixedSizeMatrixInputLearner::train() {
 }
@@ -79,6 +97,17 @@ void IFixedSizeMatrixInputLearner::validateDomainSizes(const yarp::sig::Matrix&
     }
 }
 
+int IFixedSizeMatrixInputLearner::validateBatchSizes(const yarp::sig::Matrix& inputs, const yarp::sig::Vector& outputs) {
+    if(this->getDomainRows() == 0 || inputs.cols() != (int)this->getDomainCols() || inputs.rows() % this->getDomainRows() != 0) {
+        throw std::runtime_error("Input batch has invalid dimensionality");
+    }
+    int num_samples = inputs.rows()/this->getDomainRows();
+    if(outputs.size() != num_samples*this->getCoDomainSize()) {
+        throw std::runtime_error("Output batch has invalid dimensionality");
+    }
+    return num_samples;
+}
+
 void IFixedSizeMatrixInputLearner::writeBottle(yarp::os::Bottle& bot) {
     bot.addInt(this->getDomainRows());
     bot.addInt(this->getDomainCols());
@@ -40,6 +40,20 @@ void IFixedSizeTransformer::validateDomainSizes(const yarp::sig::Vector& input,
     }
 }
 
+void IFixedSizeTransformer::transformBatch(const yarp::sig::Matrix& input, yarp::sig::Matrix& output) {
+    this->validateBatchSizes(input, output);
+    this->ITransformer::transformBatch(input, output);
+}
+
+void IFixedSizeTransformer::validateBatchSizes(const yarp::sig::Matrix& input, yarp::sig::Matrix& output) {
+    if((unsigned int) input.cols() != this->getDomainSize()) {
+        throw std::runtime_error("Input samples have invalid dimensionality");
+    }
+    if(output.rows() != input.rows() || (unsigned int) output.cols() != this->getCoDomainSize()) {
+        output.resize(input.rows(), this->getCoDomainSize());
+    }
+}
+
 bool IFixedSizeTransformer::configure(yarp::os::Searchable& config) {
     bool success = false;
     // set the domain size (int)
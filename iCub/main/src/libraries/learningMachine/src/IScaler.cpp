@@ -35,6 +35,27 @@ double IScaler::transform(double val) {
     return (std::abs(this->scale) < 1.e-20) ? (val - this->offset) : (val - this->offset) / this->scale;
 }
 
+void IScaler::getAffine(double& shift, double& gain) {
+    shift = this->offset;
+    // check for division by zero
+    gain = (std::abs(this->scale) < 1.e-20) ? 1. : 1. / this->scale;
+}
+
+void IScaler::transformBatch(const double* input, int inStride,
+                             double* output, int outStride, int count) {
+    if(this->isAffine()) {
+        double shift, gain;
+        this->getAffine(shift, gain);
+        for(int k = 0; k < count; k++) {
+            output[k * outStride] = (input[k * inStride] - shift) * gain;
+        }
+    } else {
+        for(int k = 0; k < count; k++) {
+            output[k * outStride] = this->transform(input[k * inStride]);
+        }
+    }
+}
+
 
 std::string IScaler::getInfo() {
     std::ostringstream buffer;
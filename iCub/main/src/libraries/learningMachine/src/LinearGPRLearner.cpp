@@ -143,6 +143,31 @@ void LinearGPRLearner::readBottle(yarp::os::Bottle& bot) {
     bot >> this->sampleCount >> this->sigma >> this->W >> this->B >> this->R;
 }
 
+void LinearGPRLearner::getSufficientStatistics(SufficientStatistics& stats) {
+    // R is the Cholesky factor of sigma^2*I + sum x*x^T
+    stats.gram = cholgram(this->R) - eye(this->getDomainSize(), this->getDomainSize()) * (this->sigma * this->sigma);
+    stats.rhs = this->B;
+    stats.sampleCount = this->sampleCount;
+}
+
+void LinearGPRLearner::mergeSufficientStatistics(const SufficientStatistics& stats) {
+    if(stats.gram.rows() != (int)this->getDomainSize() || stats.rhs.rows() != (int)this->getCoDomainSize() ||
+       stats.rhs.cols() != (int)this->getDomainSize()) {
+        throw std::runtime_error("LinearGPRLearner: the statistics to merge have wrong dimensions");
+    }
+
+    // update R, factorizing again the sum of the covariances
+    this->R = choldecomp(cholgram(this->R) + stats.gram);
+
+    // update B
+    this->B = this->B + stats.rhs;
+
+    // update W
+    cholsolve(this->R, this->B, this->W);
+
+    this->sampleCount += stats.sampleCount;
+}
+
 void LinearGPRLearner::setDomainSize(unsigned int size) {
     this->IFixedSizeLearner::setDomainSize(size);
     this->reset();
@@ -20,6 +20,8 @@
 #include <stdexcept>
 #include <cmath>
 #include <limits>
+#include <vector>
+#include <algorithm>
 
 #include <gsl/gsl_blas.h>
 
@@ -34,7 +36,7 @@ namespace math {
 
 void dchud(double* r, int ldr, int p, double* x, double* z, int ldz, int nz,
            double* y, double* rho, double* c, double* s,
-           unsigned char rtrans, unsigned char ztrans) {
+           unsigned char rtrans, unsigned char ztrans, double* xwork) {
     unsigned int i;
     double* work = (double*) 0x0;
     double* tbuff = (double*) 0x0;
@@ -42,8 +44,8 @@ void dchud(double* r, int ldr, int p, double* x, double* z, int ldz, int nz,
     unsigned int stp2;
     double scale, workscale, rhoscale;
 
-    // create working copy of x
-    work = (double*) malloc(p * sizeof(double));
+    // create working copy of x, in the given buffer if any
+    work = (xwork != NULL) ? xwork : (double*) malloc(p * sizeof(double));
     cblas_dcopy(p, x, 1, work, 1);
 
     stp = (rtrans == 1) ? p : 1;
@@ -65,7 +67,9 @@ void dchud(double* r, int ldr, int p, double* x, double* z, int ldz, int nz,
             cblas_drot(p-i-1, tbuff+stp, stp, work+i+1, 1, c[i], s[i]);
         }
     }
-    free(work);
+    if(xwork == NULL) {
+        free(work);
+    }
 
     // update z and rho if applicable
     if(nz > 0) {
@@ -100,7 +104,7 @@ void dchud(double* r, int ldr, int p, double* x, double* z, int ldz, int nz,
 
 void gsl_linalg_cholesky_update(gsl_matrix* R, gsl_vector* x, gsl_vector* c, gsl_vector* s,
                                 gsl_matrix* Z, gsl_vector* y, gsl_vector* rho,
-                                unsigned char rtrans, unsigned char ztrans) {
+                                unsigned char rtrans, unsigned char ztrans, gsl_vector* work) {
     int i, j;
     int ldr, p;
     int ldz = 0;
@@ -121,7 +125,8 @@ void gsl_linalg_cholesky_update(gsl_matrix* R, gsl_vector* x, gsl_vector* c, gsl
         rhop = rho->data;
     }
 
-    dchud(R->data, ldr, p, x->data, Zp, ldz, nz, yp, rhop, c->data, s->data, rtrans, ztrans);
+    dchud(R->data, ldr, p, x->data, Zp, ldz, nz, yp, rhop, c->data, s->data, rtrans, ztrans,
+          (work != NULL) ? work->data : NULL);
 
     // reflect, as GSL functions expects duplicate information (i.e., lower and upper triangles)
     for(i = 0; i < p; i++) {
@@ -160,6 +165,19 @@ void cholupdate(yarp::sig::Matrix& R, const yarp::sig::Vector& x, bool rtrans) {
     gsl_linalg_cholesky_update(Rgsl, xgsl, cgsl, sgsl, NULL, NULL, NULL, (unsigned char) rtrans, 0);
 }
 
+void cholupdate(yarp::sig::Matrix& R, const yarp::sig::Vector& x, yarp::sig::Vector& c, yarp::sig::Vector& s,
+                yarp::sig::Vector& work, bool rtrans) {
+    assert((int)c.size() == R.cols() && (int)s.size() == R.cols() && (int)work.size() == R.cols());
+
+    gsl_matrix* Rgsl = (gsl_matrix*) R.getGslMatrix();
+    gsl_vector* xgsl = (gsl_vector*) x.getGslVector();
+    gsl_vector* cgsl = (gsl_vector*) c.getGslVector();
+    gsl_vector* sgsl = (gsl_vector*) s.getGslVector();
+    gsl_vector* workgsl = (gsl_vector*) work.getGslVector();
+
+    gsl_linalg_cholesky_update(Rgsl, xgsl, cgsl, sgsl, NULL, NULL, NULL, (unsigned char) rtrans, 0, workgsl);
+}
+
 void cholsolve(const yarp::sig::Matrix& R, const yarp::sig::Matrix& B, yarp::sig::Matrix& X) {
     assert(B.rows() == X.rows());
     assert(B.cols() == X.cols());
@@ -223,6 +241,22 @@ yarp::sig::Matrix choldecomp(const yarp::sig::Matrix& A) {
     return R;
 }
 
+yarp::sig::Matrix cholgram(const yarp::sig::Matrix& R) {
+    assert(R.rows() == R.cols());
+    yarp::sig::Matrix A(R.rows(), R.cols());
+    for(int i = 0; i < R.rows(); i++) {
+        for(int j = i; j < R.cols(); j++) {
+            double sum = 0.0;
+            for(int k = 0; k <= i; k++) {
+                sum += R(k, i) * R(k, j);
+            }
+            A(i, j) = sum;
+            A(j, i) = sum;
+        }
+    }
+    return A;
+}
+
 yarp::sig::Matrix outerprod(const yarp::sig::Vector& v1, const yarp::sig::Vector& v2) {
     yarp::sig::Matrix out(v1.size(), v2.size());
     for(int r = 0; r < out.rows(); r++) {
@@ -413,6 +447,98 @@ yarp::sig::Vector diagonal(yarp::sig::Matrix & mat) {
     return ret;
 }
 
+void addgram(yarp::sig::Matrix& A, const yarp::sig::Matrix& M, const yarp::sig::Vector& w) {
+    assert(A.rows() == M.cols() && A.cols() == M.cols());
+    assert(w.size() == 0 || (int)w.size() == M.rows());
+    for(int r = 0; r < M.rows(); r++) {
+        const double weight = (w.size() == 0) ? 1.0 : w[r];
+        if(weight == 0.0) continue;
+        const double* row = M[r];
+        for(int i = 0; i < M.cols(); i++) {
+            if(row[i] == 0.0) continue;
+            const double a = weight*row[i];
+            double* A_row = A[i];
+            for(int j = 0; j < M.cols(); j++) {
+                if(row[j] != 0.0) A_row[j] += a*row[j];
+            }
+        }
+    }
+}
+
+void addtransposedproduct(yarp::sig::Vector& b, const yarp::sig::Matrix& M, const yarp::sig::Vector& w, const yarp::sig::Vector& y) {
+    assert((int)b.size() == M.cols() && (int)y.size() == M.rows());
+    assert(w.size() == 0 || (int)w.size() == M.rows());
+    for(int r = 0; r < M.rows(); r++) {
+        const double a = ((w.size() == 0) ? 1.0 : w[r])*y[r];
+        if(a == 0.0) continue;
+        const double* row = M[r];
+        for(int c = 0; c < M.cols(); c++) {
+            if(row[c] != 0.0) b[c] += a*row[c];
+        }
+    }
+}
+
+void resizepattern(std::vector<int>& columns, std::vector<int>& nonzeros, int rows, int cols) {
+    columns.resize(rows*cols);
+    nonzeros.assign(rows, 0);
+    for(int r = 0; r < rows; r++) {
+        for(int c = 0; c < cols; c++) {
+            columns[r*cols+c] = c;
+        }
+    }
+}
+
+void updatepattern(std::vector<int>& columns, std::vector<int>& nonzeros, const yarp::sig::Matrix& M) {
+    assert((int)nonzeros.size() == M.rows() && (int)columns.size() == M.rows()*M.cols());
+    for(int r = 0; r < M.rows(); r++) {
+        const double* row = M[r];
+        int* row_columns = &(columns[r*M.cols()]);
+        //only the columns not yet in the pattern are checked
+        for(int k = nonzeros[r]; k < M.cols(); k++) {
+            if(row[row_columns[k]] != 0.0) {
+                std::swap(row_columns[k], row_columns[nonzeros[r]]);
+                nonzeros[r]++;
+            }
+        }
+    }
+}
+
+void addgram(yarp::sig::Matrix& A, const yarp::sig::Matrix& M, const yarp::sig::Vector& w,
+             const std::vector<int>& columns, const std::vector<int>& nonzeros) {
+    assert(A.rows() == M.cols() && A.cols() == M.cols());
+    assert(w.size() == 0 || (int)w.size() == M.rows());
+    assert((int)nonzeros.size() == M.rows() && (int)columns.size() == M.rows()*M.cols());
+    for(int r = 0; r < M.rows(); r++) {
+        const double weight = (w.size() == 0) ? 1.0 : w[r];
+        if(weight == 0.0) continue;
+        const double* row = M[r];
+        const int* row_columns = &(columns[r*M.cols()]);
+        for(int i = 0; i < nonzeros[r]; i++) {
+            const double a = weight*row[row_columns[i]];
+            double* A_row = A[row_columns[i]];
+            for(int j = 0; j < nonzeros[r]; j++) {
+                A_row[row_columns[j]] += a*row[row_columns[j]];
+            }
+        }
+    }
+}
+
+void addtransposedproduct(yarp::sig::Vector& b, const yarp::sig::Matrix& M, const yarp::sig::Vector& w, const yarp::sig::Vector& y,
+                          const std::vector<int>& columns, const std::vector<int>& nonzeros) {
+    assert((int)b.size() == M.cols() && (int)y.size() == M.rows());
+    assert(w.size() == 0 || (int)w.size() == M.rows());
+    assert((int)nonzeros.size() == M.rows() && (int)columns.size() == M.rows()*M.cols());
+    for(int r = 0; r < M.rows(); r++) {
+        const double a = ((w.size() == 0) ? 1.0 : w[r])*y[r];
+        if(a == 0.0) continue;
+        const double* row = M[r];
+        const int* row_columns = &(columns[r*M.cols()]);
+        for(int i = 0; i < nonzeros[r]; i++) {
+            b[row_columns[i]] += a*row[row_columns[i]];
+        }
+    }
+}
+
 } // math
 } // learningmachine
 } // iCub
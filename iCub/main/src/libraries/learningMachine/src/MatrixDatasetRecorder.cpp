@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2007-2012 RobotCub Consortium, European Commission FP6 Project IST-004370
+ * author:  Silvio Traversaro
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include <yarp/os/Time.h>
+
+#include "iCub/learningMachine/MatrixDatasetRecorder.h"
+#include "iCub/learningMachine/Serialization.h"
+
+using namespace iCub::learningmachine::serialization;
+
+namespace iCub {
+namespace learningmachine {
+
+MatrixDatasetRecorder::MatrixDatasetRecorder(unsigned int domRows, unsigned int domCols, unsigned int cod)
+  : IFixedSizeMatrixInputLearner(domRows, domCols, cod), filename("dataset.lmds"), format("binary"),
+    precision(8), async(true), flushSize(1000), flushInterval(1.), source(0), timestamp(-1.),
+    sampleCount(0), writer((DatasetWriter*) 0) {
+    this->setName("MatrixRecorder");
+}
+
+MatrixDatasetRecorder::MatrixDatasetRecorder(const MatrixDatasetRecorder& other)
+  : IFixedSizeMatrixInputLearner(other), filename(other.filename), format(other.format),
+    precision(other.precision), async(other.async), flushSize(other.flushSize),
+    flushInterval(other.flushInterval), source(other.source), timestamp(other.timestamp),
+    sampleCount(other.sampleCount), writer((DatasetWriter*) 0) {
+}
+
+MatrixDatasetRecorder::~MatrixDatasetRecorder() {
+    delete this->writer;
+}
+
+MatrixDatasetRecorder& MatrixDatasetRecorder::operator=(const MatrixDatasetRecorder& other) {
+    if(this == &other) return *this; // handle self initialization
+
+    this->reset();
+    this->IFixedSizeMatrixInputLearner::operator=(other);
+    this->filename = other.filename;
+    this->format = other.format;
+    this->precision = other.precision;
+    this->async = other.async;
+    this->flushSize = other.flushSize;
+    this->flushInterval = other.flushInterval;
+    this->source = other.source;
+    this->timestamp = other.timestamp;
+    this->sampleCount = other.sampleCount;
+
+    return *this;
+}
+
+void MatrixDatasetRecorder::open() {
+    const int rows = this->getDomainRows();
+    const int cols = this->getDomainCols();
+    const int cod = this->getCoDomainSize();
+
+    std::vector<int> groups(4);
+    groups[0] = 1;
+    groups[1] = 1;
+    groups[2] = rows * cols;
+    groups[3] = cod;
+
+    std::vector<std::string> names;
+    names.push_back("time");
+    names.push_back("source");
+    for(int r = 0; r < rows; r++) {
+        for(int c = 0; c < cols; c++) {
+            std::ostringstream name;
+            name << "x" << r << "_" << c;
+            names.push_back(name.str());
+        }
+    }
+    for(int i = 0; i < cod; i++) {
+        std::ostringstream name;
+        name << "y" << i;
+        names.push_back(name.str());
+    }
+
+    this->writer = new DatasetWriter(this->format == "binary", this->precision, this->async,
+                                     this->flushSize, this->flushInterval);
+    try {
+        this->writer->open(this->filename, groups, names);
+    } catch(const std::runtime_error&) {
+        delete this->writer;
+        this->writer = (DatasetWriter*) 0;
+        throw;
+    }
+    this->record.resize(2 + rows * cols + cod);
+}
+
+void MatrixDatasetRecorder::feedSample(const yarp::sig::Matrix& input, const yarp::sig::Vector& output) {
+    this->IFixedSizeMatrixInputLearner::feedSample(input, output);
+
+    // open writer if not opened yet
+    if(this->writer == (DatasetWriter*) 0) {
+        this->open();
+    }
+
+    std::vector<double>::iterator it = this->record.begin();
+    *it++ = (this->timestamp < 0.) ? yarp::os::Time::now() : this->timestamp;
+    *it++ = this->source;
+    // the rows of a yarp::sig::Matrix are contiguous
+    it = std::copy(input.data(), input.data() + input.rows() * input.cols(), it);
+    std::copy(output.data(), output.data() + output.size(), it);
+    this->writer->write(&this->record[0]);
+    this->sampleCount++;
+}
+
+void MatrixDatasetRecorder::train() {
+    if(this->writer != (DatasetWriter*) 0) {
+        this->writer->flush();
+    }
+}
+
+void MatrixDatasetRecorder::reset() {
+    delete this->writer;
+    this->writer = (DatasetWriter*) 0;
+    this->sampleCount = 0;
+}
+
+void MatrixDatasetRecorder::setDomainRows(unsigned int rows) {
+    this->reset();
+    this->IFixedSizeMatrixInputLearner::setDomainRows(rows);
+}
+
+void MatrixDatasetRecorder::setDomainCols(unsigned int cols) {
+    this->reset();
+    this->IFixedSizeMatrixInputLearner::setDomainCols(cols);
+}
+
+void MatrixDatasetRecorder::setCoDomainSize(unsigned int size) {
+    this->reset();
+    this->IFixedSizeMatrixInputLearner::setCoDomainSize(size);
+}
+
+std::string MatrixDatasetRecorder::getInfo() {
+    std::ostringstream buffer;
+    buffer << this->IFixedSizeMatrixInputLearner::getInfo();
+    buffer << "Filename: " << this->filename << std::endl;
+    buffer << "Format: " << this->format << std::endl;
+    buffer << "Source: " << this->source << std::endl;
+    buffer << "Asynchronous: " << (this->async ? "yes" : "no") << std::endl;
+    buffer << "Flush: every " << this->flushSize << " samples or "
+           << this->flushInterval << " seconds" << std::endl;
+    buffer << "Sample Count: " << this->sampleCount << std::endl;
+    if(this->writer != (DatasetWriter*) 0) {
+        buffer << "Dropped Samples: " << this->writer->getDroppedCount() << std::endl;
+    }
+    return buffer.str();
+}
+
+void MatrixDatasetRecorder::writeBottle(yarp::os::Bottle& bot) {
+    bot.addString(this->filename.c_str());
+    bot.addString(this->format.c_str());
+    bot << this->precision << this->async << this->flushSize << this->flushInterval << this->source;
+    // make sure to call the superclass's method
+    this->IFixedSizeMatrixInputLearner::writeBottle(bot);
+}
+
+void MatrixDatasetRecorder::readBottle(yarp::os::Bottle& bot) {
+    this->reset();
+    // make sure to call the superclass's method
+    this->IFixedSizeMatrixInputLearner::readBottle(bot);
+    bot >> this->source >> this->flushInterval >> this->flushSize >> this->async >> this->precision;
+    this->format = bot.pop().asString().c_str();
+    this->filename = bot.pop().asString().c_str();
+}
+
+std::string MatrixDatasetRecorder::getConfigHelp() {
+    std::ostringstream buffer;
+    buffer << this->IFixedSizeMatrixInputLearner::getConfigHelp();
+    buffer << "  filename name             Filename to write to" << std::endl;
+    buffer << "  format text|binary        File format (default binary)" << std::endl;
+    buffer << "  precision n               Number of digits precision for doubles (text)" << std::endl;
+    buffer << "  async 0|1                 Write from a background thread" << std::endl;
+    buffer << "  flush_size n              Number of buffered samples that triggers a write" << std::endl;
+    buffer << "  flush_interval t          Maximum time in seconds between writes (0 disables)" << std::endl;
+    buffer << "  source id                 Identifier of the source of the samples" << std::endl;
+    return buffer.str();
+}
+
+bool MatrixDatasetRecorder::configure(yarp::os::Searchable& config) {
+    bool success = this->IFixedSizeMatrixInputLearner::configure(config);
+
+    // set the filename
+    if(config.find("filename").isString()) {
+        this->reset();
+        this->filename = config.find("filename").asString().c_str();
+        success = true;
+    }
+
+    // set the file format
+    if(config.find("format").isString()) {
+        std::string f = config.find("format").asString().c_str();
+        if(f == "text" || f == "binary") {
+            this->reset();
+            this->format = f;
+            success = true;
+        }
+    }
+
+    // set the precision
+    if(config.find("precision").isInt()) {
+        this->reset();
+        this->precision = config.find("precision").asInt();
+        success = true;
+    }
+
+    // enable or disable the background writer
+    if(config.find("async").isInt()) {
+        this->reset();
+        this->async = (config.find("async").asInt() != 0);
+        success = true;
+    }
+
+    // set the number of samples that triggers a write
+    if(config.find("flush_size").isInt()) {
+        this->reset();
+        this->flushSize = config.find("flush_size").asInt();
+        success = true;
+    }
+
+    // set the maximum time between writes
+    if(config.find("flush_interval").isDouble() || config.find("flush_interval").isInt()) {
+        this->reset();
+        this->flushInterval = config.find("flush_interval").asDouble();
+        success = true;
+    }
+
+    // set the identifier of the source
+    if(config.find("source").isInt()) {
+        this->source = config.find("source").asInt();
+        success = true;
+    }
+
+    return success;
+}
+
+} // learningmachine
+} // iCub
@@ -140,6 +140,15 @@ yarp::sig::Vector MultiTaskLinearFixedParameters::getParameters() const {
     return this->w;
 }
 
+void MultiTaskLinearFixedParameters::copyParameters(yarp::sig::Vector& parameters) const {
+    if( parameters.size() != this->w.size() ) {
+        parameters.resize(this->w.size());
+    }
+    for(int i = 0; i < (int)this->w.size(); i++) {
+        parameters[i] = this->w[i];
+    }
+}
+
 void  MultiTaskLinearFixedParameters::setParameters(const yarp::sig::Vector & parameters) {
     if( parameters.size() != this->getDomainCols() ) {
         throw std::runtime_error("MultiTaskLinearFixedParameters: wrong parameter size");
@@ -60,7 +60,9 @@ MultiTaskLinearGPRLearner::MultiTaskLinearGPRLearner(const MultiTaskLinearGPRLea
   : IParameterLearner(other), sampleCount(other.sampleCount), R(other.R),
     b(other.b), w(other.w), A(other.A), inv_Sigma_n(other.inv_Sigma_n), 
     inv_Sigma_w(other.inv_Sigma_w), no_output_error(other.no_output_error),
-    weight_prior_indefinite(other.weight_prior_indefinite), A_not_full_rank(other.A_not_full_rank) {
+    weight_prior_indefinite(other.weight_prior_indefinite), A_not_full_rank(other.A_not_full_rank),
+    row_weights(other.row_weights), pattern_columns(other.pattern_columns), pattern_nonzeros(other.pattern_nonzeros),
+    row_buffer(other.row_buffer), c_buffer(other.c_buffer), s_buffer(other.s_buffer), work_buffer(other.work_buffer) {
 }
 
 MultiTaskLinearGPRLearner::~MultiTaskLinearGPRLearner() {
@@ -76,45 +78,52 @@ MultiTaskLinearGPRLearner& MultiTaskLinearGPRLearner::operator=(const MultiTaskL
     this->b = other.b;
     this->w = other.w;
     this->A = other.A;
+    this->inv_Sigma_n = other.inv_Sigma_n;
+    this->inv_Sigma_w = other.inv_Sigma_w;
     
     this->no_output_error = other.no_output_error;
     this->weight_prior_indefinite = other.weight_prior_indefinite;
     this->A_not_full_rank= other.A_not_full_rank;
     
+    this->row_weights = other.row_weights;
+    this->pattern_columns = other.pattern_columns;
+    this->pattern_nonzeros = other.pattern_nonzeros;
+    this->row_buffer = other.row_buffer;
+    this->c_buffer = other.c_buffer;
+    this->s_buffer = other.s_buffer;
+    this->work_buffer = other.work_buffer;
+    
     return *this;
 }
 
 
 void MultiTaskLinearGPRLearner::feedSample(const yarp::sig::Matrix& input_matrix, const yarp::sig::Vector& output) {
     this->IFixedSizeMatrixInputLearner::feedSample(input_matrix, output);
+    if( (int)this->pattern_nonzeros.size() != this->getDomainRows() || (int)this->row_buffer.size() != this->getDomainCols() ) {
+        this->resizeBuffers();
+    }
+    
+    //the input matrix is usually a regressor with many structural zeros,
+    //so the products consider only the pattern of its non zeros 
+    updatepattern(this->pattern_columns, this->pattern_nonzeros, input_matrix);
    
     //update R (or, until it is full rank, A)
     if( ! this->A_not_full_rank) {
-        //update R
-           if( ! this->no_output_error ) {
-            for(int i = 0; i < this->getDomainRows(); i++ ) {
-                //diagonal assumption
-                cholupdate(this->R, sqrt(inv_Sigma_n(i,i))*input_matrix.getRow(i));
-            }
-        } else {
-            for(int i = 0; i < this->getDomainRows(); i++ ) {
-                //diagonal assumption
-                cholupdate(this->R, input_matrix.getRow(i));
+        //update R with the rows scaled by the square root of their weight (diagonal assumption)
+        for(int i = 0; i < this->getDomainRows(); i++ ) {
+            const double scale = (this->row_weights.size() == 0) ? 1.0 : sqrt(this->row_weights[i]);
+            const double* row = input_matrix[i];
+            for(int c = 0; c < this->getDomainCols(); c++ ) {
+                this->row_buffer[c] = scale*row[c];
             }
+            cholupdate(this->R, this->row_buffer, this->c_buffer, this->s_buffer, this->work_buffer);
         }
  
     } else {
         assert(this->A_not_full_rank);
-        if( this->no_output_error ) {
-            //update A
-            this->A += input_matrix.transposed()*input_matrix;
-            
-        } else {
-
-            assert(this->weight_prior_indefinite);
-            //Update A
-            this->A += input_matrix.transposed()*inv_Sigma_n*input_matrix;
-        }
+        assert(this->no_output_error || this->weight_prior_indefinite);
+        //update A
+        addgram(this->A, input_matrix, this->row_weights, this->pattern_columns, this->pattern_nonzeros);
         //check if after the update, A became of full rank
         if( isfullrank(this->A) ) {
                 this->R = choldecomp(A);
@@ -122,17 +131,8 @@ void MultiTaskLinearGPRLearner::feedSample(const yarp::sig::Matrix& input_matrix
         } 
     }
     
-    
     //update b
-    if( !this->no_output_error ) {
-    
-        this->b += input_matrix.transposed()*inv_Sigma_n*output;
-        
-    } else {
-        
-        this->b = this->b + input_matrix.transposed()*output;
-        
-    }
+    addtransposedproduct(this->b, input_matrix, this->row_weights, output, this->pattern_columns, this->pattern_nonzeros);
     
     //update w 
     if( ! this->A_not_full_rank) {
@@ -147,6 +147,51 @@ void MultiTaskLinearGPRLearner::feedSample(const yarp::sig::Matrix& input_matrix
 
 }
 
+void MultiTaskLinearGPRLearner::feedBatch(const yarp::sig::Matrix& inputs, const yarp::sig::Vector& outputs) {
+    int num_samples = this->validateBatchSizes(inputs, outputs);
+    if( num_samples == 0 ) return;
+
+    //weights of the stacked rows (diagonal assumption)
+    yarp::sig::Vector batch_weights;
+    if( this->row_weights.size() != 0 ) {
+        batch_weights.resize(inputs.rows());
+        for(int r = 0; r < inputs.rows(); r++ ) {
+            batch_weights[r] = this->row_weights[r % this->getDomainRows()];
+        }
+    }
+
+    //update R (or, until it is full rank, A)
+    if( ! this->A_not_full_rank) {
+        yarp::sig::Vector row(inputs.cols());
+        for(int r = 0; r < inputs.rows(); r++ ) {
+            const double scale = (batch_weights.size() == 0) ? 1.0 : sqrt(batch_weights[r]);
+            for(int c = 0; c < inputs.cols(); c++ ) {
+                row[c] = scale*inputs(r,c);
+            }
+            cholupdate(this->R, row);
+        }
+    } else {
+        //the rank of A is checked once, after adding all the samples of the batch
+        addgram(this->A, inputs, batch_weights);
+        if( isfullrank(this->A) ) {
+                this->R = choldecomp(A);
+                this->A_not_full_rank= false;
+        }
+    }
+
+    //update b
+    addtransposedproduct(this->b, inputs, batch_weights, outputs);
+
+    //update w, once for the batch
+    if( ! this->A_not_full_rank) {
+        cholsolve(this->R, this->b, this->w);
+    } else {
+        this->w = yarp::math::pinv(this->A,1e-5)*this->b;
+    }
+
+    this->sampleCount += num_samples;
+}
+
 void MultiTaskLinearGPRLearner::train() {
 };
 
@@ -173,8 +218,50 @@ Prediction MultiTaskLinearGPRLearner::predict(const yarp::sig::Matrix& input) {
 
 }
 
+void MultiTaskLinearGPRLearner::predict(const yarp::sig::Matrix& input, yarp::sig::Vector& output, yarp::sig::Vector& std) {
+    if( !this->checkDomainSize(input) ) {
+        throw std::runtime_error("Input sample has invalid dimensionality");
+    }
+    if( (int)this->row_buffer.size() != this->getDomainCols() ) {
+        this->resizeBuffers();
+    }
+    if( (int)output.size() != input.rows() ) {
+        output.resize(input.rows());
+    }
+    if( (int)std.size() != input.rows() ) {
+        std.resize(input.rows());
+    }
+
+    for(int i = 0; i < input.rows(); i++ ) {
+        const double* row = input[i];
+        double prediction = 0.0;
+        for(int c = 0; c < this->getDomainCols(); c++ ) {
+            prediction += row[c]*this->w[c];
+            this->row_buffer[c] = row[c];
+        }
+        output[i] = prediction;
+
+        //the variance is the diagonal element of input*inv(R^T*R)*input^T 
+        cholsolve(this->R, this->row_buffer, this->work_buffer);
+        double variance = 0.0;
+        for(int c = 0; c < this->getDomainCols(); c++ ) {
+            variance += row[c]*this->work_buffer[c];
+        }
+        std[i] = sqrt(variance);
+    }
+}
+
+void MultiTaskLinearGPRLearner::resizeBuffers() {
+    resizepattern(this->pattern_columns, this->pattern_nonzeros, this->getDomainRows(), this->getDomainCols());
+    this->row_buffer.resize(this->getDomainCols());
+    this->c_buffer.resize(this->getDomainCols());
+    this->s_buffer.resize(this->getDomainCols());
+    this->work_buffer.resize(this->getDomainCols());
+}
+
 void MultiTaskLinearGPRLearner::reset() {
     this->sampleCount = 0;
+    this->resizeBuffers();
     if( this->no_output_error ) {
         this->A_not_full_rank = true;
         this->A = zeros(this->getDomainCols(), this->getDomainCols());
@@ -225,6 +312,13 @@ void MultiTaskLinearGPRLearner::readBottle(yarp::os::Bottle& bot) {
     // make sure to call the superclass's method
     this->IFixedSizeMatrixInputLearner::readBottle(bot);
     bot >> this->sampleCount >> this->A_not_full_rank >> this->weight_prior_indefinite >> this->no_output_error >> this->inv_Sigma_w >> this->inv_Sigma_n >> this->A >> this->w >> this->b >> this->R;
+    //the row weights and the pattern are not serialized
+    if( this->no_output_error ) {
+        this->row_weights.resize(0);
+    } else {
+        this->row_weights = diagonal(this->inv_Sigma_n);
+    }
+    this->resizeBuffers();
 }
 
 void MultiTaskLinearGPRLearner::setNoiseStandardDeviation(double s) {
@@ -238,9 +332,11 @@ void MultiTaskLinearGPRLearner::setNoiseStandardDeviation(const yarp::sig::Vecto
     }
     
     inv_Sigma_n = zeros(this->getDomainRows(),this->getDomainRows());
+    row_weights.resize(this->getDomainRows());
     
     for(unsigned i=0; i < s.size(); i++ ) {
         inv_Sigma_n(i,i) = 1/(s[i]*s[i]);
+        row_weights[i] = inv_Sigma_n(i,i);
     }
     
     this->no_output_error = false;
@@ -295,6 +391,94 @@ yarp::sig::Vector MultiTaskLinearGPRLearner::getParameters() const {
     return this->w;
 }
 
+yarp::sig::Vector MultiTaskLinearGPRLearner::getParametersStandardDeviation() const {
+    if( this->A_not_full_rank ) {
+        return yarp::sig::Vector(0);
+    }
+    //the posterior covariance of the weights is the inverse of R^T*R
+    yarp::sig::Matrix cov = cholsolve(this->R, eye(this->R.rows(), this->R.rows()));
+    yarp::sig::Vector sd(cov.rows());
+    for(int i = 0; i < cov.rows(); i++) {
+        sd[i] = sqrt(cov(i,i));
+    }
+    return sd;
+}
+
+void MultiTaskLinearGPRLearner::copyParameters(yarp::sig::Vector& parameters) const {
+    if( parameters.size() != this->w.size() ) {
+        parameters.resize(this->w.size());
+    }
+    for(int i = 0; i < (int)this->w.size(); i++) {
+        parameters[i] = this->w[i];
+    }
+}
+
+bool MultiTaskLinearGPRLearner::copyParametersStandardDeviation(yarp::sig::Vector& sd) {
+    if( this->A_not_full_rank ) {
+        return false;
+    }
+    if( (int)this->row_buffer.size() != this->getDomainCols() ) {
+        this->resizeBuffers();
+    }
+    const int n = this->R.rows();
+    if( (int)sd.size() != n ) {
+        sd.resize(n);
+    }
+    //the i-th diagonal element of the inverse of R^T*R, solving for the i-th column of the identity
+    this->row_buffer.zero();
+    for(int i = 0; i < n; i++) {
+        this->row_buffer[i] = 1.0;
+        cholsolve(this->R, this->row_buffer, this->work_buffer);
+        this->row_buffer[i] = 0.0;
+        sd[i] = sqrt(this->work_buffer[i]);
+    }
+    return true;
+}
+
+void MultiTaskLinearGPRLearner::getSufficientStatistics(SufficientStatistics& stats) {
+    if( this->A_not_full_rank ) {
+        stats.gram = this->A;
+    } else if( !this->no_output_error && !this->weight_prior_indefinite ) {
+        //R is the Cholesky factor of inv_Sigma_w + sum X^T*inv_Sigma_n*X
+        stats.gram = cholgram(this->R) - this->inv_Sigma_w;
+    } else {
+        stats.gram = cholgram(this->R);
+    }
+    stats.rhs.resize(1,this->b.size());
+    stats.rhs.setRow(0,this->b);
+    stats.sampleCount = this->sampleCount;
+}
+
+void MultiTaskLinearGPRLearner::mergeSufficientStatistics(const SufficientStatistics& stats) {
+    if( stats.gram.rows() != (int)this->getDomainCols() || stats.rhs.rows() != 1 || 
+        stats.rhs.cols() != (int)this->getDomainCols() ) {
+        throw std::runtime_error("MultiTaskLinearGPRLearner: the statistics to merge have wrong dimensions");
+    }
+    
+    //update R (or, until it is full rank, A)
+    if( ! this->A_not_full_rank ) {
+        this->R = choldecomp(cholgram(this->R) + stats.gram);
+    } else {
+        this->A = this->A + stats.gram;
+        if( isfullrank(this->A) ) {
+                this->R = choldecomp(A);
+                this->A_not_full_rank= false;
+        }
+    }
+    
+    //update b
+    this->b = this->b + stats.rhs.getRow(0);
+    
+    //update w
+    if( ! this->A_not_full_rank) {
+        cholsolve(this->R, this->b, this->w);
+    } else {
+        this->w = yarp::math::pinv(this->A,1e-5)*this->b;
+    }
+    
+    this->sampleCount += stats.sampleCount;
+}
+
 /*
 yarp::sig::Vector MultiTaskLinearGPRLearner::saveParameters(const string file_name) const {
 }
@@ -392,8 +576,17 @@ Prediction MultiTaskLinearGPRLearner::predict(const yarp::sig::Vector& input_fea
     return Prediction(output);
 }
 
+void MultiTaskLinearGPRLearner::resizeBuffers() {
+    resizepattern(this->pattern_columns, this->pattern_nonzeros, this->getDomainRows(), this->getDomainCols());
+    this->row_buffer.resize(this->getDomainCols());
+    this->c_buffer.resize(this->getDomainCols());
+    this->s_buffer.resize(this->getDomainCols());
+    this->work_buffer.resize(this->getDomainCols());
+}
+
 void MultiTaskLinearGPRLearner::reset() {
     this->sampleCount = 0;
+    this->resizeBuffers();
     this->R = eye(this->getDomainSize(), this->getDomainSize())
     this->b = zeros(this->getDomainSize());
     this->w = zeros(this->getDomainSize());
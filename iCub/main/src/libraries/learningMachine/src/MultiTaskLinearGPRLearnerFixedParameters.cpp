@@ -299,6 +299,20 @@ yarp::sig::Vector MultiTaskLinearGPRLearnerFixedParameters::getParameters() cons
     return parameters;
 }
 
+void MultiTaskLinearGPRLearnerFixedParameters::copyParameters(yarp::sig::Vector& parameters) const {
+    const int n_fixed = this->fixed_w.size();
+    const int n = n_fixed+this->w.size();
+    if( (int)parameters.size() != n ) {
+        parameters.resize(n);
+    }
+    for(int i = 0; i < n_fixed; i++) {
+        parameters[i] = this->fixed_w[i];
+    }
+    for(int i = n_fixed; i < n; i++) {
+        parameters[i] = this->w[i-n_fixed];
+    }
+}
+
 /**
 	
 MultiTaskLinearGPRLearner::MultiTaskLinearGPRLearner(unsigned int dom, unsigned int cod, double sigma) {
@@ -133,6 +133,31 @@ void RLSLearner::readBottle(yarp::os::Bottle& bot) {
     bot >> this->sampleCount >> this->lambda >> this->W >> this->B >> this->R;
 }
 
+void RLSLearner::getSufficientStatistics(SufficientStatistics& stats) {
+    // R is the Cholesky factor of lambda*I + sum x*x^T
+    stats.gram = cholgram(this->R) - eye(this->getDomainSize(), this->getDomainSize()) * this->lambda;
+    stats.rhs = this->B;
+    stats.sampleCount = this->sampleCount;
+}
+
+void RLSLearner::mergeSufficientStatistics(const SufficientStatistics& stats) {
+    if(stats.gram.rows() != (int)this->getDomainSize() || stats.rhs.rows() != (int)this->getCoDomainSize() ||
+       stats.rhs.cols() != (int)this->getDomainSize()) {
+        throw std::runtime_error("RLSLearner: the statistics to merge have wrong dimensions");
+    }
+
+    // update R, factorizing again the sum of the covariances
+    this->R = choldecomp(cholgram(this->R) + stats.gram);
+
+    // update B
+    this->B = this->B + stats.rhs;
+
+    // update W
+    cholsolve(this->R, this->B, this->W);
+
+    this->sampleCount += stats.sampleCount;
+}
+
 void RLSLearner::setDomainSize(unsigned int size) {
     this->IFixedSizeLearner::setDomainSize(size);
     this->reset();
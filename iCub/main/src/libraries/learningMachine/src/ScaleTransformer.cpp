@@ -103,11 +103,48 @@ yarp::sig::Vector ScaleTransformer::transform(const yarp::sig::Vector& input) {
     assert(output.size() == int(this->scalers.size()));
 
     for(size_t i = 0; i < output.size(); i++) {
-        output(i) = this->getAt(i)->transform(input(i));
+        output(i) = this->scalers[i]->transform(input(i));
     }
     return output;
 }
 
+void ScaleTransformer::transformBatch(const yarp::sig::Matrix& input, yarp::sig::Matrix& output) {
+    this->validateBatchSizes(input, output);
+    const int rows = input.rows();
+    const int cols = int(this->scalers.size());
+    this->sampleCount += rows;
+    if(rows == 0 || cols == 0) {
+        return;
+    }
+
+    bool affine = true;
+    for(int i = 0; i < cols && affine; i++) {
+        affine = this->scalers[i]->isAffine();
+    }
+
+    if(affine) {
+        // fused kernel: one pass over the contiguous block
+        std::vector<double> shift(cols);
+        std::vector<double> gain(cols);
+        for(int i = 0; i < cols; i++) {
+            this->scalers[i]->getAffine(shift[i], gain[i]);
+        }
+        const double* s = &shift[0];
+        const double* g = &gain[0];
+        const double* in = input.data();
+        double* out = output.data();
+        for(int r = 0; r < rows; r++, in += cols, out += cols) {
+            for(int i = 0; i < cols; i++) {
+                out[i] = (in[i] - s[i]) * g[i];
+            }
+        }
+    } else {
+        for(int i = 0; i < cols; i++) {
+            this->scalers[i]->transformBatch(input.data() + i, cols, output.data() + i, cols, rows);
+        }
+    }
+}
+
 void ScaleTransformer::setDomainSize(unsigned int size) {
     // domain size and codomain have to be equally sized
     this->IFixedSizeTransformer::setDomainSize(size);
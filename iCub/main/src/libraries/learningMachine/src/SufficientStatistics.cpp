@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2007-2012 RobotCub Consortium, European Commission FP6 Project IST-004370
+ * author:  Silvio Traversaro
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include <stdexcept>
+
+#include "iCub/learningMachine/SufficientStatistics.h"
+#include "iCub/learningMachine/Serialization.h"
+
+using namespace iCub::learningmachine::serialization;
+
+namespace iCub {
+namespace learningmachine {
+
+SufficientStatistics::SufficientStatistics(unsigned int p, unsigned int m) {
+    this->reset(p, m);
+}
+
+void SufficientStatistics::reset(unsigned int p, unsigned int m) {
+    this->gram.resize(p, p);
+    this->gram.zero();
+    this->rhs.resize(m, p);
+    this->rhs.zero();
+    this->sampleCount = 0;
+}
+
+void SufficientStatistics::add(const SufficientStatistics& other) {
+    if(other.gram.rows() != this->gram.rows() || other.rhs.rows() != this->rhs.rows() ||
+       other.rhs.cols() != this->rhs.cols()) {
+        throw std::runtime_error("SufficientStatistics: the statistics to add have different sizes");
+    }
+    for(int r = 0; r < this->gram.rows(); r++) {
+        for(int c = 0; c < this->gram.cols(); c++) {
+            this->gram(r, c) += other.gram(r, c);
+        }
+    }
+    for(int r = 0; r < this->rhs.rows(); r++) {
+        for(int c = 0; c < this->rhs.cols(); c++) {
+            this->rhs(r, c) += other.rhs(r, c);
+        }
+    }
+    this->sampleCount += other.sampleCount;
+}
+
+void SufficientStatistics::writeBottle(yarp::os::Bottle& bot) const {
+    bot << this->gram << this->rhs << this->sampleCount;
+}
+
+void SufficientStatistics::readBottle(yarp::os::Bottle& bot) {
+    bot >> this->sampleCount >> this->rhs >> this->gram;
+}
+
+} // learningmachine
+} // iCub